@@ -0,0 +1,615 @@
+//-----------------------------------------------------------------------------
+//
+//   arrowwriter.c
+//
+//   Purpose: Writes tables of fixed width columns to Apache Arrow IPC files
+//            (the Arrow "file" format, version 5 metadata).
+//
+//   The file holds a schema, an optional dictionary of UTF-8 strings shared
+//   by all ARROW_DICT_UTF8 columns, a sequence of record batches and a
+//   footer locating each of them. Message metadata is encoded as the
+//   flatbuffers defined by Arrow's Schema.fbs, Message.fbs and File.fbs.
+//   Flatbuffers are built front to back: each table is written before the
+//   tables, vectors and strings it refers to, and its offset fields are
+//   patched once they are written. Values are written in the byte order of
+//   the host, which must be little endian.
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arrowwriter.h"
+
+#define MAXFIELDS 8             // max. fields of a flatbuffer table
+
+// Arrow metadata codes
+#define METADATA_V5         4   // MetadataVersion.V5
+#define HEADER_SCHEMA       1   // MessageHeader.Schema
+#define HEADER_DICTIONARY   2   // MessageHeader.DictionaryBatch
+#define HEADER_RECORDBATCH  3   // MessageHeader.RecordBatch
+#define TYPE_FLOAT          3   // Type.FloatingPoint
+#define TYPE_UTF8           5   // Type.Utf8
+#define TYPE_TIMESTAMP      10  // Type.Timestamp
+#define PRECISION_SINGLE    1   // Precision.SINGLE
+#define UNIT_MILLISECOND    1   // TimeUnit.MILLISECOND
+#define CONTINUATION        0xFFFFFFFF
+
+typedef struct {
+    unsigned char* data;
+    int            size;
+    int            capacity;
+    int            failed;
+} fbuffer_t;
+
+typedef struct {
+    int       count;
+    int       size[MAXFIELDS];   // scalar size, 0 if absent, -1 if offset
+    long long value[MAXFIELDS];  // value of each scalar field
+    int       slot[MAXFIELDS];   // buffer position of each offset field
+} ftable_t;
+
+typedef struct {
+    long long offset;            // file position of message
+    int       metaLength;        // size of message prefix & metadata
+    long long bodyLength;        // size of message body
+} block_t;
+
+struct arrow_writer_s {
+    FILE*           file;
+    arrow_column_t* columns;
+    int             count;
+    long long       position;      // # bytes written to file
+    block_t         dictionary;    // location of dictionary batch
+    int             hasDictionary; // TRUE if dictionary batch written
+    block_t*        batches;       // location of each record batch
+    int             nbatches;
+    int             capacity;
+    int             failed;        // TRUE if a write failed
+};
+
+//-----------------------------------------------------------------------------
+//   Local functions
+//-----------------------------------------------------------------------------
+static int  fb_append(fbuffer_t* b, const void* x, int n);
+static void fb_align(fbuffer_t* b, int align, int extra);
+static void fb_set(fbuffer_t* b, int pos, const void* x, int n);
+static void fb_link(fbuffer_t* b, int slot, int target);
+static void fb_init(ftable_t* t, int count);
+static void fb_scalar(ftable_t* t, int field, int size, long long value);
+static void fb_offset(ftable_t* t, int field);
+static int  fb_table(fbuffer_t* b, ftable_t* t);
+static int  fb_vector(fbuffer_t* b, int count, int size, int align,
+                      const void* x);
+static int  fb_string(fbuffer_t* b, const char* s);
+
+static int  writeMessage(fbuffer_t* b, int headerType, long long bodyLength);
+static int  writeSchema(fbuffer_t* b, arrow_writer_t* w);
+static int  writeField(fbuffer_t* b, const arrow_column_t* c);
+static int  writeRecordBatch(fbuffer_t* b, long long length, int nnodes,
+                             const long long* nodes, int nbuffers,
+                             const long long* buffers);
+static int  writeBlocks(fbuffer_t* b, const block_t* blocks, int count);
+static void putMetadata(arrow_writer_t* w, fbuffer_t* b, block_t* block);
+static void putBytes(arrow_writer_t* w, const void* x, long long n);
+static long long padded(long long n);
+
+
+arrow_writer_t* arrow_open(const char* path, const arrow_column_t* columns,
+    int count)
+//
+//  Purpose: Creates an Arrow IPC file and writes the schema of its columns.
+//  Returns NULL if the file can not be created.
+//
+{
+    int             i, slot;
+    fbuffer_t       b = {NULL, 0, 0, 0};
+    arrow_writer_t* w;
+
+    w = (arrow_writer_t*)calloc(1, sizeof(arrow_writer_t));
+    if (w == NULL)
+        return NULL;
+    w->columns = (arrow_column_t*)calloc(count, sizeof(arrow_column_t));
+    w->file = fopen(path, "wb");
+    if (w->columns == NULL || w->file == NULL) {
+        if (w->file)
+            fclose(w->file);
+        free(w->columns);
+        free(w);
+        return NULL;
+    }
+    w->count = count;
+    for (i = 0; i < count; i++)
+        w->columns[i] = columns[i];
+
+    // --- magic string padded to 8 bytes followed by schema message
+    putBytes(w, "ARROW1\0\0", 8);
+    slot = writeMessage(&b, HEADER_SCHEMA, 0);
+    fb_link(&b, slot, writeSchema(&b, w));
+    putMetadata(w, &b, NULL);
+    free(b.data);
+    w->failed |= b.failed;
+    return w;
+}
+
+int arrow_writeDictionary(arrow_writer_t* w, char** strings,
+    const int* lengths, int count)
+//
+//  Purpose: Writes the dictionary of strings indexed by ARROW_DICT_UTF8
+//  columns. Must be called before the first record batch is written.
+//
+{
+    int       i, slot;
+    int*      offsets;
+    long long nodes[2], buffers[6];
+    fbuffer_t b = {NULL, 0, 0, 0};
+    ftable_t  t;
+
+    if (w->hasDictionary || w->nbatches > 0)
+        return -1;
+    offsets = (int*)calloc(count + 1, sizeof(int));
+    if (offsets == NULL)
+        return -1;
+    for (i = 0; i < count; i++)
+        offsets[i + 1] = offsets[i] + lengths[i];
+
+    // --- one string column: validity, offsets & data buffers
+    nodes[0] = count;
+    nodes[1] = 0;
+    buffers[0] = 0;
+    buffers[1] = 0;
+    buffers[2] = 0;
+    buffers[3] = (long long)(count + 1) * sizeof(int);
+    buffers[4] = padded(buffers[3]);
+    buffers[5] = offsets[count];
+
+    slot = writeMessage(&b, HEADER_DICTIONARY,
+                        buffers[4] + padded(buffers[5]));
+    fb_init(&t, 3);
+    fb_scalar(&t, 0, 8, 0);
+    fb_offset(&t, 1);
+    fb_scalar(&t, 2, 1, 0);
+    fb_link(&b, slot, fb_table(&b, &t));
+    fb_link(&b, t.slot[1], writeRecordBatch(&b, count, 1, nodes, 3, buffers));
+    putMetadata(w, &b, &w->dictionary);
+    free(b.data);
+    w->failed |= b.failed;
+
+    putBytes(w, offsets, buffers[3]);
+    putBytes(w, NULL, buffers[4] - buffers[3]);
+    for (i = 0; i < count; i++)
+        putBytes(w, strings[i], lengths[i]);
+    putBytes(w, NULL, padded(buffers[5]) - buffers[5]);
+    w->dictionary.bodyLength = buffers[4] + padded(buffers[5]);
+    w->hasDictionary = 1;
+    free(offsets);
+    return w->failed;
+}
+
+int arrow_writeBatch(arrow_writer_t* w, int rows, void** values)
+//
+//  Purpose: Writes a record batch of rows taken from an array of values for
+//  each column.
+//
+{
+    int        i, width, slot;
+    long long  body = 0, *nodes, *buffers;
+    block_t*   batches;
+    fbuffer_t  b = {NULL, 0, 0, 0};
+
+    if (w->nbatches == w->capacity) {
+        batches = (block_t*)realloc(w->batches,
+                                    (2 * w->capacity + 16) * sizeof(block_t));
+        if (batches == NULL)
+            return -1;
+        w->batches = batches;
+        w->capacity = 2 * w->capacity + 16;
+    }
+    nodes = (long long*)calloc(6 * w->count, sizeof(long long));
+    if (nodes == NULL)
+        return -1;
+    buffers = nodes + 2 * w->count;
+
+    // --- each column has a field node, an empty validity buffer and
+    //     a buffer of values padded to 8 bytes
+    for (i = 0; i < w->count; i++) {
+        width = (w->columns[i].type == ARROW_TIMESTAMP_MS) ? 8 : 4;
+        nodes[2 * i] = rows;
+        nodes[2 * i + 1] = 0;
+        buffers[4 * i] = body;
+        buffers[4 * i + 1] = 0;
+        buffers[4 * i + 2] = body;
+        buffers[4 * i + 3] = (long long)rows * width;
+        body += padded(buffers[4 * i + 3]);
+    }
+
+    slot = writeMessage(&b, HEADER_RECORDBATCH, body);
+    fb_link(&b, slot, writeRecordBatch(&b, rows, w->count, nodes,
+                                       2 * w->count, buffers));
+    putMetadata(w, &b, &w->batches[w->nbatches]);
+    free(b.data);
+    w->failed |= b.failed;
+
+    for (i = 0; i < w->count; i++) {
+        putBytes(w, values[i], buffers[4 * i + 3]);
+        putBytes(w, NULL, padded(buffers[4 * i + 3]) - buffers[4 * i + 3]);
+    }
+    w->batches[w->nbatches].bodyLength = body;
+    w->nbatches++;
+    free(nodes);
+    return w->failed;
+}
+
+int arrow_close(arrow_writer_t* w)
+//
+//  Purpose: Writes the end of stream marker and the file footer, then closes
+//  the file. Returns 0 if all of the file was written.
+//
+{
+    int          failed, size;
+    unsigned int eos[2] = {CONTINUATION, 0};
+    fbuffer_t    b = {NULL, 0, 0, 0};
+    ftable_t     t;
+
+    putBytes(w, eos, sizeof(eos));
+
+    // --- footer with schema & location of dictionary & record batches
+    fb_append(&b, NULL, 4);
+    fb_init(&t, 4);
+    fb_scalar(&t, 0, 2, METADATA_V5);
+    fb_offset(&t, 1);
+    fb_offset(&t, 2);
+    fb_offset(&t, 3);
+    fb_link(&b, 0, fb_table(&b, &t));
+    fb_link(&b, t.slot[1], writeSchema(&b, w));
+    fb_link(&b, t.slot[2],
+            writeBlocks(&b, &w->dictionary, w->hasDictionary ? 1 : 0));
+    fb_link(&b, t.slot[3], writeBlocks(&b, w->batches, w->nbatches));
+    size = b.size;
+    putBytes(w, b.data, size);
+    putBytes(w, &size, sizeof(int));
+    putBytes(w, "ARROW1", 6);
+    failed = w->failed | b.failed;
+    free(b.data);
+
+    if (fclose(w->file) != 0)
+        failed = 1;
+    free(w->columns);
+    free(w->batches);
+    free(w);
+    return failed;
+}
+
+
+// Local functions:
+int writeMessage(fbuffer_t* b, int headerType, long long bodyLength)
+//
+//  Purpose: Starts a buffer with a Message table, returning the position of
+//  its header offset.
+//
+{
+    ftable_t t;
+
+    fb_append(b, NULL, 4);
+    fb_init(&t, 4);
+    fb_scalar(&t, 0, 2, METADATA_V5);
+    fb_scalar(&t, 1, 1, headerType);
+    fb_offset(&t, 2);
+    fb_scalar(&t, 3, 8, bodyLength);
+    fb_link(b, 0, fb_table(b, &t));
+    return t.slot[2];
+}
+
+int writeSchema(fbuffer_t* b, arrow_writer_t* w)
+//
+//  Purpose: Adds a Schema table describing the writer's columns.
+//
+{
+    int      i, pos, fields;
+    ftable_t t;
+
+    fb_init(&t, 2);
+    fb_scalar(&t, 0, 2, 0);
+    fb_offset(&t, 1);
+    pos = fb_table(b, &t);
+    fields = fb_vector(b, w->count, 4, 4, NULL);
+    fb_link(b, t.slot[1], fields);
+    for (i = 0; i < w->count; i++)
+        fb_link(b, fields + 4 + 4 * i, writeField(b, &w->columns[i]));
+    return pos;
+}
+
+int writeField(fbuffer_t* b, const arrow_column_t* c)
+//
+//  Purpose: Adds a Field table for a column.
+//
+{
+    int      pos, typeCode;
+    ftable_t field, type, dictionary, index;
+
+    switch (c->type) {
+        case ARROW_TIMESTAMP_MS:
+            typeCode = TYPE_TIMESTAMP;
+            fb_init(&type, 1);
+            fb_scalar(&type, 0, 2, UNIT_MILLISECOND);
+            break;
+        case ARROW_DICT_UTF8:
+            typeCode = TYPE_UTF8;
+            fb_init(&type, 0);
+            break;
+        default:
+            typeCode = TYPE_FLOAT;
+            fb_init(&type, 1);
+            fb_scalar(&type, 0, 2, PRECISION_SINGLE);
+    }
+
+    fb_init(&field, 6);
+    fb_offset(&field, 0);
+    fb_scalar(&field, 1, 1, 0);
+    fb_scalar(&field, 2, 1, typeCode);
+    fb_offset(&field, 3);
+    if (c->type == ARROW_DICT_UTF8)
+        fb_offset(&field, 4);
+    fb_offset(&field, 5);
+    pos = fb_table(b, &field);
+
+    fb_link(b, field.slot[0], fb_string(b, c->name));
+    fb_link(b, field.slot[3], fb_table(b, &type));
+
+    // --- dictionary encoding with 32 bit signed indexes
+    if (c->type == ARROW_DICT_UTF8) {
+        fb_init(&dictionary, 3);
+        fb_scalar(&dictionary, 0, 8, 0);
+        fb_offset(&dictionary, 1);
+        fb_scalar(&dictionary, 2, 1, 0);
+        fb_link(b, field.slot[4], fb_table(b, &dictionary));
+        fb_init(&index, 2);
+        fb_scalar(&index, 0, 4, 32);
+        fb_scalar(&index, 1, 1, 1);
+        fb_link(b, dictionary.slot[1], fb_table(b, &index));
+    }
+    fb_link(b, field.slot[5], fb_vector(b, 0, 4, 4, NULL));
+    return pos;
+}
+
+int writeRecordBatch(fbuffer_t* b, long long length, int nnodes,
+    const long long* nodes, int nbuffers, const long long* buffers)
+//
+//  Purpose: Adds a RecordBatch table with its FieldNode & Buffer structs.
+//
+{
+    int      pos;
+    ftable_t t;
+
+    fb_init(&t, 3);
+    fb_scalar(&t, 0, 8, length);
+    fb_offset(&t, 1);
+    fb_offset(&t, 2);
+    pos = fb_table(b, &t);
+    fb_link(b, t.slot[1], fb_vector(b, nnodes, 16, 8, nodes));
+    fb_link(b, t.slot[2], fb_vector(b, nbuffers, 16, 8, buffers));
+    return pos;
+}
+
+int writeBlocks(fbuffer_t* b, const block_t* blocks, int count)
+//
+//  Purpose: Adds a vector of Block structs.
+//
+{
+    int  i, pos;
+    char block[24];
+
+    pos = fb_vector(b, count, 24, 8, NULL);
+    for (i = 0; i < count; i++) {
+        memset(block, 0, sizeof(block));
+        memcpy(block, &blocks[i].offset, 8);
+        memcpy(block + 8, &blocks[i].metaLength, 4);
+        memcpy(block + 16, &blocks[i].bodyLength, 8);
+        fb_set(b, pos + 4 + 24 * i, block, 24);
+    }
+    return pos;
+}
+
+void putMetadata(arrow_writer_t* w, fbuffer_t* b, block_t* block)
+//
+//  Purpose: Writes a message's metadata to file, preceded by the
+//  continuation marker and its size, noting where it was written.
+//
+{
+    unsigned int prefix[2];
+
+    fb_align(b, 8, 0);
+    prefix[0] = CONTINUATION;
+    prefix[1] = b->size;
+    if (block) {
+        block->offset = w->position;
+        block->metaLength = 8 + b->size;
+    }
+    putBytes(w, prefix, sizeof(prefix));
+    putBytes(w, b->data, b->size);
+}
+
+void putBytes(arrow_writer_t* w, const void* x, long long n)
+//
+//  Purpose: Writes bytes to file, or zeros if x is NULL.
+//
+{
+    static const char zeros[8] = {0};
+
+    if (n <= 0)
+        return;
+    if (x == NULL) {
+        if (fwrite(zeros, 1, (size_t)n, w->file) != (size_t)n)
+            w->failed = 1;
+    }
+    else if (fwrite(x, 1, (size_t)n, w->file) != (size_t)n)
+        w->failed = 1;
+    w->position += n;
+}
+
+long long padded(long long n)
+//
+//  Purpose: Rounds a byte count up to a multiple of 8.
+//
+{
+    return (n + 7) / 8 * 8;
+}
+
+int fb_append(fbuffer_t* b, const void* x, int n)
+//
+//  Purpose: Appends n bytes (zeros if x is NULL) to a flatbuffer, returning
+//  their position.
+//
+{
+    int            pos = b->size, capacity;
+    unsigned char* data;
+
+    if (b->failed)
+        return pos;
+    if (b->size + n > b->capacity) {
+        capacity = 2 * b->capacity + n + 256;
+        data = (unsigned char*)realloc(b->data, capacity);
+        if (data == NULL) {
+            b->failed = 1;
+            return pos;
+        }
+        b->data = data;
+        b->capacity = capacity;
+    }
+    if (x)
+        memcpy(b->data + pos, x, n);
+    else
+        memset(b->data + pos, 0, n);
+    b->size += n;
+    return pos;
+}
+
+void fb_align(fbuffer_t* b, int align, int extra)
+//
+//  Purpose: Pads a flatbuffer with zeros until its size plus extra bytes is
+//  a multiple of align.
+//
+{
+    int n = (align - (b->size + extra) % align) % align;
+
+    fb_append(b, NULL, n);
+}
+
+void fb_set(fbuffer_t* b, int pos, const void* x, int n)
+//
+//  Purpose: Overwrites n bytes of a flatbuffer at a given position.
+//
+{
+    if (!b->failed)
+        memcpy(b->data + pos, x, n);
+}
+
+void fb_link(fbuffer_t* b, int slot, int target)
+//
+//  Purpose: Sets the offset held at slot to refer to target.
+//
+{
+    unsigned int offset = (unsigned int)(target - slot);
+
+    fb_set(b, slot, &offset, 4);
+}
+
+void fb_init(ftable_t* t, int count)
+//
+//  Purpose: Starts a table with count fields, all absent.
+//
+{
+    memset(t, 0, sizeof(ftable_t));
+    t->count = count;
+}
+
+void fb_scalar(ftable_t* t, int field, int size, long long value)
+//
+//  Purpose: Sets a scalar field of a table.
+//
+{
+    t->size[field] = size;
+    t->value[field] = value;
+}
+
+void fb_offset(ftable_t* t, int field)
+//
+//  Purpose: Marks a table field as an offset to be linked once written.
+//
+{
+    t->size[field] = -1;
+}
+
+int fb_table(fbuffer_t* b, ftable_t* t)
+//
+//  Purpose: Adds a table preceded by its vtable, returning the position of
+//  the table. Fields follow the table's vtable offset in order of
+//  4, 8, 2 and 1 byte sizes so that each is aligned.
+//
+{
+    int   i, k, n, size, vtable, table;
+    int   at[MAXFIELDS];
+    int   sizes[] = {4, 8, 2, 1};
+    short vt[2 + MAXFIELDS];
+
+    // --- lay out fields
+    size = 4;
+    for (i = 0; i < t->count; i++)
+        at[i] = 0;
+    for (k = 0; k < 4; k++) {
+        for (i = 0; i < t->count; i++) {
+            n = (t->size[i] < 0) ? 4 : t->size[i];
+            if (n != sizes[k])
+                continue;
+            size = (size + n - 1) / n * n;
+            at[i] = size;
+            size += n;
+        }
+    }
+    size = (size + 3) / 4 * 4;
+
+    // --- vtable
+    vt[0] = (short)(4 + 2 * t->count);
+    vt[1] = (short)size;
+    for (i = 0; i < t->count; i++)
+        vt[2 + i] = (short)at[i];
+    fb_align(b, 2, 0);
+    vtable = fb_append(b, vt, 2 * (2 + t->count));
+
+    // --- table, 8 byte aligned, starting with its distance from the vtable
+    fb_align(b, 8, 0);
+    table = fb_append(b, NULL, size);
+    n = table - vtable;
+    fb_set(b, table, &n, 4);
+    for (i = 0; i < t->count; i++) {
+        if (t->size[i] > 0)
+            fb_set(b, table + at[i], &t->value[i], t->size[i]);
+        else if (t->size[i] < 0)
+            t->slot[i] = table + at[i];
+    }
+    return table;
+}
+
+int fb_vector(fbuffer_t* b, int count, int size, int align, const void* x)
+//
+//  Purpose: Adds a vector of count elements of given size and alignment
+//  (zeros if x is NULL), returning the position of its length.
+//
+{
+    unsigned int n = (unsigned int)count;
+    int          pos;
+
+    fb_align(b, (align < 4) ? 4 : align, 4);
+    pos = fb_append(b, &n, 4);
+    fb_append(b, x, count * size);
+    return pos;
+}
+
+int fb_string(fbuffer_t* b, const char* s)
+//
+//  Purpose: Adds a null terminated string.
+//
+{
+    int pos = fb_vector(b, (int)strlen(s), 1, 4, s);
+
+    fb_append(b, NULL, 1);
+    return pos;
+}
@@ -0,0 +1,31 @@
+/*
+ *  arrowwriter.h
+ *
+ *  Writes tables of fixed width columns to Apache Arrow IPC files.
+ */
+
+#ifndef ARROWWRITER_H_
+#define ARROWWRITER_H_
+
+// Column types
+typedef enum {
+    ARROW_TIMESTAMP_MS,    // 8 byte integer milliseconds since 1970
+    ARROW_DICT_UTF8,       // 4 byte integer index into a string dictionary
+    ARROW_FLOAT32          // 4 byte real
+} arrow_type_t;
+
+typedef struct arrow_column_s {
+    const char*  name;
+    arrow_type_t type;
+} arrow_column_t;
+
+typedef struct arrow_writer_s arrow_writer_t;
+
+arrow_writer_t* arrow_open(const char* path, const arrow_column_t* columns,
+    int count);
+int arrow_writeDictionary(arrow_writer_t* writer, char** strings,
+    const int* lengths, int count);
+int arrow_writeBatch(arrow_writer_t* writer, int rows, void** values);
+int arrow_close(arrow_writer_t* writer);
+
+#endif /* ARROWWRITER_H_ */
@@ -17,6 +17,7 @@
 
 // This is an opaque pointer to struct. Do not access variables.
 typedef struct Handle *SMO_Handle;
+typedef struct Catalog *SMO_Catalog;
 
 
 #include "swmm_output_enums.h"
@@ -36,12 +37,31 @@ int EXPORT_OUT_API SMO_getUnits(SMO_Handle p_handle, int **int_out, int *int_dim
 int EXPORT_OUT_API SMO_getStartDate(SMO_Handle p_handle, double *date);
 int EXPORT_OUT_API SMO_getTimes(SMO_Handle p_handle, SMO_time code, int *time);
 int EXPORT_OUT_API SMO_getElementName(SMO_Handle p_handle, SMO_elementType type, int elementIndex, char **elementName, int *size);
+int EXPORT_OUT_API SMO_findElement(SMO_Handle p_handle, SMO_elementType type, const char *elementName, int *elementIndex);
 
 int EXPORT_OUT_API SMO_getSubcatchSeries(SMO_Handle p_handle, int subcatchIndex, SMO_subcatchAttribute attr, int startPeriod, int endPeriod, float **float_out, int *int_dim);
 int EXPORT_OUT_API SMO_getNodeSeries(SMO_Handle p_handle, int nodeIndex, SMO_nodeAttribute attr, int startPeriod, int endPeriod, float **float_out, int *int_dim);
 int EXPORT_OUT_API SMO_getLinkSeries(SMO_Handle p_handle, int linkIndex, SMO_linkAttribute attr, int startPeriod, int endPeriod, float **float_out, int *int_dim);
 int EXPORT_OUT_API SMO_getSystemSeries(SMO_Handle p_handle, SMO_systemAttribute attr, int startPeriod, int endPeriod, float **float_out, int *int_dim);
 
+int EXPORT_OUT_API SMO_buildSeriesIndex(SMO_Handle p_handle, const char *path);
+int EXPORT_OUT_API SMO_openSeriesIndex(SMO_Handle p_handle, const char *path);
+
+int EXPORT_OUT_API SMO_mapResults(SMO_Handle p_handle);
+int EXPORT_OUT_API SMO_getColumnCount(SMO_Handle p_handle, int *count);
+int EXPORT_OUT_API SMO_getColumn(SMO_Handle p_handle, SMO_elementType type, int elementIndex, int attr, int *column);
+int EXPORT_OUT_API SMO_getResultsView(SMO_Handle p_handle, const char **results, int *stride);
+int EXPORT_OUT_API SMO_getPeriodRange(SMO_Handle p_handle, int startPeriod, int endPeriod, float *float_out);
+int EXPORT_OUT_API SMO_getColumnSeries(SMO_Handle p_handle, const int *columns, int count, int startPeriod, int endPeriod, float *float_out);
+
+int EXPORT_OUT_API SMO_exportArrow(SMO_Handle p_handle, SMO_elementType type, const char *path, int periodsPerBatch);
+
+int EXPORT_OUT_API SMO_openCatalog(SMO_Catalog *p_catalog, const char **paths, int count);
+int EXPORT_OUT_API SMO_closeCatalog(SMO_Catalog p_catalog);
+int EXPORT_OUT_API SMO_getCatalogSize(SMO_Catalog p_catalog, int *fileCount, int *periods);
+int EXPORT_OUT_API SMO_getCatalogHandle(SMO_Catalog p_catalog, int fileIndex, SMO_Handle *p_handle);
+int EXPORT_OUT_API SMO_getCatalogSeries(SMO_Catalog p_catalog, SMO_elementType type, int elementIndex, int attr, int startPeriod, int endPeriod, float *float_out);
+
 int EXPORT_OUT_API SMO_getSubcatchAttribute(SMO_Handle p_handle, int timeIndex, SMO_subcatchAttribute attr, float **float_out, int *int_dim);
 int EXPORT_OUT_API SMO_getNodeAttribute(SMO_Handle p_handle, int timeIndex, SMO_nodeAttribute attr, float **float_out, int *int_dim);
 int EXPORT_OUT_API SMO_getLinkAttribute(SMO_Handle p_handle, int timeIndex, SMO_linkAttribute attr, float **float_out, int *int_dim);
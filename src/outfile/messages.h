@@ -21,10 +21,17 @@
 #define ERR422 "Input Error 422: reporting period index out of range"
 #define ERR423 "Input Error 423: element index out of range"
 #define ERR424 "Input Error 424: no memory allocated for results"
+#define ERR425 "Input Error 425: not available for compressed files"
+#define ERR426 "Input Error 426: element name not found"
 
 #define ERR434 "File Error 434: unable to open binary output file"
 #define ERR435 "File Error 435: invalid file - not created by SWMM"
 #define ERR436 "File Error 436: invalid file - contains no results"
+#define ERR437 "File Error 437: unable to open series index file"
+#define ERR438 "File Error 438: series index does not match output"
+#define ERR439 "File Error 439: unable to memory map output file"
+#define ERR441 "File Error 441: unable to write export file"
+#define ERR442 "File Error 442: output files differ in layout"
 
 #define ERR440 "ERROR 440: an unspecified error has occurred"
 
@@ -14,8 +14,16 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef _WIN32
+  #include <windows.h>
+  #include <io.h>
+#else
+  #include <sys/mman.h>
+#endif
+
 #include "errormanager.h"
 #include "messages.h"
+#include "arrowwriter.h"
 
 #include "swmm_output.h"
 
@@ -37,6 +45,31 @@
 #define NELEMENTTYPES 5    // Number of element types
 #define MEMCHECK(x) (((x) == NULL) ? 414 : 0)
 
+// Series index file: header followed by each result value's full time series
+#define SERIESMAGIC 516114523      // Series index magic number
+#define SERIESHEADER (4 * RECORDSIZE + DATESIZE)    // Series index header size
+#define SERIESBLOCK 16777216       // Bytes of results transposed per pass
+
+// Compressed output files end with a different magic number and an epilogue
+// of four 8 byte file positions and six 4 byte integers
+#define MAGICNUMBER 516114522
+#define MAGICNUMBER2 516114530
+#define EPILOGUE2 (4 * 8 + 6 * RECORDSIZE)
+#define CHUNKCODEC 1               // XOR delta + byte shuffle + run length
+                                   // (other codec ids are reserved)
+
+// Arrow export: days from SWMM's date origin (12/30/1899) to 01/01/1970 and
+// default number of rows per record batch; times are rounded to the second
+#define EPOCHDAYS 25569
+#define ARROWROWS 65536
+
+// Optional hash table index of element names saved between the names and
+// the pollutant units: header of three 4 byte integers, hash slots, name
+// offsets and a trailer holding the index size and magic number
+#define NAMEMAGIC 516114531
+#define NAMETRAILER (2 * RECORDSIZE)
+#define UCHAR(x) (((x) >= 'a' && (x) <= 'z') ? ((x)&~32) : (x))
+
 
 struct IDentry {
     char* IDname;
@@ -75,9 +108,38 @@ typedef struct Handle {
     F_OFF ResultsPos;        // file position where results start
     F_OFF BytesPerPeriod;    // bytes used for results in each period
 
+    FILE* seriesFile;        // element-major series index (optional)
+    int   Ncolumns;          // number of result values in each period
+
+    char* map;               // memory mapped output file (optional)
+    F_OFF mapSize;           // size of mapped output file (bytes)
+    void* mapHandle;         // file mapping object (Windows only)
+
+    int            ChunkPeriods;  // periods per chunk (0 if not compressed)
+    int            ChunkColumns;  // result values per chunk
+    int            ChunkBlocks;   // number of chunks per row of periods
+    F_OFF          IndexPos;      // file position where chunk index starts
+    double*        periodDates;   // date of each reporting period
+    long long*     chunkIndex;    // file position & size of each chunk
+    float*         rowValues;     // decoded chunks of one row of periods
+    char*          rowDecoded;    // TRUE for each chunk of row decoded
+    int            cachedRow;     // row of periods held in rowValues
+    unsigned char* packed;        // compressed chunk work array
+    unsigned char* planes;        // byte plane work array
+
+    int  nameSlotCount;   // number of hash slots for element names
+    int* nameSlots;       // position + 1 of name in each slot (0 if empty)
+    int* nameOffsets;     // offset of each name from IDPos (saved index only)
+
     error_handle_t* error_handle;
 } data_t, *SMO_Handle;
 
+typedef struct Catalog {
+    int      count;       // number of output files
+    long     Nperiods;    // fewest reporting periods held by any file
+    data_t** files;       // open output files, the first holding the names
+} catalog_t, *SMO_Catalog;
+
 
 //-----------------------------------------------------------------------------
 //   Local functions
@@ -91,6 +153,25 @@ float  getSubcatchValue(data_t *p_data, int timeIndex, int subcatchIndex, SMO_su
 float  getNodeValue(data_t *p_data, int timeIndex, int nodeIndex, SMO_nodeAttribute attr);
 float  getLinkValue(data_t *p_data, int timeIndex, int linkIndex, SMO_linkAttribute attr);
 float  getSystemValue(data_t *p_data, int timeIndex, SMO_systemAttribute attr);
+int    getSeries(data_t *p_data, int column, int startPeriod, int length, float *values);
+int    writeSeriesIndex(data_t *p_data);
+int    readResults(data_t *p_data, F_OFF offset, void *dest, int nbytes);
+int    readBytes(data_t *p_data, F_OFF offset, void *dest, int nbytes);
+int    readChunkResults(data_t *p_data, F_OFF offset, char *dest, int nbytes);
+float  getChunkValue(data_t *p_data, int period, int column);
+int    decodeChunk(data_t *p_data, int size, int n, int m, float *values);
+int    initChunks(data_t *p_data);
+void   freeChunks(data_t *p_data);
+int    getColumn(data_t *p_data, SMO_elementType type, int index, int attr);
+int    mapFile(data_t *p_data);
+void   unmapFile(data_t *p_data);
+int    validateSeriesIndex(data_t *p_data);
+const char *getVariableName(data_t *p_data, SMO_elementType type, int attr);
+int    openCatalogFile(data_t *p_ref, data_t *p_data, const char *path);
+int    initNameIndex(data_t *p_data);
+int    readNameIndex(data_t *p_data);
+int    findName(data_t *p_data, const char *id, int first, int count);
+unsigned int hashName(const char *name);
 
 int   _fopen(FILE **f, const char *name, const char *mode);
 int   _fseek(FILE *stream, F_OFF offset, int whence);
@@ -150,12 +231,20 @@ int EXPORT_OUT_API SMO_close(SMO_Handle p_handle)
 
             free(p_data->elementNames);
         }
+        free(p_data->nameSlots);
+        free(p_data->nameOffsets);
 
         dst_errormanager(p_data->error_handle);
 
+        unmapFile(p_data);
+        freeChunks(p_data);
+
         if (p_data->file != NULL)
             fclose(p_data->file);
 
+        if (p_data->seriesFile != NULL)
+            fclose(p_data->seriesFile);
+
         free(p_data);
     }
 
@@ -230,12 +319,17 @@ int EXPORT_OUT_API SMO_open(SMO_Handle p_handle, const char *path)
 
             // --- compute number of bytes of results values used per time
             // period
+            p_data->Ncolumns =
+                p_data->Nsubcatch * p_data->SubcatchVars +
+                p_data->Nnodes * p_data->NodeVars +
+                p_data->Nlinks * p_data->LinkVars + p_data->SysVars;
             p_data->BytesPerPeriod =
-                DATESIZE +
-                (p_data->Nsubcatch * p_data->SubcatchVars +
-                 p_data->Nnodes * p_data->NodeVars +
-                 p_data->Nlinks * p_data->LinkVars + p_data->SysVars) *
-                    RECORDSIZE;
+                DATESIZE + (F_OFF)p_data->Ncolumns * RECORDSIZE;
+
+            // --- results of a compressed file are read back as if they
+            //     were laid out period by period
+            if (p_data->ChunkPeriods > 0)
+                errorcode = initChunks(p_data);
         }
     }
     // If error close the binary file
@@ -469,6 +563,65 @@ int EXPORT_OUT_API SMO_getElementName(SMO_Handle p_handle, SMO_elementType type,
     return set_error(p_data->error_handle, errorcode);
 }
 
+int EXPORT_OUT_API SMO_findElement(SMO_Handle p_handle, SMO_elementType type,
+    const char *id, int *index)
+//
+//  Purpose: Given an element name returns the element index. Names are
+//  matched without regard to case, as they are by the SWMM engine.
+//
+{
+    int     first, count, errorcode = 0;
+    data_t *p_data;
+
+    p_data = (data_t *)p_handle;
+
+    if (p_data == NULL)
+        return -1;
+    else if (p_data->file == NULL)
+        errorcode = 411;
+    else if (id == NULL || index == NULL)
+        errorcode = 421;
+    else {
+        first = 0;
+        count = 0;
+        switch (type) {
+            case SMO_subcatch:
+                count = p_data->Nsubcatch;
+                break;
+
+            case SMO_node:
+                first = p_data->Nsubcatch;
+                count = p_data->Nnodes;
+                break;
+
+            case SMO_link:
+                first = p_data->Nsubcatch + p_data->Nnodes;
+                count = p_data->Nlinks;
+                break;
+
+            case SMO_pollut:
+                first = p_data->Nsubcatch + p_data->Nnodes + p_data->Nlinks;
+                count = p_data->Npolluts;
+                break;
+
+            default:
+                errorcode = 421;
+        }
+
+        // Build the name index on first use
+        if (!errorcode && p_data->nameSlots == NULL)
+            errorcode = initNameIndex(p_data);
+
+        if (!errorcode) {
+            *index = findName(p_data, id, first, count);
+            if (*index < 0)
+                errorcode = 426;
+        }
+    }
+
+    return set_error(p_data->error_handle, errorcode);
+}
+
 int EXPORT_OUT_API SMO_getSubcatchSeries(SMO_Handle p_handle, int subcatchIndex,
     SMO_subcatchAttribute attr, int startPeriod, int endPeriod,
     float **outValueArray, int *length)
@@ -477,7 +630,7 @@ int EXPORT_OUT_API SMO_getSubcatchSeries(SMO_Handle p_handle, int subcatchIndex,
 //  start and length using timeIndex and length respectively.
 //
 {
-    int    k, len, errorcode = 0;
+    int    len, errorcode = 0;
     float  *temp;
     data_t *p_data;
 
@@ -495,13 +648,16 @@ int EXPORT_OUT_API SMO_getSubcatchSeries(SMO_Handle p_handle, int subcatchIndex,
         MEMCHECK(temp = newFloatArray(len = endPeriod - startPeriod))
     errorcode = 411;
     else {
-        // loop over and build time series
-        for (k = 0; k < len; k++)
-            temp[k] =
-                getSubcatchValue(p_data, startPeriod + k, subcatchIndex, attr);
-
-        *outValueArray = temp;
-        *length         = len;
+        // read the contiguous time series
+        errorcode = getSeries(p_data,
+                              subcatchIndex * p_data->SubcatchVars + attr,
+                              startPeriod, len, temp);
+        if (errorcode)
+            free(temp);
+        else {
+            *outValueArray = temp;
+            *length         = len;
+        }
     }
 
     return set_error(p_data->error_handle, errorcode);
@@ -515,7 +671,7 @@ int EXPORT_OUT_API SMO_getNodeSeries(SMO_Handle p_handle, int nodeIndex,
 //  start and length using timeIndex and length respectively.
 //
 {
-    int    k, len, errorcode = 0;
+    int    len, errorcode = 0;
     float  *temp;
     data_t *p_data;
 
@@ -533,12 +689,17 @@ int EXPORT_OUT_API SMO_getNodeSeries(SMO_Handle p_handle, int nodeIndex,
         MEMCHECK(temp = newFloatArray(len = endPeriod - startPeriod))
     errorcode = 411;
     else {
-        // loop over and build time series
-        for (k = 0; k < len; k++)
-            temp[k] = getNodeValue(p_data, startPeriod + k, nodeIndex, attr);
-
-        *outValueArray = temp;
-        *length         = len;
+        // read the contiguous time series
+        errorcode = getSeries(p_data,
+                              p_data->Nsubcatch * p_data->SubcatchVars +
+                              nodeIndex * p_data->NodeVars + attr,
+                              startPeriod, len, temp);
+        if (errorcode)
+            free(temp);
+        else {
+            *outValueArray = temp;
+            *length         = len;
+        }
     }
 
     return set_error(p_data->error_handle, errorcode);
@@ -552,7 +713,7 @@ int EXPORT_OUT_API SMO_getLinkSeries(SMO_Handle p_handle, int linkIndex,
 //  start and length using timeIndex and length respectively.
 //
 {
-    int    k, len, errorcode = 0;
+    int    len, errorcode = 0;
     float  *temp;
     data_t *p_data;
 
@@ -570,12 +731,18 @@ int EXPORT_OUT_API SMO_getLinkSeries(SMO_Handle p_handle, int linkIndex,
         MEMCHECK(temp = newFloatArray(len = endPeriod - startPeriod))
     errorcode = 411;
     else {
-        // loop over and build time series
-        for (k = 0; k < len; k++)
-            temp[k] = getLinkValue(p_data, startPeriod + k, linkIndex, attr);
-
-        *outValueArray = temp;
-        *length         = len;
+        // read the contiguous time series
+        errorcode = getSeries(p_data,
+                              p_data->Nsubcatch * p_data->SubcatchVars +
+                              p_data->Nnodes * p_data->NodeVars +
+                              linkIndex * p_data->LinkVars + attr,
+                              startPeriod, len, temp);
+        if (errorcode)
+            free(temp);
+        else {
+            *outValueArray = temp;
+            *length         = len;
+        }
     }
 
     return set_error(p_data->error_handle, errorcode);
@@ -588,7 +755,7 @@ int EXPORT_OUT_API SMO_getSystemSeries(SMO_Handle p_handle, SMO_systemAttribute
 //  start and length using timeIndex and length respectively.
 //
 {
-    int    k, len, errorcode = 0;
+    int    len, errorcode = 0;
     float  *temp;
     data_t *p_data;
 
@@ -604,12 +771,278 @@ int EXPORT_OUT_API SMO_getSystemSeries(SMO_Handle p_handle, SMO_systemAttribute
         MEMCHECK(temp = newFloatArray(len = endPeriod - startPeriod))
     errorcode = 411;
     else {
-        // loop over and build time series
-        for (k = 0; k < len; k++)
-            temp[k] = getSystemValue(p_data, startPeriod + k, attr);
+        // read the contiguous time series
+        errorcode = getSeries(p_data,
+                              p_data->Ncolumns - p_data->SysVars + attr,
+                              startPeriod, len, temp);
+        if (errorcode)
+            free(temp);
+        else {
+            *outValueArray = temp;
+            *length         = len;
+        }
+    }
 
-        *outValueArray = temp;
-        *length         = len;
+    return set_error(p_data->error_handle, errorcode);
+}
+
+int EXPORT_OUT_API SMO_buildSeriesIndex(SMO_Handle p_handle, const char *path)
+//
+//  Purpose: Writes a series index file holding each result value's full time
+//  series contiguously and uses it for all subsequent series requests. If path
+//  is NULL the index is written next to the output file with an .idx extension.
+//
+{
+    int     errorcode = 0;
+    char    indexName[MAXFILENAME + 5];
+    data_t *p_data;
+
+    p_data = (data_t *)p_handle;
+
+    if (p_data == NULL)
+        return -1;
+
+    if (p_data->seriesFile != NULL) {
+        fclose(p_data->seriesFile);
+        p_data->seriesFile = NULL;
+    }
+
+    if (path == NULL) {
+        strncpy(indexName, p_data->name, MAXFILENAME);
+        indexName[MAXFILENAME] = '\0';
+        strcat(indexName, ".idx");
+        path = indexName;
+    }
+
+    if (_fopen(&(p_data->seriesFile), path, "w+b") != 0) {
+        p_data->seriesFile = NULL;
+        errorcode = 437;
+    }
+    else if ((errorcode = writeSeriesIndex(p_data)) != 0) {
+        fclose(p_data->seriesFile);
+        p_data->seriesFile = NULL;
+    }
+
+    return set_error(p_data->error_handle, errorcode);
+}
+
+int EXPORT_OUT_API SMO_openSeriesIndex(SMO_Handle p_handle, const char *path)
+//
+//  Purpose: Opens a series index file previously written for this output file
+//  by SMO_buildSeriesIndex and uses it for all subsequent series requests.
+//
+{
+    int     errorcode = 0;
+    data_t *p_data;
+
+    p_data = (data_t *)p_handle;
+
+    if (p_data == NULL)
+        return -1;
+
+    if (p_data->seriesFile != NULL) {
+        fclose(p_data->seriesFile);
+        p_data->seriesFile = NULL;
+    }
+
+    if (_fopen(&(p_data->seriesFile), path, "rb") != 0) {
+        p_data->seriesFile = NULL;
+        errorcode = 437;
+    }
+    else if ((errorcode = validateSeriesIndex(p_data)) != 0) {
+        fclose(p_data->seriesFile);
+        p_data->seriesFile = NULL;
+    }
+
+    return set_error(p_data->error_handle, errorcode);
+}
+
+int EXPORT_OUT_API SMO_mapResults(SMO_Handle p_handle)
+//
+//  Purpose: Memory maps the open output file read-only. All subsequent result
+//  requests are served from the mapping instead of seeking and reading.
+//
+{
+    int     errorcode = 0;
+    data_t *p_data;
+
+    p_data = (data_t *)p_handle;
+
+    if (p_data == NULL)
+        return -1;
+    else if (p_data->file == NULL)
+        errorcode = 434;
+    else if (p_data->map == NULL)
+        errorcode = mapFile(p_data);
+
+    return set_error(p_data->error_handle, errorcode);
+}
+
+int EXPORT_OUT_API SMO_getColumnCount(SMO_Handle p_handle, int *count)
+//
+//  Purpose: Returns the number of result values stored for each period.
+//
+{
+    data_t *p_data;
+
+    p_data = (data_t *)p_handle;
+
+    if (p_data == NULL)
+        return -1;
+
+    *count = p_data->Ncolumns;
+    return set_error(p_data->error_handle, 0);
+}
+
+int EXPORT_OUT_API SMO_getColumn(SMO_Handle p_handle, SMO_elementType type,
+    int elementIndex, int attr, int *column)
+//
+//  Purpose: Returns the position of an element's attribute within each
+//  period's block of results.
+//
+{
+    int     errorcode = 0;
+    data_t *p_data;
+
+    p_data = (data_t *)p_handle;
+
+    *column = -1;
+    if (p_data == NULL)
+        return -1;
+    else if (attr < 0)
+        errorcode = 421;
+    else if ((*column = getColumn(p_data, type, elementIndex, attr)) < 0)
+        errorcode = (*column == -2) ? 421 : 423;
+
+    return set_error(p_data->error_handle, errorcode);
+}
+
+int EXPORT_OUT_API SMO_getResultsView(SMO_Handle p_handle,
+    const char **results, int *stride)
+//
+//  Purpose: Returns a pointer into the mapped output file at the first result
+//  value of the first period along with the byte stride between periods. The
+//  value of column c in period t is the 4 byte float at
+//  results + t * stride + c * 4; it need not be aligned, so callers should
+//  copy it out with memcpy.
+//
+{
+    int     errorcode = 0;
+    data_t *p_data;
+
+    p_data = (data_t *)p_handle;
+
+    *results = NULL;
+    *stride  = 0;
+    if (p_data == NULL)
+        return -1;
+    else if (p_data->file == NULL)
+        errorcode = 434;
+    else if (p_data->ChunkPeriods > 0)
+        errorcode = 425;
+    else {
+        if (p_data->map == NULL)
+            errorcode = mapFile(p_data);
+        if (errorcode == 0 && p_data->mapSize < p_data->ResultsPos +
+                                  p_data->Nperiods * p_data->BytesPerPeriod)
+            errorcode = 436;
+        if (errorcode == 0) {
+            *results = p_data->map + p_data->ResultsPos + DATESIZE;
+            *stride  = (int)p_data->BytesPerPeriod;
+        }
+    }
+
+    return set_error(p_data->error_handle, errorcode);
+}
+
+int EXPORT_OUT_API SMO_getPeriodRange(SMO_Handle p_handle, int startPeriod,
+    int endPeriod, float *buffer)
+//
+//  Purpose: Copies every result value of periods startPeriod up to (but not
+//  including) endPeriod into a caller-provided buffer, period by period.
+//  The buffer must hold (endPeriod - startPeriod) * column count floats.
+//
+{
+    int     k, errorcode = 0;
+    F_OFF   offset;
+    data_t *p_data;
+
+    p_data = (data_t *)p_handle;
+
+    if (p_data == NULL)
+        return -1;
+    else if (startPeriod < 0 || endPeriod > p_data->Nperiods ||
+             endPeriod <= startPeriod)
+        errorcode = 422;
+    else if (buffer == NULL)
+        errorcode = 424;
+    else {
+        for (k = 0; k < endPeriod - startPeriod; k++) {
+            offset = p_data->ResultsPos +
+                     (startPeriod + k) * p_data->BytesPerPeriod + DATESIZE;
+            if (readResults(p_data, offset,
+                            &buffer[(F_OFF)k * p_data->Ncolumns],
+                            p_data->Ncolumns * RECORDSIZE) <
+                p_data->Ncolumns * RECORDSIZE)
+                errorcode = 436;
+        }
+    }
+
+    return set_error(p_data->error_handle, errorcode);
+}
+
+int EXPORT_OUT_API SMO_getColumnSeries(SMO_Handle p_handle, const int *columns,
+    int count, int startPeriod, int endPeriod, float *buffer)
+//
+//  Purpose: Copies the time series of each of a set of result columns into a
+//  caller-provided buffer, one full series after another. The buffer must
+//  hold count * (endPeriod - startPeriod) floats.
+//
+{
+    int     i, k, len, errorcode = 0;
+    F_OFF   offset;
+    data_t *p_data;
+
+    p_data = (data_t *)p_handle;
+
+    if (p_data == NULL)
+        return -1;
+    else if (startPeriod < 0 || endPeriod > p_data->Nperiods ||
+             endPeriod <= startPeriod)
+        errorcode = 422;
+    else if (buffer == NULL || columns == NULL || count < 0)
+        errorcode = 424;
+    else {
+        for (i = 0; i < count; i++) {
+            if (columns[i] < 0 || columns[i] >= p_data->Ncolumns)
+                errorcode = 423;
+        }
+    }
+
+    if (errorcode == 0) {
+        len = endPeriod - startPeriod;
+
+        // --- with a mapping, sweep the periods in file order
+        if (p_data->map != NULL && p_data->seriesFile == NULL &&
+            p_data->ChunkPeriods == 0) {
+            for (k = 0; k < len; k++) {
+                offset = p_data->ResultsPos +
+                         (startPeriod + k) * p_data->BytesPerPeriod + DATESIZE;
+                for (i = 0; i < count; i++) {
+                    if (readResults(p_data, offset + columns[i] * RECORDSIZE,
+                                    &buffer[(F_OFF)i * len + k], RECORDSIZE) <
+                        RECORDSIZE)
+                        errorcode = 436;
+                }
+            }
+        }
+        else {
+            for (i = 0; i < count; i++) {
+                if (getSeries(p_data, columns[i], startPeriod, len,
+                              &buffer[(F_OFF)i * len]))
+                    errorcode = 436;
+            }
+        }
     }
 
     return set_error(p_data->error_handle, errorcode);
@@ -765,8 +1198,7 @@ int EXPORT_OUT_API SMO_getSubcatchResult(SMO_Handle p_handle, int periodIndex,
         // add offset for subcatchment
         offset += (subcatchIndex * p_data->SubcatchVars) * RECORDSIZE;
 
-        _fseek(p_data->file, offset, SEEK_SET);
-        fread(temp, RECORDSIZE, p_data->SubcatchVars, p_data->file);
+        readResults(p_data, offset, temp, p_data->SubcatchVars * RECORDSIZE);
 
         *outValueArray = temp;
         *arrayLength   = p_data->SubcatchVars;
@@ -805,8 +1237,7 @@ int EXPORT_OUT_API SMO_getNodeResult(SMO_Handle p_handle, int periodIndex,
                    nodeIndex * p_data->NodeVars) *
                   RECORDSIZE;
 
-        _fseek(p_data->file, offset, SEEK_SET);
-        fread(temp, RECORDSIZE, p_data->NodeVars, p_data->file);
+        readResults(p_data, offset, temp, p_data->NodeVars * RECORDSIZE);
 
         *outValueArray = temp;
         *arrayLength   = p_data->NodeVars;
@@ -846,8 +1277,7 @@ int EXPORT_OUT_API SMO_getLinkResult(SMO_Handle p_handle, int periodIndex,
              p_data->Nnodes * p_data->NodeVars + linkIndex * p_data->LinkVars) *
             RECORDSIZE;
 
-        _fseek(p_data->file, offset, SEEK_SET);
-        fread(temp, RECORDSIZE, p_data->LinkVars, p_data->file);
+        readResults(p_data, offset, temp, p_data->LinkVars * RECORDSIZE);
 
         *outValueArray = temp;
         *arrayLength   = p_data->LinkVars;
@@ -886,8 +1316,7 @@ int EXPORT_OUT_API SMO_getSystemResult(SMO_Handle p_handle, int periodIndex,
                    p_data->Nlinks * p_data->LinkVars) *
                   RECORDSIZE;
 
-        _fseek(p_data->file, offset, SEEK_SET);
-        fread(temp, RECORDSIZE, p_data->SysVars, p_data->file);
+        readResults(p_data, offset, temp, p_data->SysVars * RECORDSIZE);
 
         *outValueArray = temp;
         *arrayLength   = p_data->SysVars;
@@ -896,6 +1325,333 @@ int EXPORT_OUT_API SMO_getSystemResult(SMO_Handle p_handle, int periodIndex,
     return set_error(p_data->error_handle, errorcode);
 }
 
+int EXPORT_OUT_API SMO_exportArrow(SMO_Handle p_handle, SMO_elementType type,
+    const char *path, int periodsPerBatch)
+//
+//  Purpose: Writes all results of one element type to an Apache Arrow IPC
+//  file. Each row holds the results of one element in one reporting period:
+//  a "time" timestamp (milliseconds, no time zone), an "element" ID that is
+//  dictionary encoded with the element names (omitted for system results)
+//  and one float column per reporting variable. Rows are ordered by period,
+//  then element, and grouped into record batches of periodsPerBatch periods
+//  (a batch of about 65536 rows if periodsPerBatch is 0).
+//
+{
+    int             i, j, k, v, rows, period, count, errorcode = 0;
+    int             nElements, nVars, first, firstName, ncols;
+    float          *values = NULL;
+    float         **vars = NULL;
+    long long      *times = NULL;
+    int            *ids = NULL;
+    void          **columns = NULL;
+    char          **names = NULL;
+    int            *lengths = NULL;
+    arrow_column_t *fields = NULL;
+    arrow_writer_t *writer = NULL;
+    double          date;
+    data_t         *p_data;
+
+    p_data = (data_t *)p_handle;
+
+    if (p_data == NULL)
+        return -1;
+    else if (p_data->file == NULL)
+        return set_error(p_data->error_handle, 411);
+
+    switch (type) {
+        case SMO_subcatch:
+            nElements = p_data->Nsubcatch;
+            nVars     = p_data->SubcatchVars;
+            firstName = 0;
+            break;
+        case SMO_node:
+            nElements = p_data->Nnodes;
+            nVars     = p_data->NodeVars;
+            firstName = p_data->Nsubcatch;
+            break;
+        case SMO_link:
+            nElements = p_data->Nlinks;
+            nVars     = p_data->LinkVars;
+            firstName = p_data->Nsubcatch + p_data->Nnodes;
+            break;
+        case SMO_sys:
+            nElements = 1;
+            nVars     = p_data->SysVars;
+            firstName = -1;
+            break;
+        default:
+            return set_error(p_data->error_handle, 421);
+    }
+    if (periodsPerBatch < 0)
+        return set_error(p_data->error_handle, 422);
+    if (nElements == 0)
+        return set_error(p_data->error_handle, 423);
+    if (periodsPerBatch == 0)
+        periodsPerBatch = ARROWROWS / nElements;
+    if (periodsPerBatch < 1)
+        periodsPerBatch = 1;
+    if (periodsPerBatch > p_data->Nperiods)
+        periodsPerBatch = (int)p_data->Nperiods;
+    if (p_data->elementNames == NULL)
+        initElementNames(p_data);
+
+    // --- columns: time, element (unless system results) & each variable
+    first = getColumn(p_data, type, 0, 0);
+    ncols = nVars + ((firstName < 0) ? 1 : 2);
+    rows  = periodsPerBatch * nElements;
+    fields  = (arrow_column_t *)calloc(ncols, sizeof(arrow_column_t));
+    columns = (void **)calloc(ncols, sizeof(void *));
+    vars    = (float **)calloc(nVars + 1, sizeof(float *));
+    times   = (long long *)calloc(rows, sizeof(long long));
+    values  = newFloatArray(nElements * nVars + 1);
+    if (!fields || !columns || !vars || !times || !values)
+        errorcode = 411;
+    else {
+        k = 0;
+        fields[k].name = "time";
+        fields[k].type = ARROW_TIMESTAMP_MS;
+        columns[k++]   = times;
+        if (firstName >= 0) {
+            ids = newIntArray(rows);
+            fields[k].name = "element";
+            fields[k].type = ARROW_DICT_UTF8;
+            columns[k++]   = ids;
+            if (ids == NULL)
+                errorcode = 411;
+        }
+        for (v = 0; v < nVars && !errorcode; v++) {
+            vars[v] = newFloatArray(rows);
+            fields[k].name = getVariableName(p_data, type, v);
+            fields[k].type = ARROW_FLOAT32;
+            columns[k++]   = vars[v];
+            if (vars[v] == NULL)
+                errorcode = 411;
+        }
+    }
+
+    // --- write schema & dictionary of element names
+    if (!errorcode) {
+        writer = arrow_open(path, fields, ncols);
+        if (writer == NULL)
+            errorcode = 441;
+    }
+    if (!errorcode && firstName >= 0) {
+        names   = (char **)calloc(nElements, sizeof(char *));
+        lengths = newIntArray(nElements);
+        if (!names || !lengths)
+            errorcode = 411;
+        else {
+            for (j = 0; j < nElements; j++) {
+                names[j]   = p_data->elementNames[firstName + j].IDname;
+                lengths[j] = p_data->elementNames[firstName + j].length;
+            }
+            if (arrow_writeDictionary(writer, names, lengths, nElements))
+                errorcode = 441;
+        }
+    }
+
+    // --- write record batches of periods
+    for (period = 0; period < p_data->Nperiods && !errorcode;
+         period += periodsPerBatch) {
+        count = periodsPerBatch;
+        if (count > p_data->Nperiods - period)
+            count = (int)(p_data->Nperiods - period);
+        for (i = 0; i < count; i++) {
+            date = getTimeValue(p_data, period + i);
+            readResults(p_data,
+                        p_data->ResultsPos +
+                            (period + i) * p_data->BytesPerPeriod + DATESIZE +
+                            (F_OFF)first * RECORDSIZE,
+                        values, nElements * nVars * RECORDSIZE);
+            for (j = 0; j < nElements; j++) {
+                k = i * nElements + j;
+                times[k] = 1000 * (long long)((date - EPOCHDAYS) * 86400.0 +
+                                              ((date < EPOCHDAYS) ? -0.5 : 0.5));
+                if (ids)
+                    ids[k] = j;
+                for (v = 0; v < nVars; v++)
+                    vars[v][k] = values[j * nVars + v];
+            }
+        }
+        if (arrow_writeBatch(writer, count * nElements, columns))
+            errorcode = 441;
+    }
+    if (writer != NULL && arrow_close(writer) && !errorcode)
+        errorcode = 441;
+
+    if (vars != NULL) {
+        for (v = 0; v < nVars; v++)
+            free(vars[v]);
+    }
+    free(vars);
+    free(values);
+    free(times);
+    free(ids);
+    free(columns);
+    free(fields);
+    free(names);
+    free(lengths);
+
+    return set_error(p_data->error_handle, errorcode);
+}
+
+int EXPORT_OUT_API SMO_openCatalog(SMO_Catalog *p_catalog, const char **paths,
+    int count)
+//
+//  Purpose: Opens a set of output files produced by the same project, such
+//  as the scenarios of an ensemble. The first file is opened in full and
+//  serves every file's element names; each of the others only has its
+//  epilogue, start date and reporting step read and its layout checked
+//  against the first. Files are opened in parallel. On failure no catalog
+//  is returned.
+//
+{
+    int        i, err, errorcode = 0;
+    catalog_t *p_cat;
+
+    *p_catalog = NULL;
+    if (paths == NULL || count <= 0)
+        return 421;
+
+    p_cat = (catalog_t *)calloc(1, sizeof(catalog_t));
+    if (p_cat == NULL)
+        return 411;
+    p_cat->files = (data_t **)calloc(count, sizeof(data_t *));
+    if (p_cat->files == NULL) {
+        free(p_cat);
+        return 411;
+    }
+    p_cat->count = count;
+
+    for (i = 0; i < count && errorcode == 0; i++) {
+        if (SMO_init(&(p_cat->files[i])) != 0)
+            errorcode = 411;
+    }
+
+    // --- open the reference file, then the others against its layout
+    if (errorcode == 0) {
+        err = SMO_open(p_cat->files[0], paths[0]);
+        if (err > 400) {
+            p_cat->files[0] = NULL;    // closed by SMO_open
+            errorcode = err;
+        }
+    }
+    if (errorcode == 0) {
+#pragma omp parallel for schedule(dynamic) private(err)
+        for (i = 1; i < count; i++) {
+            err = openCatalogFile(p_cat->files[0], p_cat->files[i], paths[i]);
+            if (err != 0) {
+#pragma omp critical
+                if (errorcode == 0)
+                    errorcode = err;
+            }
+        }
+    }
+
+    if (errorcode == 0) {
+        p_cat->Nperiods = p_cat->files[0]->Nperiods;
+        for (i = 1; i < count; i++) {
+            if (p_cat->files[i]->Nperiods < p_cat->Nperiods)
+                p_cat->Nperiods = p_cat->files[i]->Nperiods;
+        }
+        *p_catalog = p_cat;
+    }
+    else
+        SMO_closeCatalog(p_cat);
+
+    return errorcode;
+}
+
+int EXPORT_OUT_API SMO_closeCatalog(SMO_Catalog p_catalog)
+//
+//  Purpose: Closes every file of a catalog and frees it.
+//
+{
+    int i;
+
+    if (p_catalog == NULL)
+        return -1;
+
+    for (i = 0; i < p_catalog->count; i++) {
+        if (p_catalog->files[i] != NULL)
+            SMO_close(p_catalog->files[i]);
+    }
+    free(p_catalog->files);
+    free(p_catalog);
+    return 0;
+}
+
+int EXPORT_OUT_API SMO_getCatalogSize(SMO_Catalog p_catalog, int *fileCount,
+    int *periods)
+//
+//  Purpose: Returns the number of files in a catalog and the number of
+//  reporting periods that all of them hold.
+//
+{
+    if (p_catalog == NULL)
+        return -1;
+
+    *fileCount = p_catalog->count;
+    *periods   = (int)p_catalog->Nperiods;
+    return 0;
+}
+
+int EXPORT_OUT_API SMO_getCatalogHandle(SMO_Catalog p_catalog, int fileIndex,
+    SMO_Handle *p_handle)
+//
+//  Purpose: Returns the handle of one file of a catalog, through which its
+//  own start date, reporting step and period count can be retrieved. Handle
+//  0 holds the element names shared by all files (see SMO_findElement). The
+//  handle stays owned by the catalog and must not be closed.
+//
+{
+    *p_handle = NULL;
+    if (p_catalog == NULL)
+        return -1;
+    else if (fileIndex < 0 || fileIndex >= p_catalog->count)
+        return 423;
+
+    *p_handle = p_catalog->files[fileIndex];
+    return 0;
+}
+
+int EXPORT_OUT_API SMO_getCatalogSeries(SMO_Catalog p_catalog,
+    SMO_elementType type, int elementIndex, int attr, int startPeriod,
+    int endPeriod, float *buffer)
+//
+//  Purpose: Copies the time series of one element attribute from every file
+//  of a catalog into a caller-provided buffer, one file's series after
+//  another. The buffer must hold file count * (endPeriod - startPeriod)
+//  floats. Files are read in parallel.
+//
+{
+    int i, column, len, failures = 0;
+
+    if (p_catalog == NULL)
+        return -1;
+    else if (startPeriod < 0 || endPeriod > p_catalog->Nperiods ||
+             endPeriod <= startPeriod)
+        return 422;
+    else if (buffer == NULL)
+        return 424;
+    else if (attr < 0)
+        return 421;
+    else if ((column = getColumn(p_catalog->files[0], type, elementIndex,
+                                 attr)) < 0)
+        return (column == -2) ? 421 : 423;
+
+    // --- each file has its own file pointer and chunk cache
+    len = endPeriod - startPeriod;
+#pragma omp parallel for schedule(dynamic) reduction(+:failures)
+    for (i = 0; i < p_catalog->count; i++) {
+        if (getSeries(p_catalog->files[i], column, startPeriod, len,
+                      &buffer[(F_OFF)i * len]))
+            failures++;
+    }
+
+    return (failures > 0) ? 436 : 0;
+}
+
 void EXPORT_OUT_API SMO_freeMemory(void *array)
 //
 //  Purpose: Frees memory allocated by API calls
@@ -957,6 +1713,12 @@ void errorLookup(int errcode, char *dest_msg, int dest_len)
         case 424:
             msg = ERR424;
             break;
+        case 425:
+            msg = ERR425;
+            break;
+        case 426:
+            msg = ERR426;
+            break;
         case 434:
             msg = ERR434;
             break;
@@ -966,6 +1728,21 @@ void errorLookup(int errcode, char *dest_msg, int dest_len)
         case 436:
             msg = ERR436;
             break;
+        case 437:
+            msg = ERR437;
+            break;
+        case 438:
+            msg = ERR438;
+            break;
+        case 439:
+            msg = ERR439;
+            break;
+        case 441:
+            msg = ERR441;
+            break;
+        case 442:
+            msg = ERR442;
+            break;
         default:
             msg = ERR440;
     }
@@ -974,25 +1751,93 @@ void errorLookup(int errcode, char *dest_msg, int dest_len)
 }
 
 // Local functions:
+int openCatalogFile(data_t *p_ref, data_t *p_data, const char *path) {
+    //
+    //  Purpose: Opens an output file of a catalog. Its element counts and
+    //  section positions must match those of the catalog's reference file,
+    //  whose reporting variables it then shares.
+    //
+    INT4 counts[4];
+    int  errorcode;
+
+    strncpy(p_data->name, path, MAXFILENAME);
+    if (_fopen(&(p_data->file), path, "rb") != 0)
+        return 434;
+    errorcode = validateFile(p_data);
+    if (errorcode > 400)
+        return errorcode;
+
+    // --- same elements, names of the same sizes & same property data
+    _fseek(p_data->file, 3 * RECORDSIZE, SEEK_SET);
+    if (fread(counts, RECORDSIZE, 4, p_data->file) != 4 ||
+        counts[0] != p_ref->Nsubcatch || counts[1] != p_ref->Nnodes ||
+        counts[2] != p_ref->Nlinks || counts[3] != p_ref->Npolluts ||
+        p_data->IDPos != p_ref->IDPos ||
+        p_data->ObjPropPos != p_ref->ObjPropPos ||
+        p_data->ResultsPos != p_ref->ResultsPos)
+        return 442;
+
+    p_data->Nsubcatch      = p_ref->Nsubcatch;
+    p_data->Nnodes         = p_ref->Nnodes;
+    p_data->Nlinks         = p_ref->Nlinks;
+    p_data->Npolluts       = p_ref->Npolluts;
+    p_data->SubcatchVars   = p_ref->SubcatchVars;
+    p_data->NodeVars       = p_ref->NodeVars;
+    p_data->LinkVars       = p_ref->LinkVars;
+    p_data->SysVars        = p_ref->SysVars;
+    p_data->Ncolumns       = p_ref->Ncolumns;
+    p_data->BytesPerPeriod = p_ref->BytesPerPeriod;
+
+    // --- each file keeps its own time range
+    _fseek(p_data->file, p_data->ResultsPos - 3 * RECORDSIZE, SEEK_SET);
+    fread(&(p_data->StartDate), DATESIZE, 1, p_data->file);
+    fread(&(p_data->ReportStep), RECORDSIZE, 1, p_data->file);
+
+    if (p_data->ChunkPeriods > 0)
+        return initChunks(p_data);
+    return 0;
+}
+
 int validateFile(data_t *p_data) {
-    INT4 magic1, magic2, errcode;
-    int  errorcode = 0;
-
-    // --- fast forward to end and read epilogue
-    _fseek(p_data->file, -6 * RECORDSIZE, SEEK_END);
-    fread(&(p_data->IDPos), RECORDSIZE, 1, p_data->file);
-    fread(&(p_data->ObjPropPos), RECORDSIZE, 1, p_data->file);
-    fread(&(p_data->ResultsPos), RECORDSIZE, 1, p_data->file);
-    fread(&(p_data->Nperiods), RECORDSIZE, 1, p_data->file);
-    fread(&errcode, RECORDSIZE, 1, p_data->file);
+    INT4      magic1, magic2, errcode, codec = CHUNKCODEC;
+    long long pos[4];
+    int       errorcode = 0;
+
+    // --- fast forward to end and read magic number of epilogue
+    _fseek(p_data->file, -RECORDSIZE, SEEK_END);
     fread(&magic2, RECORDSIZE, 1, p_data->file);
 
+    // --- compressed file epilogue holds 64-bit file positions
+    if (magic2 == MAGICNUMBER2) {
+        _fseek(p_data->file, -EPILOGUE2, SEEK_END);
+        fread(pos, sizeof(long long), 4, p_data->file);
+        fread(&(p_data->ChunkPeriods), RECORDSIZE, 1, p_data->file);
+        fread(&(p_data->ChunkColumns), RECORDSIZE, 1, p_data->file);
+        fread(&codec, RECORDSIZE, 1, p_data->file);
+        fread(&(p_data->Nperiods), RECORDSIZE, 1, p_data->file);
+        fread(&errcode, RECORDSIZE, 1, p_data->file);
+        p_data->IDPos      = (F_OFF)pos[0];
+        p_data->ObjPropPos = (F_OFF)pos[1];
+        p_data->ResultsPos = (F_OFF)pos[2];
+        p_data->IndexPos   = (F_OFF)pos[3];
+        magic2 = MAGICNUMBER;
+    }
+    else {
+        _fseek(p_data->file, -6 * RECORDSIZE, SEEK_END);
+        fread(&(p_data->IDPos), RECORDSIZE, 1, p_data->file);
+        fread(&(p_data->ObjPropPos), RECORDSIZE, 1, p_data->file);
+        fread(&(p_data->ResultsPos), RECORDSIZE, 1, p_data->file);
+        fread(&(p_data->Nperiods), RECORDSIZE, 1, p_data->file);
+        fread(&errcode, RECORDSIZE, 1, p_data->file);
+    }
+
     // --- rewind and read magic number from beginning of the file
     _fseek(p_data->file, 0L, SEEK_SET);
     fread(&magic1, RECORDSIZE, 1, p_data->file);
 
     // Is this a valid SWMM binary output file?
-    if (magic1 != magic2)
+    if (magic1 != magic2 || codec != CHUNKCODEC ||
+        (p_data->ChunkPeriods > 0 && p_data->ChunkColumns <= 0))
         errorcode = 435;
     // Does the binary file contain results?
     else if (p_data->Nperiods <= 0)
@@ -1027,6 +1872,157 @@ void initElementNames(data_t *p_data) {
     }
 }
 
+int initNameIndex(data_t *p_data) {
+    //
+    //  Purpose: Reads the hash table index of element names saved in the
+    //  output file, or builds one from the names when none was saved.
+    //
+    int i, j, numNames, slots;
+
+    if (readNameIndex(p_data) == 0)
+        return 0;
+
+    if (p_data->elementNames == NULL)
+        initElementNames(p_data);
+
+    numNames =
+        p_data->Nsubcatch + p_data->Nnodes + p_data->Nlinks + p_data->Npolluts;
+    slots = 2;
+    while (slots < 2 * numNames)
+        slots *= 2;
+
+    p_data->nameSlots = (int *)calloc(slots, sizeof(int));
+    if (p_data->nameSlots == NULL)
+        return 411;
+    p_data->nameSlotCount = slots;
+
+    for (i = 0; i < numNames; i++) {
+        j = hashName(p_data->elementNames[i].IDname) & (slots - 1);
+        while (p_data->nameSlots[j] != 0)
+            j = (j + 1) & (slots - 1);
+        p_data->nameSlots[j] = i + 1;
+    }
+    return 0;
+}
+
+int readNameIndex(data_t *p_data) {
+    //
+    //  Purpose: Reads the hash slots and name offsets of a name index saved
+    //  just before the pollutant units codes. Returns 0 if the file holds
+    //  a valid index.
+    //
+    INT4  trailer[2], header[3];
+    int   numNames;
+    F_OFF pos, size;
+
+    numNames =
+        p_data->Nsubcatch + p_data->Nnodes + p_data->Nlinks + p_data->Npolluts;
+    pos = p_data->ObjPropPos - (F_OFF)p_data->Npolluts * RECORDSIZE -
+          NAMETRAILER;
+    if (numNames == 0 || pos < p_data->IDPos + 3 * RECORDSIZE)
+        return -1;
+    if (readBytes(p_data, pos, trailer, NAMETRAILER) != NAMETRAILER ||
+        trailer[1] != NAMEMAGIC)
+        return -1;
+
+    // --- the index must fit after the names and match the file's counts
+    size = trailer[0];
+    if (size < 5 * RECORDSIZE || pos + NAMETRAILER - size < p_data->IDPos)
+        return -1;
+    pos = pos + NAMETRAILER - size;
+    if (readBytes(p_data, pos, header, 3 * RECORDSIZE) != 3 * RECORDSIZE ||
+        header[0] != NAMEMAGIC || header[1] != numNames || header[2] <= 0 ||
+        (header[2] & (header[2] - 1)) != 0 ||
+        size != (F_OFF)(5 + header[2] + numNames) * RECORDSIZE)
+        return -1;
+
+    p_data->nameSlots   = newIntArray(header[2]);
+    p_data->nameOffsets = newIntArray(numNames);
+    if (p_data->nameSlots == NULL || p_data->nameOffsets == NULL ||
+        readBytes(p_data, pos + 3 * RECORDSIZE, p_data->nameSlots,
+                  header[2] * RECORDSIZE) != header[2] * RECORDSIZE ||
+        readBytes(p_data, pos + (3 + (F_OFF)header[2]) * RECORDSIZE,
+                  p_data->nameOffsets,
+                  numNames * RECORDSIZE) != numNames * RECORDSIZE) {
+        free(p_data->nameSlots);
+        free(p_data->nameOffsets);
+        p_data->nameSlots   = NULL;
+        p_data->nameOffsets = NULL;
+        return -1;
+    }
+    p_data->nameSlotCount = header[2];
+    return 0;
+}
+
+int findName(data_t *p_data, const char *id, int first, int count) {
+    //
+    //  Purpose: Looks up a name in the name index, returning the index of
+    //  the element among the count names starting at first, or -1 if the
+    //  name is not found. Names held only in the file are read one at a
+    //  time as hash slots are probed.
+    //
+    int   i, j, k, len, n, found = -1;
+    INT4  length;
+    char *name = NULL;
+    const char *s;
+
+    len = (int)strlen(id);
+    j   = hashName(id) & (p_data->nameSlotCount - 1);
+    if (p_data->elementNames == NULL && (name = newCharArray(len + 1)) == NULL)
+        return -1;
+
+    for (n = 0; n < p_data->nameSlotCount; n++) {
+        k = p_data->nameSlots[j] - 1;
+        if (k < 0)
+            break;
+        j = (j + 1) & (p_data->nameSlotCount - 1);
+        if (k < first || k >= first + count)
+            continue;
+
+        // --- get the candidate name
+        if (p_data->elementNames != NULL) {
+            if (p_data->elementNames[k].length != len)
+                continue;
+            s = p_data->elementNames[k].IDname;
+        }
+        else {
+            if (readBytes(p_data, p_data->IDPos + p_data->nameOffsets[k],
+                          &length, RECORDSIZE) != RECORDSIZE ||
+                length != len ||
+                readBytes(p_data, p_data->IDPos + p_data->nameOffsets[k] +
+                                      RECORDSIZE, name, len) != len)
+                continue;
+            s = name;
+        }
+
+        // --- compare without regard to case
+        for (i = 0; i < len; i++)
+            if (UCHAR(s[i]) != UCHAR(id[i]))
+                break;
+        if (i == len) {
+            found = k - first;
+            break;
+        }
+    }
+    free(name);
+    return found;
+}
+
+unsigned int hashName(const char *name) {
+    //
+    //  Purpose: Computes the case insensitive FNV-1a hash of an element
+    //  name, as used by the SWMM engine when saving a name index.
+    //
+    unsigned int h = 2166136261u;
+
+    while (*name) {
+        h ^= (unsigned char)UCHAR(*name);
+        h *= 16777619u;
+        name++;
+    }
+    return h;
+}
+
 double getTimeValue(data_t *p_data, int timeIndex) {
 
     F_OFF  offset;
@@ -1036,8 +2032,7 @@ double getTimeValue(data_t *p_data, int timeIndex) {
     offset = p_data->ResultsPos + timeIndex * p_data->BytesPerPeriod;
 
     // --- re-position the file and read the result
-    _fseek(p_data->file, offset, SEEK_SET);
-    fread(&value, RECORDSIZE * 2, 1, p_data->file);
+    readResults(p_data, offset, &value, DATESIZE);
 
     return value;
 }
@@ -1055,8 +2050,7 @@ float getSubcatchValue(data_t *p_data, int timeIndex, int subcatchIndex,
     offset += RECORDSIZE * (subcatchIndex * p_data->SubcatchVars + attr);
 
     // --- re-position the file and read the result
-    _fseek(p_data->file, offset, SEEK_SET);
-    fread(&value, RECORDSIZE, 1, p_data->file);
+    readResults(p_data, offset, &value, RECORDSIZE);
 
     return value;
 }
@@ -1075,8 +2069,7 @@ float getNodeValue(data_t *p_data, int timeIndex, int nodeIndex,
                             nodeIndex * p_data->NodeVars + attr);
 
     // --- re-position the file and read the result
-    _fseek(p_data->file, offset, SEEK_SET);
-    fread(&value, RECORDSIZE, 1, p_data->file);
+    readResults(p_data, offset, &value, RECORDSIZE);
 
     return value;
 }
@@ -1096,8 +2089,7 @@ float getLinkValue(data_t *p_data, int timeIndex, int linkIndex,
                             linkIndex * p_data->LinkVars + attr);
 
     // --- re-position the file and read the result
-    _fseek(p_data->file, offset, SEEK_SET);
-    fread(&value, RECORDSIZE, 1, p_data->file);
+    readResults(p_data, offset, &value, RECORDSIZE);
 
     return value;
 }
@@ -1116,12 +2108,488 @@ float getSystemValue(data_t *p_data, int timeIndex, SMO_systemAttribute attr) {
                             p_data->Nlinks * p_data->LinkVars + attr);
 
     // --- re-position the file and read the result
-    _fseek(p_data->file, offset, SEEK_SET);
-    fread(&value, RECORDSIZE, 1, p_data->file);
+    readResults(p_data, offset, &value, RECORDSIZE);
 
     return value;
 }
 
+int getSeries(data_t *p_data, int column, int startPeriod, int length,
+    float *values) {
+    //
+    //  Purpose: Reads length values of result column starting at startPeriod,
+    //  using a single read from the series index when one is available.
+    //  Values that cannot be read are set to zero and error 436 returned.
+    //
+    int    k, errorcode = 0;
+    size_t n;
+    F_OFF  offset;
+
+    if (p_data->seriesFile != NULL && startPeriod + length <= p_data->Nperiods) {
+        offset = SERIESHEADER +
+                 ((F_OFF)column * p_data->Nperiods + startPeriod) * RECORDSIZE;
+        _fseek(p_data->seriesFile, offset, SEEK_SET);
+        n = fread(values, RECORDSIZE, length, p_data->seriesFile);
+        if (n < (size_t)length) {
+            memset(&values[n], 0, (length - n) * RECORDSIZE);
+            errorcode = 436;
+        }
+        return errorcode;
+    }
+
+    // --- otherwise read one value from each reporting period
+    for (k = 0; k < length; k++) {
+        offset = p_data->ResultsPos +
+                 (startPeriod + k) * p_data->BytesPerPeriod + 2 * RECORDSIZE +
+                 (F_OFF)column * RECORDSIZE;
+        if (readResults(p_data, offset, &values[k], RECORDSIZE) < RECORDSIZE)
+            errorcode = 436;
+    }
+    return errorcode;
+}
+
+int writeSeriesIndex(data_t *p_data) {
+    //
+    //  Purpose: Transposes the period-major results into the series index
+    //  one block of reporting periods at a time.
+    //
+    INT4   header[4];
+    int    c, k, t, nPeriods, blockSize, errorcode = 0;
+    float *block, *series;
+    FILE  *f = p_data->seriesFile;
+
+    nPeriods  = (int)p_data->Nperiods;
+    blockSize = SERIESBLOCK / (p_data->Ncolumns * RECORDSIZE + 1);
+    if (blockSize < 1)
+        blockSize = 1;
+    if (blockSize > nPeriods)
+        blockSize = nPeriods;
+
+    block  = newFloatArray(blockSize * p_data->Ncolumns);
+    series = newFloatArray(blockSize);
+    if (block == NULL || series == NULL) {
+        free(block);
+        free(series);
+        return 411;
+    }
+
+    // --- write header identifying the results the index was built from
+    header[0] = SERIESMAGIC;
+    header[1] = nPeriods;
+    header[2] = p_data->Ncolumns;
+    header[3] = p_data->ReportStep;
+    if (fwrite(header, RECORDSIZE, 4, f) != 4 ||
+        fwrite(&(p_data->StartDate), DATESIZE, 1, f) != 1)
+        errorcode = 437;
+
+    for (t = 0; t < nPeriods && errorcode == 0; t += blockSize) {
+        if (blockSize > nPeriods - t)
+            blockSize = nPeriods - t;
+
+        // --- read a block of periods sequentially, skipping each date
+        for (k = 0; k < blockSize; k++) {
+            if (readResults(p_data, p_data->ResultsPos + DATESIZE +
+                                        (t + k) * p_data->BytesPerPeriod,
+                            &block[k * p_data->Ncolumns],
+                            p_data->Ncolumns * RECORDSIZE) !=
+                p_data->Ncolumns * RECORDSIZE) {
+                errorcode = 436;
+                break;
+            }
+        }
+
+        // --- append the block to each column's series
+        for (c = 0; c < p_data->Ncolumns && errorcode == 0; c++) {
+            for (k = 0; k < blockSize; k++)
+                series[k] = block[k * p_data->Ncolumns + c];
+            _fseek(f, SERIESHEADER + ((F_OFF)c * nPeriods + t) * RECORDSIZE,
+                   SEEK_SET);
+            if (fwrite(series, RECORDSIZE, blockSize, f) != (size_t)blockSize)
+                errorcode = 437;
+        }
+    }
+
+    free(block);
+    free(series);
+    if (errorcode == 0 && fflush(f) != 0)
+        errorcode = 437;
+    return errorcode;
+}
+
+int validateSeriesIndex(data_t *p_data) {
+    //
+    //  Purpose: Checks that a series index matches the open output file.
+    //
+    INT4   header[4];
+    double startDate;
+    F_OFF  size;
+    FILE  *f = p_data->seriesFile;
+
+    if (fread(header, RECORDSIZE, 4, f) != 4 ||
+        fread(&startDate, DATESIZE, 1, f) != 1)
+        return 438;
+    if (header[0] != SERIESMAGIC || header[1] != p_data->Nperiods ||
+        header[2] != p_data->Ncolumns || header[3] != p_data->ReportStep ||
+        startDate != p_data->StartDate)
+        return 438;
+
+    // --- index must hold every value of every series
+    _fseek(f, 0, SEEK_END);
+    size = _ftell(f);
+    if (size < SERIESHEADER + (F_OFF)p_data->Ncolumns * p_data->Nperiods *
+                                  RECORDSIZE)
+        return 438;
+    return 0;
+}
+
+int readResults(data_t *p_data, F_OFF offset, void *dest, int nbytes) {
+    //
+    //  Purpose: Reads nbytes of the output file starting at offset, from
+    //  the memory mapping when the file has been mapped. Returns the number
+    //  of bytes read; any bytes that lie past the end of the results are
+    //  set to zero.
+    //
+    int n;
+
+    if (p_data->ChunkPeriods > 0)
+        n = readChunkResults(p_data, offset, (char *)dest, nbytes);
+    else
+        n = readBytes(p_data, offset, dest, nbytes);
+    if (n < 0)
+        n = 0;
+    if (n < nbytes)
+        memset((char *)dest + n, 0, nbytes - n);
+    return n;
+}
+
+int readBytes(data_t *p_data, F_OFF offset, void *dest, int nbytes) {
+    //
+    //  Purpose: Reads nbytes of the output file as stored starting at offset.
+    //
+    if (p_data->map != NULL) {
+        if (offset < 0 || offset + nbytes > p_data->mapSize)
+            return 0;
+        memcpy(dest, p_data->map + offset, nbytes);
+        return nbytes;
+    }
+    _fseek(p_data->file, offset, SEEK_SET);
+    return (int)fread(dest, 1, nbytes, p_data->file);
+}
+
+int readChunkResults(data_t *p_data, F_OFF offset, char *dest, int nbytes) {
+    //
+    //  Purpose: Reads nbytes of a compressed file's results starting at the
+    //  offset they would have in a standard output file.
+    //
+    int   n, k, count = 0;
+    long  period;
+    F_OFF pos;
+    float value;
+
+    pos    = offset - p_data->ResultsPos;
+    period = (long)(pos / p_data->BytesPerPeriod);
+    pos   -= period * p_data->BytesPerPeriod;
+
+    while (count < nbytes && pos >= 0 && period < p_data->Nperiods) {
+        // --- date of period
+        if (pos < DATESIZE) {
+            n = (int)(DATESIZE - pos);
+            if (n > nbytes - count)
+                n = nbytes - count;
+            memcpy(dest + count,
+                   (char *)&p_data->periodDates[period] + pos, n);
+        }
+        // --- result value
+        else {
+            value = getChunkValue(p_data, (int)period,
+                                  (int)((pos - DATESIZE) / RECORDSIZE));
+            k = (int)((pos - DATESIZE) % RECORDSIZE);
+            n = RECORDSIZE - k;
+            if (n > nbytes - count)
+                n = nbytes - count;
+            memcpy(dest + count, (char *)&value + k, n);
+        }
+        count += n;
+        pos += n;
+        if (pos == p_data->BytesPerPeriod) {
+            period++;
+            pos = 0;
+        }
+    }
+    return count;
+}
+
+float getChunkValue(data_t *p_data, int period, int column) {
+    //
+    //  Purpose: Returns a result value of a compressed file, decoding the
+    //  chunk that holds it when not already done.
+    //
+    int         row, block, k, n, m;
+    long long   size;
+    float      *values;
+
+    row   = period / p_data->ChunkPeriods;
+    block = column / p_data->ChunkColumns;
+    n     = (int)(p_data->Nperiods - (long)row * p_data->ChunkPeriods);
+    if (n > p_data->ChunkPeriods)
+        n = p_data->ChunkPeriods;
+    m = p_data->Ncolumns - block * p_data->ChunkColumns;
+    if (m > p_data->ChunkColumns)
+        m = p_data->ChunkColumns;
+    values = p_data->rowValues +
+             (F_OFF)block * p_data->ChunkColumns * p_data->ChunkPeriods;
+
+    // --- start a new row of periods
+    if (row != p_data->cachedRow) {
+        memset(p_data->rowDecoded, 0, p_data->ChunkBlocks);
+        p_data->cachedRow = row;
+    }
+
+    // --- read and decode the chunk
+    if (!p_data->rowDecoded[block]) {
+        k    = row * p_data->ChunkBlocks + block;
+        size = p_data->chunkIndex[2 * k + 1];
+        if (size < 0 || size > 4 * n * m + 4 * n * m / 128 + 16 ||
+            readBytes(p_data, p_data->chunkIndex[2 * k], p_data->packed,
+                           (int)size) != size ||
+            !decodeChunk(p_data, (int)size, n, m, values))
+            memset(values, 0, (size_t)n * m * sizeof(float));
+        p_data->rowDecoded[block] = 1;
+    }
+    return values[(column - block * p_data->ChunkColumns) * n +
+                  period - row * p_data->ChunkPeriods];
+}
+
+int decodeChunk(data_t *p_data, int size, int n, int m, float *values) {
+    //
+    //  Purpose: Expands the run-length encoded byte planes of a chunk and
+    //  undoes the XOR of each value with the one before it in its column.
+    //
+    int           i = 0, j, k, t, r, pos = 0, len, nWords = n * m;
+    unsigned int  w, prev;
+    unsigned char *in = p_data->packed, *planes = p_data->planes;
+
+    len = 4 * nWords;
+    while (i < size && pos < len) {
+        t = in[i++];
+        if (t < 128) {
+            r = t + 1;
+            if (i + r > size || pos + r > len)
+                return 0;
+            memcpy(&planes[pos], &in[i], r);
+            i += r;
+        }
+        else {
+            r = t - 126;
+            if (i >= size || pos + r > len)
+                return 0;
+            memset(&planes[pos], in[i++], r);
+        }
+        pos += r;
+    }
+    if (pos != len)
+        return 0;
+
+    for (j = 0; j < m; j++) {
+        prev = 0;
+        for (i = 0; i < n; i++) {
+            k = j * n + i;
+            w = (unsigned int)planes[k] |
+                ((unsigned int)planes[nWords + k] << 8) |
+                ((unsigned int)planes[2 * nWords + k] << 16) |
+                ((unsigned int)planes[3 * nWords + k] << 24);
+            prev ^= w;
+            memcpy(&values[k], &prev, sizeof(prev));
+        }
+    }
+    return 1;
+}
+
+int initChunks(data_t *p_data) {
+    //
+    //  Purpose: Reads the period dates and chunk index of a compressed file
+    //  and allocates the arrays used to decode its chunks.
+    //
+    int n, nChunks;
+
+    p_data->ChunkBlocks = (p_data->Ncolumns + p_data->ChunkColumns - 1) /
+                          p_data->ChunkColumns;
+    nChunks = (int)((p_data->Nperiods + p_data->ChunkPeriods - 1) /
+                    p_data->ChunkPeriods) * p_data->ChunkBlocks;
+    n = p_data->ChunkPeriods * p_data->ChunkColumns;
+
+    p_data->periodDates = (double *)calloc(p_data->Nperiods, sizeof(double));
+    p_data->chunkIndex  = (long long *)calloc(2 * nChunks, sizeof(long long));
+    p_data->rowValues   = newFloatArray(p_data->ChunkBlocks * n);
+    p_data->rowDecoded  = (char *)calloc(p_data->ChunkBlocks, sizeof(char));
+    p_data->packed      = (unsigned char *)malloc(4 * n + 4 * n / 128 + 16);
+    p_data->planes      = (unsigned char *)malloc(4 * n);
+    p_data->cachedRow   = -1;
+    if (!p_data->periodDates || !p_data->chunkIndex || !p_data->rowValues ||
+        !p_data->rowDecoded || !p_data->packed || !p_data->planes)
+        return 411;
+
+    _fseek(p_data->file, p_data->IndexPos, SEEK_SET);
+    if (fread(p_data->periodDates, DATESIZE, p_data->Nperiods, p_data->file) !=
+            (size_t)p_data->Nperiods ||
+        fread(p_data->chunkIndex, sizeof(long long), 2 * nChunks,
+              p_data->file) != (size_t)(2 * nChunks))
+        return 436;
+    return 0;
+}
+
+void freeChunks(data_t *p_data) {
+    //
+    //  Purpose: Frees the arrays used to read a compressed file.
+    //
+    free(p_data->periodDates);
+    free(p_data->chunkIndex);
+    free(p_data->rowValues);
+    free(p_data->rowDecoded);
+    free(p_data->packed);
+    free(p_data->planes);
+    p_data->periodDates = NULL;
+    p_data->chunkIndex  = NULL;
+    p_data->rowValues   = NULL;
+    p_data->rowDecoded  = NULL;
+    p_data->packed      = NULL;
+    p_data->planes      = NULL;
+}
+
+int getColumn(data_t *p_data, SMO_elementType type, int index, int attr) {
+    //
+    //  Purpose: Returns the position of an element attribute within a period's
+    //  results, -1 for a bad element index or -2 for a bad attribute.
+    //
+    switch (type) {
+        case SMO_subcatch:
+            if (index < 0 || index >= p_data->Nsubcatch)
+                return -1;
+            if (attr >= p_data->SubcatchVars)
+                return -2;
+            return index * p_data->SubcatchVars + attr;
+
+        case SMO_node:
+            if (index < 0 || index >= p_data->Nnodes)
+                return -1;
+            if (attr >= p_data->NodeVars)
+                return -2;
+            return p_data->Nsubcatch * p_data->SubcatchVars +
+                   index * p_data->NodeVars + attr;
+
+        case SMO_link:
+            if (index < 0 || index >= p_data->Nlinks)
+                return -1;
+            if (attr >= p_data->LinkVars)
+                return -2;
+            return p_data->Nsubcatch * p_data->SubcatchVars +
+                   p_data->Nnodes * p_data->NodeVars +
+                   index * p_data->LinkVars + attr;
+
+        case SMO_sys:
+            if (attr >= p_data->SysVars)
+                return -2;
+            return p_data->Ncolumns - p_data->SysVars + attr;
+
+        default:
+            return -2;
+    }
+}
+
+const char *getVariableName(data_t *p_data, SMO_elementType type, int attr) {
+    //
+    //  Purpose: Returns the column name of an element type's reporting
+    //  variable; pollutant concentrations are named after their pollutant.
+    //
+    static const char *subcatchNames[] = {"rainfall", "snow_depth",
+        "evap_loss", "infil_loss", "runoff_rate", "gwoutflow_rate",
+        "gwtable_elev", "soil_moisture"};
+    static const char *nodeNames[] = {"invert_depth", "hydraulic_head",
+        "stored_ponded_volume", "lateral_inflow", "total_inflow",
+        "flooding_losses"};
+    static const char *linkNames[] = {"flow_rate", "flow_depth",
+        "flow_velocity", "flow_volume", "capacity"};
+    static const char *sysNames[] = {"air_temp", "rainfall", "snow_depth",
+        "evap_infil_loss", "runoff_flow", "dry_weather_inflow",
+        "groundwater_inflow", "RDII_inflow", "direct_inflow",
+        "total_lateral_inflow", "flood_losses", "outfall_flows",
+        "volume_stored", "evap_rate", "potential_evap_rate"};
+    const char **names;
+    int          n, p;
+
+    switch (type) {
+        case SMO_subcatch:
+            names = subcatchNames;
+            n     = SMO_pollutant_conc_subcatch;
+            break;
+        case SMO_node:
+            names = nodeNames;
+            n     = SMO_pollutant_conc_node;
+            break;
+        case SMO_link:
+            names = linkNames;
+            n     = SMO_pollutant_conc_link;
+            break;
+        default:
+            return (attr < 15) ? sysNames[attr] : "";
+    }
+    if (attr < n)
+        return names[attr];
+    p = attr - n;
+    if (p < p_data->Npolluts)
+        return p_data->elementNames[p_data->Nsubcatch + p_data->Nnodes +
+                                    p_data->Nlinks + p].IDname;
+    return "";
+}
+
+int mapFile(data_t *p_data) {
+    //
+    //  Purpose: Maps the entire output file into memory read-only.
+    //
+    _fseek(p_data->file, 0, SEEK_END);
+    p_data->mapSize = _ftell(p_data->file);
+    if (p_data->mapSize <= 0 || (unsigned long long)p_data->mapSize > (size_t)-1)
+        return 439;
+
+#ifdef _WIN32
+    p_data->mapHandle = CreateFileMapping(
+        (HANDLE)_get_osfhandle(_fileno(p_data->file)), NULL, PAGE_READONLY,
+        0, 0, NULL);
+    if (p_data->mapHandle == NULL)
+        return 439;
+    p_data->map = (char *)MapViewOfFile(p_data->mapHandle, FILE_MAP_READ, 0, 0,
+                                        0);
+    if (p_data->map == NULL) {
+        CloseHandle(p_data->mapHandle);
+        p_data->mapHandle = NULL;
+        return 439;
+    }
+#else
+    p_data->map = (char *)mmap(NULL, (size_t)p_data->mapSize, PROT_READ,
+                               MAP_SHARED, fileno(p_data->file), 0);
+    if (p_data->map == MAP_FAILED) {
+        p_data->map = NULL;
+        return 439;
+    }
+#endif
+    return 0;
+}
+
+void unmapFile(data_t *p_data) {
+    //
+    //  Purpose: Releases the memory mapping of the output file.
+    //
+    if (p_data->map == NULL)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(p_data->map);
+    CloseHandle(p_data->mapHandle);
+    p_data->mapHandle = NULL;
+#else
+    munmap(p_data->map, (size_t)p_data->mapSize);
+#endif
+    p_data->map = NULL;
+}
+
 int _fopen(FILE **f, const char *name, const char *mode) {
     //
     //  Purpose: Substitute for fopen_s on platforms where it doesn't exist
@@ -75,9 +75,20 @@ int  main(int argc, char *argv[])
 //  where f1 = name of input file, f2 = name of report file, and
 //  f3 = name of binary output file if saved (or blank if not saved).
 //
+//  Command line to compile an input file is: swmm5 --compile f1 f2
+//
 {
      // --- check for proper number of command line arguments
-    if (argc == 4) {
+    if (argc == 4 && (strcmp(argv[1], "--compile") == 0 ||
+        strcmp(argv[1], "-c") == 0)) {
+        // --- compile the input file
+        if ( swmm_compile(argv[2], argv[3]) > 0 )
+            printf("\n\n... EPA-SWMM compile failed with errors.\n");
+        else
+            printf("\n\n... EPA-SWMM compiled input file successfully.\n");
+    }
+
+    else if (argc == 4) {
         // --- extract file names from command line arguments
         char *inputFile = argv[1];
         char *reportFile = argv[2];
@@ -118,8 +129,10 @@ int  main(int argc, char *argv[])
             printf("Commands:\n");
             printf("\t--help (-h)       Help Docs\n");
             printf("\t--version (-v)    Build Version\n");
+            printf("\t--compile (-c)    Compile Input File\n");
             printf("\nUsage:\n");
-            printf("\t swmm5 <input file> <report file> <output file>\n\n");
+            printf("\t swmm5 <input file> <report file> <output file>\n");
+            printf("\t swmm5 --compile <input file> <report file>\n\n");
         }
         else if (strcmp(arg1, "--version") == 0 || strcmp(arg1, "-v") == 0) {
             int version = swmm_getVersion();
@@ -32,6 +32,16 @@
 //   Build 5.1.013:
 //   - Reads names of monthly adjustment patterns for various parameters
 //     of a subcatchment from the [ADJUSTMENTS] section of input file.
+//
+//   Build 5.1.015:
+//   - Daily climate file values for the entire simulation period are read
+//     once at the start of a run and can be saved to or used from a binary
+//     climate table file.
+//   - Daily temperature, evaporation and wind quantities are precomputed
+//     into a table that is indexed by simulation day.
+//   - climate_snapshot() added to save and restore climate state.
+//   - A climate table file records the name, size and modification time of
+//     the climate file it was made from and is rejected if they change.
 ///-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -39,6 +49,8 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #include "headers.h" 
 
 //-----------------------------------------------------------------------------
@@ -72,21 +84,27 @@ typedef struct
     int       front;         // index of front of moving average window
 } TMovAve;
 
+typedef struct
+{
+    double    tmin;          // min. daily temperature (deg F)
+    double    tmax;          // max. daily temperature (deg F)
+    double    trng;          // 1/2 range of daily temperatures
+    double    trng1;         // prev. max - current min. temp.
+    double    tave;          // average daily temperature (deg F)
+    double    hrsr;          // time of min. temp. (hrs)
+    double    hrss;          // time of max. temp (hrs)
+    double    hrday;         // avg. of min/max temp times
+    double    dhrdy;         // hrs. between min. & max. temp. times
+    double    dydif;         // hrs. between max. & min. temp. times
+    double    evap;          // daily evaporation (user units)
+    double    wind;          // daily wind speed (mph)
+} TClimateDay;
+
 
 //-----------------------------------------------------------------------------
 //  Shared variables
 //-----------------------------------------------------------------------------
 // Temperature variables
-static double    Tmin;                 // min. daily temperature (deg F)
-static double    Tmax;                 // max. daily temperature (deg F)
-static double    Trng;                 // 1/2 range of daily temperatures
-static double    Trng1;                // prev. max - current min. temp.
-static double    Tave;                 // average daily temperature (deg F)
-static double    Hrsr;                 // time of min. temp. (hrs)
-static double    Hrss;                 // time of max. temp (hrs)
-static double    Hrday;                // avg. of min/max temp times
-static double    Dhrdy;                // hrs. between min. & max. temp. times
-static double    Dydif;                // hrs. between max. & min. temp. times
 static DateTime  LastDay;              // date of last day with temp. data
 static TMovAve   Tma;                  // moving average of daily temperatures
 
@@ -109,6 +127,15 @@ static int      FileFieldPos[4];       // start of data fields for file record
 static int      FileDateFieldPos;      // start of date field for file record 
 static int      FileWindType;          // wind speed type
 
+// Daily climate tables
+static int          FileDays;          // number of days in FileTable
+static double*      FileTable;         // daily climate file values
+static int          NumDays;           // number of days in DayTable
+static TClimateDay* DayTable;          // daily climate quantities
+static TClimateDay* Today;             // current day's entry in DayTable
+
+static const char* TableFileStamp = "SWMM5-CLIMATE2";
+
 //-----------------------------------------------------------------------------
 //  External functions (defined in funcs.h)
 //-----------------------------------------------------------------------------
@@ -117,8 +144,10 @@ static int      FileWindType;          // wind speed type
 //  climate_validate                   // called by project_validate
 //  climate_openFile                   // called by runoff_open
 //  climate_initState                  // called by project_init
+//  climate_close                      // called by project_close
 //  climate_setState                   // called by runoff_execute
 //  climate_getNextEvapDate            // called by runoff_getTimeStep
+//  climate_snapshot                   // called by visitState in snapshot.c
 
 //-----------------------------------------------------------------------------
 //  Local functions
@@ -134,11 +163,17 @@ static void setNextEvapDate(DateTime thedate);
 static void setEvap(DateTime theDate);
 static void setTemp(DateTime theDate);
 static void setWind(DateTime theDate);
-static void updateTempTimes(int day);
+static void updateTempTimes(int day, TClimateDay* c);
 static void updateTempMoveAve(double tmin, double tmax);
 static double getTempEvap(int day, double ta, double tr);
 
-static void updateFileValues(DateTime theDate);
+static void readNextFileDay(void);
+static void loadFileTable(void);
+static void readTableFile(void);
+static void saveTableFile(void);
+static void getSourceStamp(long long* size, long long* mtime);
+static void createDayTable(void);
+static void setDayValues(DateTime theDate);
 static void parseUserFileLine(void);
 static void parseTD3200FileLine(void);
 static void parseDLY0204FileLine(void);
@@ -486,7 +521,9 @@ void climate_validate()
     }
 
     // --- open the climate data file
-    if ( Fclimate.mode == USE_FILE ) climate_openFile();
+    //     (not needed if its values come from a saved climate table file)
+    if ( Fclimate.mode == USE_FILE && Fclimtable.mode != USE_FILE )
+        climate_openFile();
 
     // --- snow melt parameters tipm & rnm must be fractions
     if ( Snow.tipm < 0.0 ||
@@ -591,6 +628,7 @@ void climate_initState()
 //
 {
     LastDay = NO_DATE;
+    Today = NULL;
     Temp.tmax = MISSING;
     Snow.removed = 0.0;
     NextEvapDate = StartDate;
@@ -622,6 +660,59 @@ void climate_initState()
         Tma.tAve = 0.0;
         Tma.tRng = 0.0;
     }
+
+    // --- read the climate file's daily values for the simulation period
+    //     (only once, since the climate file is closed afterwards)
+    if ( Fclimate.mode == USE_FILE && FileTable == NULL )
+    {
+        if ( Fclimtable.mode == USE_FILE ) readTableFile();
+        else
+        {
+            loadFileTable();
+            if ( Fclimtable.mode == SAVE_FILE ) saveTableFile();
+        }
+    }
+
+    // --- precompute the daily climate quantities derived from these values
+    if ( Fclimate.mode == USE_FILE && !ErrorCode ) createDayTable();
+}
+
+//=============================================================================
+
+void climate_close()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees memory used for daily climate tables.
+//
+{
+    FREE(FileTable);
+    FREE(DayTable);
+    FileDays = 0;
+    NumDays = 0;
+    Today = NULL;
+}
+
+//=============================================================================
+
+void climate_snapshot(TSnapshot* s)
+//
+//  Input:   s = a simulation state snapshot
+//  Output:  none
+//  Purpose: saves or restores the current climate conditions.
+//
+{
+    snapshot_add(s, &Temp, sizeof(TTemp));
+    snapshot_add(s, &Evap, sizeof(TEvap));
+    snapshot_add(s, &Wind, sizeof(TWind));
+    snapshot_add(s, &Snow, sizeof(TSnow));
+    snapshot_add(s, &Adjust, sizeof(TAdjust));
+    snapshot_add(s, &LastDay, sizeof(DateTime));
+    snapshot_add(s, &Tma, sizeof(TMovAve));
+    snapshot_add(s, &NextEvapDate, sizeof(DateTime));
+    snapshot_add(s, &NextEvapRate, sizeof(double));
+    snapshot_add(s, FileValue, sizeof(FileValue));
+    snapshot_add(s, &Today, sizeof(TClimateDay*));
 }
 
 //=============================================================================
@@ -633,7 +724,7 @@ void climate_setState(DateTime theDate)
 //  Purpose: sets climate variables for current date.
 //
 {
-    if ( Fclimate.mode == USE_FILE ) updateFileValues(theDate);
+    if ( Fclimate.mode == USE_FILE ) setDayValues(theDate);
     if ( Temp.dataSource != NO_TEMP ) setTemp(theDate);
     setEvap(theDate);
     setWind(theDate);
@@ -719,11 +810,11 @@ void setNextEvapDate(DateTime theDate)
 
 //=============================================================================
 
-void updateFileValues(DateTime theDate)
+void readNextFileDay()
 //
-//  Input:   theDate = current simulation date
+//  Input:   none
 //  Output:  none
-//  Purpose: updates daily climate variables for new day or reads in
+//  Purpose: updates daily climate file values for the next day or reads in
 //           another month worth of values if a new month begins.
 //
 //  NOTE:    counters FileElapsedDays, FileDay, FileMonth, FileYear and
@@ -731,42 +822,268 @@ void updateFileValues(DateTime theDate)
 //
 {
     int i;
-    int deltaDays;
 
-    // --- see if a new day has begun
-    deltaDays = (int)(floor(theDate) - floor(StartDateTime));
-    if ( deltaDays > FileElapsedDays )
-    {
-        // --- advance day counters
-        FileElapsedDays++;
-        FileDay++;
+    // --- advance day counters
+    FileElapsedDays++;
+    FileDay++;
 
-        // --- see if new month of data needs to be read from file
-        if ( FileDay > FileLastDay )
+    // --- see if new month of data needs to be read from file
+    if ( FileDay > FileLastDay )
+    {
+        FileMonth++;
+        if ( FileMonth > 12 )
         {
-            FileMonth++;
-            if ( FileMonth > 12 )
-            {
-                FileMonth = 1;
-                FileYear++;
-            }
-            readFileValues();
-            FileDay = 1;
-            FileLastDay = datetime_daysPerMonth(FileYear, FileMonth);
+            FileMonth = 1;
+            FileYear++;
         }
+        readFileValues();
+        FileDay = 1;
+        FileLastDay = datetime_daysPerMonth(FileYear, FileMonth);
+    }
 
-        // --- set climate variables for new day
-        for (i=TMIN; i<=WIND; i++)
+    // --- set climate variables for new day
+    for (i=TMIN; i<=WIND; i++)
+    {
+        // --- no change in current value if its missing
+        if ( FileData[i][FileDay] == MISSING ) continue;
+        FileValue[i] = FileData[i][FileDay];
+    }
+}
+
+//=============================================================================
+
+void loadFileTable()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: reads the climate file's values for each day of the simulation
+//           period into FileTable and then closes the climate file.
+//
+{
+    int d, i;
+
+    if ( Fclimate.file == NULL ) return;
+    FileDays = (int)(floor(EndDateTime) - floor(StartDateTime)) + 1;
+    FileTable = (double *) calloc(FileDays*MAXCLIMATEVARS, sizeof(double));
+    if ( FileTable == NULL )
+    {
+        report_writeErrorMsg(ERR_MEMORY, "");
+        return;
+    }
+
+    // --- FileValue already holds the first day's values
+    //     (see climate_openFile)
+    for (d = 0; d < FileDays; d++)
+    {
+        if ( d > 0 ) readNextFileDay();
+        if ( ErrorCode ) break;
+        for (i=TMIN; i<=WIND; i++) FileTable[d*MAXCLIMATEVARS+i] = FileValue[i];
+    }
+    fclose(Fclimate.file);
+    Fclimate.file = NULL;
+}
+
+//=============================================================================
+
+void readTableFile()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: reads the daily climate file values for the simulation period
+//           from a previously saved climate table file.
+//
+//  The file contains a stamp string, the unit system, the date on which
+//  reading of the climate file began, the number of days saved, the name,
+//  size and modification time of the climate file and then the daily
+//  TMIN, TMAX, EVAP and WIND values.
+//
+{
+    FILE*     f;
+    int       unitSystem, nDays;
+    DateTime  fileStart;
+    char      fStamp[16] = "";
+    char      fName[MAXFNAME+1] = "";
+    long long fSize, fTime, size, mtime;
+
+    if ( (f = fopen(Fclimtable.name, "rb")) == NULL )
+    {
+        report_writeErrorMsg(ERR_CLIMATE_FILE_OPEN, Fclimtable.name);
+        return;
+    }
+
+    // --- check that file was made from the current version of the same
+    //     climate file, for the same units, starting date and at least as
+    //     many days as the current run needs
+    FileDays = (int)(floor(EndDateTime) - floor(StartDateTime)) + 1;
+    getSourceStamp(&size, &mtime);
+    if ( fread(fStamp, sizeof(char), strlen(TableFileStamp), f) <
+             strlen(TableFileStamp) ||
+         fread(&unitSystem, sizeof(int), 1, f) < 1 ||
+         fread(&fileStart, sizeof(DateTime), 1, f) < 1 ||
+         fread(&nDays, sizeof(int), 1, f) < 1 ||
+         fread(fName, sizeof(char), MAXFNAME+1, f) < MAXFNAME+1 ||
+         fread(&fSize, sizeof(long long), 1, f) < 1 ||
+         fread(&fTime, sizeof(long long), 1, f) < 1 ||
+         strcmp(fStamp, TableFileStamp) != 0 ||
+         fName[MAXFNAME] != '\0' ||
+         strcmp(fName, Fclimate.name) != 0 ||
+         size < 0 || fSize != size || fTime != mtime ||
+         unitSystem != UnitSystem ||
+         fileStart != (Temp.fileStartDate == NO_DATE ?
+                       StartDate : Temp.fileStartDate) ||
+         nDays < FileDays )
+    {
+        report_writeErrorMsg(ERR_CLIMATE_FILE_READ, Fclimtable.name);
+        fclose(f);
+        return;
+    }
+
+    // --- read the daily values
+    FileTable = (double *) calloc(FileDays*MAXCLIMATEVARS, sizeof(double));
+    if ( FileTable == NULL ) report_writeErrorMsg(ERR_MEMORY, "");
+    else if ( fread(FileTable, sizeof(double), FileDays*MAXCLIMATEVARS, f)
+              < (size_t)(FileDays*MAXCLIMATEVARS) )
+    {
+        report_writeErrorMsg(ERR_CLIMATE_FILE_READ, Fclimtable.name);
+    }
+    fclose(f);
+}
+
+//=============================================================================
+
+void saveTableFile()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: saves the daily climate file values for the simulation period
+//           to a binary climate table file (see readTableFile).
+//
+{
+    FILE*     f;
+    DateTime  fileStart;
+    char      fName[MAXFNAME+1];
+    long long size, mtime;
+
+    if ( ErrorCode || FileTable == NULL ) return;
+    if ( (f = fopen(Fclimtable.name, "wb")) == NULL )
+    {
+        report_writeErrorMsg(ERR_CLIMATE_FILE_OPEN, Fclimtable.name);
+        return;
+    }
+    fileStart = Temp.fileStartDate;
+    if ( fileStart == NO_DATE ) fileStart = StartDate;
+    fwrite(TableFileStamp, sizeof(char), strlen(TableFileStamp), f);
+    fwrite(&UnitSystem, sizeof(int), 1, f);
+    fwrite(&fileStart, sizeof(DateTime), 1, f);
+    fwrite(&FileDays, sizeof(int), 1, f);
+    memset(fName, 0, sizeof(fName));
+    sstrncpy(fName, Fclimate.name, MAXFNAME);
+    getSourceStamp(&size, &mtime);
+    fwrite(fName, sizeof(char), MAXFNAME+1, f);
+    fwrite(&size, sizeof(long long), 1, f);
+    fwrite(&mtime, sizeof(long long), 1, f);
+    fwrite(FileTable, sizeof(double), FileDays*MAXCLIMATEVARS, f);
+    fclose(f);
+}
+
+//=============================================================================
+
+void getSourceStamp(long long* size, long long* mtime)
+//
+//  Input:   none
+//  Output:  size = size of climate file in bytes (-1 if not found)
+//           mtime = time climate file was last modified
+//  Purpose: identifies the version of the climate file a climate table
+//           file is made from.
+//
+{
+    struct stat st;
+
+    *size = -1;
+    *mtime = 0;
+    if ( stat(Fclimate.name, &st) != 0 ) return;
+    *size = (long long)st.st_size;
+    *mtime = (long long)st.st_mtime;
+}
+
+//=============================================================================
+
+void createDayTable()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: computes the daily min/max temperatures, their times of day,
+//           evaporation and wind speed for each day of the simulation
+//           period from the climate file values in FileTable.
+//
+{
+    int          d, k, mon, day;
+    DateTime     theDay;
+    double       tmp;
+    TClimateDay* c;
+
+    FREE(DayTable);
+    NumDays = (int)(floor(EndDateTime) - floor(StartDateTime)) + 1;
+    DayTable = (TClimateDay *) calloc(NumDays, sizeof(TClimateDay));
+    if ( DayTable == NULL )
+    {
+        report_writeErrorMsg(ERR_MEMORY, "");
+        return;
+    }
+
+    for (d = 0; d < NumDays; d++)
+    {
+        c = &DayTable[d];
+        k = MIN(d, FileDays-1) * MAXCLIMATEVARS;
+        theDay = floor(StartDateTime) + d;
+        mon = datetime_monthOfYear(theDay);
+        day = datetime_dayOfYear(theDay);
+        c->evap = FileTable[k+EVAP];
+        c->wind = FileTable[k+WIND];
+
+        // --- update min. & max. temps & their time of day
+        if ( Temp.dataSource == FILE_TEMP )
         {
-            // --- no change in current value if its missing
-            if ( FileData[i][FileDay] == MISSING ) continue;
-            FileValue[i] = FileData[i][FileDay];
+            c->tmin = FileTable[k+TMIN] + Adjust.temp[mon-1];
+            c->tmax = FileTable[k+TMAX] + Adjust.temp[mon-1];
+            if ( c->tmin > c->tmax )
+            {
+                tmp = c->tmin;
+                c->tmin = c->tmax;
+                c->tmax = tmp;
+            }
+            updateTempTimes(day, c);
+            if ( Evap.type == TEMPERATURE_EVAP )
+            {
+                updateTempMoveAve(c->tmin, c->tmax);
+                c->evap = getTempEvap(day, Tma.tAve, Tma.tRng);
+            }
         }
     }
 }
 
 //=============================================================================
 
+void setDayValues(DateTime theDate)
+//
+//  Input:   theDate = current simulation date
+//  Output:  none
+//  Purpose: retrieves the daily climate quantities for the current date.
+//
+{
+    int d;
+
+    if ( DayTable == NULL ) return;
+    d = (int)(floor(theDate) - floor(StartDateTime));
+    if ( d < 0 ) d = 0;
+    if ( d >= NumDays ) d = NumDays - 1;
+    Today = &DayTable[d];
+    FileValue[EVAP] = Today->evap;
+    FileValue[WIND] = Today->wind;
+}
+
+//=============================================================================
+
 void setTemp(DateTime theDate)
 //
 //  Input:   theDate = simulation date
@@ -780,34 +1097,16 @@ void setTemp(DateTime theDate)
     int      day;                      // day of year
     DateTime theDay;                   // calendar day
     double   hour;                     // hour of day
-    double   tmp;                      // temporary temperature
 
     // --- see if a new day has started
     mon = datetime_monthOfYear(theDate);
     theDay = floor(theDate);
     if ( theDay > LastDay )
     {
-        // --- update min. & max. temps & their time of day
-        day = datetime_dayOfYear(theDate);
-        if ( Temp.dataSource == FILE_TEMP )
-        {
-            Tmin = FileValue[TMIN] + Adjust.temp[mon-1];
-            Tmax = FileValue[TMAX] + Adjust.temp[mon-1];
-            if ( Tmin > Tmax )
-            {
-                tmp = Tmin;
-                Tmin = Tmax;
-                Tmax = tmp;
-            }
-            updateTempTimes(day);
-            if ( Evap.type == TEMPERATURE_EVAP )
-            {
-                updateTempMoveAve(Tmin, Tmax); 
-                FileValue[EVAP] = getTempEvap(day, Tma.tAve, Tma.tRng);
-            }
-        }
-
         // --- compute snow melt coefficients based on day of year
+        //     (min. & max. temps & their time of day were
+        //     precomputed in createDayTable)
+        day = datetime_dayOfYear(theDate);
         Snow.season = sin(0.0172615*(day-81.0));
         for (j=0; j<Nobjects[SNOWMELT]; j++)
         {
@@ -820,15 +1119,18 @@ void setTemp(DateTime theDate)
 
     // --- for min/max daily temps. from climate file,
     //     compute hourly temp. by sinusoidal interp.
-    if ( Temp.dataSource == FILE_TEMP )
+    if ( Temp.dataSource == FILE_TEMP && Today != NULL )
     {
         hour = (theDate - theDay) * 24.0;
-        if ( hour < Hrsr )
-            Temp.ta = Tmin + Trng1/2.0 * sin(PI/Dydif * (Hrsr - hour));
-        else if ( hour >= Hrsr && hour <= Hrss )
-            Temp.ta = Tave + Trng * sin(PI/Dhrdy * (Hrday - hour));
+        if ( hour < Today->hrsr )
+            Temp.ta = Today->tmin + Today->trng1/2.0 *
+                      sin(PI/Today->dydif * (Today->hrsr - hour));
+        else if ( hour >= Today->hrsr && hour <= Today->hrss )
+            Temp.ta = Today->tave + Today->trng *
+                      sin(PI/Today->dhrdy * (Today->hrday - hour));
         else
-            Temp.ta = Tmax - Trng * sin(PI/Dydif * (hour - Hrss));
+            Temp.ta = Today->tmax - Today->trng *
+                      sin(PI/Today->dydif * (hour - Today->hrss));
     }
 
     // --- for user-supplied temperature time series,
@@ -934,9 +1236,10 @@ void setWind(DateTime theDate)
 
 //=============================================================================
 
-void updateTempTimes(int day)
+void updateTempTimes(int day, TClimateDay* c)
 //
 //  Input:   day = day of year
+//           c = daily climate quantities with min/max temperatures assigned
 //  Output:  none
 //  Purpose: computes time of day when min/max temperatures occur.
 //           (min. temp occurs at sunrise, max. temp. at 3 hrs. < sunset)
@@ -952,16 +1255,16 @@ void updateTempTimes(int day)
     else if ( arg >= 1.0 )  arg = 0.0;
     else                    arg = acos(arg);
     hrang = 3.8197 * arg;
-    Hrsr  = 12.0 - hrang + Temp.dtlong;
-    Hrss  = 12.0 + hrang + Temp.dtlong - 3.0;
-    Dhrdy = Hrsr - Hrss;
-    Dydif = 24.0 + Hrsr - Hrss;
-    Hrday = (Hrsr + Hrss) / 2.0;
-    Tave  = (Tmin + Tmax) / 2.0;
-    Trng  = (Tmax - Tmin) / 2.0;
-    if ( Temp.tmax == MISSING ) Trng1 = Tmax - Tmin;
-    else                        Trng1 = Temp.tmax - Tmin;
-    Temp.tmax = Tmax;
+    c->hrsr  = 12.0 - hrang + Temp.dtlong;
+    c->hrss  = 12.0 + hrang + Temp.dtlong - 3.0;
+    c->dhrdy = c->hrsr - c->hrss;
+    c->dydif = 24.0 + c->hrsr - c->hrss;
+    c->hrday = (c->hrsr + c->hrss) / 2.0;
+    c->tave  = (c->tmin + c->tmax) / 2.0;
+    c->trng  = (c->tmax - c->tmin) / 2.0;
+    if ( Temp.tmax == MISSING ) c->trng1 = c->tmax - c->tmin;
+    else                        c->trng1 = Temp.tmax - c->tmin;
+    Temp.tmax = c->tmax;
 }
 
 //=============================================================================
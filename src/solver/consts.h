@@ -24,6 +24,7 @@
 #define   SEMVERSION_LEN     20             // Version String Len
 
 #define   MAGICNUMBER        516114522
+#define   MAGICNUMBER2       516114530      // Ends compressed output file     //(5.1.015)
 #define   EOFMARK            0x1A           // Use 0x04 for UNIX systems
 #define   MAXTITLE           3              // Max. # title lines
 #define   MAXMSG             1024           // Max. # characters in message text
@@ -50,6 +50,10 @@
 //  - Support added for DAYOFYEAR attribute.
 //  - Modulated controls no longer included in reported control actions.
 //
+//  Build 5.1.015:
+//  - controls_usesTseries() added.
+//  - controls_snapshot() added.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -156,6 +160,8 @@ DateTime CurrentTime;                  // current time of day (decimal)
 //     controls_delete
 //     controls_addRuleClause
 //     controls_evaluate
+//     controls_usesTseries
+//     controls_snapshot
 
 //-----------------------------------------------------------------------------
 //  Local functions
@@ -344,6 +350,59 @@ int controls_evaluate(DateTime currentTime, DateTime elapsedTime, double tStep)
 
 //=============================================================================
 
+int controls_usesTseries(int k)
+//
+//  Input:   k = time series index
+//  Output:  returns TRUE if time series is used by a control rule action
+//  Purpose: checks if any modulated control action uses a time series.
+//
+{
+    int    r;                          // control rule index
+    struct TAction* a;                 // pointer to rule action clause
+
+    for (r = 0; r < RuleCount; r++)
+    {
+        for (a = Rules[r].thenActions; a; a = a->next)
+        {
+            if ( a->tseries == k ) return TRUE;
+        }
+        for (a = Rules[r].elseActions; a; a = a->next)
+        {
+            if ( a->tseries == k ) return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+//=============================================================================
+
+void controls_snapshot(TSnapshot* s)
+//
+//  Input:   s = a simulation state snapshot
+//  Output:  none
+//  Purpose: saves or restores the set point errors of PID control actions.
+//
+{
+    int    r;                          // control rule index
+    struct TAction* a;                 // pointer to rule action clause
+
+    for (r = 0; r < RuleCount; r++)
+    {
+        for (a = Rules[r].thenActions; a; a = a->next)
+        {
+            snapshot_add(s, &a->e1, sizeof(double));
+            snapshot_add(s, &a->e2, sizeof(double));
+        }
+        for (a = Rules[r].elseActions; a; a = a->next)
+        {
+            snapshot_add(s, &a->e1, sizeof(double));
+            snapshot_add(s, &a->e2, sizeof(double));
+        }
+    }
+}
+
+//=============================================================================
+
 int  addPremise(int r, int type, char* tok[], int nToks)
 //
 //  Input:   r = control rule index
@@ -49,6 +49,9 @@
 //   - updateNodeFlows() modified to subtract conduit evap. and seepage losses
 //     from downstream node inflow instead of upstream node outflow.
 //
+//   Build 5.1.015:
+//   - New function dynwave_snapshot() saves and restores the routing state.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -177,6 +180,21 @@ void  dynwave_close()
 
 //=============================================================================
 
+void dynwave_snapshot(TSnapshot* s)
+//
+//  Input:   s = a simulation state snapshot
+//  Output:  none
+//  Purpose: saves or restores the state of dynamic wave routing.
+//
+{
+    snapshot_add(s, &VariableStep, sizeof(double));
+    snapshot_add(s, Xnode, Nobjects[NODE] * sizeof(TXnode));
+    snapshot_add(s, &Omega, sizeof(double));
+    snapshot_add(s, &Steps, sizeof(int));
+}
+
+//=============================================================================
+
 void dynwave_validate()
 //
 //  Input:   none
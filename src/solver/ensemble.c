@@ -0,0 +1,384 @@
+//-----------------------------------------------------------------------------
+//   ensemble.c
+//
+//   Project:  EPA SWMM5
+//   Version:  5.1
+//   Date:     (Build 5.1.015)
+//
+//   Forking of a running simulation into an ensemble of member processes.
+//
+//   Each ensemble member is a child process created with the operating
+//   system's fork(), so it starts with the simulation exactly as it stood
+//   in the forking process. All project data are shared with the other
+//   members copy-on-write: the input data, which a simulation never
+//   changes, stays shared for the life of the ensemble, while the pages
+//   holding a member's dynamic state are copied only as it changes them.
+//   Members can then be given different rainfall or control settings
+//   through the toolkit API and stepped in parallel, without re-reading
+//   the input file or repeating the simulation up to the fork.
+//
+//   Files open at the time of the fork are not shared. Files being written
+//   (report, binary output, recording, routing interface, hot start and LID
+//   report files) are copied to new files for each member, named after the
+//   original with "_<member>" added before the extension, and scratch files
+//   are copied to new scratch files. Files being read are opened again in
+//   each member at the position reached. Members therefore never move each
+//   other's file positions.
+//
+//   Forking is only available on systems that support fork(). The
+//   swmm_fork() and swmm_waitForks() functions built on it are exported
+//   but kept out of toolkit.h, since an ensemble of processes is to be
+//   replaced by members copied within one process once project data can
+//   be held in a per-project context.
+//
+//-----------------------------------------------------------------------------
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdlib.h>
+#include <string.h>
+#if !defined(_WIN32)
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "headers.h"
+
+#if !defined(_WIN32)
+
+//-----------------------------------------------------------------------------
+//  Constants
+//-----------------------------------------------------------------------------
+#define COPY_BLOCK 65536               // size of file copying buffer (bytes)
+
+//-----------------------------------------------------------------------------
+//  Data Structures
+//-----------------------------------------------------------------------------
+typedef struct
+{
+    FILE*   file;                      // open file
+    TFile*  tfile;                     // project file it belongs to (or NULL)
+    char    name[MAXFNAME+1];          // file's name
+    int     writable;                  // TRUE if file open for writing
+    off_t   offset;                    // file offset at time of fork
+    off_t   size;                      // file size at time of fork
+}  TForkFile;
+
+//-----------------------------------------------------------------------------
+//  Shared variables
+//-----------------------------------------------------------------------------
+static TForkFile*  ForkFiles;          // files open when forking
+static int         NumForkFiles;       // number of open files
+static int         MaxForkFiles;       // size of ForkFiles array
+static pid_t*      Members;            // process id of each member forked
+static int         NumMembers;         // number of members forked
+
+//-----------------------------------------------------------------------------
+//  External functions (declared in funcs.h)
+//-----------------------------------------------------------------------------
+//  ensemble_fork           (called by swmm_fork in toolkit.c)
+//  ensemble_wait           (called by swmm_waitForks in toolkit.c)
+//  ensemble_addFile        (called by lid_addEnsembleFiles in lid.c)
+
+//-----------------------------------------------------------------------------
+//  Local functions
+//-----------------------------------------------------------------------------
+static int  addProjectFiles(void);
+static void addTFile(TFile* f);
+static int  separateFile(TForkFile* f, int member);
+static int  getMemberFileName(TForkFile* f, int member, char* name);
+static int  copyFile(TForkFile* f, int fd);
+
+#endif
+
+//=============================================================================
+
+int ensemble_fork(int count, int* member)
+//
+//  Input:   count = number of ensemble members to create
+//  Output:  member = 0 in the calling process or the member number (starting
+//                    from 1) in each new member process;
+//           returns TRUE if successful, FALSE if not
+//  Purpose: forks the running simulation into new member processes.
+//
+{
+#if defined(_WIN32)
+    *member = 0;
+    return FALSE;
+#else
+    int    i, k;
+    pid_t  pid;
+    pid_t* members;
+
+    *member = 0;
+    if ( count < 1 ) return FALSE;
+    members = (pid_t *) realloc(Members, (NumMembers + count) * sizeof(pid_t));
+    if ( members == NULL ) return FALSE;
+    Members = members;
+
+    // --- empty all output buffers so that no member writes them again
+    //     and note the state of each open file
+    fflush(NULL);
+    if ( !addProjectFiles() )
+    {
+        FREE(ForkFiles);
+        return FALSE;
+    }
+
+    for (k = 1; k <= count; k++)
+    {
+        pid = fork();
+        if ( pid < 0 ) break;
+
+        // --- a new member gets files of its own & has no members itself
+        if ( pid == 0 )
+        {
+            *member = NumMembers + 1;
+            FREE(Members);
+            NumMembers = 0;
+            for (i = 0; i < NumForkFiles; i++)
+            {
+                if ( !separateFile(&ForkFiles[i], *member) ) break;
+            }
+            FREE(ForkFiles);
+            return (i == NumForkFiles);
+        }
+        Members[NumMembers] = pid;
+        NumMembers++;
+    }
+    FREE(ForkFiles);
+    return (k > count);
+#endif
+}
+
+//=============================================================================
+
+int ensemble_wait(int* failures)
+//
+//  Input:   none
+//  Output:  failures = number of members that did not end normally;
+//           returns number of members waited for
+//  Purpose: waits for all member processes forked by this process to end.
+//
+{
+#if defined(_WIN32)
+    *failures = 0;
+    return 0;
+#else
+    int i, n, status;
+
+    *failures = 0;
+    for (i = 0; i < NumMembers; i++)
+    {
+        if ( waitpid(Members[i], &status, 0) != Members[i] ||
+             !WIFEXITED(status) || WEXITSTATUS(status) != 0 )
+        {
+            (*failures)++;
+        }
+    }
+    n = NumMembers;
+    FREE(Members);
+    NumMembers = 0;
+    return n;
+#endif
+}
+
+//=============================================================================
+
+void ensemble_addFile(FILE* f, char* name)
+//
+//  Input:   f = an open file (or NULL)
+//           name = the file's name
+//  Output:  none
+//  Purpose: adds a file that is not one of the project's TFile files to
+//           the files separated from each new ensemble member.
+//
+{
+#if !defined(_WIN32)
+    int         fd, flags;
+    struct stat st;
+    TForkFile*  files;
+
+    if ( f == NULL || MaxForkFiles < 0 ) return;
+    if ( NumForkFiles == MaxForkFiles )
+    {
+        MaxForkFiles = MAX(2 * MaxForkFiles, 16);
+        files = (TForkFile *) realloc(ForkFiles,
+                                      MaxForkFiles * sizeof(TForkFile));
+        if ( files == NULL )
+        {
+            MaxForkFiles = -1;         // signals out of memory
+            return;
+        }
+        ForkFiles = files;
+    }
+
+    fd = fileno(f);
+    flags = fcntl(fd, F_GETFL);
+    if ( flags < 0 || fstat(fd, &st) != 0 ) return;
+    ForkFiles[NumForkFiles].file = f;
+    ForkFiles[NumForkFiles].tfile = NULL;
+    sstrncpy(ForkFiles[NumForkFiles].name, name, MAXFNAME);
+    ForkFiles[NumForkFiles].writable = (flags & O_ACCMODE) != O_RDONLY;
+    ForkFiles[NumForkFiles].offset = lseek(fd, 0, SEEK_CUR);
+    ForkFiles[NumForkFiles].size = st.st_size;
+    NumForkFiles++;
+#endif
+}
+
+#if !defined(_WIN32)
+
+//=============================================================================
+
+int addProjectFiles()
+//
+//  Input:   none
+//  Output:  returns TRUE if successful, FALSE if out of memory
+//  Purpose: lists the files open in a running simulation.
+//
+//  Fhotstart1 is closed once its contents are read at the start of a run.
+//
+{
+    int i;
+
+    NumForkFiles = 0;
+    MaxForkFiles = 0;
+    addTFile(&Finp);
+    addTFile(&Fout);
+    addTFile(&Frpt);
+    addTFile(&Fclimate);
+    addTFile(&Frain);
+    addTFile(&Frunoff);
+    addTFile(&Frdii);
+    addTFile(&Fhotstart2);
+    addTFile(&Finflows);
+    addTFile(&Foutflows);
+    addTFile(&Frecord);
+    for (i = 0; i < Nobjects[TSERIES]; i++) addTFile(&Tseries[i].file);
+    lid_addEnsembleFiles();
+    return MaxForkFiles >= 0;
+}
+
+//=============================================================================
+
+void addTFile(TFile* f)
+//
+//  Input:   f = a project file
+//  Output:  none
+//  Purpose: adds a project file that is open to the list of files to be
+//           separated from each new ensemble member.
+//
+{
+    int n = NumForkFiles;
+    ensemble_addFile(f->file, f->name);
+    if ( NumForkFiles > n ) ForkFiles[n].tfile = f;
+}
+
+//=============================================================================
+
+int separateFile(TForkFile* f, int member)
+//
+//  Input:   f = a file open when the member was forked
+//           member = ensemble member number
+//  Output:  returns TRUE if successful, FALSE if not
+//  Purpose: gives a new ensemble member its own copy of an open file,
+//           leaving the file's stream buffer untouched.
+//
+//  The file descriptor under the stream is shared with the forking process,
+//  so it is replaced by a new one rather than being closed or repositioned.
+//
+{
+    int  fd, result;
+    char name[MAXFNAME+1];
+
+    // --- files being read are opened again at the same position
+    if ( !f->writable )
+    {
+        fd = open(f->name, O_RDONLY);
+        if ( fd < 0 ) return FALSE;
+    }
+
+    // --- files being written are copied to a new file of the member's own
+    else
+    {
+        if ( !getMemberFileName(f, member, name) ) return FALSE;
+        fd = open(name, O_RDWR | O_CREAT | O_TRUNC, 0666);
+        if ( fd < 0 ) return FALSE;
+        if ( !copyFile(f, fd) )
+        {
+            close(fd);
+            return FALSE;
+        }
+        if ( f->tfile ) sstrncpy(f->tfile->name, name, MAXFNAME);
+    }
+
+    result = lseek(fd, f->offset, SEEK_SET) == f->offset &&
+             dup2(fd, fileno(f->file)) >= 0;
+    close(fd);
+    return result;
+}
+
+//=============================================================================
+
+int getMemberFileName(TForkFile* f, int member, char* name)
+//
+//  Input:   f = a file being written
+//           member = ensemble member number
+//  Output:  name = name of the member's copy of the file;
+//           returns TRUE if successful, FALSE if name is too long
+//  Purpose: names an ensemble member's copy of a file.
+//
+{
+    char   suffix[MAXMSG+1];
+    char*  ext;
+    char*  dir;
+    size_t n;
+
+    // --- scratch files are copied to a new scratch file
+    if ( f->tfile && f->tfile->mode == SCRATCH_FILE )
+    {
+        return getTempFileName(name) != NULL;
+    }
+
+    // --- other files have the member number added before their extension
+    sprintf(suffix, "_%d", member);
+    ext = strrchr(f->name, '.');
+    dir = strrchr(f->name, '/');
+    if ( dir == NULL ) dir = strrchr(f->name, '\\');
+    if ( ext == NULL || (dir && ext < dir) ) ext = f->name + strlen(f->name);
+    n = ext - f->name;
+    if ( n + strlen(suffix) + strlen(ext) > MAXFNAME ) return FALSE;
+    memcpy(name, f->name, n);
+    strcpy(name + n, suffix);
+    strcat(name, ext);
+    return TRUE;
+}
+
+//=============================================================================
+
+int copyFile(TForkFile* f, int fd)
+//
+//  Input:   f = a file being written
+//           fd = descriptor of the member's copy of the file
+//  Output:  returns TRUE if successful, FALSE if not
+//  Purpose: copies the contents a file had when it was forked.
+//
+{
+    char    buffer[COPY_BLOCK];
+    off_t   copied = 0;
+    ssize_t n;
+    int     src = open(f->name, O_RDONLY);
+
+    if ( src < 0 ) return FALSE;
+    while ( copied < f->size )
+    {
+        n = read(src, buffer, (size_t)MIN(f->size - copied, COPY_BLOCK));
+        if ( n <= 0 || write(fd, buffer, n) != n ) break;
+        copied += n;
+    }
+    close(src);
+    return copied == f->size;
+}
+
+#endif
@@ -61,6 +61,17 @@
       LID,                             // LID treatment units
       MAX_OBJ_TYPES};
 
+//-------------------------------------
+// Memory pools for project data
+//-------------------------------------
+ enum MemPoolType {                                                            //(5.1.015)
+      ID_POOL,                         // object ID names                      //(5.1.015)
+      QUAL_POOL,                       // water quality & land use arrays      //(5.1.015)
+      CURVE_POOL,                      // curve table entries                  //(5.1.015)
+      TSERIES_POOL,                    // time series table entries            //(5.1.015)
+      LID_POOL,                        // LID units placed in subcatchments    //(5.1.015)
+      MAX_POOLS};                                                              //(5.1.015)
+
 //-------------------------------------
 // Names of Node sub-types
 //-------------------------------------
@@ -91,7 +102,9 @@
       HOTSTART_FILE,                   // hotstart file
       RDII_FILE,                       // RDII file
       INFLOWS_FILE,                    // inflows interface file
-      OUTFLOWS_FILE};                  // outflows interface file
+      OUTFLOWS_FILE,                   // outflows interface file
+      CLIMATE_FILE,                    // climate table file              //(5.1.015)
+      RECORD_FILE};                    // result recording file           //(5.1.015)
 
 //-------------------------------------
 // File usage types
@@ -454,7 +467,7 @@ enum  CompatibilityType {
       s_COORDINATE,   s_VERTICES,     s_POLYGON,      s_LABEL,
       s_SYMBOL,       s_BACKDROP,     s_TAG,          s_PROFILE,
       s_MAP,          s_LID_CONTROL,  s_LID_USAGE,    s_GWF,
-      s_ADJUST,       s_EVENT};
+      s_ADJUST,       s_EVENT,        s_RECORDING};                            //(5.1.015)
 
  enum InputOptionType {
     FLOW_UNITS, INFIL_MODEL, ROUTE_MODEL,
@@ -470,7 +483,12 @@ enum  CompatibilityType {
     IGNORE_SNOWMELT, IGNORE_GWATER, IGNORE_ROUTING,
     IGNORE_QUALITY, MAX_TRIALS, HEAD_TOL,
     SYS_FLOW_TOL, LAT_FLOW_TOL, IGNORE_RDII,
-    MIN_ROUTE_STEP, NUM_THREADS, SURCHARGE_METHOD};                              //(5.1.013)
+    MIN_ROUTE_STEP, NUM_THREADS, SURCHARGE_METHOD,                               //(5.1.013)
+    OUTPUT_FORMAT, OUTPUT_NAME_INDEX};                                         //(5.1.015)
+
+ enum OutputFormatType {                                                       //(5.1.015)
+      STANDARD_OUTPUT,                 // fixed-size records, 32-bit offsets   //
+      COMPRESSED_OUTPUT};              // compressed chunks, 64-bit offsets    //
 
 enum  NoYesType {
       NO,
@@ -16,6 +16,12 @@
 //   Build 5.1.010:
 //   - Text of Error 318 for rainfall data files modified.
 //
+//   Build 5.1.015:
+//   - Error message string made private to each thread.
+//   - Errors 369 and 371 for compiled project files added.
+//   - API error 513 for simulation state snapshots added.
+//   - API error 514 for forked simulation ensembles added.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -160,6 +166,12 @@
 #define ERR361 "\n  ERROR 361: could not open external file used for Time Series %s."
 #define ERR363 "\n  ERROR 363: invalid data in external file used for Time Series %s."
 
+#define ERR365 "\n  ERROR 365: cannot open recording file %s."
+#define ERR367 "\n  ERROR 367: error writing to recording file %s."
+
+#define ERR369 "\n  ERROR 369: cannot open compiled project file %s."
+#define ERR371 "\n  ERROR 371: error writing to compiled project file %s."
+
 #define ERR401 "\n  ERROR 401: general system error."
 #define ERR402 \
 "\n  ERROR 402: cannot open new project while current project still open."
@@ -181,6 +193,8 @@
 #define ERR510 "\n API Key Error: Invalid Lid Unit Index"
 #define ERR511 "\n API Key Error: Undefined Subcatchment Lid"
 #define ERR512 "\n API Key Error: No memory allocated for return value"
+#define ERR513 "\n API Key Error: Snapshot not available for current simulation"
+#define ERR514 "\n API Key Error: Simulation could not be forked"
 
 ////////////////////////////////////////////////////////////////////////////
 //  NOTE: Need to update ErrorMsgs[], ErrorCodes[], and ErrorType
@@ -199,8 +213,9 @@ char* ErrorMsgs[] =
       ERR313, ERR315, ERR317, ERR318, ERR319, ERR320, ERR321, ERR323, ERR325,
       ERR327, ERR329, ERR330, ERR331, ERR333, ERR335, ERR336, ERR337, ERR338,
       ERR339, ERR341, ERR343, ERR345, ERR351, ERR353, ERR355, ERR357, ERR361,
-      ERR363, ERR401, ERR402, ERR403, ERR405, ERR501, ERR502, ERR503, ERR504,
-      ERR505, ERR506, ERR507, ERR508, ERR509, ERR510, ERR511, ERR512};
+      ERR363, ERR365, ERR367, ERR369, ERR371, ERR401, ERR402, ERR403, ERR405,
+      ERR501, ERR502, ERR503, ERR504, ERR505, ERR506, ERR507, ERR508, ERR509,
+      ERR510, ERR511, ERR512, ERR513, ERR514};
 
 int ErrorCodes[] =
     { 0,      101,    103,    105,    107,    108,    109,    110,    111,
@@ -214,10 +229,12 @@ int ErrorCodes[] =
       313,    315,    317,    318,    319,    320,    321,    323,    325,
       327,    329,    330,    331,    333,    335,    336,    337,    338,
       339,    341,    343,    345,    351,    353,    355,    357,    361,
-      363,    401,    402,    403,    405,    501,    502,    503,    504,
-      505,    506,    507,    508,    509,    510,    511,    512};
+      363,    365,    367,    369,    371,    401,    402,    403,    405,
+      501,    502,    503,    504,    505,    506,    507,    508,    509,
+      510,    511,    512,    513,    514};
 
-char  ErrString[256];
+char  ErrString[256];                                                          //(5.1.015)
+#pragma omp threadprivate(ErrString)                                           //
 
 char* error_getMsg(int i)
 {
@@ -154,25 +154,35 @@ enum  ErrorType {
       ERR_TABLE_FILE_OPEN,      //361  98
       ERR_TABLE_FILE_READ,      //363  99
 
+  //... Recording File Errors
+      ERR_RECORD_FILE_OPEN,     //365  100
+      ERR_RECORD_FILE_WRITE,    //367  101
+
+  //... Compiled Project File Errors
+      ERR_COMPILED_FILE_OPEN,   //369  102
+      ERR_COMPILED_FILE_WRITE,  //371  103
+
   //... Runtime Errors
-      ERR_SYSTEM,               //401  100
-      ERR_NOT_CLOSED,           //402  101
-      ERR_NOT_OPEN,             //403  102
-      ERR_FILE_SIZE,            //405  103
+      ERR_SYSTEM,               //401  104
+      ERR_NOT_CLOSED,           //402  105
+      ERR_NOT_OPEN,             //403  106
+      ERR_FILE_SIZE,            //405  107
 
   //... API Errors
-      ERR_API_OUTBOUNDS,        //501  104
-      ERR_API_INPUTNOTOPEN,     //502  105
-      ERR_API_SIM_NRUNNING,     //503  106
-      ERR_API_WRONG_TYPE,       //504  107
-      ERR_API_OBJECT_INDEX,     //505  108
-      ERR_API_POLLUT_INDEX,     //506  109
-      ERR_API_INFLOWTYPE,       //507  110
-      ERR_API_TSERIES_INDEX,    //508  111
-      ERR_API_PATTERN_INDEX,    //509  112
-      ERR_API_LIDUNIT_INDEX,    //510  113
-      ERR_API_UNDEFINED_LID,    //511  114
-      ERR_API_MEMORY,           //512  115
+      ERR_API_OUTBOUNDS,        //501  108
+      ERR_API_INPUTNOTOPEN,     //502  109
+      ERR_API_SIM_NRUNNING,     //503  110
+      ERR_API_WRONG_TYPE,       //504  111
+      ERR_API_OBJECT_INDEX,     //505  112
+      ERR_API_POLLUT_INDEX,     //506  113
+      ERR_API_INFLOWTYPE,       //507  114
+      ERR_API_TSERIES_INDEX,    //508  115
+      ERR_API_PATTERN_INDEX,    //509  116
+      ERR_API_LIDUNIT_INDEX,    //510  117
+      ERR_API_UNDEFINED_LID,    //511  118
+      ERR_API_MEMORY,           //512  119
+      ERR_API_SNAPSHOT,         //513  120
+      ERR_API_FORK,             //514  121
       MAXERRMSG};
 
 char* error_getMsg(int i);
@@ -31,6 +31,32 @@
 //   Build 5.1.014:
 //   - Arguments to link_getLossRate function changed.
 //
+//   Build 5.1.015:
+//   - gwater_getGroundwater() replaced with gwater_setSurfaceLosses() and
+//     gwater_execute() so that groundwater can be computed in parallel.
+//   - snow_getSnowMelt() replaced with snow_execute() and
+//     snow_getNetPrecip() so that snow melt can be computed in parallel.
+//   - climate_close() added.
+//   - runoff results frame & pipelining functions added.
+//   - controls_usesTseries() added.
+//   - subcatch_open(), subcatch_close() and subcatch_getSurfaceRunoff()
+//     added so that LID units can be analyzed in parallel.
+//   - output_startWriter(), output_execWriter() and output_stopWriter()
+//     added so that results can be written to file on their own thread.
+//   - result recording functions added.
+//   - input_startCompiling() and input_writeCompiled() added to save
+//     compiled project files.
+//   - simulation state snapshot functions added.
+//   - ensemble forking functions added.
+//   - table_markTimeseries(), table_startTseriesLoad(),
+//     table_endTseriesLoad() and input_loadTimeseries() added so that time
+//     series data are only loaded when used.
+//   - report_startDeferredMsgs(), report_deferMsgs(),
+//     report_writeDeferredMsgs(), report_endDeferredMsgs() and
+//     link_setNodeDepths() added so that objects can be validated in
+//     parallel.
+//   - pauseThread() added.
+//
 //-----------------------------------------------------------------------------
 
 void     project_open(char *f1, char *f2, char *f3);
@@ -45,6 +71,7 @@ int      project_addObject(int type, char* id, int n);
 
 int      project_findObject(int type, char* id);
 char*    project_findID(int type, char* id);
+void*    project_alloc(int pool, int n, int size);                             //(5.1.015)
 
 double** project_createMatrix(int nrows, int ncols);
 void     project_freeMatrix(double** m);
@@ -54,6 +81,9 @@ void     project_freeMatrix(double** m);
 //-----------------------------------------------------------------------------
 int     input_countObjects(void);
 int     input_readData(void);
+void    input_startCompiling(void);
+int     input_writeCompiled(void);
+int     input_loadTimeseries(void);
 
 //-----------------------------------------------------------------------------
 //   Report Writer Methods
@@ -90,6 +120,10 @@ void    report_writeErrorCode(void);
 void    report_writeInputErrorMsg(int k, int sect, char* line, long lineCount);
 void    report_writeWarningMsg(char* msg, char* id);
 void    report_writeTseriesErrorMsg(int code, TTable *tseries);
+int     report_startDeferredMsgs(int nThreads);
+void    report_deferMsgs(int object);
+void    report_writeDeferredMsgs(int object);
+void    report_endDeferredMsgs(void);
 
 void    inputrpt_writeInput(void);
 void    statsrpt_writeReport(void);
@@ -103,6 +137,7 @@ int      climate_readAdjustments(char* tok[], int ntoks);
 void     climate_validate(void);
 void     climate_openFile(void);
 void     climate_initState(void);
+void     climate_close(void);
 void     climate_setState(DateTime aDate);
 DateTime climate_getNextEvapDate(void);
 
@@ -127,8 +162,10 @@ void    snow_setState(int subcatch, int subArea, double x[]);
 
 void    snow_setMeltCoeffs(int snowIndex, double season);
 void    snow_plowSnow(int subcatch, double tStep);
-double  snow_getSnowMelt(int subcatch, double rainfall, double snowfall,
-        double tStep, double netPrecip[]);
+int     snow_open(void);
+void    snow_close(void);
+void    snow_execute(double tStep);
+void    snow_getNetPrecip(int subcatch, double netPrecip[]);
 double  snow_getSnowCover(int subcatch);
 
 //-----------------------------------------------------------------------------
@@ -137,6 +174,14 @@ double  snow_getSnowCover(int subcatch);
 int     runoff_open(void);
 void    runoff_execute(void);
 void    runoff_close(void);
+TRunoffFrame* runoff_getFrame(void);
+double  runoff_getEvapRate(void);
+double  runoff_getHydconFactor(void);
+int     runoff_isPipelined(void);
+int     runoff_startPipeline(void);
+void    runoff_execPipeline(void);
+void    runoff_stopPipeline(void);
+void    runoff_waitForFrame(double routingTime);
 
 //-----------------------------------------------------------------------------
 //   Conveyance System Routing Methods
@@ -159,6 +204,19 @@ void    output_readDateTime(int period, DateTime *aDate);
 void    output_readSubcatchResults(int period, int area);
 void    output_readNodeResults(int period, int node);
 void    output_readLinkResults(int period, int link);
+int     output_startWriter(void);
+void    output_execWriter(void);
+void    output_stopWriter(void);
+
+//-----------------------------------------------------------------------------
+//   Result Recording Methods
+//-----------------------------------------------------------------------------
+void    record_create(void);
+void    record_delete(void);
+int     record_readParams(char* tok[], int ntoks);
+int     record_open(void);
+void    record_saveResults(void);
+void    record_close(void);
 
 //-----------------------------------------------------------------------------
 //   Groundwater Methods
@@ -175,8 +233,10 @@ void    gwater_initState(int subcatch);
 void    gwater_getState(int subcatch, double x[]);
 void    gwater_setState(int subcatch, double x[]);
 
-void    gwater_getGroundwater(int subcatch, double evap, double infil,
-        double tStep);
+int     gwater_open(void);
+void    gwater_close(void);
+void    gwater_setSurfaceLosses(int subcatch, double evap, double infil);
+void    gwater_execute(double tStep);
 double  gwater_getVolume(int subcatch);
 
 //-----------------------------------------------------------------------------
@@ -307,6 +367,8 @@ int     subcatch_readInitBuildup(char* tok[], int ntoks);
 
 void    subcatch_validate(int subcatch);
 void    subcatch_initState(int subcatch);
+int     subcatch_open(void);
+void    subcatch_close(void);
 void    subcatch_setOldState(int subcatch);
 
 double  subcatch_getFracPerv(int subcatch);
@@ -316,6 +378,7 @@ double  subcatch_getBuildup(int subcatch, int pollut);
 
 void    subcatch_getRunon(int subcatch);
 void    subcatch_addRunonFlow(int subcatch, double flow);
+void    subcatch_getSurfaceRunoff(int subcatch, double tStep);
 double  subcatch_getRunoff(int subcatch, double tStep);
 
 double  subcatch_getWtdOutflow(int subcatch, double wt);
@@ -393,6 +456,38 @@ void    iface_saveOutletResults(DateTime reportDate, FILE* file);
 int     hotstart_open(void);
 void    hotstart_close(void);
 
+//-----------------------------------------------------------------------------
+//   Simulation State Snapshot Methods
+//-----------------------------------------------------------------------------
+void       snapshot_newRun(void);
+TSnapshot* snapshot_save(void);
+int        snapshot_restore(TSnapshot* s);
+void       snapshot_delete(TSnapshot* s);
+void       snapshot_add(TSnapshot* s, void* data, size_t size);
+void       snapshot_addFile(TSnapshot* s, FILE* f);
+
+void    climate_snapshot(TSnapshot* s);
+void    infil_snapshot(TSnapshot* s);
+void    lid_snapshot(TSnapshot* s);
+void    rdii_snapshot(TSnapshot* s);
+void    iface_snapshot(TSnapshot* s);
+void    controls_snapshot(TSnapshot* s);
+void    runoff_snapshot(TSnapshot* s);
+void    routing_snapshot(TSnapshot* s);
+void    dynwave_snapshot(TSnapshot* s);
+void    massbal_snapshot(TSnapshot* s);
+void    stats_snapshot(TSnapshot* s);
+void    output_snapshot(TSnapshot* s);
+void    record_snapshot(TSnapshot* s);
+
+//-----------------------------------------------------------------------------
+//   Simulation Ensemble Methods
+//-----------------------------------------------------------------------------
+int     ensemble_fork(int count, int* member);
+int     ensemble_wait(int* failures);
+void    ensemble_addFile(FILE* f, char* name);
+void    lid_addEnsembleFiles(void);
+
 //-----------------------------------------------------------------------------
 //   Conveyance System Link Methods
 //-----------------------------------------------------------------------------
@@ -401,6 +496,7 @@ int     link_readXsectParams(char* tok[], int ntoks);
 int     link_readLossParams(char* tok[], int ntoks);
 
 void    link_validate(int link);
+void    link_setNodeDepths(int link);
 void    link_initState(int link);
 void    link_setOldHydState(int link);
 void    link_setOldQualState(int link);
@@ -476,12 +572,18 @@ void    controls_delete(void);
 int     controls_addRuleClause(int rule, int keyword, char* Tok[], int nTokens);
 int     controls_evaluate(DateTime currentTime, DateTime elapsedTime,
         double tStep);
+int     controls_usesTseries(int k);
 
 //-----------------------------------------------------------------------------
 //   Table & Time Series Methods
 //-----------------------------------------------------------------------------
 int     table_readCurve(char* tok[], int ntoks);
 int     table_readTimeseries(char* tok[], int ntoks);
+int     table_markTimeseries(char* tok[], int ntoks, size_t start, size_t end,
+        long lineCount);
+void    table_startTseriesLoad(TTable* table, DateTime start, DateTime end,
+        DateTime startDate);
+void    table_endTseriesLoad(TTable* table);
 
 int     table_addEntry(TTable* table, double x, double y);
 int     table_getFirstEntry(TTable* table, double* x, double* y);
@@ -517,7 +619,10 @@ int      match(char *str, char *substr);      // true if substr matches part of
 int      strcomp(char *s1, char *s2);         // case insensitive string compare
 char*    sstrncpy(char *dest, const char *src,
          size_t maxlen);                      // safe string copy
+char*    sstrtok(char *s, const char *delim,
+         char **next);                        // reentrant string tokenizer
 void     writecon(char *s);                   // writes string to console
+void     pauseThread(int tries);              // pause a waiting thread
 DateTime getDateTime(double elapsedMsec);     // convert elapsed time to date
 void     getElapsedTime(DateTime aDate,       // convert elapsed date
          int* days, int* hrs, int* mins);
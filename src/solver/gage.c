@@ -447,6 +447,7 @@ void gage_setReportRainfall(int j, DateTime reportDate)
 //
 {
     double result;
+    TGageFrame* g = &runoff_getFrame()->gage[j];                               //(5.1.015)
 
     // --- use value from co-gage if it exists
     if ( Gage[j].coGage >= 0)
@@ -461,14 +462,14 @@ void gage_setReportRainfall(int j, DateTime reportDate)
 
     // --- use current rainfall if report date/time is before end
     //     of current rain interval
-    if ( reportDate < Gage[j].endDate ) result = Gage[j].rainfall;
+    if ( reportDate < g->endDate ) result = g->rainfall;                       //(5.1.015)
 
     // --- use 0.0 if report date/time is before start of next rain interval
-    else if ( reportDate < Gage[j].nextDate ) result = 0.0;
+    else if ( reportDate < g->nextDate ) result = 0.0;                         //(5.1.015)
 
     // --- otherwise report date/time falls right on end of current rain
     //     interval and start of next interval so use next interval's rainfall
-    else result = Gage[j].nextRainfall;
+    else result = g->nextRainfall;                                             //(5.1.015)
     Gage[j].reportRainfall = result;
 }
 
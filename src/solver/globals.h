@@ -48,7 +48,9 @@ EXTERN TFile
                   Fhotstart1,               // Hot start input file
                   Fhotstart2,               // Hot start output file
                   Finflows,                 // Inflows routing file
-                  Foutflows;                // Outflows routing file
+                  Foutflows,                // Outflows routing file
+                  Fclimtable,               // Climate table file           //(5.1.015)
+                  Frecord;                  // Result recording file        //(5.1.015)
 
 EXTERN long
                   Nperiods,                 // Number of reporting periods
@@ -75,6 +77,8 @@ EXTERN int
                   ForceMainEqn,             // Flow equation for force mains
                   LinkOffsets,              // Link offset convention
                   SurchargeMethod,          // EXTRAN or SLOT method           //(5.1.013)
+                  OutputFormat,             // Binary output file format       //(5.1.015)
+                  OutputNameIndex,          // Save name index to output file  //(5.1.015)
                   AllowPonding,             // Allow water to pond at nodes
                   InertDamping,             // Degree of inertial damping
                   NormalFlowLtd,            // Normal flow limited
@@ -24,6 +24,13 @@
 //   Build 5.1.010:
 //   - Unsaturated hydraulic conductivity added to GW flow equation variables.
 //
+//   Build 5.1.015:
+//   - Shared variables replaced with a per-subcatchment analysis state so
+//     that groundwater can be computed in parallel across subcatchments.
+//   - Mass balance and statistics updates deferred to a serial pass that
+//     visits subcatchments in index order.
+//   - Custom GW flow expressions evaluated in compiled form.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -61,33 +68,63 @@ static char* GWVarWords[] = {"HGW", "HSW", "HCB", "HGS", "KS", "K",
                              "THETA", "PHI", "FI", "FU", "A", NULL};
 
 //-----------------------------------------------------------------------------
-//  Shared variables
+//  Data Structures
 //-----------------------------------------------------------------------------
 //  NOTE: all flux rates are in ft/sec, all depths are in ft.
-static double    Area;            // subcatchment area (ft2)
-static double    Infil;           // infiltration rate from surface
-static double    MaxEvap;         // max. evaporation rate
-static double    AvailEvap;       // available evaporation rate
-static double    UpperEvap;       // evaporation rate from upper GW zone
-static double    LowerEvap;       // evaporation rate from lower GW zone
-static double    UpperPerc;       // percolation rate from upper to lower zone
-static double    LowerLoss;       // loss rate from lower GW zone
-static double    GWFlow;          // flow rate from lower zone to conveyance node
-static double    MaxUpperPerc;    // upper limit on UpperPerc
-static double    MaxGWFlowPos;    // upper limit on GWFlow when its positve
-static double    MaxGWFlowNeg;    // upper limit on GWFlow when its negative
-static double    FracPerv;        // fraction of surface that is pervious
-static double    TotalDepth;      // total depth of GW aquifer
-static double    Theta;           // moisture content of upper zone
-static double    HydCon;          // unsaturated hydraulic conductivity (ft/s)
-static double    Hgw;             // ht. of saturated zone
-static double    Hstar;           // ht. from aquifer bottom to node invert
-static double    Hsw;             // ht. from aquifer bottom to water surface
-static double    Tstep;           // current time step (sec)
-static TAquifer  A;               // aquifer being analyzed
-static TGroundwater* GW;          // groundwater object being analyzed
-static MathExpr* LatFlowExpr;     // user-supplied lateral GW flow expression
-static MathExpr* DeepFlowExpr;    // user-supplied deep GW flow expression
+typedef struct
+{
+    double    area;            // subcatchment area (ft2)
+    double    infil;           // infiltration rate from surface
+    double    maxEvap;         // max. evaporation rate
+    double    availEvap;       // available evaporation rate
+    double    upperEvap;       // evaporation rate from upper GW zone
+    double    lowerEvap;       // evaporation rate from lower GW zone
+    double    upperPerc;       // percolation rate from upper to lower zone
+    double    lowerLoss;       // loss rate from lower GW zone
+    double    gwFlow;          // flow rate from lower zone to conveyance node
+    double    maxUpperPerc;    // upper limit on upperPerc
+    double    maxGWFlowPos;    // upper limit on gwFlow when its positve
+    double    maxGWFlowNeg;    // upper limit on gwFlow when its negative
+    double    fracPerv;        // fraction of surface that is pervious
+    double    totalDepth;      // total depth of GW aquifer
+    double    theta;           // moisture content of upper zone
+    double    hydCon;          // unsaturated hydraulic conductivity (ft/s)
+    double    hgw;             // ht. of saturated zone
+    double    hstar;           // ht. from aquifer bottom to node invert
+    double    hsw;             // ht. from aquifer bottom to water surface
+    double    tstep;           // current time step (sec)
+    int       month;           // current month of year
+    TAquifer* a;               // aquifer being analyzed
+    TGroundwater* gw;          // groundwater object being analyzed
+    MathExprCode* latFlowExpr; // user-supplied lateral GW flow expression
+    MathExprCode* deepFlowExpr;// user-supplied deep GW flow expression
+}   TGwaterState;
+
+//  Surface losses received by and fluxes produced by a subcatchment's
+//  groundwater over the current time step
+typedef struct
+{
+    char      hasLosses;       // TRUE if surface losses were assigned
+    char      updated;         // TRUE if groundwater was updated
+    double    evap;            // pervious surface evap. volume (ft3)
+    double    infil;           // surface infiltration volume (ft3)
+    double    infilRate;       // infiltration rate into GW zone (ft/sec)
+    double    upperEvap;       // upper zone evaporation rate (ft/sec)
+    double    lowerEvap;       // lower zone evaporation rate (ft/sec)
+    double    lowerLoss;       // deep percolation rate (ft/sec)
+    double    gwFlow;          // lateral GW flow rate (ft/sec)
+}   TGwaterStep;
+
+//-----------------------------------------------------------------------------
+//  Imported variables
+//-----------------------------------------------------------------------------
+// Declared in RUNOFF.C
+extern int RunoffThreads;     // threads used by runoff's parallel loops
+
+//-----------------------------------------------------------------------------
+//  Shared variables
+//-----------------------------------------------------------------------------
+static TGwaterStep* GwStep;    // per-subcatchment time step results
 
 //-----------------------------------------------------------------------------
 //  External Functions (declared in funcs.h)
@@ -98,25 +135,30 @@ static MathExpr* DeepFlowExpr;    // user-supplied deep GW flow expression
 //  gwater_deleteFlowExpression  (called by deleteObjects in project.c)
 //  gwater_validateAquifer       (called by swmm_open)
 //  gwater_validate              (called by subcatch_validate) 
+//  gwater_open                  (called by runoff_open)
+//  gwater_close                 (called by runoff_close)
 //  gwater_initState             (called by subcatch_initState)
 //  gwater_getVolume             (called by massbal_open & massbal_getGwaterError)
-//  gwater_getGroundwater        (called by getSubareaRunoff in subcatch.c)
+//  gwater_setSurfaceLosses      (called by subcatch_getRunoff)
+//  gwater_execute               (called by runoff_execute)
 //  gwater_getState              (called by saveRunoff in hotstart.c)
 //  gwater_setState              (called by readRunoff in hotstart.c)
 
 //-----------------------------------------------------------------------------
 //  Local functions
 //-----------------------------------------------------------------------------
-static void   getDxDt(double t, double* x, double* dxdt);
-static void   getFluxes(double upperVolume, double lowerDepth);
-static void   getEvapRates(double theta, double upperDepth);
-static double getUpperPerc(double theta, double upperDepth);
-static double getGWFlow(double lowerDepth);
-static void   updateMassBal(double area,  double tStep);
+static void   getGroundwater(int j, double tStep);
+static void   getDxDt(double t, double* x, double* dxdt, void* data);
+static void   getFluxes(TGwaterState* s, double theta, double lowerDepth);
+static void   getEvapRates(TGwaterState* s, double theta, double upperDepth);
+static double getUpperPerc(TGwaterState* s, double theta, double upperDepth);
+static double getGWFlow(TGwaterState* s, double lowerDepth);
+static void   updateMassBal(TGwaterStep* g, TGroundwater* gw, double area,
+              double tStep);
 
 // Used to process custom GW outflow equations
 static int    getVariableIndex(char* s);
-static double getVariableValue(int varIndex);
+static void   getVariableValues(TGwaterState* s, double values[]);
 
 //=============================================================================
 
@@ -299,8 +341,20 @@ int gwater_readFlowExpression(char* tok[], int ntoks)
     }
 
     // --- delete any previous flow eqn.
-    if ( k == 1 ) mathexpr_delete(Subcatch[j].gwLatFlowExpr);
-    else          mathexpr_delete(Subcatch[j].gwDeepFlowExpr);
+    if ( k == 1 )
+    {
+        mathexpr_delete(Subcatch[j].gwLatFlowExpr);
+        mathexpr_deleteCompiled(Subcatch[j].gwLatFlowCode);
+        Subcatch[j].gwLatFlowExpr = NULL;
+        Subcatch[j].gwLatFlowCode = NULL;
+    }
+    else
+    {
+        mathexpr_delete(Subcatch[j].gwDeepFlowExpr);
+        mathexpr_deleteCompiled(Subcatch[j].gwDeepFlowCode);
+        Subcatch[j].gwDeepFlowExpr = NULL;
+        Subcatch[j].gwDeepFlowCode = NULL;
+    }
 
     // --- create a parsed expression tree from the string expr
     //     (getVariableIndex is the function that converts a GW
@@ -308,9 +362,21 @@ int gwater_readFlowExpression(char* tok[], int ntoks)
     expr = mathexpr_create(exprStr, getVariableIndex);
     if ( expr == NULL ) return error_setInpError(ERR_TREATMENT_EXPR, "");
 
-    // --- save expression tree with the subcatchment
-    if ( k == 1 ) Subcatch[j].gwLatFlowExpr = expr;
-    else          Subcatch[j].gwDeepFlowExpr = expr;
+    // --- save expression tree and its compiled form with the subcatchment
+    if ( k == 1 )
+    {
+        Subcatch[j].gwLatFlowExpr = expr;
+        Subcatch[j].gwLatFlowCode = mathexpr_compile(expr);
+        if ( !Subcatch[j].gwLatFlowCode )
+            return error_setInpError(ERR_MEMORY, "");
+    }
+    else
+    {
+        Subcatch[j].gwDeepFlowExpr = expr;
+        Subcatch[j].gwDeepFlowCode = mathexpr_compile(expr);
+        if ( !Subcatch[j].gwDeepFlowCode )
+            return error_setInpError(ERR_MEMORY, "");
+    }
     return 0;
 }
 
@@ -325,6 +391,8 @@ void gwater_deleteFlowExpression(int j)
 {
     mathexpr_delete(Subcatch[j].gwLatFlowExpr);
     mathexpr_delete(Subcatch[j].gwDeepFlowExpr);
+    mathexpr_deleteCompiled(Subcatch[j].gwLatFlowCode);
+    mathexpr_deleteCompiled(Subcatch[j].gwDeepFlowCode);
 }
 
 //=============================================================================
@@ -383,6 +451,34 @@ void  gwater_validate(int j)
 
 //=============================================================================
 
+int  gwater_open()
+//
+//  Input:   none
+//  Output:  returns error code
+//  Purpose: allocates memory for groundwater time step results.
+//
+{
+    GwStep = NULL;
+    if ( Nobjects[SUBCATCH] == 0 ) return 0;
+    GwStep = (TGwaterStep *) calloc(Nobjects[SUBCATCH], sizeof(TGwaterStep));
+    if ( GwStep == NULL ) return ERR_MEMORY;
+    return 0;
+}
+
+//=============================================================================
+
+void  gwater_close()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees memory for groundwater time step results.
+//
+{
+    FREE(GwStep);
+}
+
+//=============================================================================
+
 void  gwater_initState(int j)
 //
 //  Input:   j = subcatchment index
@@ -478,137 +574,208 @@ double gwater_getVolume(int j)
 
 //=============================================================================
 
-void gwater_getGroundwater(int j, double evap, double infil, double tStep)
+void gwater_setSurfaceLosses(int j, double evap, double infil)
 //
-//  Purpose: computes groundwater flow from subcatchment during current time step.
 //  Input:   j     = subcatchment index
 //           evap  = pervious surface evaporation volume consumed (ft3)
 //           infil = surface infiltration volume (ft3)
+//  Output:  none
+//  Purpose: saves the surface losses that feed a subcatchment's groundwater
+//           during the current time step.
+//
+{
+    GwStep[j].hasLosses = TRUE;
+    GwStep[j].evap = evap;
+    GwStep[j].infil = infil;
+}
+
+//=============================================================================
+
+void gwater_execute(double tStep)
+//
+//  Input:   tStep = time step (sec)
+//  Output:  none
+//  Purpose: computes groundwater flow from all subcatchments that received
+//           surface losses during the current time step.
+//
+//  Each subcatchment's groundwater depends only on its own state, so the
+//  subcatchments are analyzed in parallel. Mass balance and statistics
+//  are then updated serially in subcatchment order so that results do not
+//  depend on the number of threads used.
+//
+{
+    int j;
+
+    if ( GwStep == NULL ) return;
+
+#pragma omp parallel num_threads(RunoffThreads)
+{
+    #pragma omp for
+    for ( j = 0; j < Nobjects[SUBCATCH]; j++ )
+    {
+        GwStep[j].updated = FALSE;
+        if ( GwStep[j].hasLosses ) getGroundwater(j, tStep);
+    }
+}
+
+    for ( j = 0; j < Nobjects[SUBCATCH]; j++ )
+    {
+        GwStep[j].hasLosses = FALSE;
+        if ( !GwStep[j].updated ) continue;
+
+        // --- update GW mass balance
+        updateMassBal(&GwStep[j], Subcatch[j].groundwater, Subcatch[j].area,
+                      tStep);
+
+        // --- update GW statistics
+        stats_updateGwaterStats(j, GwStep[j].infilRate,
+            Subcatch[j].groundwater->evapLoss, GwStep[j].gwFlow,
+            GwStep[j].lowerLoss, Subcatch[j].groundwater->theta,
+            Subcatch[j].groundwater->lowerDepth +
+            Subcatch[j].groundwater->bottomElev, tStep);
+    }
+}
+
+//=============================================================================
+
+void getGroundwater(int j, double tStep)
+//
+//  Purpose: computes groundwater flow from subcatchment during current time step.
+//  Input:   j     = subcatchment index
 //           tStep = time step (sec)
 //  Output:  none
 //
 {
     int    n;                          // node exchanging groundwater
-    double x[2];                       // upper moisture content & lower depth 
+    double x[2];                       // upper moisture content & lower depth
     double vUpper;                     // upper vol. available for percolation
     double nodeFlow;                   // max. possible GW flow from node
-
-    // --- save subcatchment's groundwater and aquifer objects to 
-    //     shared variables
-    GW = Subcatch[j].groundwater;
-    if ( GW == NULL ) return;
-    LatFlowExpr = Subcatch[j].gwLatFlowExpr;
-    DeepFlowExpr = Subcatch[j].gwDeepFlowExpr;
-    A = Aquifer[GW->aquifer];
+    double evap;                       // surface evap. rate (ft/sec)
+    double work[ODESOLVE_WORKSIZE(2)]; // ODE solver work space
+    TGwaterState  state;               // state of GW being analyzed
+    TGwaterState* s = &state;
+    TGwaterStep*  g = &GwStep[j];
+
+    // --- save subcatchment's groundwater and aquifer objects to
+    //     the analysis state
+    s->gw = Subcatch[j].groundwater;
+    if ( s->gw == NULL ) return;
+    s->latFlowExpr = Subcatch[j].gwLatFlowCode;
+    s->deepFlowExpr = Subcatch[j].gwDeepFlowCode;
+    s->a = &Aquifer[s->gw->aquifer];
+    s->hydCon = 0.0;
+    s->month = datetime_monthOfYear(getDateTime(NewRunoffTime));
 
     // --- get fraction of total area that is pervious
-    FracPerv = subcatch_getFracPerv(j);
-    if ( FracPerv <= 0.0 ) return;
-    Area = Subcatch[j].area;
+    s->fracPerv = subcatch_getFracPerv(j);
+    if ( s->fracPerv <= 0.0 ) return;
+    s->area = Subcatch[j].area;
 
     // --- convert infiltration volume (ft3) to equivalent rate
     //     over entire GW (subcatchment) area
-    infil = infil / Area / tStep;
-    Infil = infil;
-    Tstep = tStep;
+    s->infil = g->infil / s->area / tStep;
+    s->tstep = tStep;
 
     // --- convert pervious surface evaporation already exerted (ft3)
     //     to equivalent rate over entire GW (subcatchment) area
-    evap = evap / Area / tStep;
+    evap = g->evap / s->area / tStep;
 
     // --- convert max. surface evap rate (ft/sec) to a rate
     //     that applies to GW evap (GW evap can only occur
     //     through the pervious land surface area)
-    MaxEvap = Evap.rate * FracPerv;
+    s->maxEvap = Evap.rate * s->fracPerv;
 
     // --- available subsurface evaporation is difference between max.
     //     rate and pervious surface evap already exerted
-    AvailEvap = MAX((MaxEvap - evap), 0.0);
+    s->availEvap = MAX((s->maxEvap - evap), 0.0);
 
-    // --- save total depth & outlet node properties to shared variables
-    TotalDepth = GW->surfElev - GW->bottomElev;
-    if ( TotalDepth <= 0.0 ) return;
-    n = GW->node;
+    // --- save total depth & outlet node properties to the analysis state
+    s->totalDepth = s->gw->surfElev - s->gw->bottomElev;
+    if ( s->totalDepth <= 0.0 ) return;
+    n = s->gw->node;
 
     // --- establish min. water table height above aquifer bottom at which
     //     GW flow can occur (override node's invert if a value was provided
     //     in the GW object)
-    if ( GW->nodeElev != MISSING ) Hstar = GW->nodeElev - GW->bottomElev;
-    else Hstar = Node[n].invertElev - GW->bottomElev;
-    
+    if ( s->gw->nodeElev != MISSING )
+        s->hstar = s->gw->nodeElev - s->gw->bottomElev;
+    else s->hstar = Node[n].invertElev - s->gw->bottomElev;
+
     // --- establish surface water height (relative to aquifer bottom)
     //     for drainage system node connected to the GW aquifer
-    if ( GW->fixedDepth > 0.0 )
+    if ( s->gw->fixedDepth > 0.0 )
     {
-        Hsw = GW->fixedDepth + Node[n].invertElev - GW->bottomElev;
+        s->hsw = s->gw->fixedDepth + Node[n].invertElev - s->gw->bottomElev;
     }
-    else Hsw = Node[n].newDepth + Node[n].invertElev - GW->bottomElev;
+    else s->hsw = Node[n].newDepth + Node[n].invertElev - s->gw->bottomElev;
 
     // --- store state variables (upper zone moisture content, lower zone
     //     depth) in work vector x
-    x[THETA] = GW->theta;
-    x[LOWERDEPTH] = GW->lowerDepth;
+    x[THETA] = s->gw->theta;
+    x[LOWERDEPTH] = s->gw->lowerDepth;
 
     // --- set limit on percolation rate from upper to lower GW zone
-    vUpper = (TotalDepth - x[LOWERDEPTH]) * (x[THETA] - A.fieldCapacity);
-    vUpper = MAX(0.0, vUpper); 
-    MaxUpperPerc = vUpper / tStep;
+    vUpper = (s->totalDepth - x[LOWERDEPTH]) * (x[THETA] - s->a->fieldCapacity);
+    vUpper = MAX(0.0, vUpper);
+    s->maxUpperPerc = vUpper / tStep;
 
     // --- set limit on GW flow out of aquifer based on volume of lower zone
-    MaxGWFlowPos = x[LOWERDEPTH]*A.porosity / tStep;
+    s->maxGWFlowPos = x[LOWERDEPTH]*s->a->porosity / tStep;
 
     // --- set limit on GW flow into aquifer from drainage system node
     //     based on min. of capacity of upper zone and drainage system
     //     inflow to the node
-    MaxGWFlowNeg = (TotalDepth - x[LOWERDEPTH]) * (A.porosity - x[THETA])
-                   / tStep;
-    nodeFlow = (Node[n].inflow + Node[n].newVolume/tStep) / Area;
-    MaxGWFlowNeg = -MIN(MaxGWFlowNeg, nodeFlow);
-    
+    s->maxGWFlowNeg = (s->totalDepth - x[LOWERDEPTH]) *
+                      (s->a->porosity - x[THETA]) / tStep;
+    nodeFlow = (Node[n].inflow + Node[n].newVolume/tStep) / s->area;
+    s->maxGWFlowNeg = -MIN(s->maxGWFlowNeg, nodeFlow);
+
     // --- integrate eqns. for d(Theta)/dt and d(LowerDepth)/dt
-    //     NOTE: ODE solver must have been initialized previously
-    odesolve_integrate(x, 2, 0, tStep, GWTOL, tStep, getDxDt);
-    
+    odesolve_integrateEx(x, 2, 0, tStep, GWTOL, tStep, getDxDt, s, work);
+
     // --- keep state variables within allowable bounds
-    x[THETA] = MAX(x[THETA], A.wiltingPoint);
-    if ( x[THETA] >= A.porosity )
+    x[THETA] = MAX(x[THETA], s->a->wiltingPoint);
+    if ( x[THETA] >= s->a->porosity )
     {
-        x[THETA] = A.porosity - XTOL;
-        x[LOWERDEPTH] = TotalDepth - XTOL;
+        x[THETA] = s->a->porosity - XTOL;
+        x[LOWERDEPTH] = s->totalDepth - XTOL;
     }
     x[LOWERDEPTH] = MAX(x[LOWERDEPTH],  0.0);
-    if ( x[LOWERDEPTH] >= TotalDepth )
+    if ( x[LOWERDEPTH] >= s->totalDepth )
     {
-        x[LOWERDEPTH] = TotalDepth - XTOL;
+        x[LOWERDEPTH] = s->totalDepth - XTOL;
     }
 
     // --- save new values of state values
-    GW->theta = x[THETA];
-    GW->lowerDepth  = x[LOWERDEPTH];
-    getFluxes(GW->theta, GW->lowerDepth);
-    GW->oldFlow = GW->newFlow;
-    GW->newFlow = GWFlow;
-    GW->evapLoss = UpperEvap + LowerEvap;
+    s->gw->theta = x[THETA];
+    s->gw->lowerDepth  = x[LOWERDEPTH];
+    getFluxes(s, s->gw->theta, s->gw->lowerDepth);
+    s->gw->oldFlow = s->gw->newFlow;
+    s->gw->newFlow = s->gwFlow;
+    s->gw->evapLoss = s->upperEvap + s->lowerEvap;
 
     //--- find max. infiltration volume (as depth over
     //    the pervious portion of the subcatchment)
     //    that upper zone can support in next time step
-    GW->maxInfilVol = (TotalDepth - x[LOWERDEPTH]) *
-                      (A.porosity - x[THETA]) / FracPerv;
-
-    // --- update GW mass balance
-    updateMassBal(Area, tStep);
-
-    // --- update GW statistics 
-    stats_updateGwaterStats(j, infil, GW->evapLoss, GWFlow, LowerLoss,
-        GW->theta, GW->lowerDepth + GW->bottomElev, tStep);
+    s->gw->maxInfilVol = (s->totalDepth - x[LOWERDEPTH]) *
+                         (s->a->porosity - x[THETA]) / s->fracPerv;
+
+    // --- save fluxes needed for mass balance & statistics
+    g->infilRate = s->infil;
+    g->upperEvap = s->upperEvap;
+    g->lowerEvap = s->lowerEvap;
+    g->lowerLoss = s->lowerLoss;
+    g->gwFlow    = s->gwFlow;
+    g->updated   = TRUE;
 }
 
 //=============================================================================
 
-void updateMassBal(double area, double tStep)
+void updateMassBal(TGwaterStep* g, TGroundwater* gw, double area, double tStep)
 //
-//  Input:   area  = subcatchment area (ft2)
+//  Input:   g     = groundwater fluxes over current time step
+//           gw    = groundwater object
+//           area  = subcatchment area (ft2)
 //           tStep = time step (sec)
 //  Output:  none
 //  Purpose: updates GW mass balance with volumes of water fluxes.
@@ -621,83 +788,92 @@ void updateMassBal(double area, double tStep)
     double vGwater;                    // volume of exchanged groundwater
     double ft2sec = area * tStep;
 
-    vInfil     = Infil * ft2sec;
-    vUpperEvap = UpperEvap * ft2sec;
-    vLowerEvap = LowerEvap * ft2sec;
-    vLowerPerc = LowerLoss * ft2sec;
-    vGwater    = 0.5 * (GW->oldFlow + GW->newFlow) * ft2sec;
+    vInfil     = g->infilRate * ft2sec;
+    vUpperEvap = g->upperEvap * ft2sec;
+    vLowerEvap = g->lowerEvap * ft2sec;
+    vLowerPerc = g->lowerLoss * ft2sec;
+    vGwater    = 0.5 * (gw->oldFlow + gw->newFlow) * ft2sec;
     massbal_updateGwaterTotals(vInfil, vUpperEvap, vLowerEvap, vLowerPerc,
                                vGwater);
 }
 
 //=============================================================================
 
-void  getFluxes(double theta, double lowerDepth)
+void  getFluxes(TGwaterState* s, double theta, double lowerDepth)
 //
-//  Input:   upperVolume = vol. depth of upper zone (ft)
-//           upperDepth  = depth of upper zone (ft)
+//  Input:   s          = state of GW being analyzed
+//           theta      = moisture content of upper zone
+//           lowerDepth = depth of lower zone (ft)
 //  Output:  none
 //  Purpose: computes water fluxes into/out of upper/lower GW zones.
 //
 {
     double upperDepth;
+    double values[gwvMAX];
 
     // --- find upper zone depth
     lowerDepth = MAX(lowerDepth, 0.0);
-    lowerDepth = MIN(lowerDepth, TotalDepth);
-    upperDepth = TotalDepth - lowerDepth;
+    lowerDepth = MIN(lowerDepth, s->totalDepth);
+    upperDepth = s->totalDepth - lowerDepth;
 
-    // --- save lower depth and theta to global variables
-    Hgw = lowerDepth;
-    Theta = theta;
+    // --- save lower depth and theta to the analysis state
+    s->hgw = lowerDepth;
+    s->theta = theta;
 
     // --- find evaporation rate from both zones
-    getEvapRates(theta, upperDepth);
+    getEvapRates(s, theta, upperDepth);
 
     // --- find percolation rate from upper to lower zone
-    UpperPerc = getUpperPerc(theta, upperDepth);
-    UpperPerc = MIN(UpperPerc, MaxUpperPerc);
+    s->upperPerc = getUpperPerc(s, theta, upperDepth);
+    s->upperPerc = MIN(s->upperPerc, s->maxUpperPerc);
+
+    // --- find current values of variables used in custom flow expressions
+    if ( s->deepFlowExpr != NULL || s->latFlowExpr != NULL )
+        getVariableValues(s, values);
 
     // --- find loss rate to deep GW
-    if ( DeepFlowExpr != NULL )
-        LowerLoss = mathexpr_eval(DeepFlowExpr, getVariableValue) /
-                    UCF(RAINFALL);
+    if ( s->deepFlowExpr != NULL )
+        s->lowerLoss = mathexpr_evalCompiled(s->deepFlowExpr, values) /
+                       UCF(RAINFALL);
     else
-        LowerLoss = A.lowerLossCoeff * lowerDepth / TotalDepth;
-    LowerLoss = MIN(LowerLoss, lowerDepth/Tstep);
+        s->lowerLoss = s->a->lowerLossCoeff * lowerDepth / s->totalDepth;
+    s->lowerLoss = MIN(s->lowerLoss, lowerDepth/s->tstep);
 
     // --- find GW flow rate from lower zone to drainage system node
-    GWFlow = getGWFlow(lowerDepth);
-    if ( LatFlowExpr != NULL )
+    s->gwFlow = getGWFlow(s, lowerDepth);
+    if ( s->latFlowExpr != NULL )
     {
-        GWFlow += mathexpr_eval(LatFlowExpr, getVariableValue) / UCF(GWFLOW);
+        s->gwFlow += mathexpr_evalCompiled(s->latFlowExpr, values) /
+                     UCF(GWFLOW);
     }
-    if ( GWFlow >= 0.0 ) GWFlow = MIN(GWFlow, MaxGWFlowPos);
-    else GWFlow = MAX(GWFlow, MaxGWFlowNeg);
+    if ( s->gwFlow >= 0.0 ) s->gwFlow = MIN(s->gwFlow, s->maxGWFlowPos);
+    else s->gwFlow = MAX(s->gwFlow, s->maxGWFlowNeg);
 }
 
 //=============================================================================
 
-void  getDxDt(double t, double* x, double* dxdt)
+void  getDxDt(double t, double* x, double* dxdt, void* data)
 //
 //  Input:   t    = current time (not used)
 //           x    = array of state variables
+//           data = state of GW being analyzed
 //  Output:  dxdt = array of time derivatives of state variables
-//  Purpose: computes time derivatives of upper moisture content 
+//  Purpose: computes time derivatives of upper moisture content
 //           and lower depth.
 //
 {
     double qUpper;    // inflow - outflow for upper zone (ft/sec)
     double qLower;    // inflow - outflow for lower zone (ft/sec)
     double denom;
+    TGwaterState* s = (TGwaterState *)data;
 
-    getFluxes(x[THETA], x[LOWERDEPTH]);
-    qUpper = Infil - UpperEvap - UpperPerc;
-    qLower = UpperPerc - LowerLoss - LowerEvap - GWFlow;
+    getFluxes(s, x[THETA], x[LOWERDEPTH]);
+    qUpper = s->infil - s->upperEvap - s->upperPerc;
+    qLower = s->upperPerc - s->lowerLoss - s->lowerEvap - s->gwFlow;
 
     // --- d(upper zone moisture)/dt = (net upper zone flow) /
     //                                 (upper zone depth)
-    denom = TotalDepth - x[LOWERDEPTH];
+    denom = s->totalDepth - x[LOWERDEPTH];
     if (denom > 0.0)
         dxdt[THETA] = qUpper / denom;
     else
@@ -705,7 +881,7 @@ void  getDxDt(double t, double* x, double* dxdt)
 
     // --- d(lower zone depth)/dt = (net lower zone flow) /
     //                              (upper zone moisture deficit)
-    denom = A.porosity - x[THETA];
+    denom = s->a->porosity - x[THETA];
     if (denom > 0.0)
         dxdt[LOWERDEPTH] = qLower / denom;
     else
@@ -714,65 +890,66 @@ void  getDxDt(double t, double* x, double* dxdt)
 
 //=============================================================================
 
-void getEvapRates(double theta, double upperDepth)
+void getEvapRates(TGwaterState* s, double theta, double upperDepth)
 //
-//  Input:   theta      = moisture content of upper zone
+//  Input:   s          = state of GW being analyzed
+//           theta      = moisture content of upper zone
 //           upperDepth = depth of upper zone (ft)
 //  Output:  none
 //  Purpose: computes evapotranspiration out of upper & lower zones.
 //
 {
-    int    p, month;
+    int    p;
     double f;
     double lowerFrac, upperFrac;
 
     // --- no GW evaporation when infiltration is occurring
-    UpperEvap = 0.0;
-    LowerEvap = 0.0;
-    if ( Infil > 0.0 ) return;
+    s->upperEvap = 0.0;
+    s->lowerEvap = 0.0;
+    if ( s->infil > 0.0 ) return;
 
     // --- get monthly-adjusted upper zone evap fraction
-    upperFrac = A.upperEvapFrac;
+    upperFrac = s->a->upperEvapFrac;
     f = 1.0;
-    p = A.upperEvapPat;
+    p = s->a->upperEvapPat;
     if ( p >= 0 )
     {
-        month = datetime_monthOfYear(getDateTime(NewRunoffTime));
-        f = Pattern[p].factor[month-1];
+        f = Pattern[p].factor[s->month-1];
     }
     upperFrac *= f;
 
     // --- upper zone evaporation requires that soil moisture
     //     be above the wilting point
-    if ( theta > A.wiltingPoint )
+    if ( theta > s->a->wiltingPoint )
     {
         // --- actual evap is upper zone fraction applied to max. potential
-        //     rate, limited by the available rate after any surface evap 
-        UpperEvap = upperFrac * MaxEvap;
-        UpperEvap = MIN(UpperEvap, AvailEvap);
+        //     rate, limited by the available rate after any surface evap
+        s->upperEvap = upperFrac * s->maxEvap;
+        s->upperEvap = MIN(s->upperEvap, s->availEvap);
     }
 
     // --- check if lower zone evaporation is possible
-    if ( A.lowerEvapDepth > 0.0 )
+    if ( s->a->lowerEvapDepth > 0.0 )
     {
         // --- find the fraction of the lower evaporation depth that
         //     extends into the saturated lower zone
-        lowerFrac = (A.lowerEvapDepth - upperDepth) / A.lowerEvapDepth;
+        lowerFrac = (s->a->lowerEvapDepth - upperDepth) / s->a->lowerEvapDepth;
         lowerFrac = MAX(0.0, lowerFrac);
         lowerFrac = MIN(lowerFrac, 1.0);
 
         // --- make the lower zone evap rate proportional to this fraction
         //     and the evap not used in the upper zone
-        LowerEvap = lowerFrac * (1.0 - upperFrac) * MaxEvap;
-        LowerEvap = MIN(LowerEvap, (AvailEvap - UpperEvap));
+        s->lowerEvap = lowerFrac * (1.0 - upperFrac) * s->maxEvap;
+        s->lowerEvap = MIN(s->lowerEvap, (s->availEvap - s->upperEvap));
     }
 }
 
 //=============================================================================
 
-double getUpperPerc(double theta, double upperDepth)
+double getUpperPerc(TGwaterState* s, double theta, double upperDepth)
 //
-//  Input:   theta      = moisture content of upper zone
+//  Input:   s          = state of GW being analyzed
+//           theta      = moisture content of upper zone
 //           upperDepth = depth of upper zone (ft)
 //  Output:  returns percolation rate (ft/sec)
 //  Purpose: finds percolation rate from upper to lower zone.
@@ -782,54 +959,56 @@ double getUpperPerc(double theta, double upperDepth)
     double dhdz;                        // avg. change in head with depth
     double hydcon;                      // unsaturated hydraulic conductivity
 
-    // --- no perc. from upper zone if no depth or moisture content too low    
-    if ( upperDepth <= 0.0 || theta <= A.fieldCapacity ) return 0.0;
+    // --- no perc. from upper zone if no depth or moisture content too low
+    if ( upperDepth <= 0.0 || theta <= s->a->fieldCapacity ) return 0.0;
 
     // --- compute hyd. conductivity as function of moisture content
-    delta = theta - A.porosity;
-    hydcon = A.conductivity * exp(delta * A.conductSlope);
+    delta = theta - s->a->porosity;
+    hydcon = s->a->conductivity * exp(delta * s->a->conductSlope);
 
     // --- compute integral of dh/dz term
-    delta = theta - A.fieldCapacity;
-    dhdz = 1.0 + A.tensionSlope * 2.0 * delta / upperDepth;
+    delta = theta - s->a->fieldCapacity;
+    dhdz = 1.0 + s->a->tensionSlope * 2.0 * delta / upperDepth;
 
     // --- compute upper zone percolation rate
-    HydCon = hydcon;
+    s->hydCon = hydcon;
     return hydcon * dhdz;
 }
 
 //=============================================================================
 
-double getGWFlow(double lowerDepth)
+double getGWFlow(TGwaterState* s, double lowerDepth)
 //
-//  Input:   lowerDepth = depth of lower zone (ft)
+//  Input:   s          = state of GW being analyzed
+//           lowerDepth = depth of lower zone (ft)
 //  Output:  returns groundwater flow rate (ft/sec)
 //  Purpose: finds groundwater outflow from lower saturated zone.
 //
 {
     double q, t1, t2, t3;
+    TGroundwater* gw = s->gw;
 
     // --- water table must be above Hstar for flow to occur
-    if ( lowerDepth <= Hstar ) return 0.0;
+    if ( lowerDepth <= s->hstar ) return 0.0;
 
     // --- compute groundwater component of flow
-    if ( GW->b1 == 0.0 ) t1 = GW->a1;
-    else t1 = GW->a1 * pow( (lowerDepth - Hstar)*UCF(LENGTH), GW->b1);
+    if ( gw->b1 == 0.0 ) t1 = gw->a1;
+    else t1 = gw->a1 * pow( (lowerDepth - s->hstar)*UCF(LENGTH), gw->b1);
 
     // --- compute surface water component of flow
-    if ( GW->b2 == 0.0 ) t2 = GW->a2;
-    else if (Hsw > Hstar)
+    if ( gw->b2 == 0.0 ) t2 = gw->a2;
+    else if (s->hsw > s->hstar)
     {
-        t2 = GW->a2 * pow( (Hsw - Hstar)*UCF(LENGTH), GW->b2);
+        t2 = gw->a2 * pow( (s->hsw - s->hstar)*UCF(LENGTH), gw->b2);
     }
     else t2 = 0.0;
 
     // --- compute groundwater/surface water interaction term
-    t3 = GW->a3 * lowerDepth * Hsw * UCF(LENGTH) * UCF(LENGTH);
+    t3 = gw->a3 * lowerDepth * s->hsw * UCF(LENGTH) * UCF(LENGTH);
 
     // --- compute total groundwater flow
-    q = (t1 - t2 + t3) / UCF(GWFLOW); 
-    if ( q < 0.0 && GW->a3 != 0.0 ) q = 0.0;
+    q = (t1 - t2 + t3) / UCF(GWFLOW);
+    if ( q < 0.0 && gw->a3 != 0.0 ) q = 0.0;
     return q;
 }
 
@@ -851,26 +1030,23 @@ int  getVariableIndex(char* s)
 
 //=============================================================================
 
-double getVariableValue(int varIndex)
+void getVariableValues(TGwaterState* s, double values[])
 //
-//  Input:   varIndex = index of a GW variable
-//  Output:  returns current value of GW variable
-//  Purpose: finds current value of a GW variable.
+//  Input:   s = state of GW being analyzed
+//  Output:  values = current value of each GW variable
+//  Purpose: finds current values of the GW variables that can appear in
+//           a custom GW flow expression.
 //
 {
-    switch (varIndex)
-    {
-    case gwvHGW:  return Hgw * UCF(LENGTH);
-    case gwvHSW:  return Hsw * UCF(LENGTH);
-    case gwvHCB:  return Hstar * UCF(LENGTH);
-    case gwvHGS:  return TotalDepth * UCF(LENGTH);
-    case gwvKS:   return A.conductivity * UCF(RAINFALL);
-    case gwvK:    return HydCon * UCF(RAINFALL);
-    case gwvTHETA:return Theta;
-    case gwvPHI:  return A.porosity;
-    case gwvFI:   return Infil * UCF(RAINFALL); 
-    case gwvFU:   return UpperPerc * UCF(RAINFALL);
-    case gwvA:    return Area * UCF(LANDAREA);
-    default:      return 0.0;
-    }
+    values[gwvHGW]   = s->hgw * UCF(LENGTH);
+    values[gwvHSW]   = s->hsw * UCF(LENGTH);
+    values[gwvHCB]   = s->hstar * UCF(LENGTH);
+    values[gwvHGS]   = s->totalDepth * UCF(LENGTH);
+    values[gwvKS]    = s->a->conductivity * UCF(RAINFALL);
+    values[gwvK]     = s->hydCon * UCF(RAINFALL);
+    values[gwvTHETA] = s->theta;
+    values[gwvPHI]   = s->a->porosity;
+    values[gwvFI]    = s->infil * UCF(RAINFALL);
+    values[gwvFU]    = s->upperPerc * UCF(RAINFALL);
+    values[gwvA]     = s->area * UCF(LANDAREA);
 }
@@ -7,7 +7,15 @@
 //   Written by L. Rossman
 //   Last Updated on 6/19/03
 //
-//   The hash table data structure (HTable) is defined in "hash.h".
+//   Build 5.1.015:
+//   - Fixed size table of chained entries replaced with an open addressing
+//     table (linear probing) that doubles in size as entries are added.
+//   - Fletcher checksum replaced with the FNV-1a hash of the upper case
+//     string, followed by a final mixing step.
+//
+//   The hash table data structure (HTtable) is defined in "hash.h".
+//   The table does not copy key strings; callers store them (SWMM keeps
+//   object ID names in its mempool memory pool).
 //   Interface Functions:
 //      HTcreate() - creates a hash table
 //      HTinsert() - inserts a string & its index value into a hash table
@@ -17,6 +25,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include "hash.h"
 #define UCHAR(x) (((x) >= 'a' && (x) <= 'z') ? ((x)&~32) : (x))
 
@@ -29,89 +38,116 @@ int  samestr(char *s1, char *s2)
    return(0);
 }                                       /*  End of samestr  */
 
-/* Use Fletcher's checksum to compute 2-byte hash of string */
+/* Compute a 4-byte FNV-1a hash of an upper case copy of a string */
 unsigned int hash(char *str)
 {
-    unsigned int sum1= 0, check1;
-    unsigned long sum2= 0L;
-	while(  '\0' != *str  )
+    unsigned int h = 2166136261u;
+    while ( '\0' != *str )
     {
-        sum1 += UCHAR(*str);
+        h ^= (unsigned char)UCHAR(*str);
+        h *= 16777619u;
         str++;
-        if (  255 <= sum1  ) sum1 -= 255;
-        sum2 += sum1;
     }
-    check1= sum2;
-    check1 %= 255;
-    check1= 255 - (sum1+check1) % 255;
-    sum1= 255 - (sum1+check1) % 255;
-    return( ( ( check1 << 8 )  |  sum1  ) % HTMAXSIZE);
+
+    /* mix the bits so that the low ones used to index the table
+       depend on all of the string's characters */
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+/* Find the slot holding key or, if key is not in the table, the empty
+   slot where it belongs */
+static struct HTentry *findslot(HTtable *ht, char *key, unsigned int h)
+{
+    unsigned int i = h & (ht->size - 1);
+    struct HTentry *entry;
+    for (;;)
+    {
+        entry = &ht->entries[i];
+        if ( entry->key == NULL ) return(entry);
+        if ( entry->hash == h && samestr(entry->key, key) ) return(entry);
+        i = (i + 1) & (ht->size - 1);
+    }
+}
+
+/* Double the number of slots in a table, re-inserting its entries */
+static int grow(HTtable *ht)
+{
+    struct HTentry *old = ht->entries;
+    struct HTentry *entry;
+    unsigned int i, oldsize = ht->size;
+
+    if ( ht->size > UINT_MAX / 2 / sizeof(struct HTentry) ) return(0);
+    entry = (struct HTentry *) calloc(2 * oldsize, sizeof(struct HTentry));
+    if ( entry == NULL ) return(0);
+    ht->entries = entry;
+    ht->size = 2 * oldsize;
+    for (i=0; i<oldsize; i++)
+    {
+        if ( old[i].key == NULL ) continue;
+        entry = &ht->entries[old[i].hash & (ht->size - 1)];
+        while ( entry->key != NULL )
+        {
+            entry++;
+            if ( entry == ht->entries + ht->size ) entry = ht->entries;
+        }
+        *entry = old[i];
+    }
+    free(old);
+    return(1);
 }
 
 HTtable *HTcreate()
 {
-        int i;
-        HTtable *ht = (HTtable *) calloc(HTMAXSIZE, sizeof(HTtable));
-        if (ht != NULL) for (i=0; i<HTMAXSIZE; i++) ht[i] = NULL;
-        return(ht);
+    HTtable *ht = (HTtable *) malloc(sizeof(HTtable));
+    if ( ht == NULL ) return(NULL);
+    ht->entries = (struct HTentry *) calloc(HTMINSIZE, sizeof(struct HTentry));
+    if ( ht->entries == NULL )
+    {
+        free(ht);
+        return(NULL);
+    }
+    ht->size = HTMINSIZE;
+    ht->count = 0;
+    return(ht);
 }
 
+/* A key already in the table has its entry replaced (the most recently
+   inserted entry of a key is the one that is found) */
 int     HTinsert(HTtable *ht, char *key, int data)
 {
-        unsigned int i = hash(key);
-        struct HTentry *entry;
-        if ( i >= HTMAXSIZE ) return(0);
-        entry = (struct HTentry *) malloc(sizeof(struct HTentry));
-        if (entry == NULL) return(0);
-        entry->key = key;
-        entry->data = data;
-        entry->next = ht[i];
-        ht[i] = entry;
-        return(1);
+    unsigned int h = hash(key);
+    struct HTentry *entry;
+
+    /* keep the table at most half full */
+    if ( 2 * (ht->count + 1) > ht->size && !grow(ht) ) return(0);
+    entry = findslot(ht, key, h);
+    if ( entry->key == NULL ) ht->count++;
+    entry->key = key;
+    entry->data = data;
+    entry->hash = h;
+    return(1);
 }
 
 int     HTfind(HTtable *ht, char *key)
 {
-        unsigned int i = hash(key);
-        struct HTentry *entry;
-        if ( i >= HTMAXSIZE ) return(NOTFOUND);
-        entry = ht[i];
-        while (entry != NULL)
-        {
-            if ( samestr(entry->key,key) ) return(entry->data);
-            entry = entry->next;
-        }
-        return(NOTFOUND);
+    struct HTentry *entry = findslot(ht, key, hash(key));
+    if ( entry->key == NULL ) return(NOTFOUND);
+    return(entry->data);
 }
 
 char    *HTfindKey(HTtable *ht, char *key)
 {
-        unsigned int i = hash(key);
-        struct HTentry *entry;
-        if ( i >= HTMAXSIZE ) return(NULL);
-        entry = ht[i];
-        while (entry != NULL)
-        {
-            if ( samestr(entry->key,key) ) return(entry->key);
-            entry = entry->next;
-        }
-        return(NULL);
+    struct HTentry *entry = findslot(ht, key, hash(key));
+    return(entry->key);
 }
 
 void    HTfree(HTtable *ht)
 {
-        struct HTentry *entry,
-                       *nextentry;
-        int i;
-        for (i=0; i<HTMAXSIZE; i++)
-        {
-            entry = ht[i];
-            while (entry != NULL)
-            {
-                nextentry = entry->next;
-                free(entry);
-                entry = nextentry;
-            }
-        }
-        free(ht);
+    free(ht->entries);
+    free(ht);
 }
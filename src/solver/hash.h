@@ -4,17 +4,22 @@
 //   Header file for Hash Table module hash.c.
 //-----------------------------------------------------------------------------
 
-#define HTMAXSIZE 1999
+#define HTMINSIZE 64
 #define NOTFOUND  -1
 
 struct HTentry
 {
     char   *key;
     int    data;
-    struct HTentry *next;
+    unsigned int hash;
 };
 
-typedef struct HTentry *HTtable;
+typedef struct
+{
+    struct HTentry *entries;
+    unsigned int   size;
+    unsigned int   count;
+}   HTtable;
 
 HTtable *HTcreate(void);
 int     HTinsert(HTtable *, char *, int);
@@ -37,6 +37,13 @@
 //   Build 5.1.011:
 //   - Link control setting bug when reading a hot start file fixed.    
 //
+//   Build 5.1.015:
+//   - A new hot start file format (version 5) stores the state of all
+//     objects in double precision as a table of sections, each holding a
+//     contiguous array of one state variable for all objects along with a
+//     checksum. The file is written and read in a single pass. Files in
+//     earlier formats can still be read.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -51,6 +58,36 @@
 //-----------------------------------------------------------------------------
 static int fileVersion;
 
+//-----------------------------------------------------------------------------
+//  Version 5 file sections
+//-----------------------------------------------------------------------------
+enum HotstartSectionType {
+    HS_SUBCATCH_DEPTH,       // ponded depth of each sub-area (3 per subcatch)
+    HS_SUBCATCH_RUNOFF,      // runoff
+    HS_SUBCATCH_INFIL,       // infiltration state (6 per subcatch)
+    HS_SUBCATCH_GWATER,      // groundwater state (4 per groundwater object)
+    HS_SUBCATCH_SNOW,        // snowpack state (15 per snowpack)
+    HS_SUBCATCH_QUAL,        // runoff quality (per pollutant)
+    HS_SUBCATCH_PONDED_QUAL, // ponded quality (per pollutant)
+    HS_SUBCATCH_BUILDUP,     // buildup (per land use & pollutant)
+    HS_SUBCATCH_LAST_SWEPT,  // date of last street sweeping (per land use)
+    HS_NODE_DEPTH,           // water depth
+    HS_NODE_LATFLOW,         // lateral inflow
+    HS_NODE_HRT,             // hydraulic residence time (per storage node)
+    HS_NODE_QUAL,            // quality (per pollutant)
+    HS_LINK_FLOW,            // flow rate
+    HS_LINK_DEPTH,           // flow depth
+    HS_LINK_SETTING,         // control setting
+    HS_LINK_QUAL,            // quality (per pollutant)
+    MAX_HOTSTART_SECTIONS};
+
+typedef struct
+{
+    int          type;         // type of state variable held in section
+    int          size;         // number of values in section
+    unsigned int checksum[2];  // Fletcher-64 checksum of section's values
+}  THotstartSection;
+
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)
 //-----------------------------------------------------------------------------
@@ -63,11 +100,15 @@ static int fileVersion;
 static int  openHotstartFile1(void); 
 static int  openHotstartFile2(void);       
 static void readRunoff(void);
-static void saveRunoff(void);
 static void readRouting(void);
-static void saveRouting(void);
 static int  readFloat(float *x, FILE* f);
 static int  readDouble(double* x, FILE* f);
+static void saveState(void);                                                   //(5.1.015)
+static void readState(void);                                                   //(5.1.015)
+static int  getSectionSize(int type);                                          //(5.1.015)
+static void getSection(int type, double* x);                                   //(5.1.015)
+static void setSection(int type, double* x);                                   //(5.1.015)
+static void getChecksum(double* x, int n, unsigned int sum[2]);                //(5.1.015)
 
 //=============================================================================
 
@@ -85,8 +126,7 @@ void hotstart_close()
 {
     if ( Fhotstart2.file )
     {
-        saveRunoff();
-        saveRouting();
+        saveState();                                                           //(5.1.015)
         fclose(Fhotstart2.file);
     }
 }
@@ -112,6 +152,7 @@ int openHotstartFile1()
     char  fileStamp2[] = "SWMM5-HOTSTART2";
     char  fileStamp3[] = "SWMM5-HOTSTART3";
     char  fileStamp4[] = "SWMM5-HOTSTART4";
+    char  fileStamp5[] = "SWMM5-HOTSTART5";                                   //(5.1.015)
 
     // --- try to open the file
     if ( Fhotstart1.mode != USE_FILE ) return TRUE;
@@ -123,7 +164,8 @@ int openHotstartFile1()
 
     // --- check that file contains proper header records
     fread(fStampx, sizeof(char), strlen(fileStamp2), Fhotstart1.file);
-    if      ( strcmp(fStampx, fileStamp4) == 0 ) fileVersion = 4;
+    if      ( strcmp(fStampx, fileStamp5) == 0 ) fileVersion = 5;             //(5.1.015)
+    else if ( strcmp(fStampx, fileStamp4) == 0 ) fileVersion = 4;
     else if ( strcmp(fStampx, fileStamp3) == 0 ) fileVersion = 3;
     else if ( strcmp(fStampx, fileStamp2) == 0 ) fileVersion = 2;
     else
@@ -170,8 +212,12 @@ int openHotstartFile1()
     }
 
     // --- read contents of the file and close it
-    if ( fileVersion >= 3 ) readRunoff();
-    readRouting();
+    if ( fileVersion >= 5 ) readState();                                       //(5.1.015)
+    else                                                                       //(5.1.015)
+    {                                                                          //(5.1.015)
+        if ( fileVersion >= 3 ) readRunoff();
+        readRouting();
+    }                                                                          //(5.1.015)
     fclose(Fhotstart1.file);
     if ( ErrorCode ) return FALSE;
     else return TRUE;
@@ -192,7 +238,7 @@ int openHotstartFile2()
     int   nLinks;
     int   nPollut;
     int   flowUnits;
-    char  fileStamp[] = "SWMM5-HOTSTART4";
+    char  fileStamp[] = "SWMM5-HOTSTART5";                                    //(5.1.015)
 
     // --- try to open file
     if ( Fhotstart2.mode != SAVE_FILE ) return TRUE;
@@ -221,51 +267,6 @@ int openHotstartFile2()
 
 //=============================================================================
 
-void  saveRouting()
-//
-//  Input:   none
-//  Output:  none
-//  Purpose: saves current state of all nodes and links to hotstart file.
-//
-{
-    int   i, j;
-    float x[3];
-
-    for (i = 0; i < Nobjects[NODE]; i++)
-    {
-        x[0] = (float)Node[i].newDepth;
-        x[1] = (float)Node[i].newLatFlow;
-        fwrite(x, sizeof(float), 2, Fhotstart2.file);
-
-        if ( Node[i].type == STORAGE )
-        {
-            j = Node[i].subIndex;
-            x[0] = (float)Storage[j].hrt;
-            fwrite(&x[0], sizeof(float), 1, Fhotstart2.file);
-        }
-
-        for (j = 0; j < Nobjects[POLLUT]; j++)
-        {
-            x[0] = (float)Node[i].newQual[j];
-            fwrite(&x[0], sizeof(float), 1, Fhotstart2.file);
-        }
-    }
-    for (i = 0; i < Nobjects[LINK]; i++)
-    {
-        x[0] = (float)Link[i].newFlow;
-        x[1] = (float)Link[i].newDepth;
-        x[2] = (float)Link[i].setting;
-        fwrite(x, sizeof(float), 3, Fhotstart2.file);
-        for (j = 0; j < Nobjects[POLLUT]; j++)
-        {
-            x[0] = (float)Link[i].newQual[j];
-            fwrite(&x[0], sizeof(float), 1, Fhotstart2.file);
-        }
-    }
-}
-
-//=============================================================================
-
 void readRouting()
 //
 //  Input:   none 
@@ -355,76 +356,6 @@ void readRouting()
 
 //=============================================================================
 
-void  saveRunoff(void)
-//
-//  Input:   none
-//  Output:  none
-//  Purpose: saves current state of all subcatchments to hotstart file.
-//
-{
-    int   i, j, k, sizeX;
-    double* x;
-    FILE*  f = Fhotstart2.file;
-
-    sizeX = MAX(6, Nobjects[POLLUT]+1);
-    x = (double *) calloc(sizeX, sizeof(double));
-
-    for (i = 0; i < Nobjects[SUBCATCH]; i++)
-    {
-        // Ponded depths for each sub-area & total runoff (4 elements)
-        for (j = 0; j < 3; j++) x[j] = Subcatch[i].subArea[j].depth;
-        x[3] = Subcatch[i].newRunoff;
-        fwrite(x, sizeof(double), 4, f);
-
-        // Infiltration state (max. of 6 elements)
-        for (j=0; j<sizeX; j++) x[j] = 0.0;
-        infil_getState(i, InfilModel, x);
-        fwrite(x, sizeof(double), 6, f);
-
-        // Groundwater state (4 elements)
-        if ( Subcatch[i].groundwater != NULL )
-        {
-            gwater_getState(i, x);
-            fwrite(x, sizeof(double), 4, f);
-        }
-
-        // Snowpack state (5 elements for each of 3 snow surfaces)
-        if ( Subcatch[i].snowpack != NULL )
-        {
-            for (j=0; j<3; j++)
-            {
-                snow_getState(i, j, x);
-                fwrite(x, sizeof(double), 5, f);
-            }
-        }
-
-        // Water quality
-        if ( Nobjects[POLLUT] > 0 )
-        {
-            // Runoff quality
-            for (j=0; j<Nobjects[POLLUT]; j++) x[j] = Subcatch[i].newQual[j];
-            fwrite(x, sizeof(double), Nobjects[POLLUT], f);
-
-            // Ponded quality
-            for (j=0; j<Nobjects[POLLUT]; j++) x[j] = Subcatch[i].pondedQual[j];
-            fwrite(x, sizeof(double), Nobjects[POLLUT], f);
-            
-            // Buildup and when streets were last swept
-            for (k=0; k<Nobjects[LANDUSE]; k++)
-            {
-                for (j=0; j<Nobjects[POLLUT]; j++)
-                    x[j] = Subcatch[i].landFactor[k].buildup[j];
-                fwrite(x, sizeof(double), Nobjects[POLLUT], f);
-                x[0] = Subcatch[i].landFactor[k].lastSwept;
-                fwrite(x, sizeof(double), 1, f);
-            }
-        }
-    }
-    free(x);
-}
-
-//=============================================================================
-
 void  readRunoff()
 //
 //  Input:   none
@@ -540,3 +471,412 @@ int  readDouble(double* x, FILE* f)
     }
     return TRUE;
 }
+
+//=============================================================================
+////  The following functions were added for release 5.1.015.  ////
+
+void  saveState()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: saves the current state of all subcatchments, nodes and links
+//           to a version 5 hot start file.
+//
+{
+    int    i, n, total = 0;
+    double *x;
+    THotstartSection section[MAX_HOTSTART_SECTIONS];
+    FILE*  f = Fhotstart2.file;
+
+    // --- find size of each section and place all values in one array
+    for (i = 0; i < MAX_HOTSTART_SECTIONS; i++)
+    {
+        section[i].type = i;
+        section[i].size = getSectionSize(i);
+        total += section[i].size;
+    }
+    x = (double *) malloc(MAX(total, 1) * sizeof(double));
+    if ( x == NULL )
+    {
+        report_writeErrorMsg(ERR_MEMORY, "");
+        return;
+    }
+    for (i = 0, n = 0; i < MAX_HOTSTART_SECTIONS; i++)
+    {
+        getSection(i, &x[n]);
+        getChecksum(&x[n], section[i].size, section[i].checksum);
+        n += section[i].size;
+    }
+
+    // --- write section table followed by section values
+    n = MAX_HOTSTART_SECTIONS;
+    fwrite(&n, sizeof(int), 1, f);
+    fwrite(section, sizeof(THotstartSection), n, f);
+    fwrite(x, sizeof(double), total, f);
+    free(x);
+}
+
+//=============================================================================
+
+void  readState()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: reads the saved state of all subcatchments, nodes and links
+//           from a version 5 hot start file.
+//
+{
+    int    i, j, n, total = 0;
+    int    found[MAX_HOTSTART_SECTIONS];
+    int    offset[MAX_HOTSTART_SECTIONS];
+    unsigned int sum[2];
+    double *x = NULL;
+    THotstartSection *section = NULL;
+    FILE*  f = Fhotstart1.file;
+
+    // --- read section table
+    if ( fread(&n, sizeof(int), 1, f) != 1 || n <= 0 ) n = 0;
+    else section = (THotstartSection *) malloc(n * sizeof(THotstartSection));
+    if ( section == NULL ||
+         fread(section, sizeof(THotstartSection), n, f) != (size_t)n )
+    {
+        report_writeErrorMsg(ERR_HOTSTART_FILE_READ, "");
+        free(section);
+        return;
+    }
+
+    // --- locate the sections used by this version of SWMM (others are
+    //     skipped over) and check that each holds the number of values
+    //     needed by the current project
+    for (i = 0; i < MAX_HOTSTART_SECTIONS; i++) found[i] = -1;
+    for (j = 0; j < n; j++)
+    {
+        i = section[j].type;
+        if ( section[j].size < 0 ) break;
+        if ( i >= 0 && i < MAX_HOTSTART_SECTIONS )
+        {
+            if ( found[i] >= 0 || section[j].size != getSectionSize(i) ) break;
+            found[i] = j;
+            offset[i] = total;
+        }
+        total += section[j].size;
+    }
+    for (i = 0; i < MAX_HOTSTART_SECTIONS; i++)
+    {
+        if ( found[i] < 0 ) j = -1;
+    }
+    if ( j != n )
+    {
+        report_writeErrorMsg(ERR_HOTSTART_FILE_FORMAT, "");
+        free(section);
+        return;
+    }
+
+    // --- read the values of all sections at once
+    x = (double *) malloc(MAX(total, 1) * sizeof(double));
+    if ( x == NULL )
+    {
+        report_writeErrorMsg(ERR_MEMORY, "");
+        free(section);
+        return;
+    }
+    if ( fread(x, sizeof(double), total, f) != (size_t)total )
+    {
+        report_writeErrorMsg(ERR_HOTSTART_FILE_READ, "");
+        free(section);
+        free(x);
+        return;
+    }
+
+    // --- verify each section's checksum and values before any object's
+    //     state is changed
+    for (i = 0; i < MAX_HOTSTART_SECTIONS; i++)
+    {
+        n = section[found[i]].size;
+        getChecksum(&x[offset[i]], n, sum);
+        if ( sum[0] != section[found[i]].checksum[0] ||
+             sum[1] != section[found[i]].checksum[1] ) break;
+        for (j = 0; j < n; j++)
+        {
+            if ( x[offset[i]+j] != x[offset[i]+j] ) break;
+        }
+        if ( j < n ) break;
+    }
+    if ( i < MAX_HOTSTART_SECTIONS )
+    {
+        report_writeErrorMsg(ERR_HOTSTART_FILE_READ, "");
+        free(section);
+        free(x);
+        return;
+    }
+
+    // --- assign saved values to objects
+    for (i = 0; i < MAX_HOTSTART_SECTIONS; i++) setSection(i, &x[offset[i]]);
+    free(section);
+    free(x);
+}
+
+//=============================================================================
+
+int  getSectionSize(int type)
+//
+//  Input:   type = type of hot start file section
+//  Output:  returns number of values in the section
+//  Purpose: finds the size of a hot start file section for the current
+//           project.
+//
+{
+    int i, n = 0;
+    switch (type)
+    {
+      case HS_SUBCATCH_DEPTH:   return 3 * Nobjects[SUBCATCH];
+      case HS_SUBCATCH_RUNOFF:  return Nobjects[SUBCATCH];
+      case HS_SUBCATCH_INFIL:   return 6 * Nobjects[SUBCATCH];
+      case HS_SUBCATCH_GWATER:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++)
+            if ( Subcatch[i].groundwater != NULL ) n += 4;
+        return n;
+      case HS_SUBCATCH_SNOW:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++)
+            if ( Subcatch[i].snowpack != NULL ) n += 15;
+        return n;
+      case HS_SUBCATCH_QUAL:
+      case HS_SUBCATCH_PONDED_QUAL:
+        return Nobjects[SUBCATCH] * Nobjects[POLLUT];
+      case HS_SUBCATCH_BUILDUP:
+        return Nobjects[SUBCATCH] * Nobjects[LANDUSE] * Nobjects[POLLUT];
+      case HS_SUBCATCH_LAST_SWEPT: return Nobjects[SUBCATCH] * Nobjects[LANDUSE];
+      case HS_NODE_DEPTH:
+      case HS_NODE_LATFLOW:     return Nobjects[NODE];
+      case HS_NODE_HRT:         return Nnodes[STORAGE];
+      case HS_NODE_QUAL:        return Nobjects[NODE] * Nobjects[POLLUT];
+      case HS_LINK_FLOW:
+      case HS_LINK_DEPTH:
+      case HS_LINK_SETTING:     return Nobjects[LINK];
+      case HS_LINK_QUAL:        return Nobjects[LINK] * Nobjects[POLLUT];
+    }
+    return 0;
+}
+
+//=============================================================================
+
+void  getSection(int type, double* x)
+//
+//  Input:   type = type of hot start file section
+//  Output:  x = array of the section's values
+//  Purpose: retrieves the current values of a hot start file section's
+//           state variable for all objects.
+//
+{
+    int i, j, k, n = 0;
+    switch (type)
+    {
+      case HS_SUBCATCH_DEPTH:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++)
+            for (j = 0; j < 3; j++) x[n++] = Subcatch[i].subArea[j].depth;
+        break;
+      case HS_SUBCATCH_RUNOFF:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++) x[i] = Subcatch[i].newRunoff;
+        break;
+      case HS_SUBCATCH_INFIL:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++, n += 6)
+        {
+            for (j = 0; j < 6; j++) x[n+j] = 0.0;
+            infil_getState(i, InfilModel, &x[n]);
+        }
+        break;
+      case HS_SUBCATCH_GWATER:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++)
+        {
+            if ( Subcatch[i].groundwater == NULL ) continue;
+            gwater_getState(i, &x[n]);
+            n += 4;
+        }
+        break;
+      case HS_SUBCATCH_SNOW:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++)
+        {
+            if ( Subcatch[i].snowpack == NULL ) continue;
+            for (j = 0; j < 3; j++, n += 5) snow_getState(i, j, &x[n]);
+        }
+        break;
+      case HS_SUBCATCH_QUAL:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++)
+            for (j = 0; j < Nobjects[POLLUT]; j++)
+                x[n++] = Subcatch[i].newQual[j];
+        break;
+      case HS_SUBCATCH_PONDED_QUAL:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++)
+            for (j = 0; j < Nobjects[POLLUT]; j++)
+                x[n++] = Subcatch[i].pondedQual[j];
+        break;
+      case HS_SUBCATCH_BUILDUP:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++)
+            for (k = 0; k < Nobjects[LANDUSE]; k++)
+                for (j = 0; j < Nobjects[POLLUT]; j++)
+                    x[n++] = Subcatch[i].landFactor[k].buildup[j];
+        break;
+      case HS_SUBCATCH_LAST_SWEPT:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++)
+            for (k = 0; k < Nobjects[LANDUSE]; k++)
+                x[n++] = Subcatch[i].landFactor[k].lastSwept;
+        break;
+      case HS_NODE_DEPTH:
+        for (i = 0; i < Nobjects[NODE]; i++) x[i] = Node[i].newDepth;
+        break;
+      case HS_NODE_LATFLOW:
+        for (i = 0; i < Nobjects[NODE]; i++) x[i] = Node[i].newLatFlow;
+        break;
+      case HS_NODE_HRT:
+        for (i = 0; i < Nnodes[STORAGE]; i++) x[i] = Storage[i].hrt;
+        break;
+      case HS_NODE_QUAL:
+        for (i = 0; i < Nobjects[NODE]; i++)
+            for (j = 0; j < Nobjects[POLLUT]; j++) x[n++] = Node[i].newQual[j];
+        break;
+      case HS_LINK_FLOW:
+        for (i = 0; i < Nobjects[LINK]; i++) x[i] = Link[i].newFlow;
+        break;
+      case HS_LINK_DEPTH:
+        for (i = 0; i < Nobjects[LINK]; i++) x[i] = Link[i].newDepth;
+        break;
+      case HS_LINK_SETTING:
+        for (i = 0; i < Nobjects[LINK]; i++) x[i] = Link[i].setting;
+        break;
+      case HS_LINK_QUAL:
+        for (i = 0; i < Nobjects[LINK]; i++)
+            for (j = 0; j < Nobjects[POLLUT]; j++) x[n++] = Link[i].newQual[j];
+        break;
+    }
+}
+
+//=============================================================================
+
+void  setSection(int type, double* x)
+//
+//  Input:   type = type of hot start file section
+//           x = array of the section's values
+//  Output:  none
+//  Purpose: assigns the values of a hot start file section's state variable
+//           to all objects.
+//
+{
+    int i, j, k, n = 0;
+    switch (type)
+    {
+      case HS_SUBCATCH_DEPTH:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++)
+            for (j = 0; j < 3; j++) Subcatch[i].subArea[j].depth = x[n++];
+        break;
+      case HS_SUBCATCH_RUNOFF:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++) Subcatch[i].newRunoff = x[i];
+        break;
+      case HS_SUBCATCH_INFIL:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++, n += 6)
+            infil_setState(i, InfilModel, &x[n]);
+        break;
+      case HS_SUBCATCH_GWATER:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++)
+        {
+            if ( Subcatch[i].groundwater == NULL ) continue;
+            gwater_setState(i, &x[n]);
+            n += 4;
+        }
+        break;
+      case HS_SUBCATCH_SNOW:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++)
+        {
+            if ( Subcatch[i].snowpack == NULL ) continue;
+            for (j = 0; j < 3; j++, n += 5) snow_setState(i, j, &x[n]);
+        }
+        break;
+      case HS_SUBCATCH_QUAL:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++)
+            for (j = 0; j < Nobjects[POLLUT]; j++)
+                Subcatch[i].newQual[j] = x[n++];
+        break;
+      case HS_SUBCATCH_PONDED_QUAL:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++)
+            for (j = 0; j < Nobjects[POLLUT]; j++)
+                Subcatch[i].pondedQual[j] = x[n++];
+        break;
+      case HS_SUBCATCH_BUILDUP:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++)
+            for (k = 0; k < Nobjects[LANDUSE]; k++)
+                for (j = 0; j < Nobjects[POLLUT]; j++)
+                    Subcatch[i].landFactor[k].buildup[j] = x[n++];
+        break;
+      case HS_SUBCATCH_LAST_SWEPT:
+        for (i = 0; i < Nobjects[SUBCATCH]; i++)
+            for (k = 0; k < Nobjects[LANDUSE]; k++)
+                Subcatch[i].landFactor[k].lastSwept = x[n++];
+        break;
+      case HS_NODE_DEPTH:
+        for (i = 0; i < Nobjects[NODE]; i++) Node[i].newDepth = x[i];
+        break;
+      case HS_NODE_LATFLOW:
+        for (i = 0; i < Nobjects[NODE]; i++) Node[i].newLatFlow = x[i];
+        break;
+      case HS_NODE_HRT:
+        for (i = 0; i < Nnodes[STORAGE]; i++) Storage[i].hrt = x[i];
+        break;
+      case HS_NODE_QUAL:
+        for (i = 0; i < Nobjects[NODE]; i++)
+            for (j = 0; j < Nobjects[POLLUT]; j++) Node[i].newQual[j] = x[n++];
+        break;
+      case HS_LINK_FLOW:
+        for (i = 0; i < Nobjects[LINK]; i++) Link[i].newFlow = x[i];
+        break;
+      case HS_LINK_DEPTH:
+        for (i = 0; i < Nobjects[LINK]; i++) Link[i].newDepth = x[i];
+        break;
+      case HS_LINK_SETTING:
+        // --- set each link's target setting to its saved setting
+        for (i = 0; i < Nobjects[LINK]; i++)
+        {
+            Link[i].setting = x[i];
+            Link[i].targetSetting = x[i];
+            link_setTargetSetting(i);
+            link_setSetting(i, 0.0);
+        }
+        break;
+      case HS_LINK_QUAL:
+        for (i = 0; i < Nobjects[LINK]; i++)
+            for (j = 0; j < Nobjects[POLLUT]; j++) Link[i].newQual[j] = x[n++];
+        break;
+    }
+}
+
+//=============================================================================
+
+void  getChecksum(double* x, int n, unsigned int sum[2])
+//
+//  Input:   x = array of values
+//           n = number of values
+//  Output:  sum = Fletcher-64 checksum of the values
+//  Purpose: computes a checksum of the 32-bit words that make up an array
+//           of double precision values.
+//
+{
+    int i, k;
+    unsigned int w[2];
+    unsigned long long sum1 = 0, sum2 = 0;
+
+    for (i = 0; i < n; i += k)
+    {
+        // --- the sums can't overflow over a block of this many values
+        //     before being reduced
+        for (k = 0; k < 8192 && i+k < n; k++)
+        {
+            memcpy(w, &x[i+k], sizeof(double));
+            sum1 += w[0];
+            sum2 += sum1;
+            sum1 += w[1];
+            sum2 += sum1;
+        }
+        sum1 %= 0xffffffff;
+        sum2 %= 0xffffffff;
+    }
+    sum[0] = (unsigned int)sum1;
+    sum[1] = (unsigned int)sum2;
+}
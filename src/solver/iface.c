@@ -7,6 +7,11 @@
 //   Author:   L. Rossman
 //
 //   Routing interface file functions.
+//
+//   Build 5.1.015:
+//   - New function iface_snapshot saves and restores the interface file
+//     inflows in use.
+//   - Lines of inflows interface file parsed with reentrant sstrtok().
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -46,6 +51,7 @@ static DateTime NewIfaceDate;          // next date of interface values
 //  iface_getIfaceFlow       (called by addIfaceInflows in routing.c)
 //  iface_getIfaceQual       (called by addIfaceInflows in routing.c)
 //  iface_saveOutletResults  (called by output_saveResults)
+//  iface_snapshot           (called by visitState in snapshot.c)
 
 //-----------------------------------------------------------------------------
 //  Local functions
@@ -125,6 +131,19 @@ int iface_readFileParams(char* tok[], int ntoks)
         Foutflows.mode = k;
         sstrncpy(Foutflows.name, tok[2], MAXFNAME);
         break;
+
+      case CLIMATE_FILE:                                                       //(5.1.015)
+        if ( k != USE_FILE && k != SAVE_FILE )
+            return error_setInpError(ERR_ITEMS, "");
+        Fclimtable.mode = k;
+        sstrncpy(Fclimtable.name, tok[2], MAXFNAME);
+        break;
+
+      case RECORD_FILE:                                                        //(5.1.015)
+        if ( k != SAVE_FILE ) return error_setInpError(ERR_ITEMS, "");
+        Frecord.mode = k;
+        sstrncpy(Frecord.name, tok[2], MAXFNAME);
+        break;
     }
     return 0;
 }
@@ -180,6 +199,29 @@ void iface_closeRoutingFiles()
 
 //=============================================================================
 
+void iface_snapshot(TSnapshot* s)
+//
+//  Input:   s = a simulation state snapshot
+//  Output:  none
+//  Purpose: saves or restores the interface file inflows in use and the
+//           position reached in the inflows interface file.
+//
+{
+    size_t size;
+
+    if ( NumIfaceNodes == 0 || OldIfaceValues == NULL ||
+         NewIfaceValues == NULL ) return;
+    size = NumIfaceNodes * (1 + NumIfacePolluts) * sizeof(double);
+    snapshot_add(s, OldIfaceValues[0], size);
+    snapshot_add(s, NewIfaceValues[0], size);
+    snapshot_add(s, &IfaceFrac, sizeof(double));
+    snapshot_add(s, &OldIfaceDate, sizeof(DateTime));
+    snapshot_add(s, &NewIfaceDate, sizeof(DateTime));
+    snapshot_addFile(s, Finflows.file);
+}
+
+//=============================================================================
+
 int iface_getNumIfaceNodes(DateTime currentDate)
 //
 //  Input:   currentDate = current date/time
@@ -548,6 +590,7 @@ void readNewIfaceValues()
 {
     int    i, j;
     char*  s;
+    char*  next;                       // rest of line being parsed            //(5.1.015)
     int    yr = 0, mon = 0, day = 0,
 		   hr = 0, min = 0, sec = 0;   // year, month, day, hour, minute, second
     char   line[MAXLINE+1];            // line from interface file
@@ -560,35 +603,35 @@ void readNewIfaceValues()
         fgets(line, MAXLINE, Finflows.file);
 
         // --- parse date & time from line
-        if ( strtok(line, SEPSTR) == NULL ) return;
-        s = strtok(NULL, SEPSTR);
+        if ( sstrtok(line, SEPSTR, &next) == NULL ) return;                    //(5.1.015)
+        s = sstrtok(NULL, SEPSTR, &next);                                      //(5.1.015)
         if ( s == NULL ) return;
         yr  = atoi(s);
-        s = strtok(NULL, SEPSTR);
+        s = sstrtok(NULL, SEPSTR, &next);                                      //(5.1.015)
         if ( s == NULL ) return;
         mon = atoi(s);
-        s = strtok(NULL, SEPSTR);
+        s = sstrtok(NULL, SEPSTR, &next);                                      //(5.1.015)
         if ( s == NULL ) return;
         day = atoi(s);
-        s = strtok(NULL, SEPSTR);
+        s = sstrtok(NULL, SEPSTR, &next);                                      //(5.1.015)
         if ( s == NULL ) return;
         hr  = atoi(s);
-        s = strtok(NULL, SEPSTR);
+        s = sstrtok(NULL, SEPSTR, &next);                                      //(5.1.015)
         if ( s == NULL ) return;
         min = atoi(s);
-        s = strtok(NULL, SEPSTR);
+        s = sstrtok(NULL, SEPSTR, &next);                                      //(5.1.015)
         if ( s == NULL ) return;
         sec = atoi(s);
 
         // --- parse flow value
-        s = strtok(NULL, SEPSTR);
+        s = sstrtok(NULL, SEPSTR, &next);                                      //(5.1.015)
         if ( s == NULL ) return;
         NewIfaceValues[i][0] = atof(s) / Qcf[IfaceFlowUnits]; 
 
         // --- parse pollutant values
         for (j=1; j<=NumIfacePolluts; j++)
         {
-            s = strtok(NULL, SEPSTR);
+            s = sstrtok(NULL, SEPSTR, &next);                                  //(5.1.015)
             if ( s == NULL ) return;
             NewIfaceValues[i][j] = atof(s);
         }
@@ -58,6 +58,17 @@ int  DLLEXPORT   swmm_getVersionInfo(char **major, char **minor, char **patch);
 int  DLLEXPORT   swmm_run_cb(const char *f1, const char *f2, const char *f3,
     void (*callback) (double *));
 
+/**
+ @brief Reads and validates a SWMM input file and saves it as a compiled
+ project file. The compiled file is named after the input file with a .swc
+ extension, and swmm_open loads it in place of the input file for as long as
+ the input file is unchanged.
+ @param f1 pointer to name of input file (must exist)
+ @param f2 pointer to name of report file (to be created)
+ @return error code
+*/
+int  DLLEXPORT   swmm_compile(const char *f1, const char *f2);
+
 /**
  @brief Get the text of an error code.
  @param errcode The error code
@@ -356,6 +367,10 @@ int DLLEXPORT swmm_getSimulationDateTime(SM_TimePropety type, int *year, int *mo
  @param minute The minute
  @param second The second
  @return Error code
+
+ Time series data in the input file are only loaded for the dates that
+ cover the simulation period. Moving the start or end date past them
+ reloads the data of the time series in use.
 */
 int DLLEXPORT swmm_setSimulationDateTime(SM_TimePropety type, int year, int month,
                                          int day, int hour, int minute,
@@ -562,6 +577,70 @@ int DLLEXPORT swmm_setOutfallStage(int index, double stage);
 */
 int DLLEXPORT swmm_setGagePrecip(int index, double total_precip);
 
+/**
+ @brief Subscribes to the values of a result variable for a set of elements.
+ @param type The object type (SM_SUBCATCH, SM_NODE or SM_LINK)
+ @param variable The result code (@ref SM_SubcResult, @ref SM_NodeResult or
+ @ref SM_LinkResult, depending on type)
+ @param indexes The indexes of the elements (NULL for all elements of type)
+ @param count The number of indexes
+ @param[out] subscription The position of the subscription's view in the
+ views passed to the results callback
+ @return Error code
+*/
+int DLLEXPORT swmm_subscribeResults(SM_ObjectType type, int variable,
+    int *indexes, int count, int *subscription);
+
+/**
+ @brief Sets a callback that receives a view of every results subscription.
+ @param timing When the callback is made (@ref SM_StreamTiming)
+ @param callback The callback function (NULL to stop streaming)
+ @param userData A pointer passed back to the callback
+ @return Error code
+
+ The views and their values are owned by SWMM and are only valid during the
+ callback. Values are those returned by the result getter functions at the
+ end of the routing step in which the callback is made.
+*/
+int DLLEXPORT swmm_setResultsCallback(SM_StreamTiming timing,
+    SM_ResultsCallback callback, void *userData);
+
+/**
+ @brief Removes all results subscriptions and the results callback.
+ @return Error code
+*/
+int DLLEXPORT swmm_clearResultsSubscriptions(void);
+
+/**
+ @brief Saves the full dynamic state of a running simulation in memory.
+ @param[out] snapshot The new snapshot, to be freed with swmm_deleteSnapshot
+ @return Error code
+
+ The snapshot holds the state of all nodes, links, subcatchments (including
+ groundwater, snow packs and LID units), water quality, control rules,
+ simulation clocks, mass balances and statistics. Snapshots cannot be taken
+ while a simulation is run by swmm_run_cb with runoff computed ahead of
+ routing.
+*/
+int DLLEXPORT swmm_saveSnapshot(SM_Snapshot **snapshot);
+
+/**
+ @brief Returns a running simulation to the state saved in a snapshot.
+ @param snapshot A snapshot taken earlier in the same simulation
+ @return Error code
+
+ The simulation continues from the time the snapshot was taken, exactly as
+ it did then. Results already saved to the output and report files are
+ not rewound. A snapshot can be restored any number of times.
+*/
+int DLLEXPORT swmm_restoreSnapshot(SM_Snapshot *snapshot);
+
+/**
+ @brief Frees the memory used by a snapshot.
+ @param snapshot A snapshot (or NULL)
+*/
+void DLLEXPORT swmm_deleteSnapshot(SM_Snapshot *snapshot);
+
 /**
  @brief Helper function to free memory array allocated in SWMM.
  @param array The pointer to the array
@@ -273,5 +273,11 @@ typedef enum {
     SM_STORAGEDRAIN = 29, /**< Underdrain flow rate layer */
 } SM_LidResult;
 
+/// Results streaming timing codes
+typedef enum {
+    SM_REPORTSTEP   = 0,  /**< Each reporting period */
+    SM_ROUTINGSTEP  = 1   /**< Each routing time step */
+} SM_StreamTiming;
+
 
 #endif /* TOOLKIT_ENUMS_H_ */
@@ -346,5 +346,35 @@ typedef struct
    double        pctError;
 }  SM_RunoffTotals;
 
+/** @struct SM_ResultsView
+ *  @brief Read-only view of a streamed results subscription
+ *
+ *  @var SM_ResultsView::objectType
+ *    object type of the elements (SM_SUBCATCH, SM_NODE or SM_LINK)
+ *  @var SM_ResultsView::variable
+ *    result code of the variable (SM_SubcResult, SM_NodeResult or
+ *    SM_LinkResult)
+ *  @var SM_ResultsView::count
+ *    number of elements
+ *  @var SM_ResultsView::indexes
+ *    index of each element
+ *  @var SM_ResultsView::values
+ *    current value of the variable for each element
+ */
+typedef struct
+{
+   int           objectType;
+   int           variable;
+   int           count;
+   const int*    indexes;
+   const double* values;
+}  SM_ResultsView;
+
+/// Callback receiving the views of all results subscriptions
+typedef void (*SM_ResultsCallback)(double elapsedTime,
+    const SM_ResultsView *views, int count, void *userData);
+
+/// Opaque in-memory snapshot of the state of a running simulation
+typedef struct SM_Snapshot SM_Snapshot;
 
 #endif /* TOOLKIT_STRUCTS_H_ */
\ No newline at end of file
@@ -33,6 +33,12 @@
 //   Build 5.1.013:
 //   - Support added for subcatchment-specific time patterns that adjust
 //     hydraulic conductivity.
+//
+//   Build 5.1.015:
+//   - Green-Ampt functions made reentrant so that LID units can be evaluated
+//     in parallel (see grnampt_getInfilEx).
+//   - New function infil_getInfilFactor() added.
+//   - New function infil_snapshot() added.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -48,7 +54,6 @@ THorton*   HortInfil = NULL;
 TGrnAmpt*  GAInfil   = NULL;
 TCurveNum* CNInfil   = NULL;
 
-static double Fumax;   // saturated water volume in upper soil zone (ft)
 static double InfilFactor;                                                     //(5.1.013)
 
 //-----------------------------------------------------------------------------
@@ -61,11 +66,14 @@ static double InfilFactor;                                                     /
 //  infil_getState   (called by writeRunoffFile in hotstart.c)
 //  infil_setState   (called by readRunoffFile in hotstart.c)
 //  infil_getInfil   (called by getSubareaRunoff in subcatch.c)
+//  infil_getInfilFactor (called by lid_setGroupInflows in lid.c)
+//  infil_snapshot   (called by visitState in snapshot.c)
 
 //  Called locally and by storage node methods in node.c
 //  grnampt_setParams
 //  grnampt_initState
 //  grnampt_getInfil
+//  grnampt_getInfilEx
 
 //-----------------------------------------------------------------------------
 //  Local functions
@@ -82,9 +90,9 @@ static double modHorton_getInfil(THorton *infil, double tstep, double irate,
 static void   grnampt_getState(TGrnAmpt *infil, double x[]);
 static void   grnampt_setState(TGrnAmpt *infil, double x[]);
 static double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep,
-              double irate, double depth, int modelType);
+              double irate, double depth, int modelType, double factor);
 static double grnampt_getSatInfil(TGrnAmpt *infil, double tstep,
-              double irate, double depth);
+              double irate, double depth, double factor);
 static double grnampt_getF2(double f1, double c1, double ks, double ts);
 
 static int    curvenum_setParams(TCurveNum *infil, double p[]);
@@ -141,6 +149,21 @@ void infil_delete()
 
 //=============================================================================
 
+void infil_snapshot(TSnapshot* s)
+//
+//  Input:   s = a simulation state snapshot
+//  Output:  none
+//  Purpose: saves or restores the infiltration state of all subcatchments.
+//
+{
+    int n = Nobjects[SUBCATCH];
+    snapshot_add(s, HortInfil, n * sizeof(THorton));
+    snapshot_add(s, GAInfil, n * sizeof(TGrnAmpt));
+    snapshot_add(s, CNInfil, n * sizeof(TCurveNum));
+}
+
+//=============================================================================
+
 int infil_readParams(int m, char* tok[], int ntoks)
 //
 //  Input:   m = infiltration method code
@@ -295,6 +318,20 @@ void infil_setInfilFactor(int j)
 
 //=============================================================================
 
+////  New function added to release 5.1.015.  ////                             //(5.1.015)
+
+double infil_getInfilFactor()
+//
+//  Input:   none
+//  Output:  returns the current infiltration adjustment factor
+//  Purpose: retrieves the factor last assigned by infil_setInfilFactor.
+//
+{
+    return InfilFactor;
+}
+
+//=============================================================================
+
 double infil_getInfil(int j, int m, double tstep, double rainfall,
                       double runon, double depth)
 //
@@ -639,21 +676,43 @@ double grnampt_getInfil(TGrnAmpt *infil, double tstep, double irate,
 //           or a storage node.
 //
 {
-    // --- find saturated upper soil zone water volume
-    Fumax = infil->IMDmax * infil->Lu * sqrt(InfilFactor);                     //(5.1.013)
+    return grnampt_getInfilEx(infil, tstep, irate, depth, modelType,           //(5.1.015)
+                              InfilFactor);
+}
+
+//=============================================================================
+
+////  New function added to release 5.1.015.  ////                             //(5.1.015)
 
+double grnampt_getInfilEx(TGrnAmpt *infil, double tstep, double irate,
+    double depth, int modelType, double factor)
+//
+//  Input:   infil = ptr. to Green-Ampt infiltration object
+//           tstep =  time step (sec),
+//           irate = net "rainfall" rate to upper zone (ft/sec)
+//           depth = depth of ponded water (ft)
+//           modelType = either GREEN_AMPT or MOD_GREEN_AMPT
+//           factor = hydraulic conductivity adjustment factor
+//  Output:  returns infiltration rate (ft/sec)
+//  Purpose: computes Green-Ampt infiltration using an explicit conductivity
+//           factor, so that it can be called concurrently for different
+//           infiltration objects.
+//
+{
     // --- reduce time until next event
     infil->T -= tstep;
 
     // --- use different procedures depending on upper soil zone saturation
-    if ( infil->Sat ) return grnampt_getSatInfil(infil, tstep, irate, depth);
-    else return grnampt_getUnsatInfil(infil, tstep, irate, depth, modelType);
+    if ( infil->Sat )
+        return grnampt_getSatInfil(infil, tstep, irate, depth, factor);
+    else return grnampt_getUnsatInfil(infil, tstep, irate, depth, modelType,
+                                      factor);
 }
 
 //=============================================================================
 
 double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep, double irate,
-    double depth, int modelType)
+    double depth, int modelType, double factor)
 //
 //  Input:   infil = ptr. to Green-Ampt infiltration object
 //           tstep =  runoff time step (sec),
@@ -662,14 +721,16 @@ double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep, double irate,
 //                   does not include ponded water (added on below)
 //           depth = depth of ponded water (ft)
 //           modelType = either GREEN_AMPT or MOD_GREEN_AMPT
+//           factor = hydraulic conductivity adjustment factor
 //  Output:  returns infiltration rate (ft/sec)
 //  Purpose: computes Green-Ampt infiltration when upper soil zone is
 //           unsaturated.
 //
 {
     double ia, c1, F2, dF, Fs, kr, ts;
-    double ks = infil->Ks * InfilFactor;                                       //(5.1.013)
-    double lu = infil->Lu * sqrt(InfilFactor);                                 //(5.1.013)
+    double ks = infil->Ks * factor;                                            //(5.1.015)
+    double lu = infil->Lu * sqrt(factor);                                      //(5.1.015)
+    double fumax = infil->IMDmax * infil->Lu * sqrt(factor);                   //(5.1.015)
 
     // --- get available infiltration rate (rainfall + ponded water)
     ia = irate + depth / tstep;
@@ -680,7 +741,7 @@ double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep, double irate,
     {
         if ( infil->Fu <= 0.0 ) return 0.0;
         kr = lu / 90000.0 * Evap.recoveryFactor; 
-        dF = kr * Fumax * tstep;
+        dF = kr * fumax * tstep;
         infil->F -= dF;
         infil->Fu -= dF;
         if ( infil->Fu <= 0.0 )
@@ -694,7 +755,7 @@ double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep, double irate,
         // --- if new wet event begins then reset IMD & F
         if ( infil->T <= 0.0 )
         {
-            infil->IMD = (Fumax - infil->Fu) / lu; 
+            infil->IMD = (fumax - infil->Fu) / lu; 
             infil->F = 0.0;
         }
         return 0.0;
@@ -706,10 +767,10 @@ double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep, double irate,
         dF = ia * tstep;
         infil->F += dF;
         infil->Fu += dF;
-        infil->Fu = MIN(infil->Fu, Fumax);
+        infil->Fu = MIN(infil->Fu, fumax);
         if ( modelType == GREEN_AMPT &&  infil->T <= 0.0 )
         {
-            infil->IMD = (Fumax - infil->Fu) / lu;
+            infil->IMD = (fumax - infil->Fu) / lu;
             infil->F = 0.0;
         }
         return ia;
@@ -725,7 +786,7 @@ double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep, double irate,
     if ( infil->F > Fs )
     {
         infil->Sat = TRUE;
-        return grnampt_getSatInfil(infil, tstep, irate, depth);
+        return grnampt_getSatInfil(infil, tstep, irate, depth, factor);
     }
 
     // --- surface layer remains unsaturated
@@ -734,7 +795,7 @@ double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep, double irate,
         dF = ia * tstep;
         infil->F += dF;
         infil->Fu += dF;
-        infil->Fu = MIN(infil->Fu, Fumax);
+        infil->Fu = MIN(infil->Fu, fumax);
         return ia;
     }
 
@@ -752,7 +813,7 @@ double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep, double irate,
     dF = F2 - infil->F;
     infil->F = F2;
     infil->Fu += dF;
-    infil->Fu = MIN(infil->Fu, Fumax);
+    infil->Fu = MIN(infil->Fu, fumax);
     infil->Sat = TRUE;
     return dF / tstep;
 }
@@ -760,7 +821,7 @@ double grnampt_getUnsatInfil(TGrnAmpt *infil, double tstep, double irate,
 //=============================================================================
 
 double grnampt_getSatInfil(TGrnAmpt *infil, double tstep, double irate,
-    double depth)
+    double depth, double factor)
 //
 //  Input:   infil = ptr. to Green-Ampt infiltration object
 //           tstep =  runoff time step (sec),
@@ -768,14 +829,16 @@ double grnampt_getSatInfil(TGrnAmpt *infil, double tstep, double irate,
 //                 = rainfall + snowmelt + runon,
 //                   does not include ponded water (added on below)
 //           depth = depth of ponded water (ft).
+//           factor = hydraulic conductivity adjustment factor
 //  Output:  returns infiltration rate (ft/sec)
 //  Purpose: computes Green-Ampt infiltration when upper soil zone is
 //           saturated.
 //
 {
     double ia, c1, dF, F2;
-    double ks = infil->Ks * InfilFactor;                                       //(5.1.013)
-    double lu = infil->Lu * sqrt(InfilFactor);                                 //(5.1.013)
+    double ks = infil->Ks * factor;                                            //(5.1.015)
+    double lu = infil->Lu * sqrt(factor);                                      //(5.1.015)
+    double fumax = infil->IMDmax * infil->Lu * sqrt(factor);                   //(5.1.015)
 
     // --- get available infiltration rate (rainfall + ponded water)
     ia = irate + depth / tstep;
@@ -799,7 +862,7 @@ double grnampt_getSatInfil(TGrnAmpt *infil, double tstep, double irate,
     // --- update total infiltration and upper zone moisture deficit
     infil->F += dF;
     infil->Fu += dF;
-    infil->Fu = MIN(infil->Fu, Fumax);
+    infil->Fu = MIN(infil->Fu, fumax);
     return dF / tstep;
 }
 
@@ -16,6 +16,9 @@
 //
 //   Build 5.1.013:
 //   - New function infil_setInfilFactor() added.
+//
+//   Build 5.1.015:
+//   - New functions infil_getInfilFactor() and grnampt_getInfilEx() added.
 //-----------------------------------------------------------------------------
 
 #ifndef INFIL_H
@@ -100,6 +103,7 @@ void    infil_initState(int area, int model);
 void    infil_getState(int j, int m, double x[]);
 void    infil_setState(int j, int m, double x[]);
 void    infil_setInfilFactor(int j);                                           //(5.1.013)
+double  infil_getInfilFactor(void);                                            //(5.1.015)
 double  infil_getInfil(int area, int model, double tstep, double rainfall,
         double runon, double depth);
 
@@ -107,5 +111,7 @@ int     grnampt_setParams(TGrnAmpt *infil, double p[]);
 void    grnampt_initState(TGrnAmpt *infil);
 double  grnampt_getInfil(TGrnAmpt *infil, double tstep, double irate,
         double depth, int modelType);
+double  grnampt_getInfilEx(TGrnAmpt *infil, double tstep, double irate,        //(5.1.015)
+        double depth, int modelType, double factor);
 
 #endif
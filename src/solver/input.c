@@ -16,6 +16,17 @@
 //   Build 5.1.011:
 //   - Support added for reading hydraulic event dates.
 //
+//   Build 5.1.015:
+//   - Input file memory mapped (or read whole) and read in a single pass
+//     that counts objects and indexes the sections of the file.
+//   - Lines of input tokenized in place rather than copied.
+//   - Curve and time series sections parsed on their own threads while
+//     the remaining sections are parsed in file order.
+//   - Input data read from a project's compiled file when it is up to date,
+//     and saved to the compiled file by swmm_compile.
+//   - Time series data only loaded for series that are used, and only for
+//     the dates that cover the simulation period.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -23,6 +34,17 @@
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
+#include <sys/types.h>                                                         //(5.1.015)
+#include <sys/stat.h>                                                          //
+#if defined(_WIN32)                                                            //
+#include <windows.h>                                                           //
+#include <io.h>                                                                //
+#else                                                                          //
+#include <sys/mman.h>                                                          //
+#endif                                                                         //
+#if defined(_OPENMP)                                                           //
+#include <omp.h>                                                               //
+#endif                                                                         //
 #include "headers.h"
 #include "lid.h"
 
@@ -31,6 +53,84 @@
 //-----------------------------------------------------------------------------
 static const int MAXERRS = 100;        // Max. input errors reported
 
+static const int COMPILED_MAGIC = 516114525; // identifies compiled files      //(5.1.015)
+static const int COMPILED_VERSION = 1;       // compiled file format           //
+#define COMPILED_EXT ".swc"                  // compiled file extension        //
+
+enum InputTaskType {                   // Groups of sections parsed together   //(5.1.015)
+      MAIN_TASK,                       // sections parsed in file order        //
+      CURVE_TASK,                      // curve sections                       //
+      TSERIES_TASK,                    // time series sections                 //
+      INPUT_TASKS};                                                            //
+
+enum CompiledRecordType {              // Records saved in a compiled file     //(5.1.015)
+      COUNT_RECORDS,                   // lines read when counting objects     //
+      READ_RECORDS,                    // lines parsed by the main task        //
+      TABLE_RECORDS,                   // curve & time series data             //
+      COMPILED_RECORDS};                                                       //
+
+//-----------------------------------------------------------------------------
+//  Data Structures
+//-----------------------------------------------------------------------------
+typedef struct                                                                 //(5.1.015)
+{                                                                              //
+    int    sect;             // section code (-1 if heading not recognized)    //
+    char*  heading;          // start of heading line (NULL for first section) //
+    char*  start;            // start of section's lines in working text       //
+    char*  end;              // end of section's lines in working text         //
+    long   lineCount;        // line number of heading line                    //
+}   TInpSection;                                                               //
+
+typedef struct                                                                 //(5.1.015)
+{                                                                              //
+    int    code;             // error code                                     //
+    int    sect;             // section containing line in error               //
+    long   lineCount;        // line number of line in error                   //
+    char*  line;             // start of line in working text                  //
+    char   msg[256];         // text passed to error_setInpError               //
+}   TInpError;                                                                 //
+
+typedef struct                                                                 //(5.1.015)
+{                                                                              //
+    int        count;        // # errors found                                 //
+    TInpError  errs[101];    // errors found (up to MAXERRS + 1)               //
+}   TInpErrors;                                                                //
+
+typedef struct                                                                 //(5.1.015)
+{                                                                              //
+    int        magic;        // identifies a compiled project file             //
+    int        version;      // version of compiled file format                //
+    int        swmmVersion;  // version of SWMM that compiled the file         //
+    int        headerSize;   // size of this header (bytes)                    //
+    long long  inpSize;      // size of input file when compiled (bytes)       //
+    long long  inpTime;      // time input file was last modified              //
+    long long  size[COMPILED_RECORDS]; // size of each set of records (bytes)  //
+}   TCompiledHeader;                                                           //
+
+typedef struct                                                                 //(5.1.015)
+{                                                                              //
+    int    sect;             // section code                                   //
+    int    ntoks;            // number of tokens (-1 for a section heading)    //
+    int    size;             // size of the text that follows (bytes)          //
+    int    lineCount;        // line number in input file                      //
+}   TCompiledLine;                                                             //
+
+typedef struct                                                                 //(5.1.015)
+{                                                                              //
+    int    curveType;        // type of curve tabulated                        //
+    int    fileMode;         // external file mode of time series              //
+    int    size;             // size of the text that follows (bytes)          //
+    int    entries;          // number of x,y entries that follow the text     //
+    double lastDate;         // last input date of time series                 //
+}   TCompiledTable;                                                            //
+
+typedef struct                                                                 //(5.1.015)
+{                                                                              //
+    char*  data;             // records compiled so far                        //
+    size_t size;             // size of records (bytes)                        //
+    size_t capacity;         // size of memory allocated for records (bytes)   //
+}   TCompiledRecords;                                                          //
+
 //-----------------------------------------------------------------------------
 //  Shared variables
 //-----------------------------------------------------------------------------
@@ -41,16 +141,40 @@ static int  Mnodes[MAX_NODE_TYPES];    // Working number of node objects
 static int  Mlinks[MAX_LINK_TYPES];    // Working number of link objects
 static int  Mevents;                   // Working number of event periods
 
+static char*        InpText;           // original text of input file          //(5.1.015)
+static char*        InpWork;           // text of input file tokenized in place//
+static size_t       InpSize;           // size of input file text (bytes)      //
+static int          InpMapped;         // TRUE if text is memory mapped        //
+static TInpSection* Sections;          // sections of input file, in order     //
+static int          NumSections;       // number of sections indexed           //
+static int          MaxSections;       // size of Sections array               //
+static TInpErrors   TaskErrors[INPUT_TASKS]; // errors found by each task      //
+static int          Compiling;         // TRUE if input is being compiled      //
+static TCompiledRecords Compiled[COMPILED_RECORDS]; // records being compiled  //
+static char*        CompiledText;      // compiled file mapped into memory     //
+static size_t       CompiledSize;      // size of compiled file (bytes)        //
+static DateTime     TseriesStartDate;  // date that times without a date       //
+                                       //   in time series data refer to       //
+
+//-----------------------------------------------------------------------------
+//  Imported variables
+//-----------------------------------------------------------------------------
+extern char ErrString[256];            // defined in ERROR.C                   //(5.1.015)
+#pragma omp threadprivate(ErrString)                                           //
+
 //-----------------------------------------------------------------------------
 //  External Functions (declared in funcs.h)
 //-----------------------------------------------------------------------------
 //  input_countObjects  (called by swmm_open in swmm5.c)
 //  input_readData      (called by swmm_open in swmm5.c)
+//  input_startCompiling (called by swmm_compile in toolkit.c)                 //(5.1.015)
+//  input_writeCompiled  (called by swmm_compile in toolkit.c)                 //
+//  input_loadTimeseries (called by swmm_setSimulationDateTime in toolkit.c)   //
 
 //-----------------------------------------------------------------------------
 //  Local functions
 //-----------------------------------------------------------------------------
-static int  addObject(int objType, char* id);
+static int  addObject(int objType, char* tok[], int ntoks);                    //(5.1.015)
 static int  getTokens(char *s);
 static int  parseLine(int sect, char* line);
 static int  readOption(char* line);
@@ -60,6 +184,39 @@ static int  readNode(int type);
 static int  readLink(int type);
 static int  readEvent(char* tok[], int ntoks);
 
+static int   openInputText(void);                                              //(5.1.015)
+static void  closeInputText(void);                                             //
+static int   mapFile(FILE* file, int copy, char** view, size_t* size);         //
+static void  unmapFile(char* view, size_t size);                               //
+static char* nextLine(char* s, char* end);                                     //
+static int   getFirstTokens(char* s, char* end, char* buf, char* tok[]);       //
+static int   findHeading(char* s, char* end);                                  //
+static int   addSection(int sect, char* heading, char* start, long lineCount); //
+static int   getSectionTask(int sect);                                         //
+static void  parseSections(int task);                                          //
+static int   parseSectionLines(int task, TInpSection* section, int sect);      //
+static void  addInputError(int task, int code, int sect, char* line,           //
+             long lineCount);                                                  //
+static int   reportInputErrors(void);                                          //
+static char* copyInputLine(char* text, char* buf);                             //
+static char* getUsedTseries(void);                                             //
+static int   isTseriesLoaded(int j, char* used, DateTime start, DateTime end); //
+static int   loadTimeseries(char* used, DateTime start, DateTime end,          //
+             int validate);                                                    //
+static int   compareInputErrors(const void* a, const void* b);                 //
+static int   tokenize(char *s, char* tok[]);                                   //
+
+static int   getCompiledName(char* name);                                      //(5.1.015)
+static int   openCompiledInput(void);                                          //
+static void  closeCompiledInput(void);                                         //
+static int   countCompiledObjects(void);                                       //
+static int   readCompiledData(void);                                           //
+static char* addCompiledRecord(int type, size_t size);                         //
+static int   addCompiledLine(int type, int sect, char* tok[], int ntoks,       //
+             char* text, long lineCount);                                      //
+static int   addCompiledTable(TTable* table);                                  //
+static void  freeCompiledRecords(void);                                        //
+
 //=============================================================================
 
 int input_countObjects()
@@ -68,13 +225,21 @@ int input_countObjects()
 //  Output:  returns error code
 //  Purpose: reads input file to determine number of system objects.
 //
+//  Note:    the input file is read into memory just once, here, and the
+//           positions of its sections are indexed for input_readData.
+//
 {
-    char  line[MAXLINE+1];             // line from input data file     
-    char  wLine[MAXLINE+1];            // working copy of input line   
-    char  *tok;                        // first string token of line          
-    int   sect = -1, newsect;          // input data sections          
+    char  line[MAXLINE+1];             // copy of line from input file
+    char  wLine[MAXLINE+2];            // first tokens of line
+    char* tok[2];                      // first string tokens of line
+    char* s;                           // start of line in input text
+    char* next;                        // start of next line in input text
+    char* end;                         // end of input text
+    int   ntoks;                       // number of tokens found
+    int   sect = -1, newsect;          // input data sections
+    int   heading;                     // TRUE if line is a section heading
     int   errcode = 0;                 // error code
-    int   errsum = 0;                  // number of errors found                   
+    int   errsum = 0;                  // number of errors found
     int   i;
     long  lineCount = 0;
 
@@ -85,21 +250,50 @@ int input_countObjects()
     for (i = 0; i < MAX_NODE_TYPES; i++) Nnodes[i] = 0;
     for (i = 0; i < MAX_LINK_TYPES; i++) Nlinks[i] = 0;
 
+    // --- use the project's compiled file if it is up to date
+    if ( !Compiling && openCompiledInput() ) return countCompiledObjects();
+
+    // --- load the input file's text; lines before the first heading
+    //     are read as title lines
+    errcode = openInputText();
+    if ( errcode == 0 && !addSection(s_TITLE, NULL, InpWork, 0) )
+        errcode = ERR_MEMORY;
+    if ( errcode )
+    {
+        report_writeErrorMsg(errcode, Finp.name);
+        return ErrorCode;
+    }
+
     // --- make pass through data file counting number of each object
-    while ( fgets(line, MAXLINE, Finp.file) != NULL )
+    end = InpText + InpSize;
+    for ( s = InpText; s < end; s = next )
     {
         // --- skip blank lines & those beginning with a comment
+        next = nextLine(s, end);
         lineCount++;
-        strcpy(wLine, line);           // make working copy of line
-        tok = strtok(wLine, SEPSTR);   // get first text token on line
-        if ( tok == NULL ) continue;
-        if ( *tok == ';' ) continue;
+        ntoks = getFirstTokens(s, next, wLine, tok);
+        if ( ntoks == 0 ) continue;
+        if ( *tok[0] == ';' ) continue;
+
+        // --- index the line if it begins with a section heading (a quoted
+        //     token can begin a heading once the line is parsed)
+        newsect = -1;
+        heading = TRUE;
+        if ( *tok[0] == '[' ) newsect = findmatch(tok[0], SectWords);
+        else if ( *tok[0] == '"' && tok[0][1] == '[' )
+            newsect = findHeading(s, next);
+        else heading = FALSE;
+        if ( heading && !addSection(newsect, InpWork + (s - InpText),
+                                    InpWork + (next - InpText), lineCount) )
+        {
+            report_writeErrorMsg(ERR_MEMORY, "");
+            return ErrorCode;
+        }
 
         // --- check if line begins with a new section heading
-        if ( *tok == '[' )
+        if ( *tok[0] == '[' )
         {
             // --- look for heading in list of section keywords
-            newsect = findmatch(tok, SectWords);
             if ( newsect >= 0 )
             {
                 sect = newsect;
@@ -114,17 +308,34 @@ int input_countObjects()
 
         // --- if in OPTIONS section then read the option setting
         //     otherwise add object and its ID name (tok) to project
-        if ( sect == s_OPTION ) errcode = readOption(line);
-        else if ( sect >= 0 )   errcode = addObject(sect, tok);
+        if ( sect == s_OPTION )
+        {
+            copyInputLine(s, line);
+            if ( Compiling && !addCompiledLine(COUNT_RECORDS, sect, NULL, 0,
+                                               line, lineCount) )
+                errcode = ERR_MEMORY;
+            else errcode = readOption(line);
+        }
+        else if ( sect >= 0 )
+        {
+            if ( Compiling && !addCompiledLine(COUNT_RECORDS, sect, tok, ntoks,
+                                               NULL, lineCount) )
+                errcode = ERR_MEMORY;
+            else errcode = addObject(sect, tok, ntoks);
+        }
 
         // --- report any error found
+        //     (an option line is echoed as left by readOption, i.e. just
+        //     its keyword, as it always has been)
         if ( errcode )
         {
+            if ( sect != s_OPTION ) copyInputLine(s, line);
             report_writeInputErrorMsg(errcode, sect, line, lineCount);
             errsum++;
             if (errsum >= MAXERRS ) break;
         }
     }
+    if ( NumSections > 0 ) Sections[NumSections-1].end = InpWork + InpSize;
 
     // --- set global error code if input errors were found
     if ( errsum > 0 ) ErrorCode = ERR_INPUT;
@@ -139,20 +350,29 @@ int input_readData()
 //  Output:  returns error code
 //  Purpose: reads input file to determine input parameters for each object.
 //
+//  Note:    curve and time series sections only refer to the names of
+//           objects, so they are parsed by their own tasks alongside the
+//           task that parses all other sections in file order. Errors are
+//           reported in file order once all tasks are done.
+//
+//           The time series task only notes where each series' data lie.
+//           The data of the series that other objects use are then loaded
+//           for the dates covering the simulation period (or all data of
+//           all series if the project is being compiled).
+//
 {
-    char  line[MAXLINE+1];        // line from input data file
-    char  wLine[MAXLINE+1];       // working copy of input line
-    char* comment;                // ptr. to start of comment in input line
-    int   sect, newsect;          // data sections
-    int   inperr, errsum;         // error code & total error count
-    int   lineLength;             // number of characters in input line
-    int   i;
-    long  lineCount = 0;
+    int   i, task;
+    int   nThreads = 1;
+    char* used = NULL;                                                         //(5.1.015)
 
     // --- initialize working item count arrays
     //     (final counts in Mobjects, Mnodes & Mlinks should
     //      match those in Nobjects, Nnodes and Nlinks).
-    if ( ErrorCode ) return ErrorCode;
+    if ( ErrorCode )
+    {
+        closeInputText();
+        return ErrorCode;
+    }
     error_setInpError(0, "");
     for (i = 0; i < MAX_OBJ_TYPES; i++)  Mobjects[i] = 0;
     for (i = 0; i < MAX_NODE_TYPES; i++) Mnodes[i] = 0;
@@ -160,98 +380,188 @@ int input_readData()
     Mevents = 0;
 
     // --- initialize starting date for all time series
+    TseriesStartDate = StartDate + StartTime;                                  //(5.1.015)
     for ( i = 0; i < Nobjects[TSERIES]; i++ )
     {
-        Tseries[i].lastDate = StartDate + StartTime;
+        Tseries[i].lastDate = TseriesStartDate;                                //(5.1.015)
     }
 
-    // --- read each line from input file
-    sect = 0;
-    errsum = 0;
-    rewind(Finp.file);
-    while ( fgets(line, MAXLINE, Finp.file) != NULL )
+    // --- read the project's compiled file if one was opened
+    if ( CompiledText )
     {
-        // --- make copy of line and scan for tokens
-        lineCount++;
-        strcpy(wLine, line);
-        Ntokens = getTokens(wLine);
+        readCompiledData();
+        closeInputText();
+        return ErrorCode;
+    }
 
-        // --- skip blank lines and comments
-        if ( Ntokens == 0 ) continue;
-        if ( *Tok[0] == ';' ) continue;
+    // --- parse the indexed sections
+    for (task = 0; task < INPUT_TASKS; task++) TaskErrors[task].count = 0;
+#if defined(_OPENMP)
+    nThreads = NumThreads > 0 ? NumThreads : omp_get_max_threads();
+    nThreads = MIN(nThreads, INPUT_TASKS);
+#endif
+#pragma omp parallel for num_threads(nThreads) schedule(dynamic, 1)
+    for (task = 0; task < INPUT_TASKS; task++)
+    {
+        parseSections(task);
+    }
 
-        // --- check if max. line length exceeded
-        lineLength = strlen(line);
-        if ( lineLength >= MAXLINE )
-        {
-            // --- don't count comment if present
-            comment = strchr(line, ';');
-            if ( comment ) lineLength = comment - line;    // Pointer math here
-            if ( lineLength >= MAXLINE )
-            {
-                inperr = ERR_LINE_LENGTH;
-                report_writeInputErrorMsg(inperr, sect, line, lineCount);
-                errsum++;
-            }
-        }
+    // --- load the data of the time series in use, or all of the data of      //(5.1.015)
+    //     every time series if they are being compiled                        //
+    if ( Compiling ) loadTimeseries(NULL, -BIG, BIG, FALSE);                   //
+    else                                                                       //
+    {                                                                          //
+        used = getUsedTseries();                                               //
+        loadTimeseries(used, StartDate, EndDate + EndTime, FALSE);             //
+        FREE(used);                                                            //
+    }                                                                          //
+
+    // --- report errors in file order
+    if ( reportInputErrors() > 0 ) ErrorCode = ERR_INPUT;
+
+    // --- save the data read for curves & time series if compiling
+    for ( i = 0; Compiling && !ErrorCode && i < Nobjects[CURVE]; i++ )
+    {
+        if ( !addCompiledTable(&Curve[i]) ) report_writeErrorMsg(ERR_MEMORY, "");
+    }
+    for ( i = 0; Compiling && !ErrorCode && i < Nobjects[TSERIES]; i++ )
+    {
+        if ( !addCompiledTable(&Tseries[i]) ) report_writeErrorMsg(ERR_MEMORY, "");
+    }
+    closeInputText();
+    return ErrorCode;
+}
 
-        // --- check if at start of a new input section
-        if (*Tok[0] == '[')
-        {
-            // --- match token against list of section keywords
-            newsect = findmatch(Tok[0], SectWords);
-            if (newsect >= 0)
-            {
-                // --- SPECIAL CASE FOR TRANSECTS
-                //     finish processing the last set of transect data
-                if ( sect == s_TRANSECT )
-                    transect_validate(Nobjects[TRANSECT]-1);
+//=============================================================================
 
-                // --- begin a new input section
-                sect = newsect;
-                continue;
-            }
-            else
-            {
-                inperr = error_setInpError(ERR_KEYWORD, Tok[0]);
-                report_writeInputErrorMsg(inperr, sect, line, lineCount);
-                errsum++;
-                break;
-            }
-        }
+void input_startCompiling()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: has the next input file read be saved as a compiled file.
+//
+{
+    freeCompiledRecords();
+    Compiling = TRUE;
+}
 
-        // --- otherwise parse tokens from input line
-        else
-        {
-            inperr = parseLine(sect, line);
-            if ( inperr > 0 )
-            {
-                errsum++;
-                if ( errsum > MAXERRS ) report_writeLine(FMT19);
-                else report_writeInputErrorMsg(inperr, sect, line, lineCount);
-            }
-        }
+//=============================================================================
+
+int input_writeCompiled()
+//
+//  Input:   none
+//  Output:  returns an error code
+//  Purpose: writes the input data saved since input_startCompiling was
+//           called to the project's compiled file.
+//
+//  Note:    the compiled file holds the lines of input (already tokenized)
+//           that input_countObjects and input_readData pass on to each
+//           object's parser, along with the parsed contents of curves and
+//           time series. It is only written for a project that was read
+//           and validated without error.
+//
+{
+    char   name[MAXFNAME+1];
+    FILE*  file;
+    struct stat st;
+    TCompiledHeader header;
+    int    i;
+
+    if ( !Compiling ) return ErrorCode;
+    Compiling = FALSE;
+    if ( ErrorCode )
+    {
+        freeCompiledRecords();
+        return ErrorCode;
+    }
 
-        // --- stop if reach end of file or max. error count
-        if (errsum > MAXERRS) break;
-    }   /* End of while */
+    // --- identify the version of the input file that was compiled
+    memset(&header, 0, sizeof(header));
+    header.magic = COMPILED_MAGIC;
+    header.version = COMPILED_VERSION;
+    header.swmmVersion = VERSION;
+    header.headerSize = sizeof(header);
+    if ( stat(Finp.name, &st) == 0 )
+    {
+        header.inpSize = st.st_size;
+        header.inpTime = st.st_mtime;
+    }
+    for (i = 0; i < COMPILED_RECORDS; i++) header.size[i] = Compiled[i].size;
 
-    // --- check for errors
-    if (errsum > 0)  ErrorCode = ERR_INPUT;
+    // --- write the header & each set of records
+    if ( !getCompiledName(name) || (file = fopen(name, "wb")) == NULL )
+    {
+        report_writeErrorMsg(ERR_COMPILED_FILE_OPEN, name);
+        freeCompiledRecords();
+        return ErrorCode;
+    }
+    fwrite(&header, sizeof(header), 1, file);
+    for (i = 0; i < COMPILED_RECORDS; i++)
+    {
+        if ( Compiled[i].size > 0 )
+            fwrite(Compiled[i].data, Compiled[i].size, 1, file);
+    }
+    i = ferror(file);
+    if ( fclose(file) != 0 || i )
+    {
+        remove(name);
+        report_writeErrorMsg(ERR_COMPILED_FILE_WRITE, name);
+    }
+    freeCompiledRecords();
     return ErrorCode;
 }
 
 //=============================================================================
 
-int  addObject(int objType, char* id)
+int input_loadTimeseries()
+//
+//  Input:   none
+//  Output:  returns an error code
+//  Purpose: reloads the data of each time series in use that were loaded
+//           for dates that don't cover the current simulation period.
+//
+{
+    int   j, errcode = 0;
+    char* used;
+
+    // --- check if any time series in use needs its data reloaded
+    used = getUsedTseries();
+    if ( used == NULL ) return ERR_MEMORY;
+    for (j = 0; j < Nobjects[TSERIES]; j++)
+    {
+        if ( !isTseriesLoaded(j, used, StartDate, EndDateTime) ) break;
+    }
+
+    // --- reload their data from the input file
+    if ( j < Nobjects[TSERIES] )
+    {
+        rewind(Finp.file);
+        errcode = openInputText();
+        if ( !errcode )
+        {
+            TaskErrors[TSERIES_TASK].count = 0;
+            errcode = loadTimeseries(used, StartDate, EndDateTime, TRUE);
+            if ( reportInputErrors() > 0 ) errcode = ERR_INPUT;
+        }
+        closeInputText();
+    }
+    FREE(used);
+    return errcode;
+}
+
+//=============================================================================
+
+int  addObject(int objType, char* tok[], int ntoks)
 //
 //  Input:   objType = object type index
-//           id = object's ID string
+//           tok[] = first two string tokens of a line of input
+//           ntoks = number of tokens
 //  Output:  returns an error code
 //  Purpose: adds a new object to the project.
 //
 {
     int errcode = 0;
+    char* id = tok[0];
     switch( objType )
     {
       case s_RAINGAGE:
@@ -386,8 +696,8 @@ int  addObject(int objType, char* id)
             Nobjects[CURVE]++;
 
             // --- check for a conduit shape curve
-            id = strtok(NULL, SEPSTR);
-            if ( findmatch(id, CurveTypeWords) == SHAPE_CURVE )
+            if ( ntoks > 1 &&                                                  //(5.1.015)
+                 findmatch(tok[1], CurveTypeWords) == SHAPE_CURVE )            //
                 Nobjects[SHAPE]++;
         }
         break;
@@ -410,9 +720,9 @@ int  addObject(int objType, char* id)
         // --- for TRANSECTS, ID name appears as second entry on X1 line
         if ( match(id, "X1") )
         {
-            id = strtok(NULL, SEPSTR);
-            if ( id ) 
+            if ( ntoks > 1 )                                                   //(5.1.015)
             {
+                id = tok[1];                                                   //(5.1.015)
                 if ( !project_addObject(TRANSECT, id, Nobjects[TRANSECT]) )
                     errcode = error_setInpError(ERR_DUP_NAME, id);
                 Nobjects[TRANSECT]++;
@@ -597,6 +907,9 @@ int  parseLine(int sect, char *line)
       case s_EVENT:
         return readEvent(Tok, Ntokens);
 
+      case s_RECORDING:                                                        //(5.1.015)
+        return record_readParams(Tok, Ntokens);                                //(5.1.015)
+
       default: return 0;
     }
 }
@@ -850,6 +1163,19 @@ int  getTokens(char *s)
 //  Purpose: scans a string for tokens, saving pointers to them
 //           in shared variable Tok[].
 //
+{
+    return tokenize(s, Tok);                                                   //(5.1.015)
+}
+
+//=============================================================================
+
+int  tokenize(char *s, char* tok[])
+//
+//  Input:   s = a character string
+//  Output:  tok[] = pointers to the tokens found in s
+//           returns number of tokens found in s
+//  Purpose: scans a string for tokens, saving pointers to them in tok[].
+//
 //  Notes:   Tokens can be separated by the characters listed in SEPSTR
 //           (spaces, tabs, newline, carriage return) which is defined
 //           in CONSTS.H. Text between quotes is treated as a single token.
@@ -859,7 +1185,7 @@ int  getTokens(char *s)
     char *c;
 
     // --- begin with no tokens
-    for (n = 0; n < MAXTOKS; n++) Tok[n] = NULL;
+    for (n = 0; n < MAXTOKS; n++) tok[n] = NULL;
     n = 0;
 
     // --- truncate s at start of comment 
@@ -881,7 +1207,7 @@ int  getTokens(char *s)
                 m = strcspn(s,"\"\n");      // find end quote or new line
             }
             s[m] = '\0';                    // null-terminate the token
-            Tok[n] = s;                     // save pointer to token 
+            tok[n] = s;                     // save pointer to token 
             n++;                            // update token count
             s += m+1;                       // begin next token
         }
@@ -891,3 +1217,1011 @@ int  getTokens(char *s)
 }
 
 //=============================================================================
+
+////  The following functions were added for release 5.1.015.  ////
+
+int openInputText()
+//
+//  Input:   none
+//  Output:  returns an error code
+//  Purpose: maps the input file into memory twice, once to keep its original
+//           text and once as a private copy whose lines are tokenized in
+//           place, or reads the file into two buffers if it can't be mapped.
+//
+{
+    char*  buf;
+    size_t n, size = 0, capacity;
+
+    InpText = NULL;
+    InpWork = NULL;
+    InpSize = 0;
+    InpMapped = FALSE;
+    NumSections = 0;
+
+    // --- map the file's text and a private copy of it
+    if ( mapFile(Finp.file, FALSE, &InpText, &InpSize) )
+    {
+        if ( mapFile(Finp.file, TRUE, &InpWork, &size) )
+        {
+            InpMapped = TRUE;
+            return 0;
+        }
+        unmapFile(InpText, InpSize);
+        InpText = NULL;
+        InpSize = 0;
+    }
+
+    // --- otherwise read the file's contents into memory
+    capacity = 65536;
+    InpText = (char *) malloc(capacity);
+    if ( InpText == NULL ) return ERR_MEMORY;
+    for (;;)
+    {
+        n = fread(InpText + size, 1, capacity - size, Finp.file);
+        size += n;
+        if ( size < capacity ) break;
+        capacity *= 2;
+        buf = (char *) realloc(InpText, capacity);
+        if ( buf == NULL ) return ERR_MEMORY;
+        InpText = buf;
+    }
+    if ( ferror(Finp.file) ) return ERR_INP_FILE;
+
+    // --- make the working copy of the text
+    InpWork = (char *) malloc(size + 1);
+    if ( InpWork == NULL ) return ERR_MEMORY;
+    memcpy(InpWork, InpText, size);
+    InpSize = size;
+    return 0;
+}
+
+//=============================================================================
+
+void closeInputText()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: releases the input file's text and its index of sections.
+//
+{
+    if ( InpMapped )
+    {
+        unmapFile(InpText, InpSize);
+        unmapFile(InpWork, InpSize);
+    }
+    else
+    {
+        FREE(InpText);
+        FREE(InpWork);
+    }
+    InpText = NULL;
+    InpWork = NULL;
+    InpSize = 0;
+    InpMapped = FALSE;
+    FREE(Sections);
+    NumSections = 0;
+    MaxSections = 0;
+    closeCompiledInput();
+}
+
+//=============================================================================
+
+int mapFile(FILE* file, int copy, char** view, size_t* size)
+//
+//  Input:   file = an open file
+//           copy = TRUE for a private copy-on-write view of the file
+//  Output:  view = start of the file's contents in memory
+//           size = size of the file (bytes)
+//           returns TRUE if the file was mapped into memory
+//  Purpose: maps the contents of a regular file into memory.
+//
+{
+#if defined(_WIN32)
+    HANDLE hFile = (HANDLE)_get_osfhandle(_fileno(file));
+    HANDLE hMap;
+    LARGE_INTEGER fileSize;
+
+    *view = NULL;
+    if ( hFile == INVALID_HANDLE_VALUE ||
+         !GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart <= 0 ||
+         (unsigned long long)fileSize.QuadPart > (size_t)-1 ) return FALSE;
+    hMap = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if ( hMap == NULL ) return FALSE;
+    *view = MapViewOfFile(hMap, copy ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(hMap);
+    if ( *view == NULL ) return FALSE;
+    *size = (size_t)fileSize.QuadPart;
+    return TRUE;
+#else
+    struct stat st;
+    void* text;
+    int   fd = fileno(file);
+
+    *view = NULL;
+    if ( fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+         (unsigned long long)st.st_size > (size_t)-1 ) return FALSE;
+    if ( copy ) text = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE, fd, 0);
+    else text = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if ( text == MAP_FAILED ) return FALSE;
+    *view = (char *) text;
+    *size = (size_t)st.st_size;
+    return TRUE;
+#endif
+}
+
+//=============================================================================
+
+void unmapFile(char* view, size_t size)
+//
+//  Input:   view = start of a file's contents mapped by mapFile
+//           size = size of the file (bytes)
+//  Output:  none
+//  Purpose: unmaps a file's contents from memory.
+//
+{
+    if ( view == NULL ) return;
+#if defined(_WIN32)
+    UnmapViewOfFile(view);
+#else
+    munmap(view, size);
+#endif
+}
+
+//=============================================================================
+
+char* nextLine(char* s, char* end)
+//
+//  Input:   s = start of a line of input text
+//           end = end of the input text
+//  Output:  returns start of the next line of input text
+//  Purpose: finds the end of a line of input text.
+//
+//  Note:    as when read with fgets, a line ends just past its line feed
+//           and lines longer than MAXLINE-1 characters are split.
+//
+{
+    size_t n = end - s;
+    char*  c;
+
+    if ( n > MAXLINE - 1 ) n = MAXLINE - 1;
+    c = (char *) memchr(s, '\n', n);
+    if ( c ) return c + 1;
+    return s + n;
+}
+
+//=============================================================================
+
+int getFirstTokens(char* s, char* end, char* buf, char* tok[])
+//
+//  Input:   s = start of a line of input text
+//           end = start of the next line
+//           buf = buffer of at least MAXLINE+1 characters
+//  Output:  tok[] = pointers to the first two tokens of the line
+//           returns number of tokens found (0 to 2)
+//  Purpose: copies a line of input text into buf and finds its first
+//           two tokens in the same way that strtok does.
+//
+{
+    int   n;
+    char* c;
+
+    memcpy(buf, s, end - s);
+    buf[end - s] = '\0';
+    tok[0] = NULL;
+    tok[1] = NULL;
+    c = buf;
+    for (n = 0; n < 2; n++)
+    {
+        c += strspn(c, SEPSTR);
+        if ( *c == '\0' ) break;
+        tok[n] = c;
+        c += strcspn(c, SEPSTR);
+        if ( *c != '\0' ) *c++ = '\0';
+    }
+    return n;
+}
+
+//=============================================================================
+
+int findHeading(char* s, char* end)
+//
+//  Input:   s = start of a line of input text
+//           end = start of the next line
+//  Output:  returns the section code of the line's heading, or -1
+//  Purpose: identifies a heading that is only seen once the line's tokens
+//           have been parsed (such as one placed within quotes).
+//
+{
+    char  buf[MAXLINE+1];
+    char* tok[MAXTOKS];
+
+    memcpy(buf, s, end - s);
+    buf[end - s] = '\0';
+    if ( tokenize(buf, tok) == 0 ) return -1;
+    return findmatch(tok[0], SectWords);
+}
+
+//=============================================================================
+
+int addSection(int sect, char* heading, char* start, long lineCount)
+//
+//  Input:   sect = section code (-1 if heading not recognized)
+//           heading = start of section's heading line in working text
+//           start = start of line following the heading
+//           lineCount = line number of heading line
+//  Output:  returns TRUE if successful, FALSE if out of memory
+//  Purpose: adds a new section to the index of the input file's sections.
+//
+{
+    TInpSection* sections;
+
+    if ( NumSections >= MaxSections )
+    {
+        MaxSections = MaxSections > 0 ? 2 * MaxSections : 64;
+        sections = (TInpSection *) realloc(Sections,
+                   MaxSections * sizeof(TInpSection));
+        if ( sections == NULL ) return FALSE;
+        Sections = sections;
+    }
+    if ( NumSections > 0 ) Sections[NumSections-1].end = heading;
+    Sections[NumSections].sect = sect;
+    Sections[NumSections].heading = heading;
+    Sections[NumSections].start = start;
+    Sections[NumSections].end = start;
+    Sections[NumSections].lineCount = lineCount;
+    NumSections++;
+    return TRUE;
+}
+
+//=============================================================================
+
+int getSectionTask(int sect)
+//
+//  Input:   sect = section code
+//  Output:  returns the task that parses the section, or -1 if its lines
+//           hold nothing that input_readData needs
+//  Purpose: assigns an input section to a parsing task.
+//
+{
+    switch ( sect )
+    {
+      case s_CURVE:      return CURVE_TASK;
+      case s_TIMESERIES: return TSERIES_TASK;
+
+      // --- options were read by input_countObjects while map and
+      //     graphics data are only used by the GUI
+      case s_OPTION:
+      case s_COORDINATE:
+      case s_VERTICES:
+      case s_POLYGON:
+      case s_LABEL:
+      case s_SYMBOL:
+      case s_BACKDROP:
+      case s_TAG:
+      case s_PROFILE:
+      case s_MAP:        return -1;
+      default:           return MAIN_TASK;
+    }
+}
+
+//=============================================================================
+
+void parseSections(int task)
+//
+//  Input:   task = a parsing task
+//  Output:  none
+//  Purpose: parses the lines of each input section assigned to a task.
+//
+//  Note:    no section is parsed past a heading that isn't recognized;
+//           the main task reports the heading as an error.
+//
+{
+    char  line[MAXLINE+1];
+    char* tok[MAXTOKS];
+    int   i, sect = s_TITLE;
+
+    for (i = 0; i < NumSections; i++)
+    {
+        // --- check if at start of a new input section
+        if ( Sections[i].heading )
+        {
+            if ( Sections[i].sect < 0 )
+            {
+                if ( task == MAIN_TASK )
+                {
+                    copyInputLine(InpText + (Sections[i].heading - InpWork),
+                                  line);
+                    tokenize(line, tok);
+                    error_setInpError(ERR_KEYWORD, tok[0]);
+                    addInputError(task, ERR_KEYWORD, sect,
+                                  Sections[i].heading, Sections[i].lineCount);
+                }
+                return;
+            }
+
+            // --- SPECIAL CASE FOR TRANSECTS
+            //     finish processing the last set of transect data
+            if ( task == MAIN_TASK && sect == s_TRANSECT )
+                transect_validate(Nobjects[TRANSECT]-1);
+
+            // --- begin a new input section
+            sect = Sections[i].sect;
+            if ( task == MAIN_TASK && Compiling &&
+                 !addCompiledLine(READ_RECORDS, sect, NULL, -1, NULL,
+                                  Sections[i].lineCount) )
+            {
+                error_setInpError(ERR_MEMORY, "");
+                addInputError(task, ERR_MEMORY, sect, Sections[i].heading,
+                              Sections[i].lineCount);
+                return;
+            }
+        }
+
+        // --- parse the section's lines if it belongs to this task
+        if ( getSectionTask(sect) != task ) continue;
+        if ( parseSectionLines(task, &Sections[i], sect) > MAXERRS ) return;
+    }
+}
+
+//=============================================================================
+
+int parseSectionLines(int task, TInpSection* section, int sect)
+//
+//  Input:   task = a parsing task
+//           section = an indexed input section
+//           sect = section code
+//  Output:  returns number of errors found so far by the task
+//  Purpose: parses each line of an input section.
+//
+{
+    char  wLine[MAXLINE+1];            // copy of a line without a line feed
+    char  text[MAXLINE+1];             // original text of a title line
+    char* tok[MAXTOKS];                // tokens of line for curve & series
+    char* s;                           // start of line in working text
+    char* next;                        // start of next line in working text
+    char* line;                        // line to tokenize
+    int   ntoks;                       // number of tokens in line
+    int   inperr;                      // input error code
+    long  lineCount = section->lineCount;
+
+    for ( s = section->start; s < section->end; s = next )
+    {
+        // --- tokenize the line in place, replacing its line feed with a
+        //     null, or tokenize a copy of a line with no line feed
+        next = nextLine(s, section->end);
+        lineCount++;
+        if ( next[-1] == '\n' )
+        {
+            next[-1] = '\0';
+            line = s;
+        }
+        else
+        {
+            memcpy(wLine, s, next - s);
+            wLine[next - s] = '\0';
+            line = wLine;
+        }
+        if ( task == MAIN_TASK ) ntoks = Ntokens = getTokens(line);
+        else ntoks = tokenize(line, tok);
+
+        // --- skip blank lines and comments
+        if ( ntoks == 0 ) continue;
+        if ( task == MAIN_TASK && *Tok[0] == ';' ) continue;
+        if ( task != MAIN_TASK && *tok[0] == ';' ) continue;
+
+        // --- parse tokens from input line
+        switch ( task )
+        {
+          case CURVE_TASK:   inperr = table_readCurve(tok, ntoks);      break;
+          case TSERIES_TASK:                                                   //(5.1.015)
+            inperr = table_markTimeseries(tok, ntoks, s - InpWork,             //
+                                          next - InpWork, lineCount);          //
+            break;                                                             //
+          default:
+            if ( sect == s_TITLE )
+                line = copyInputLine(InpText + (s - InpWork), text);
+            if ( Compiling &&
+                 !addCompiledLine(READ_RECORDS, sect, Tok, ntoks,
+                                  sect == s_TITLE ? line : NULL, lineCount) )
+                inperr = error_setInpError(ERR_MEMORY, "");
+            else inperr = parseLine(sect, line);
+        }
+        if ( inperr > 0 )
+        {
+            addInputError(task, inperr, sect, s, lineCount);
+            if ( TaskErrors[task].count > MAXERRS ) break;
+        }
+    }
+    return TaskErrors[task].count;
+}
+
+//=============================================================================
+
+void addInputError(int task, int code, int sect, char* line, long lineCount)
+//
+//  Input:   task = a parsing task
+//           code = error code
+//           sect = section code
+//           line = start of line in working text
+//           lineCount = line number of line
+//  Output:  none
+//  Purpose: saves an input error found by a parsing task so that it can be
+//           reported once all tasks are done.
+//
+{
+    TInpErrors* errors = &TaskErrors[task];
+    TInpError*  err;
+
+    if ( errors->count > MAXERRS ) return;
+    err = &errors->errs[errors->count];
+    err->code = code;
+    err->sect = sect;
+    err->lineCount = lineCount;
+    err->line = line;
+    sstrncpy(err->msg, ErrString, sizeof(err->msg) - 1);
+    errors->count++;
+}
+
+//=============================================================================
+
+int reportInputErrors()
+//
+//  Input:   none
+//  Output:  returns number of input errors found
+//  Purpose: reports the errors found by all parsing tasks in the order
+//           that their lines appear in the input file.
+//
+{
+    char       line[MAXLINE+1];
+    int        next[INPUT_TASKS];
+    int        task, k, errsum = 0;
+    TInpError* err;
+
+    for (task = 0; task < INPUT_TASKS; task++) next[task] = 0;
+    for (;;)
+    {
+        // --- find the task whose next error comes first in the file
+        k = -1;
+        for (task = 0; task < INPUT_TASKS; task++)
+        {
+            if ( next[task] >= TaskErrors[task].count ) continue;
+            if ( k < 0 || TaskErrors[task].errs[next[task]].lineCount <
+                          TaskErrors[k].errs[next[k]].lineCount ) k = task;
+        }
+        if ( k < 0 ) break;
+        err = &TaskErrors[k].errs[next[k]];
+        next[k]++;
+
+        // --- report the error
+        errsum++;
+        if ( errsum > MAXERRS )
+        {
+            report_writeLine(FMT19);
+            break;
+        }
+        error_setInpError(err->code, err->msg);
+        report_writeInputErrorMsg(err->code, err->sect,
+            copyInputLine(InpText + (err->line - InpWork), line),
+            err->lineCount);
+    }
+    return errsum;
+}
+
+//=============================================================================
+
+char* copyInputLine(char* text, char* buf)
+//
+//  Input:   text = start of a line in the original input text
+//           buf = buffer of at least MAXLINE+1 characters
+//  Output:  returns buf
+//  Purpose: copies a line of the original input text, including its line
+//           feed, into a null-terminated buffer.
+//
+{
+    size_t n = nextLine(text, InpText + InpSize) - text;
+
+    memcpy(buf, text, n);
+    buf[n] = '\0';
+#if defined(_WIN32)
+    // --- drop the carriage return that reading in text mode would remove
+    if ( n >= 2 && buf[n-2] == '\r' && buf[n-1] == '\n' )
+    {
+        buf[n-2] = '\n';
+        buf[n-1] = '\0';
+    }
+#endif
+    return buf;
+}
+
+//=============================================================================
+
+char* getUsedTseries()
+//
+//  Input:   none
+//  Output:  returns an array that is TRUE for each time series in use,
+//           or NULL if out of memory (when all are taken to be in use)
+//  Purpose: finds the time series that other objects use.
+//
+{
+    int   i;
+    char* used = (char *) calloc(Nobjects[TSERIES] + 1, sizeof(char));
+
+    if ( used == NULL ) return NULL;
+    for (i = 0; i < Nobjects[TSERIES]; i++)
+    {
+        if ( Tseries[i].refersTo >= 0 ) used[i] = TRUE;
+    }
+    for (i = 0; i < Nobjects[GAGE]; i++)
+    {
+        if ( Gage[i].dataSource == RAIN_TSERIES && Gage[i].tSeries >= 0 )
+            used[Gage[i].tSeries] = TRUE;
+    }
+    return used;
+}
+
+//=============================================================================
+
+int isTseriesLoaded(int j, char* used, DateTime start, DateTime end)
+//
+//  Input:   j = time series index
+//           used = array that is TRUE for each time series in use
+//                  (NULL if all time series are used)
+//           start = start of period of dates needed
+//           end = end of period of dates needed
+//  Output:  returns TRUE if the time series needs no data loaded
+//  Purpose: checks if a time series has the data it needs.
+//
+{
+    if ( Tseries[j].firstLines == NULL ) return TRUE;
+    if ( used && !used[j] ) return TRUE;
+    return Tseries[j].loadStart <= start && Tseries[j].loadEnd >= end;
+}
+
+//=============================================================================
+
+int loadTimeseries(char* used, DateTime start, DateTime end, int validate)
+//
+//  Input:   used = array that is TRUE for each time series in use
+//                  (NULL if all time series are used)
+//           start = start of period of dates to load
+//           end = end of period of dates to load
+//           validate = TRUE if each time series loaded is to be validated
+//  Output:  returns an error code
+//  Purpose: loads data from the input file's text for each time series in
+//           use that doesn't already have them.
+//
+//  Note:    the errors found are added to those of the time series task in
+//           the order that their lines appear in the input file.
+//
+{
+    char   line[MAXLINE+1];
+    char*  tok[MAXTOKS];
+    char*  s;
+    char*  next;
+    char*  end1;
+    int    j, ntoks, inperr, errcode = 0;
+    long   lineCount;
+    TTableLines* lines;
+
+    for (j = 0; j < Nobjects[TSERIES]; j++)
+    {
+        if ( isTseriesLoaded(j, used, start, end) ) continue;
+        table_startTseriesLoad(&Tseries[j], start, end, TseriesStartDate);
+        for (lines = Tseries[j].firstLines; lines; lines = lines->next)
+        {
+            lineCount = lines->lineCount;
+            end1 = InpText + lines->end;
+            for (s = InpText + lines->start; s < end1; s = next)
+            {
+                next = nextLine(s, end1);
+                memcpy(line, s, next - s);
+                line[next - s] = '\0';
+                ntoks = tokenize(line, tok);
+                if ( ntoks > 0 && *tok[0] != ';' )
+                {
+                    inperr = table_readTimeseries(tok, ntoks);
+                    if ( inperr > 0 )
+                        addInputError(TSERIES_TASK, inperr, s_TIMESERIES,
+                                      InpWork + (s - InpText), lineCount);
+                }
+                lineCount++;
+            }
+        }
+        table_endTseriesLoad(&Tseries[j]);
+
+        // --- check the data loaded for a simulation already validated
+        if ( validate )
+        {
+            inperr = table_validate(&Tseries[j]);
+            if ( inperr )
+            {
+                report_writeTseriesErrorMsg(inperr, &Tseries[j]);
+                errcode = inperr;
+            }
+        }
+    }
+
+    // --- place errors in line order for reportInputErrors
+    qsort(TaskErrors[TSERIES_TASK].errs, TaskErrors[TSERIES_TASK].count,
+          sizeof(TInpError), compareInputErrors);
+    return errcode;
+}
+
+//=============================================================================
+
+int compareInputErrors(const void* a, const void* b)
+//
+//  Input:   a, b = pointers to two input errors
+//  Output:  returns -1, 0 or 1 as a's line comes before, with or after b's
+//  Purpose: compares the line numbers of two input errors for qsort.
+//
+{
+    long n1 = ((TInpError *)a)->lineCount;
+    long n2 = ((TInpError *)b)->lineCount;
+
+    if ( n1 < n2 ) return -1;
+    if ( n1 > n2 ) return 1;
+    return 0;
+}
+
+//=============================================================================
+
+int getCompiledName(char* name)
+//
+//  Input:   none
+//  Output:  name = name of the project's compiled file
+//           returns TRUE if the name fits in MAXFNAME characters
+//  Purpose: names the compiled file after the input file, replacing the
+//           input file's extension with COMPILED_EXT.
+//
+{
+    char* ext;
+    char* dir;
+
+    sstrncpy(name, Finp.name, MAXFNAME);
+    dir = strrchr(name, '/');
+    ext = strrchr(name, '\\');
+    if ( ext > dir ) dir = ext;
+    ext = strrchr(name, '.');
+    if ( ext && ext > dir ) *ext = '\0';
+    if ( strlen(name) + strlen(COMPILED_EXT) > MAXFNAME ) return FALSE;
+    strcat(name, COMPILED_EXT);
+    return TRUE;
+}
+
+//=============================================================================
+
+int openCompiledInput()
+//
+//  Input:   none
+//  Output:  returns TRUE if the project's compiled file can be used
+//  Purpose: maps the project's compiled file into memory if it was made
+//           from the current version of the input file.
+//
+{
+    char   name[MAXFNAME+1];
+    FILE*  file;
+    struct stat inpStat, st;
+    TCompiledHeader* header;
+    long long size;
+    int    i, mapped;
+
+    // --- the compiled file must be newer than the input file
+    CompiledText = NULL;
+    CompiledSize = 0;
+    if ( !getCompiledName(name) ||
+         stat(Finp.name, &inpStat) != 0 || stat(name, &st) != 0 ||
+         st.st_mtime < inpStat.st_mtime ) return FALSE;
+
+    // --- map a private copy of it (since parsers may modify tokens)
+    file = fopen(name, "rb");
+    if ( file == NULL ) return FALSE;
+    mapped = mapFile(file, TRUE, &CompiledText, &CompiledSize);
+    fclose(file);
+    if ( !mapped ) return FALSE;
+
+    // --- check that it was compiled from this input file by this version
+    //     of SWMM
+    header = (TCompiledHeader *)CompiledText;
+    size = sizeof(TCompiledHeader);
+    if ( CompiledSize >= sizeof(TCompiledHeader) )
+    {
+        for (i = 0; i < COMPILED_RECORDS; i++) size += header->size[i];
+    }
+    if ( CompiledSize < sizeof(TCompiledHeader) ||
+         header->magic != COMPILED_MAGIC ||
+         header->version != COMPILED_VERSION ||
+         header->swmmVersion != VERSION ||
+         header->headerSize != sizeof(TCompiledHeader) ||
+         header->inpSize != inpStat.st_size ||
+         header->inpTime != inpStat.st_mtime ||
+         size != (long long)CompiledSize )
+    {
+        closeCompiledInput();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+//=============================================================================
+
+void closeCompiledInput()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: unmaps the project's compiled file from memory.
+//
+{
+    unmapFile(CompiledText, CompiledSize);
+    CompiledText = NULL;
+    CompiledSize = 0;
+}
+
+//=============================================================================
+
+int countCompiledObjects()
+//
+//  Input:   none
+//  Output:  returns error code
+//  Purpose: counts the number of system objects listed in the project's
+//           compiled file.
+//
+{
+    TCompiledHeader* header = (TCompiledHeader *)CompiledText;
+    TCompiledLine*   line;
+    char* c = CompiledText + sizeof(TCompiledHeader);
+    char* end = c + header->size[COUNT_RECORDS];
+    char* tok[2];
+    int   errcode;
+    int   errsum = 0;
+
+    for ( ; c < end; c += sizeof(TCompiledLine) + line->size )
+    {
+        // --- read an option setting or add an object to the project
+        line = (TCompiledLine *)c;
+        tok[0] = c + sizeof(TCompiledLine);
+        tok[1] = NULL;
+        if ( line->ntoks > 1 ) tok[1] = tok[0] + strlen(tok[0]) + 1;
+        if ( line->sect == s_OPTION ) errcode = readOption(tok[0]);
+        else errcode = addObject(line->sect, tok, line->ntoks);
+
+        // --- report any error found
+        if ( errcode )
+        {
+            report_writeInputErrorMsg(errcode, line->sect, "",
+                                      line->lineCount);
+            errsum++;
+            if ( errsum >= MAXERRS ) break;
+        }
+    }
+    if ( errsum > 0 ) ErrorCode = ERR_INPUT;
+    return ErrorCode;
+}
+
+//=============================================================================
+
+int readCompiledData()
+//
+//  Input:   none
+//  Output:  returns error code
+//  Purpose: reads each object's input data from the project's compiled file.
+//
+{
+    TCompiledHeader* header = (TCompiledHeader *)CompiledText;
+    TCompiledLine*   line;
+    TCompiledTable*  table;
+    TTable* t;
+    char*   c;
+    char*   end;
+    char*   text;
+    double* x;
+    int     i, k, sect = s_TITLE;
+    int     inperr, errsum = 0;
+
+    // --- pass each line parsed by the main task to its section's parser
+    c = CompiledText + sizeof(TCompiledHeader) + header->size[COUNT_RECORDS];
+    end = c + header->size[READ_RECORDS];
+    for ( ; c < end; c += sizeof(TCompiledLine) + line->size )
+    {
+        line = (TCompiledLine *)c;
+        text = c + sizeof(TCompiledLine);
+
+        // --- check if at start of a new input section
+        if ( line->ntoks < 0 )
+        {
+            // --- SPECIAL CASE FOR TRANSECTS
+            //     finish processing the last set of transect data
+            if ( sect == s_TRANSECT )
+                transect_validate(Nobjects[TRANSECT]-1);
+            sect = line->sect;
+            continue;
+        }
+
+        // --- retrieve the line's tokens
+        for (k = 0; k < MAXTOKS; k++) Tok[k] = NULL;
+        Ntokens = line->ntoks;
+        for (k = 0; k < Ntokens && sect != s_TITLE; k++)
+        {
+            Tok[k] = text;
+            text += strlen(text) + 1;
+        }
+        inperr = parseLine(sect, text);
+        if ( inperr > 0 )
+        {
+            errsum++;
+            if ( errsum > MAXERRS )
+            {
+                report_writeLine(FMT19);
+                break;
+            }
+            report_writeInputErrorMsg(inperr, sect, "", line->lineCount);
+        }
+    }
+
+    // --- add the data read for each curve & time series
+    c = end;
+    end = c + header->size[TABLE_RECORDS];
+    for (i = 0; c < end && i < Nobjects[CURVE] + Nobjects[TSERIES]; i++)
+    {
+        table = (TCompiledTable *)c;
+        text = c + sizeof(TCompiledTable);
+        x = (double *)(text + table->size);
+        if ( i < Nobjects[CURVE] ) t = &Curve[i];
+        else t = &Tseries[i - Nobjects[CURVE]];
+        if ( *text != '\0' )
+            t->ID = project_findID(i < Nobjects[CURVE] ? CURVE : TSERIES, text);
+        t->curveType = table->curveType;
+        t->file.mode = (char)table->fileMode;
+        sstrncpy(t->file.name, text + strlen(text) + 1, MAXFNAME);
+        t->lastDate = table->lastDate;
+        for (k = 0; k < table->entries; k++)
+        {
+            if ( !table_addEntry(t, x[2*k], x[2*k+1]) )
+            {
+                report_writeErrorMsg(ERR_MEMORY, "");
+                return ErrorCode;
+            }
+        }
+        c = (char *)(x + 2 * table->entries);
+    }
+    if ( errsum > 0 ) ErrorCode = ERR_INPUT;
+    return ErrorCode;
+}
+
+//=============================================================================
+
+char* addCompiledRecord(int type, size_t size)
+//
+//  Input:   type = type of record (see CompiledRecordType)
+//           size = size of the record (bytes)
+//  Output:  returns a pointer to the new record, zeroed, or NULL if out of
+//           memory
+//  Purpose: adds room for a new record to a set of records being compiled.
+//
+{
+    TCompiledRecords* records = &Compiled[type];
+    size_t capacity;
+    char*  data;
+
+    if ( records->size + size > records->capacity )
+    {
+        capacity = records->capacity > 0 ? 2 * records->capacity : 65536;
+        while ( capacity < records->size + size ) capacity *= 2;
+        data = (char *) realloc(records->data, capacity);
+        if ( data == NULL ) return NULL;
+        records->data = data;
+        records->capacity = capacity;
+    }
+    data = records->data + records->size;
+    memset(data, 0, size);
+    records->size += size;
+    return data;
+}
+
+//=============================================================================
+
+int addCompiledLine(int type, int sect, char* tok[], int ntoks, char* text,
+                    long lineCount)
+//
+//  Input:   type = COUNT_RECORDS or READ_RECORDS
+//           sect = section code
+//           tok[] = tokens of a line of input
+//           ntoks = number of tokens (-1 for a section heading)
+//           text = full text of the line (or NULL if only tokens are saved)
+//           lineCount = line number in input file
+//  Output:  returns TRUE if successful, FALSE if out of memory
+//  Purpose: saves a line of input to be written to a compiled file.
+//
+{
+    TCompiledLine* line;
+    char*  c;
+    size_t n, len = 0;
+    int    k;
+
+    // --- find size of the line's text or tokens (rounded up so that
+    //     records stay aligned)
+    if ( text ) len = strlen(text) + 1;
+    else for (k = 0; k < ntoks; k++) len += strlen(tok[k]) + 1;
+    len = (len + 7) & ~(size_t)7;
+
+    // --- add the line's record followed by its text or tokens
+    c = addCompiledRecord(type, sizeof(TCompiledLine) + len);
+    if ( c == NULL ) return FALSE;
+    line = (TCompiledLine *)c;
+    line->sect = sect;
+    line->ntoks = ntoks;
+    line->size = (int)len;
+    line->lineCount = (int)lineCount;
+    c += sizeof(TCompiledLine);
+    if ( text ) strcpy(c, text);
+    else for (k = 0; k < ntoks; k++)
+    {
+        n = strlen(tok[k]) + 1;
+        memcpy(c, tok[k], n);
+        c += n;
+    }
+    return TRUE;
+}
+
+//=============================================================================
+
+int addCompiledTable(TTable* table)
+//
+//  Input:   table = a curve or time series
+//  Output:  returns TRUE if successful, FALSE if out of memory
+//  Purpose: saves the data read for a curve or time series to be written
+//           to a compiled file.
+//
+{
+    TCompiledTable* t;
+    TTableEntry*    entry;
+    char*   c;
+    char*   id = table->ID ? table->ID : "";
+    double* x;
+    size_t  len;
+    int     n = 0;
+
+    // --- add a record holding the table's ID, external file name and
+    //     x,y entries
+    for ( entry = table->firstEntry; entry; entry = entry->next ) n++;
+    len = strlen(id) + strlen(table->file.name) + 2;
+    len = (len + 7) & ~(size_t)7;
+    c = addCompiledRecord(TABLE_RECORDS,
+                          sizeof(TCompiledTable) + len + 2 * n * sizeof(double));
+    if ( c == NULL ) return FALSE;
+    t = (TCompiledTable *)c;
+    t->curveType = table->curveType;
+    t->fileMode = table->file.mode;
+    t->size = (int)len;
+    t->entries = n;
+    t->lastDate = table->lastDate;
+    c += sizeof(TCompiledTable);
+    strcpy(c, id);
+    strcpy(c + strlen(id) + 1, table->file.name);
+    x = (double *)(c + len);
+    for ( entry = table->firstEntry; entry; entry = entry->next )
+    {
+        *x++ = entry->x;
+        *x++ = entry->y;
+    }
+    return TRUE;
+}
+
+//=============================================================================
+
+void freeCompiledRecords()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees the records saved for a compiled file.
+//
+{
+    int i;
+    for (i = 0; i < COMPILED_RECORDS; i++)
+    {
+        FREE(Compiled[i].data);
+        Compiled[i].size = 0;
+        Compiled[i].capacity = 0;
+    }
+}
@@ -52,7 +52,8 @@ char* EvapTypeWords[]      = { w_CONSTANT, w_MONTHLY, w_TIMESERIES,
                                w_TEMPERATURE, w_FILE, w_RECOVERY,
                                w_DRYONLY, NULL};
 char* FileTypeWords[]      = { w_RAINFALL, w_RUNOFF, w_HOTSTART, w_RDII,
-                               w_INFLOWS, w_OUTFLOWS, NULL};
+                               w_INFLOWS, w_OUTFLOWS, w_CLIMATE,               //(5.1.015)
+                               w_RECORDING, NULL};                             //(5.1.015)
 char* FileModeWords[]      = { w_NO, w_SCRATCH, w_USE, w_SAVE, NULL};
 char* FlowUnitWords[]      = { w_CFS, w_GPM, w_MGD, w_CMS, w_LPS, w_MLD, NULL};
 char* ForceMainEqnWords[]  = { w_H_W, w_D_W, NULL};
@@ -94,15 +95,25 @@ char* OptionWords[]        = { w_FLOW_UNITS,        w_INFIL_MODEL,
                                w_SYS_FLOW_TOL,      w_LAT_FLOW_TOL,
                                w_IGNORE_RDII,       w_MIN_ROUTE_STEP,
                                w_NUM_THREADS,       w_SURCHARGE_METHOD,        //(5.1.013)
+                               w_OUTPUT_FORMAT,     w_OUTPUT_NAME_INDEX,       //(5.1.015)
                                NULL };
 char* OrificeTypeWords[]   = { w_SIDE, w_BOTTOM, NULL};
 char* OutfallTypeWords[]   = { w_FREE, w_NORMAL, w_FIXED, w_TIDAL,
                                w_TIMESERIES, NULL};
+char* OutputFormatWords[]  = { w_STANDARD, w_COMPRESSED, NULL};                //(5.1.015)
 char* PatternTypeWords[]   = { w_MONTHLY, w_DAILY, w_HOURLY, w_WEEKEND, NULL};
 char* PondingUnitsWords[]  = { w_PONDED_FEET, w_PONDED_METERS };
 char* ProcessVarWords[]    = { w_HRT, w_DT, w_FLOW, w_DEPTH, w_AREA, NULL};
 char* PumpTypeWords[]      = { w_TYPE1, w_TYPE2, w_TYPE3, w_TYPE4, w_IDEAL };
 char* QualUnitsWords[]     = { w_MGperL, w_UGperL, w_COUNTperL, NULL};
+char* RecordLinkWords[]    = { w_FLOW, w_DEPTH, w_VELOCITY, w_VOLUME,          //(5.1.015)
+                               w_CAPACITY, NULL};                              //
+char* RecordNodeWords[]    = { w_DEPTH, w_HEAD, w_VOLUME, w_LAT_INFLOW,        //
+                               w_TOTAL_INFLOW, w_OVERFLOW, NULL};              //
+char* RecordSubcatchWords[] = { w_RAINFALL, w_SNOW_DEPTH, w_EVAP, w_INFIL,     //
+                               w_RUNOFF, w_GW_FLOW, w_GW_ELEV,                 //
+                               w_SOIL_MOIST, NULL};                            //
+char* RecordTypeWords[]    = { w_SUBCATCH, w_NODE, w_LINK, NULL};              //
 char* RainTypeWords[]      = { w_INTENSITY, w_VOLUME, w_CUMULATIVE, NULL};
 char* RainUnitsWords[]     = { w_INCHES, w_MMETER, NULL};
 char* RelationWords[]      = { w_TABULAR, w_FUNCTIONAL, NULL};
@@ -140,6 +151,7 @@ char* SectWords[]          = { ws_TITLE,          ws_OPTION,
                                ws_MAP,            ws_LID_CONTROL,
                                ws_LID_USAGE,      ws_GWF,
                                ws_ADJUST,         ws_EVENT,
+                               ws_RECORDING,                                   //(5.1.015)
                                NULL};                       
 char* SnowmeltWords[]      = { w_PLOWABLE, w_IMPERV, w_PERV, w_REMOVAL, NULL};
 char* SurchargeWords[]     = { w_EXTRAN, w_SLOT, NULL};                        //(5.1.013)
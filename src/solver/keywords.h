@@ -42,11 +42,16 @@ extern char* OffOnWords[];
 extern char* OptionWords[];
 extern char* OrificeTypeWords[];
 extern char* OutfallTypeWords[];
+extern char* OutputFormatWords[];                                              //(5.1.015)
 extern char* PatternTypeWords[];
 extern char* PondingUnitsWords[];
 extern char* ProcessVarWords[];
 extern char* PumpTypeWords[];
 extern char* QualUnitsWords[];
+extern char* RecordLinkWords[];                                                //(5.1.015)
+extern char* RecordNodeWords[];                                                //
+extern char* RecordSubcatchWords[];                                            //
+extern char* RecordTypeWords[];                                                //
 extern char* RainTypeWords[];
 extern char* RainUnitsWords[];
 extern char* ReportWords[];
@@ -77,6 +77,18 @@
 //   Build 5.1.014:
 //   - Fixed bug in creating LidProcs when there are no subcatchments.
 //   - Fixed bug in adding underdrain pollutant loads to mass balances.
+//
+//   Build 5.1.015:
+//   - Drain flows sent to conveyance system nodes are read from the
+//     runoff results frame used by routing.
+//   - LID units of all subcatchments are analyzed in a single pass by
+//     lid_execute, in parallel and ordered by LID process, between the
+//     computation of each subcatchment's non-LID runoff and its LID totals.
+//   - LID groups, units and drain pollutant removals are allocated from the
+//     project's memory pools and are freed with them.
+//   - New function lid_snapshot saves and restores the state of LID units.
+//   - New function lid_addEnsembleFiles lists LID report files to be copied
+//     for each member of a forked simulation ensemble.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -128,6 +140,33 @@ char* LidTypeWords[] =
 //-----------------------------------------------------------------------------
 // LID List - list of LID units contained in an LID group
 
+// LID Task - an LID unit analyzed by lid_execute over a time step             //(5.1.015)
+typedef struct
+{
+    int        subcatch;       // subcatchment containing the unit
+    TLidUnit*  lidUnit;        // the LID unit
+    char       isActive;       // TRUE if unit awaits analysis by lid_execute
+    double     lidArea;        // area of the LID unit (ft2)
+    double     vIn;            // runoff volume treated by the unit (ft3)
+    double     inflow;         // inflow to the unit (ft/s)
+    double     runoff;         // surface runoff from the unit (ft/s)
+    double     evap;           // evaporation rate from the unit (ft/s)
+    double     infil;          // infiltration rate from the unit (ft/s)
+    double     drain;          // drain flow from the unit (ft/s)
+    TLidState  state;          // flux rates found for the unit
+}   TLidTask;
+
+// LID Group Step - conditions seen by a group's LID units over a time step
+typedef struct
+{
+    int        firstTask;      // index of group's first unit in LidTasks
+    int        taskCount;      // number of units in the group
+    double     evapRate;       // evaporation rate (ft/s)
+    double     nativeInfil;    // native soil infil. rate (ft/s)
+    double     maxNativeInfil; // native soil infil. rate limit (ft/s)
+    double     infilFactor;    // hydraulic conductivity adjustment factor
+}   TLidGroupStep;
+
 //-----------------------------------------------------------------------------
 //  Shared Variables
 //-----------------------------------------------------------------------------
@@ -136,9 +175,10 @@ static int        LidCount;            // number of LID processes
 static TLidGroup* LidGroups;           // array of LID process groups
 static int        GroupCount;          // number of LID groups (subcatchments)
 
-static double     EvapRate;            // evaporation rate (ft/s)
-static double     NativeInfil;         // native soil infil. rate (ft/s)
-static double     MaxNativeInfil;      // native soil infil. rate limit (ft/s)
+static TLidTask*  LidTasks;            // LID units of all groups              //(5.1.015)
+static int        TaskCount;           // number of LID units                  //
+static int*       TaskOrder;           // LidTasks ordered by LID process      //
+static TLidGroupStep* GroupSteps;      // per group time step conditions       //
 
 //-----------------------------------------------------------------------------
 //  Imported Variables (from SUBCATCH.C)
@@ -154,6 +194,8 @@ extern double     VlidDrain;           // drain outflow from LID units
 extern double     VlidReturn;          // LID outflow returned to pervious area
 extern char       HasWetLids;          // TRUE if any LIDs are wet
                                        // (from RUNOFF.C)
+extern int        RunoffThreads;       // threads used by runoff's loops       //(5.1.015)
+                                       // (from RUNOFF.C)                      //
 
 //-----------------------------------------------------------------------------
 //  External Functions (prototyped in lid.h)
@@ -162,6 +204,8 @@ extern char       HasWetLids;          // TRUE if any LIDs are wet
 //  lid_delete               called by deleteObjects in project.c
 //  lid_validate             called by project_validate
 //  lid_initState            called by project_init
+//  lid_open                 called by runoff_open
+//  lid_close                called by runoff_close
 
 //  lid_readProcParams       called by parseLine in input.c
 //  lid_readGroupParams      called by parseLine in input.c
@@ -176,11 +220,16 @@ extern char       HasWetLids;          // TRUE if any LIDs are wet
 //  lid_getDepthOnPavement   called by sweptSurfacesDry in subcatch.c
 //  lid_getStoredVolume      called by subcatch_getStorage
 //  lid_getRunon             called by subcatch_getRunon
+//  lid_setGroupInflows      called by subcatch_getSurfaceRunoff
+//  lid_execute              called by runoff_execute
 //  lid_getRunoff            called by subcatch_getRunoff
 
 //  lid_addDrainRunon        called by subcatch_getRunon
 //  lid_addDrainLoads        called by surfqual_getWashoff
 //  lid_addDrainInflow       called by addLidDrainInflows in routing.c
+//  lid_saveDrainFlows       called by saveFrame in runoff.c
+//  lid_snapshot             called by visitState in snapshot.c
+//  lid_addEnsembleFiles     called by addProjectFiles in ensemble.c
 
 //  lid_writeSummary         called by inputrpt_writeInput
 //  lid_writeWaterBalance    called by statsrpt_writeReport
@@ -218,11 +267,11 @@ static int    isLidPervious(int k);
 static double getImpervAreaRunoff(int j);
 static double getPervAreaRunoff(int j);                                        //(5.1.013)
 static double getSurfaceDepth(int subcatch);
-static void   findNativeInfil(int j, double tStep);
+static void   findNativeInfil(int j, double tStep, TLidGroupStep* g);
 
-static void   evalLidUnit(int j, TLidUnit* lidUnit, double lidArea,
-              double lidInflow, double tStep, double *qRunoff,
-              double *qDrain, double *qReturn);
+static void   evalLidTask(TLidTask* task, double tStep);                       //(5.1.015)
+static void   evalLidUnit(int j, TLidTask* task, double tStep,
+              double *qRunoff, double *qDrain, double *qReturn);
 
 //=============================================================================
 
@@ -281,8 +330,8 @@ void lid_create(int lidCount, int subcatchCount)
         LidProcs[j].drainMat.thickness = 0.0;
         LidProcs[j].drainMat.roughness = 0.0;
         LidProcs[j].drainRmvl = NULL;                                          //(5.1.013)
-        LidProcs[j].drainRmvl = (double *)                                     //
-                                calloc(Nobjects[POLLUT], sizeof(double));      //
+        LidProcs[j].drainRmvl = (double *) project_alloc(QUAL_POOL,            //(5.1.015)
+                                Nobjects[POLLUT], sizeof(double));             //(5.1.015)
         if (LidProcs[j].drainRmvl == NULL)                                     //
         {                                                                      //
             ErrorCode = ERR_MEMORY;                                            //
@@ -303,7 +352,6 @@ void lid_delete()
     int j;
     for (j = 0; j < GroupCount; j++) freeLidGroup(j);
     FREE(LidGroups);
-    for (j = 0; j < LidCount; j++) FREE(LidProcs[j].drainRmvl);                //(5.1.013)
     FREE(LidProcs);
     GroupCount = 0;
     LidCount = 0;
@@ -317,11 +365,14 @@ void freeLidGroup(int j)
 //  Input:   j = group (or subcatchment) index
 //  Output:  none
 //
+//  Note: the group, its units and its list of units were allocated from
+//        the project's LID memory pool and are freed along with it; only
+//        the units' report files are released here.
+//
 {
     TLidGroup  lidGroup = LidGroups[j];
     TLidList*  lidList;
     TLidUnit*  lidUnit;
-    TLidList*  nextLidUnit;
 
     if ( lidGroup == NULL ) return;
     lidList = lidGroup->lidList;
@@ -331,14 +382,11 @@ void freeLidGroup(int j)
         if ( lidUnit->rptFile )
         {
             if ( lidUnit->rptFile->file ) fclose(lidUnit->rptFile->file);
+            FREE(lidUnit->rptFile->name);                                      //(5.1.015)
             free(lidUnit->rptFile);
         }
-        nextLidUnit = lidList->nextLidUnit;
-        free(lidUnit);
-        free(lidList);
-        lidList = nextLidUnit;
+        lidList = lidList->nextLidUnit;                                        //(5.1.015)
     }
-    free(lidGroup);
     LidGroups[j] = NULL;
 }
 
@@ -511,24 +559,21 @@ int addLidUnit(int j, int k, int n, double x[], char* fname,
     lidGroup = LidGroups[j];
     if ( !lidGroup )
     {
-        lidGroup = (struct LidGroup *) malloc(sizeof(struct LidGroup));
+        lidGroup = (struct LidGroup *)                                         //(5.1.015)
+                   project_alloc(LID_POOL, 1, sizeof(struct LidGroup));        //(5.1.015)
         if ( !lidGroup ) return error_setInpError(ERR_MEMORY, "");
         lidGroup->lidList = NULL;
         LidGroups[j] = lidGroup;
     }
 
     //... create a new LID unit to add to the group
-    lidUnit = (TLidUnit *) malloc(sizeof(TLidUnit));
+    lidUnit = (TLidUnit *) project_alloc(LID_POOL, 1, sizeof(TLidUnit));       //(5.1.015)
     if ( !lidUnit ) return error_setInpError(ERR_MEMORY, "");
     lidUnit->rptFile = NULL;
 
     //... add the LID unit to the group
-    lidList = (TLidList *) malloc(sizeof(TLidList));
-    if ( !lidList )
-    {
-        free(lidUnit);
-        return error_setInpError(ERR_MEMORY, "");
-    }
+    lidList = (TLidList *) project_alloc(LID_POOL, 1, sizeof(TLidList));       //(5.1.015)
+    if ( !lidList ) return error_setInpError(ERR_MEMORY, "");                  //(5.1.015)
     lidList->lidUnit = lidUnit;
     lidList->nextLidUnit = lidGroup->lidList;
     lidGroup->lidList = lidList;
@@ -563,8 +608,12 @@ int createLidRptFile(TLidUnit* lidUnit, char* fname)
     rptFile = (TLidRptFile *) malloc(sizeof(TLidRptFile));
     if ( rptFile == NULL ) return 0;
     lidUnit->rptFile = rptFile;
+    rptFile->name = NULL;                                                      //(5.1.015)
     rptFile->file = fopen(fname, "wt");
     if ( rptFile->file == NULL ) return 0;
+    rptFile->name = (char *) malloc(strlen(fname) + 1);                        //(5.1.015)
+    if ( rptFile->name == NULL ) return 0;                                     //(5.1.015)
+    strcpy(rptFile->name, fname);                                              //(5.1.015)
     return 1;
 }
 
@@ -1300,6 +1349,91 @@ void lid_initState()
 
 //=============================================================================
 
+////  New function added to release 5.1.015.  ////                             //(5.1.015)
+
+int lid_open()
+//
+//  Purpose: allocates memory used to analyze all LID units in a single pass.
+//  Input:   none
+//  Output:  returns an error code
+//
+//  Each LID unit becomes a task whose position in LidTasks follows the order
+//  of the units within their groups. TaskOrder lists the same tasks sorted
+//  (stably) by LID process so that units sharing the same parameters and
+//  flux rate functions are analyzed together.
+//
+{
+    int        j, k, n;
+    int*       count;
+    TLidList*  lidList;
+
+    LidTasks = NULL;
+    TaskOrder = NULL;
+    GroupSteps = NULL;
+    TaskCount = 0;
+
+    //... count LID units in all groups
+    n = 0;
+    for (j = 0; j < GroupCount; j++) n += lid_getLidUnitCount(j);
+    if ( n == 0 ) return 0;
+
+    //... allocate memory
+    LidTasks = (TLidTask *) calloc(n, sizeof(TLidTask));
+    TaskOrder = (int *) calloc(n, sizeof(int));
+    GroupSteps = (TLidGroupStep *) calloc(GroupCount, sizeof(TLidGroupStep));
+    count = (int *) calloc(LidCount + 1, sizeof(int));
+    if ( !LidTasks || !TaskOrder || !GroupSteps || !count )
+    {
+        FREE(count);
+        return ERR_MEMORY;
+    }
+
+    //... assign each group's LID units to consecutive tasks
+    for (j = 0; j < GroupCount; j++)
+    {
+        GroupSteps[j].firstTask = TaskCount;
+        if ( LidGroups[j] ) lidList = LidGroups[j]->lidList;
+        else                lidList = NULL;
+        while ( lidList )
+        {
+            LidTasks[TaskCount].subcatch = j;
+            LidTasks[TaskCount].lidUnit = lidList->lidUnit;
+            LidTasks[TaskCount].isActive = FALSE;
+            TaskCount++;
+            lidList = lidList->nextLidUnit;
+        }
+        GroupSteps[j].taskCount = TaskCount - GroupSteps[j].firstTask;
+    }
+
+    //... order the tasks by LID process using a counting sort
+    for (k = 0; k < TaskCount; k++)
+        count[LidTasks[k].lidUnit->lidIndex + 1]++;
+    for (j = 1; j < LidCount; j++) count[j] += count[j-1];
+    for (k = 0; k < TaskCount; k++)
+        TaskOrder[count[LidTasks[k].lidUnit->lidIndex]++] = k;
+    FREE(count);
+    return 0;
+}
+
+//=============================================================================
+
+////  New function added to release 5.1.015.  ////                             //(5.1.015)
+
+void lid_close()
+//
+//  Purpose: frees memory used to analyze all LID units in a single pass.
+//  Input:   none
+//  Output:  none
+//
+{
+    FREE(LidTasks);
+    FREE(TaskOrder);
+    FREE(GroupSteps);
+    TaskCount = 0;
+}
+
+//=============================================================================
+
 void  lid_setOldGroupState(int j)
 //
 //  Purpose: saves the current drain flow rate for the LIDs in a subcatchment.
@@ -1565,12 +1699,16 @@ void  lid_addDrainInflow(int j, double f)
                p;            // pollutant index
     double     q,            // drain flow (cfs)
                w, w1, w2;    // pollutant mass loads (mass/sec)
+    double*    x;            // saved old & new drain flows (cfs)
     TLidUnit*  lidUnit;
     TLidList*  lidList;
     TLidGroup  lidGroup;
+    TSubcatchFrame* s;       // saved runoff results for subcatchment
 
     //... check if LID group exists
     lidGroup = LidGroups[j];
+    s = &runoff_getFrame()->subcatch[j];
+    x = s->lidDrains;
     if ( lidGroup != NULL )
     {
         //... examine each LID in the group
@@ -1584,7 +1722,7 @@ void  lid_addDrainInflow(int j, double f)
             if ( k >= 0 )
             {
                 //... add drain flow to node's wet weather inflow
-                q = (1.0 - f) * lidUnit->oldDrainFlow + f * lidUnit->newDrainFlow;
+                q = (1.0 - f) * x[0] + f * x[1];
                 Node[k].newLatFlow += q;
                 massbal_addInflowFlow(WET_WEATHER_INFLOW, q);
 
@@ -1592,8 +1730,8 @@ void  lid_addDrainInflow(int j, double f)
                 for (p = 0; p < Nobjects[POLLUT]; p++)
                 {
                     //... get previous & current drain loads
-                    w1 = lidUnit->oldDrainFlow * Subcatch[j].oldQual[p];
-                    w2 = lidUnit->newDrainFlow * Subcatch[j].newQual[p]; 
+                    w1 = x[0] * s->oldQual[p];
+                    w2 = x[1] * s->newQual[p];
 
                     //... add interpolated load to node's wet weather loading
                     w = (1.0 - f) * w1 + f * w2;
@@ -1602,6 +1740,7 @@ void  lid_addDrainInflow(int j, double f)
                     massbal_addInflowQual(WET_WEATHER_INFLOW, p, w);
                 }
             }
+            x += 2;
             lidList = lidList->nextLidUnit;
         }
     }
@@ -1609,63 +1748,157 @@ void  lid_addDrainInflow(int j, double f)
 
 //=============================================================================
 
-void lid_getRunoff(int j, double tStep)
+void  lid_saveDrainFlows(int j, double x[])
 //
-//  Purpose: computes runoff and drain flows from the LIDs in a subcatchment.
-//  Input:   j     = subcatchment index 
+//  Purpose: saves the previous and current drain flows of each LID unit
+//           in a subcatchment.
+//  Input:   j = subcatchment index
+//  Output:  x = old & new drain flow (cfs) of each unit, in list order.
+//
+{
+    TLidUnit*  lidUnit;
+    TLidList*  lidList;
+
+    if ( LidGroups == NULL || LidGroups[j] == NULL ) return;
+    lidList = LidGroups[j]->lidList;
+    while ( lidList )
+    {
+        lidUnit = lidList->lidUnit;
+        *x++ = lidUnit->oldDrainFlow;
+        *x++ = lidUnit->newDrainFlow;
+        lidList = lidList->nextLidUnit;
+    }
+}
+
+//=============================================================================
+
+////  New function added to release 5.1.015.  ////                             //(5.1.015)
+
+void lid_snapshot(TSnapshot* s)
+//
+//  Purpose: saves or restores the state of every LID group and unit.
+//  Input:   s = a simulation state snapshot
+//  Output:  none
+//
+{
+    int        j;
+    TLidList*  lidList;
+
+    if ( LidGroups == NULL ) return;
+    for (j = 0; j < GroupCount; j++)
+    {
+        if ( LidGroups[j] == NULL ) continue;
+        snapshot_add(s, LidGroups[j], sizeof(struct LidGroup));
+        lidList = LidGroups[j]->lidList;
+        while ( lidList )
+        {
+            snapshot_add(s, lidList->lidUnit, sizeof(TLidUnit));
+            lidList = lidList->nextLidUnit;
+        }
+    }
+}
+
+//=============================================================================
+
+////  New function added to release 5.1.015.  ////                             //(5.1.015)
+
+void lid_addEnsembleFiles()
+//
+//  Purpose: adds the report file of each LID unit to the files copied for
+//           each new member of a forked simulation ensemble.
+//  Input:   none
+//  Output:  none
+//
+{
+    int        j;
+    TLidList*  lidList;
+    TLidUnit*  lidUnit;
+
+    if ( LidGroups == NULL ) return;
+    for (j = 0; j < GroupCount; j++)
+    {
+        if ( LidGroups[j] == NULL ) continue;
+        lidList = LidGroups[j]->lidList;
+        while ( lidList )
+        {
+            lidUnit = lidList->lidUnit;
+            if ( lidUnit->rptFile )
+            {
+                ensemble_addFile(lidUnit->rptFile->file, lidUnit->rptFile->name);
+            }
+            lidList = lidList->nextLidUnit;
+        }
+    }
+}
+
+//=============================================================================
+
+////  New function added to release 5.1.015.  ////                             //(5.1.015)
+
+void lid_setGroupInflows(int j, double tStep)
+//
+//  Purpose: finds the inflow to each LID unit in a subcatchment from the
+//           non-LID runoff just computed for the subcatchment.
+//  Input:   j     = subcatchment index
 //           tStep = time step (sec)
-//  Output:  updates following global quantities after LID treatment applied:
-//           Vevap, Vpevap, VlidInfil, VlidIn, VlidOut, VlidDrain.
+//  Output:  none
+//
+//  The LID units are then analyzed by lid_execute, after which
+//  lid_getRunoff combines their results for the subcatchment.
 //
 {
+    int        k;
     TLidGroup  theLidGroup;       // group of LIDs placed in the subcatchment
-    TLidList*  lidList;           // list of LID units in the group
+    TLidGroupStep* g;             // conditions seen by the group's LIDs
+    TLidTask*  task;              // an LID unit awaiting analysis
     TLidUnit*  lidUnit;           // a member of the list of LID units
     double lidArea;               // area of an LID unit
     double qImperv = 0.0;         // runoff from impervious areas (cfs)
-    double qPerv = 0.0;           // runoff from pervious areas (cfs)          //(5.1.013)
-    double lidInflow = 0.0;       // inflow to an LID unit (ft/s) 
-    double qRunoff = 0.0;         // surface runoff from all LID units (cfs)
-    double qDrain = 0.0;          // drain flow from all LID units (cfs)
-    double qReturn = 0.0;         // LID outflow returned to pervious area (cfs) 
+    double qPerv = 0.0;           // runoff from pervious areas (cfs)
+    double lidInflow = 0.0;       // inflow to an LID unit (ft/s)
 
     //... return if there are no LID's
     theLidGroup = LidGroups[j];
     if ( !theLidGroup ) return;
-    lidList = theLidGroup->lidList;
-    if ( !lidList ) return;
+    if ( !theLidGroup->lidList ) return;
+    g = &GroupSteps[j];
 
     //... determine if evaporation can occur
-    EvapRate = Evap.rate;
-    if ( Evap.dryOnly && Subcatch[j].rainfall > 0.0 ) EvapRate = 0.0;
+    g->evapRate = Evap.rate;
+    if ( Evap.dryOnly && Subcatch[j].rainfall > 0.0 ) g->evapRate = 0.0;
 
     //... find subcatchment's infiltration rate into native soil
-    findNativeInfil(j, tStep);
+    findNativeInfil(j, tStep, g);
+
+    //... save the conductivity adjustment applied to the subcatchment
+    g->infilFactor = infil_getInfilFactor();
 
     //... get impervious and pervious area runoff from non-LID
     //    portion of subcatchment (cfs)
     if ( Subcatch[j].area > Subcatch[j].lidArea )
-    {    
+    {
         qImperv = getImpervAreaRunoff(j);
-        qPerv = getPervAreaRunoff(j);                                          //(5.1.013)
+        qPerv = getPervAreaRunoff(j);
     }
 
-    //... evaluate performance of each LID unit placed in the subcatchment
-    while ( lidList )
+    //... find the inflow to each LID unit placed in the subcatchment
+    for (k = g->firstTask; k < g->firstTask + g->taskCount; k++)
     {
         //... find area of the LID unit
-        lidUnit = lidList->lidUnit;
+        task = &LidTasks[k];
+        lidUnit = task->lidUnit;
         lidArea = lidUnit->area * lidUnit->number;
+        task->lidArea = lidArea;
 
-        //... if LID unit has area, evaluate its performance
+        //... if LID unit has area, it will be evaluated
         if ( lidArea > 0.0 )
         {
             //... find runoff from non-LID area treated by LID area (ft/sec)
-            lidInflow = (qImperv * lidUnit->fromImperv +                       //(5.1.013)
-                         qPerv * lidUnit->fromPerv) / lidArea;                 //
+            lidInflow = (qImperv * lidUnit->fromImperv +
+                         qPerv * lidUnit->fromPerv) / lidArea;
 
-            //... update total runoff volume treated
-            VlidIn += lidInflow * lidArea * tStep;
+            //... save runoff volume treated
+            task->vIn = lidInflow * lidArea * tStep;
 
             //... add rainfall onto LID inflow (ft/s)
             lidInflow = lidInflow + Subcatch[j].rainfall;
@@ -1675,14 +1908,112 @@ void lid_getRunoff(int j, double tStep)
             {
                 lidInflow += Subcatch[j].runon;
             }
+            task->inflow = lidInflow;
+            task->isActive = TRUE;
+        }
+    }
+}
+
+//=============================================================================
+
+////  New function added to release 5.1.015.  ////                             //(5.1.015)
+
+void lid_execute(double tStep)
+//
+//  Purpose: analyzes the performance of all LID units whose inflows were
+//           set by lid_setGroupInflows over the current time step.
+//  Input:   tStep = time step (sec)
+//  Output:  none
+//
+//  Each LID unit only changes its own state here, so the units are
+//  analyzed in parallel. They are visited in order of LID process so that
+//  units of the same type are evaluated together.
+//
+{
+    int n;
+
+    if ( TaskCount == 0 ) return;
 
-            //... evaluate the LID unit's performance, updating the LID group's
-            //    total surface runoff, drain flow, and flow returned to
-            //    pervious area 
-            evalLidUnit(j, lidUnit, lidArea, lidInflow, tStep,
-                        &qRunoff, &qDrain, &qReturn);
+#pragma omp parallel num_threads(RunoffThreads)
+{
+    #pragma omp for schedule(dynamic, 16)
+    for (n = 0; n < TaskCount; n++)
+    {
+        if ( LidTasks[TaskOrder[n]].isActive )
+            evalLidTask(&LidTasks[TaskOrder[n]], tStep);
+    }
+}
+}
+
+//=============================================================================
+
+void evalLidTask(TLidTask* task, double tStep)
+//
+//  Purpose: finds the outflows of a single LID unit over a time step.
+//  Input:   task  = LID unit with its inflow
+//           tStep = time step (sec)
+//  Output:  none
+//
+{
+    TLidGroupStep* g = &GroupSteps[task->subcatch];
+    TLidUnit* lidUnit = task->lidUnit;
+
+    //... initialize evap and infil losses
+    task->evap = 0.0;
+    task->infil = 0.0;
+    task->drain = 0.0;
+
+    //... find surface runoff from the LID unit (in ft/s)
+    task->runoff = lidproc_getOutflow(&task->state, lidUnit,
+                                      &LidProcs[lidUnit->lidIndex],
+                                      task->inflow, g->evapRate,
+                                      g->nativeInfil, g->maxNativeInfil,
+                                      g->infilFactor, tStep, &task->evap,
+                                      &task->infil, &task->drain);
+    task->isActive = FALSE;
+}
+
+//=============================================================================
+
+void lid_getRunoff(int j, double tStep)
+//
+//  Purpose: computes runoff and drain flows from the LIDs in a subcatchment.
+//  Input:   j     = subcatchment index 
+//           tStep = time step (sec)
+//  Output:  updates following global quantities after LID treatment applied:
+//           Vevap, Vpevap, VlidInfil, VlidIn, VlidOut, VlidDrain.
+//
+//  The LID units must first have been analyzed by lid_execute.
+//
+{
+    int        k;
+    TLidGroup  theLidGroup;       // group of LIDs placed in the subcatchment
+    TLidGroupStep* g;             // conditions seen by the group's LIDs
+    TLidTask*  task;              // an analyzed LID unit
+    double qRunoff = 0.0;         // surface runoff from all LID units (cfs)
+    double qDrain = 0.0;          // drain flow from all LID units (cfs)
+    double qReturn = 0.0;         // LID outflow returned to pervious area (cfs) 
+
+    //... return if there are no LID's
+    theLidGroup = LidGroups[j];
+    if ( !theLidGroup ) return;
+    if ( !theLidGroup->lidList ) return;
+    g = &GroupSteps[j];
+
+    //... combine the performance of each LID unit placed in the subcatchment
+    for (k = g->firstTask; k < g->firstTask + g->taskCount; k++)
+    {
+        //... if LID unit has area, add in its performance
+        task = &LidTasks[k];
+        if ( task->lidArea > 0.0 )
+        {
+            //... update total runoff volume treated
+            VlidIn += task->vIn;
+
+            //... update the LID group's total surface runoff, drain flow,
+            //    and flow returned to pervious area 
+            evalLidUnit(j, task, tStep, &qRunoff, &qDrain, &qReturn);
         }
-        lidList = lidList->nextLidUnit;
     }
 
     //... save the LID group's total drain & return flows
@@ -1697,13 +2028,14 @@ void lid_getRunoff(int j, double tStep)
 
 //=============================================================================
 
-void findNativeInfil(int j, double tStep)
+void findNativeInfil(int j, double tStep, TLidGroupStep* g)
 //
 //  Purpose: determines a subcatchment's current infiltration rate into
 //           its native soil.
 //  Input:   j = subcatchment index
 //           tStep    = time step (sec)
-//  Output:  sets values for module-level variables NativeInfil
+//           g        = conditions seen by the subcatchment's LIDs
+//  Output:  sets values for g->nativeInfil and g->maxNativeInfil
 //
 {
     double nonLidArea;
@@ -1712,24 +2044,24 @@ void findNativeInfil(int j, double tStep)
     nonLidArea = Subcatch[j].area - Subcatch[j].lidArea;
     if ( nonLidArea > 0.0 && Subcatch[j].fracImperv < 1.0 )
     {
-        NativeInfil = Vinfil / nonLidArea / tStep;
+        g->nativeInfil = Vinfil / nonLidArea / tStep;
     }
 
     //... otherwise find infil. rate for the subcatchment's rainfall + runon
     else
     {
-        NativeInfil = infil_getInfil(j, InfilModel, tStep,
-                                     Subcatch[j].rainfall,
-                                     Subcatch[j].runon,
-                                     getSurfaceDepth(j));                      //(5.1.008)
+        g->nativeInfil = infil_getInfil(j, InfilModel, tStep,
+                                        Subcatch[j].rainfall,
+                                        Subcatch[j].runon,
+                                        getSurfaceDepth(j));                   //(5.1.008)
     }
 
     //... see if there is any groundwater-imposed limit on infil.
     if ( !IgnoreGwater && Subcatch[j].groundwater )
     {
-        MaxNativeInfil = Subcatch[j].groundwater->maxInfilVol / tStep;
+        g->maxNativeInfil = Subcatch[j].groundwater->maxInfilVol / tStep;
     }
-    else MaxNativeInfil = BIG;
+    else g->maxNativeInfil = BIG;
 }
 
 //=============================================================================
@@ -1792,37 +2124,32 @@ double getPervAreaRunoff(int j)
 
 //=============================================================================
 
-void evalLidUnit(int j, TLidUnit* lidUnit, double lidArea, double lidInflow,
-    double tStep, double *qRunoff, double *qDrain, double *qReturn)
+void evalLidUnit(int j, TLidTask* task, double tStep, double *qRunoff,
+    double *qDrain, double *qReturn)
 //
 //  Purpose: evaluates performance of a specific LID unit over current time step.
 //  Input:   j         = subcatchment index
-//           lidUnit   = ptr. to LID unit being evaluated
-//           lidArea   = area of LID unit
-//           lidInflow = inflow to LID unit (ft/s)
+//           task      = LID unit with outflows found by lid_execute
 //           tStep     = time step (sec)
 //  Output:  qRunoff   = sum of surface runoff from all LIDs (cfs)
 //           qDrain    = sum of drain flows from all LIDs (cfs)
 //           qReturn   = sum of LID flows returned to pervious area (cfs)
 //
 {
-    TLidProc* lidProc;       // LID process associated with lidUnit
+    TLidUnit* lidUnit = task->lidUnit;  // LID unit being evaluated
+    double lidArea = task->lidArea;     // area of LID unit
     double lidRunoff,        // surface runoff from LID unit (cfs)
            lidEvap,          // evaporation rate from LID unit (ft/s)
            lidInfil,         // infiltration rate from LID unit (ft/s)
            lidDrain;         // drain flow rate from LID unit (ft/s & cfs)
 
-    //... identify the LID process of the LID unit being analyzed
-    lidProc = &LidProcs[lidUnit->lidIndex];
-
-    //... initialize evap and infil losses
-    lidEvap = 0.0;
-    lidInfil = 0.0;
+    //... retrieve the unit's losses and outflows found by lid_execute
+    lidEvap = task->evap;
+    lidInfil = task->infil;
+    lidDrain = task->drain;
 
     //... find surface runoff from the LID unit (in cfs)
-    lidRunoff = lidproc_getOutflow(lidUnit, lidProc, lidInflow, EvapRate,
-                                  NativeInfil, MaxNativeInfil, tStep,
-                                  &lidEvap, &lidInfil, &lidDrain) * lidArea;
+    lidRunoff = task->runoff * lidArea;
     
     //... convert drain flow to CFS
     lidDrain *= lidArea;
@@ -1866,7 +2193,7 @@ void evalLidUnit(int j, TLidUnit* lidUnit, double lidArea, double lidInflow,
     else lidUnit->dryTime += tStep;
 
     //... update LID water balance and save results
-    lidproc_saveResults(lidUnit, UCF(RAINFALL), UCF(RAINDEPTH));
+    lidproc_saveResults(&task->state, UCF(RAINFALL), UCF(RAINDEPTH));
 
     //... update LID group totals
     *qRunoff += lidRunoff;
@@ -36,6 +36,13 @@
 //   - New members added to TPavementLayer and TLidUnit to support
 //     unclogging permeable pavement at fixed intervals.
 //
+//   Build 5.1.015:
+//   - New TLidState structure holds the variables used to analyze a single
+//     LID unit so that units can be analyzed concurrently.
+//   - New functions lid_open, lid_close, lid_setGroupInflows and lid_execute
+//     analyze all LID units in a single pass.
+//   - Name of a LID report file saved in TLidRptFile.
+//
 //-----------------------------------------------------------------------------
 
 #ifndef LID_H
@@ -183,6 +190,7 @@ typedef struct
 typedef struct
 {
     FILE*     file;               // file pointer
+    char*     name;               // file name                                 //(5.1.015)
     int       wasDry;             // number of successive dry periods
     char      results[256];       // results for current time period
 }   TLidRptFile;
@@ -241,6 +249,32 @@ struct LidGroup
 };
 typedef struct LidGroup* TLidGroup;
 
+// LID State - flux rates & volumes found when analyzing an LID unit           //(5.1.015)
+typedef struct
+{
+    TLidUnit*      lidUnit;        // LID unit being analyzed
+    TLidProc*      lidProc;        // LID process of the unit
+    double         tStep;          // current time step (sec)
+    double         evapRate;       // evaporation rate (ft/s)
+    double         maxNativeInfil; // native soil infil. rate limit (ft/s)
+    double         surfaceInflow;  // precip. + runon to LID unit (ft/s)
+    double         surfaceInfil;   // infil. rate from surface layer (ft/s)
+    double         surfaceEvap;    // evap. rate from surface layer (ft/s)
+    double         surfaceOutflow; // outflow from surface layer (ft/s)
+    double         surfaceVolume;  // volume in surface storage (ft)
+    double         paveEvap;       // evap. from pavement layer (ft/s)
+    double         pavePerc;       // percolation from pavement layer (ft/s)
+    double         paveVolume;     // volume stored in pavement layer  (ft)
+    double         soilEvap;       // evap. from soil layer (ft/s)
+    double         soilPerc;       // percolation from soil layer (ft/s)
+    double         soilVolume;     // volume in soil/pavement storage (ft)
+    double         storageInflow;  // inflow rate to storage layer (ft/s)
+    double         storageExfil;   // exfil. rate from storage layer (ft/s)
+    double         storageEvap;    // evap.rate from storage layer (ft/s)
+    double         storageDrain;   // underdrain flow rate layer (ft/s)
+    double         storageVolume;  // volume in storage layer (ft)
+}  TLidState;
+
 //-----------------------------------------------------------------------------
 //   LID Methods
 //-----------------------------------------------------------------------------
@@ -252,6 +286,8 @@ int      lid_readGroupParams(char* tok[], int ntoks);
 
 void     lid_validate(void);
 void     lid_initState(void);
+int      lid_open(void);                                                       //(5.1.015)
+void     lid_close(void);                                                      //(5.1.015)
 void     lid_setOldGroupState(int subcatch);
 
 double   lid_getPervArea(int subcatch);
@@ -261,6 +297,9 @@ double   lid_getStoredVolume(int subcatch);
 void     lid_addDrainLoads(int subcatch, double c[], double tStep);
 void     lid_addDrainRunon(int subcatch);
 void     lid_addDrainInflow(int subcatch, double f);
+void     lid_saveDrainFlows(int subcatch, double x[]);                          //(5.1.015)
+void     lid_setGroupInflows(int subcatch, double tStep);                      //(5.1.015)
+void     lid_execute(double tStep);                                            //(5.1.015)
 void     lid_getRunoff(int subcatch, double tStep);
 void     lid_writeSummary(void);
 void     lid_writeWaterBalance(void);
@@ -278,10 +317,11 @@ void        lid_updateLidGroup(int index);
 
 void     lidproc_initWaterBalance(TLidUnit *lidUnit, double initVol);
 void     lidproc_initWaterRate(TLidUnit *lidUnit);
-double   lidproc_getOutflow(TLidUnit* lidUnit, TLidProc* lidProc,
-         double inflow, double evap, double infil, double maxInfil,
-         double tStep, double* lidEvap, double* lidInfil, double* lidDrain);
+double   lidproc_getOutflow(TLidState* s, TLidUnit* lidUnit,                   //(5.1.015)
+         TLidProc* lidProc, double inflow, double evap, double infil,
+         double maxInfil, double infilFactor, double tStep, double* lidEvap,
+         double* lidInfil, double* lidDrain);
 
-void     lidproc_saveResults(TLidUnit* lidUnit, double ucfRainfall,
+void     lidproc_saveResults(TLidState* s, double ucfRainfall,                 //(5.1.015)
          double ucfRainDepth);
 #endif
@@ -64,6 +64,11 @@
 //   - Fixed failure to initialize all LID layer moisture volumes to 0 before
 //     computing LID unit performance in lidproc_getOutflow.
 //
+//   Build 5.1.015:
+//   - Variables shared between the flux rate functions were moved from
+//     module-level statics into a TLidState structure supplied by the
+//     caller, so that different LID units can be analyzed concurrently.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -109,70 +114,39 @@ enum LidRptVars {
 //-----------------------------------------------------------------------------
 extern char HasWetLids;      // TRUE if any LIDs are wet (declared in runoff.c)
 
-//-----------------------------------------------------------------------------
-//  Local Variables
-//-----------------------------------------------------------------------------
-static TLidUnit*  theLidUnit;     // ptr. to a subcatchment's LID unit
-static TLidProc*  theLidProc;     // ptr. to a LID process
-
-static double     Tstep;          // current time step (sec)
-static double     EvapRate;       // evaporation rate (ft/s)
-static double     MaxNativeInfil; // native soil infil. rate limit (ft/s)
-
-static double     SurfaceInflow;  // precip. + runon to LID unit (ft/s)
-static double     SurfaceInfil;   // infil. rate from surface layer (ft/s)
-static double     SurfaceEvap;    // evap. rate from surface layer (ft/s)
-static double     SurfaceOutflow; // outflow from surface layer (ft/s)
-static double     SurfaceVolume;  // volume in surface storage (ft)
-
-static double     PaveEvap;       // evap. from pavement layer (ft/s)
-static double     PavePerc;       // percolation from pavement layer (ft/s)
-static double     PaveVolume;     // volume stored in pavement layer  (ft)
-
-static double     SoilEvap;       // evap. from soil layer (ft/s)
-static double     SoilPerc;       // percolation from soil layer (ft/s)
-static double     SoilVolume;     // volume in soil/pavement storage (ft)
-
-static double     StorageInflow;  // inflow rate to storage layer (ft/s)
-static double     StorageExfil;   // exfil. rate from storage layer (ft/s)
-static double     StorageEvap;    // evap.rate from storage layer (ft/s)
-static double     StorageDrain;   // underdrain flow rate layer (ft/s)
-static double     StorageVolume;  // volume in storage layer (ft)
-
-static double     Xold[MAX_LAYERS];  // previous moisture level in LID layers
-
 //-----------------------------------------------------------------------------
 //  External Functions (declared in lid.h)
 //-----------------------------------------------------------------------------
 // lidproc_initWaterBalance  (called by lid_initState)
 // lidproc_initWaterRate     (called by lid_initState)
-// lidproc_getOutflow        (called by evalLidUnit in lid.c)
+// lidproc_getOutflow        (called by lid_execute in lid.c)
 // lidproc_saveResults       (called by evalLidUnit in lid.c)
 //-----------------------------------------------------------------------------
 // Local Functions
 //-----------------------------------------------------------------------------
-static void   barrelFluxRates(double x[], double f[]);
-static void   biocellFluxRates(double x[], double f[]);
-static void   greenRoofFluxRates(double x[], double f[]);
-static void   pavementFluxRates(double x[], double f[]);
-static void   trenchFluxRates(double x[], double f[]);
-static void   swaleFluxRates(double x[], double f[]);
-static void   roofFluxRates(double x[], double f[]);
-
-static double getSurfaceOutflowRate(double depth);
-static double getSurfaceOverflowRate(double* surfaceDepth);
-static double getPavementPermRate(void);
-static double getSoilPercRate(double theta);
-static double getStorageExfilRate(void);
-static double getStorageDrainRate(double storageDepth, double soilTheta,
-              double paveDepth, double surfaceDepth);
-static double getDrainMatOutflow(double depth);
-static void   getEvapRates(double surfaceVol, double paveVol,
+static void   barrelFluxRates(TLidState* s, double x[], double f[]);
+static void   biocellFluxRates(TLidState* s, double x[], double f[]);
+static void   greenRoofFluxRates(TLidState* s, double x[], double f[]);
+static void   pavementFluxRates(TLidState* s, double x[], double f[]);
+static void   trenchFluxRates(TLidState* s, double x[], double f[]);
+static void   swaleFluxRates(TLidState* s, double x[], double f[]);
+static void   roofFluxRates(TLidState* s, double x[], double f[]);
+
+static double getSurfaceOutflowRate(TLidState* s, double depth);
+static double getSurfaceOverflowRate(TLidState* s, double* surfaceDepth);
+static double getPavementPermRate(TLidState* s);
+static double getSoilPercRate(TLidState* s, double theta);
+static double getStorageExfilRate(TLidState* s);
+static double getStorageDrainRate(TLidState* s, double storageDepth,
+              double soilTheta, double paveDepth, double surfaceDepth);
+static double getDrainMatOutflow(TLidState* s, double depth);
+static void   getEvapRates(TLidState* s, double surfaceVol, double paveVol,
               double soilVol, double storageVol, double pervFrac);
 
 static void   updateWaterBalance(TLidUnit *lidUnit, double inflow,
                                  double evap, double infil, double surfFlow,
-                                 double drainFlow, double storage);
+                                 double drainFlow, double storage,
+                                 double tStep);
 
 static void updateWaterRate(TLidUnit *lidUnit, double evap, double maxNativeInfil,
                             double surfaceInflow, double surfInfil, double surfaceEvap, 
@@ -183,7 +157,8 @@ static void updateWaterRate(TLidUnit *lidUnit, double evap, double maxNativeInfi
 static int    modpuls_solve(int n, double* x, double* xOld, double* xPrev,
                             double* xMin, double* xMax, double* xTol,
                             double* qOld, double* q, double dt, double omega,
-                            void (*derivs)(double*, double*));
+                            TLidState* s,
+                            void (*derivs)(TLidState*, double*, double*));
 
 
 //=============================================================================
@@ -230,18 +205,20 @@ void lidproc_initWaterRate(TLidUnit* lidUnit)
 }
 //=============================================================================
 
-double lidproc_getOutflow(TLidUnit* lidUnit, TLidProc* lidProc, double inflow,
-                          double evap, double infil, double maxInfil,
-                          double tStep, double* lidEvap,
-                          double* lidInfil, double* lidDrain)
+double lidproc_getOutflow(TLidState* s, TLidUnit* lidUnit, TLidProc* lidProc,
+                          double inflow, double evap, double infil,
+                          double maxInfil, double infilFactor, double tStep,
+                          double* lidEvap, double* lidInfil, double* lidDrain)
 //
 //  Purpose: computes runoff outflow from a single LID unit.
-//  Input:   lidUnit  = ptr. to specific LID unit being analyzed
+//  Input:   s        = work space that retains the unit's flux rates
+//           lidUnit  = ptr. to specific LID unit being analyzed
 //           lidProc  = ptr. to generic LID process of the LID unit
 //           inflow   = runoff rate captured by LID unit (ft/s)
 //           evap     = potential evaporation rate (ft/s)
 //           infil    = infiltration rate to native soil (ft/s)
 //           maxInfil = max. infiltration rate to native soil (ft/s)
+//           infilFactor = hydraulic conductivity adjustment factor
 //           tStep    = time step (sec)
 //  Output:  lidEvap  = evaporation rate for LID unit (ft/s)
 //           lidInfil = infiltration rate for LID unit (ft/s)
@@ -264,81 +241,80 @@ double lidproc_getOutflow(TLidUnit* lidUnit, TLidProc* lidProc, double inflow,
     double omega = 0.0;          // integration time weighting
 
     //... define a pointer to function that computes flux rates through the LID
-    void (*fluxRates) (double *, double *) = NULL;
+    void (*fluxRates) (TLidState *, double *, double *) = NULL;
 
     //... save references to the LID process and LID unit
-    theLidProc = lidProc;
-    theLidUnit = lidUnit;
+    s->lidProc = lidProc;
+    s->lidUnit = lidUnit;
 
     //... save evap, max. infil. & time step to shared variables
-    EvapRate = evap;
-    MaxNativeInfil = maxInfil;
-    Tstep = tStep;
+    s->evapRate = evap;
+    s->maxNativeInfil = maxInfil;
+    s->tStep = tStep;
 
     //... store current moisture levels in vector x
-    x[SURF] = theLidUnit->surfaceDepth;
-    x[SOIL] = theLidUnit->soilMoisture;
-    x[STOR] = theLidUnit->storageDepth;
-    x[PAVE] = theLidUnit->paveDepth;
+    x[SURF] = s->lidUnit->surfaceDepth;
+    x[SOIL] = s->lidUnit->soilMoisture;
+    x[STOR] = s->lidUnit->storageDepth;
+    x[PAVE] = s->lidUnit->paveDepth;
 
     //... initialize layer moisture volumes, flux rates and moisture limits
-    SurfaceVolume  = 0.0;
-    PaveVolume     = 0.0;
-    SoilVolume     = 0.0;
-    StorageVolume  = 0.0;
-    SurfaceInflow  = inflow;
-    SurfaceInfil   = 0.0;
-    SurfaceEvap    = 0.0;
-    SurfaceOutflow = 0.0;
-    PaveEvap       = 0.0;
-    PavePerc       = 0.0;
-    SoilEvap       = 0.0;
-    SoilPerc       = 0.0;
-    StorageInflow  = 0.0;
-    StorageExfil   = 0.0;
-    StorageEvap    = 0.0;
-    StorageDrain   = 0.0;
+    s->surfaceVolume  = 0.0;
+    s->paveVolume     = 0.0;
+    s->soilVolume     = 0.0;
+    s->storageVolume  = 0.0;
+    s->surfaceInflow  = inflow;
+    s->surfaceInfil   = 0.0;
+    s->surfaceEvap    = 0.0;
+    s->surfaceOutflow = 0.0;
+    s->paveEvap       = 0.0;
+    s->pavePerc       = 0.0;
+    s->soilEvap       = 0.0;
+    s->soilPerc       = 0.0;
+    s->storageInflow  = 0.0;
+    s->storageExfil   = 0.0;
+    s->storageEvap    = 0.0;
+    s->storageDrain   = 0.0;
     for (i = 0; i < MAX_LAYERS; i++)
     {
         f[i] = 0.0;
-        fOld[i] = theLidUnit->oldFluxRates[i];
+        fOld[i] = s->lidUnit->oldFluxRates[i];
         xMin[i] = 0.0;
         xMax[i] = BIG;
-        Xold[i] = x[i];
     }
 
     //... find Green-Ampt infiltration from surface layer
-    if ( theLidProc->lidType == POROUS_PAVEMENT ) SurfaceInfil = 0.0;
-    else if ( theLidUnit->soilInfil.Ks > 0.0 )
+    if ( s->lidProc->lidType == POROUS_PAVEMENT ) s->surfaceInfil = 0.0;
+    else if ( s->lidUnit->soilInfil.Ks > 0.0 )
     {
-        SurfaceInfil =
-            grnampt_getInfil(&theLidUnit->soilInfil, Tstep,
-                             SurfaceInflow, theLidUnit->surfaceDepth,
-                             MOD_GREEN_AMPT);
+        s->surfaceInfil =
+            grnampt_getInfilEx(&s->lidUnit->soilInfil, s->tStep,               //(5.1.015)
+                               s->surfaceInflow, s->lidUnit->surfaceDepth,
+                               MOD_GREEN_AMPT, infilFactor);
     }
-    else SurfaceInfil = infil;
+    else s->surfaceInfil = infil;
 
     //... set moisture limits for soil & storage layers
-    if ( theLidProc->soil.thickness > 0.0 )
+    if ( s->lidProc->soil.thickness > 0.0 )
     {
-        xMin[SOIL] = theLidProc->soil.wiltPoint;
-        xMax[SOIL] = theLidProc->soil.porosity;
+        xMin[SOIL] = s->lidProc->soil.wiltPoint;
+        xMax[SOIL] = s->lidProc->soil.porosity;
     }
-    if ( theLidProc->pavement.thickness > 0.0 )
+    if ( s->lidProc->pavement.thickness > 0.0 )
     {
-        xMax[PAVE] = theLidProc->pavement.thickness;
+        xMax[PAVE] = s->lidProc->pavement.thickness;
     }
-    if ( theLidProc->storage.thickness > 0.0 )
+    if ( s->lidProc->storage.thickness > 0.0 )
     {
-        xMax[STOR] = theLidProc->storage.thickness;
+        xMax[STOR] = s->lidProc->storage.thickness;
     }
-    if ( theLidProc->lidType == GREEN_ROOF )
+    if ( s->lidProc->lidType == GREEN_ROOF )
     {
-        xMax[STOR] = theLidProc->drainMat.thickness;
+        xMax[STOR] = s->lidProc->drainMat.thickness;
     }
 
     //... determine which flux rate function to use
-    switch (theLidProc->lidType)
+    switch (s->lidProc->lidType)
     {
     case BIO_CELL:
     case RAIN_GARDEN:     fluxRates = &biocellFluxRates;   break;
@@ -355,7 +331,7 @@ double lidproc_getOutflow(TLidUnit* lidUnit, TLidProc* lidProc, double inflow,
 
     //... update moisture levels and flux rates over the time step
     i = modpuls_solve(MAX_LAYERS, x, xOld, xPrev, xMin, xMax, xTol,
-                     fOld, f, tStep, omega, fluxRates);
+                     fOld, f, tStep, omega, s, fluxRates);
 
 /** For debugging only ********************************************
     if  (i == 0)
@@ -365,39 +341,39 @@ double lidproc_getOutflow(TLidUnit* lidUnit, TLidProc* lidProc, double inflow,
             theDate, theTime);
         fprintf(Frpt.file,
         "\n              for LID %s placed in subcatchment %s.",
-            theLidProc->ID, theSubcatch->ID);
+            s->lidProc->ID, theSubcatch->ID);
     }
 *******************************************************************/
 
     //... add any surface overflow to surface outflow
-    if ( theLidProc->surface.canOverflow || theLidUnit->fullWidth == 0.0 )
+    if ( s->lidProc->surface.canOverflow || s->lidUnit->fullWidth == 0.0 )
     {
-        SurfaceOutflow += getSurfaceOverflowRate(&x[SURF]);
+        s->surfaceOutflow += getSurfaceOverflowRate(s, &x[SURF]);
     }
 
     //... save updated results
-    theLidUnit->surfaceDepth = x[SURF];
-    theLidUnit->paveDepth    = x[PAVE];
-    theLidUnit->soilMoisture = x[SOIL];
-    theLidUnit->storageDepth = x[STOR];
-    for (i = 0; i < MAX_LAYERS; i++) theLidUnit->oldFluxRates[i] = f[i];
+    s->lidUnit->surfaceDepth = x[SURF];
+    s->lidUnit->paveDepth    = x[PAVE];
+    s->lidUnit->soilMoisture = x[SOIL];
+    s->lidUnit->storageDepth = x[STOR];
+    for (i = 0; i < MAX_LAYERS; i++) s->lidUnit->oldFluxRates[i] = f[i];
 
     //... assign values to LID unit evaporation, infiltration & drain flow
-    *lidEvap = SurfaceEvap + PaveEvap + SoilEvap + StorageEvap;
-    *lidInfil = StorageExfil;
-    *lidDrain = StorageDrain;
+    *lidEvap = s->surfaceEvap + s->paveEvap + s->soilEvap + s->storageEvap;
+    *lidInfil = s->storageExfil;
+    *lidDrain = s->storageDrain;
 
     //... return surface outflow (per unit area) from unit
-    return SurfaceOutflow;
+    return s->surfaceOutflow;
 }
 
 //=============================================================================
 
-void lidproc_saveResults(TLidUnit* lidUnit, double ucfRainfall, double ucfRainDepth)
+void lidproc_saveResults(TLidState* s, double ucfRainfall, double ucfRainDepth)
 //
 //  Purpose: updates the mass balance for an LID unit and saves
 //           current flux rates to the LID report file.
-//  Input:   lidUnit = ptr. to LID unit
+//  Input:   s = flux rates found for the unit by lidproc_getOutflow
 //           ucfRainfall = units conversion factor for rainfall rate
 //           ucfDepth = units conversion factor for rainfall depth
 //  Output:  none
@@ -412,24 +388,27 @@ void lidproc_saveResults(TLidUnit* lidUnit, double ucfRainfall, double ucfRainDe
     double elapsedHrs;                 // elapsed hours
 
     //... find total evap. rate and stored volume
-    totalEvap = SurfaceEvap + PaveEvap + SoilEvap + StorageEvap; 
-    totalVolume = SurfaceVolume + PaveVolume + SoilVolume + StorageVolume;
+    totalEvap = s->surfaceEvap + s->paveEvap + s->soilEvap + s->storageEvap; 
+    totalVolume = s->surfaceVolume + s->paveVolume + s->soilVolume +
+                  s->storageVolume;
 
     //... update mass balance totals
-    updateWaterBalance(theLidUnit, SurfaceInflow, totalEvap, StorageExfil,
-                       SurfaceOutflow, StorageDrain, totalVolume);
+    updateWaterBalance(s->lidUnit, s->surfaceInflow, totalEvap,
+                       s->storageExfil, s->surfaceOutflow, s->storageDrain,
+                       totalVolume, s->tStep);
     
     //... update water rate
-    updateWaterRate(theLidUnit, EvapRate, MaxNativeInfil, SurfaceInflow, 
-                    SurfaceInfil, SurfaceEvap, SurfaceOutflow, PaveEvap, 
-                    PavePerc, SoilEvap, SoilPerc, StorageInflow, StorageExfil,
-                    StorageEvap, StorageDrain);
+    updateWaterRate(s->lidUnit, s->evapRate, s->maxNativeInfil,
+                    s->surfaceInflow, s->surfaceInfil, s->surfaceEvap,
+                    s->surfaceOutflow, s->paveEvap, s->pavePerc, s->soilEvap,
+                    s->soilPerc, s->storageInflow, s->storageExfil,
+                    s->storageEvap, s->storageDrain);
 
     //... check if dry-weather conditions hold
-    if ( SurfaceInflow  < MINFLOW &&
-         SurfaceOutflow < MINFLOW &&
-         StorageDrain   < MINFLOW &&
-         StorageExfil   < MINFLOW &&
+    if ( s->surfaceInflow  < MINFLOW &&
+         s->surfaceOutflow < MINFLOW &&
+         s->storageDrain   < MINFLOW &&
+         s->storageExfil   < MINFLOW &&
 		 totalEvap      < MINFLOW
        ) isDry = TRUE;
 
@@ -437,40 +416,40 @@ void lidproc_saveResults(TLidUnit* lidUnit, double ucfRainfall, double ucfRainDe
     if ( !isDry ) HasWetLids = TRUE;
 
     //... write results to LID report file
-    if ( lidUnit->rptFile )
+    if ( s->lidUnit->rptFile )
     {
         //... convert rate results to original units (in/hr or mm/hr)
         ucf = ucfRainfall;
-        rptVars[SURF_INFLOW]  = SurfaceInflow*ucf;
+        rptVars[SURF_INFLOW]  = s->surfaceInflow*ucf;
         rptVars[TOTAL_EVAP]   = totalEvap*ucf;
-        rptVars[SURF_INFIL]   = SurfaceInfil*ucf;
-        rptVars[PAVE_PERC]    = PavePerc*ucf;
-        rptVars[SOIL_PERC]    = SoilPerc*ucf;
-        rptVars[STOR_EXFIL]   = StorageExfil*ucf;
-        rptVars[SURF_OUTFLOW] = SurfaceOutflow*ucf;
-        rptVars[STOR_DRAIN]   = StorageDrain*ucf;
+        rptVars[SURF_INFIL]   = s->surfaceInfil*ucf;
+        rptVars[PAVE_PERC]    = s->pavePerc*ucf;
+        rptVars[SOIL_PERC]    = s->soilPerc*ucf;
+        rptVars[STOR_EXFIL]   = s->storageExfil*ucf;
+        rptVars[SURF_OUTFLOW] = s->surfaceOutflow*ucf;
+        rptVars[STOR_DRAIN]   = s->storageDrain*ucf;
 
         //... convert storage results to original units (in or mm)
         ucf = ucfRainDepth;
-        rptVars[SURF_DEPTH] = theLidUnit->surfaceDepth*ucf;
-        rptVars[PAVE_DEPTH] = theLidUnit->paveDepth;
-        rptVars[SOIL_MOIST] = theLidUnit->soilMoisture;
-        rptVars[STOR_DEPTH] = theLidUnit->storageDepth*ucf;
+        rptVars[SURF_DEPTH] = s->lidUnit->surfaceDepth*ucf;
+        rptVars[PAVE_DEPTH] = s->lidUnit->paveDepth;
+        rptVars[SOIL_MOIST] = s->lidUnit->soilMoisture;
+        rptVars[STOR_DEPTH] = s->lidUnit->storageDepth*ucf;
 
         //... if the current LID state is wet but the previous state was dry
         //    for more than one period then write the saved previous results
         //    to the report file thus marking the end of a dry period
-        if ( !isDry && theLidUnit->rptFile->wasDry > 1)
+        if ( !isDry && s->lidUnit->rptFile->wasDry > 1)
         {
-            fprintf(theLidUnit->rptFile->file, "%s",
-				  theLidUnit->rptFile->results);
+            fprintf(s->lidUnit->rptFile->file, "%s",
+				  s->lidUnit->rptFile->results);
         }
 
         //... write the current results to a string which is saved between
         //    reporting periods
         elapsedHrs = NewRunoffTime / 1000.0 / 3600.0;
         datetime_getTimeStamp(M_D_Y, getDateTime(NewRunoffTime), 24, timeStamp);
-        sprintf(theLidUnit->rptFile->results,
+        sprintf(s->lidUnit->rptFile->results,
              "\n%20s\t %8.3f\t %8.3f\t %8.4f\t %8.3f\t %8.3f\t %8.3f\t %8.3f\t"
              "%8.3f\t %8.3f\t %8.3f\t %8.3f\t %8.3f\t %8.3f",
              timeStamp, elapsedHrs, rptVars[0], rptVars[1], rptVars[2],
@@ -482,32 +461,32 @@ void lidproc_saveResults(TLidUnit* lidUnit, double ucfRainfall, double ucfRainDe
         {
             //... if the previous state was wet then write the current
             //    results to file marking the start of a dry period
-            if ( theLidUnit->rptFile->wasDry == 0 )
+            if ( s->lidUnit->rptFile->wasDry == 0 )
             {
-                fprintf(theLidUnit->rptFile->file, "%s",
-					theLidUnit->rptFile->results);
+                fprintf(s->lidUnit->rptFile->file, "%s",
+					s->lidUnit->rptFile->results);
             }
 
             //... increment the number of successive dry periods
-            theLidUnit->rptFile->wasDry++;
+            s->lidUnit->rptFile->wasDry++;
         }
 
         //... if the current LID state is wet
         else
         {
             //... write the current results to the report file
-			fprintf(theLidUnit->rptFile->file, "%s",
-			    theLidUnit->rptFile->results);
+			fprintf(s->lidUnit->rptFile->file, "%s",
+			    s->lidUnit->rptFile->results);
 
             //... re-set the number of successive dry periods to 0
-            theLidUnit->rptFile->wasDry = 0; 
+            s->lidUnit->rptFile->wasDry = 0; 
         }
     }
 }
 
 //=============================================================================
 
-void roofFluxRates(double x[], double f[])
+void roofFluxRates(TLidState* s, double x[], double f[])
 //
 //  Purpose: computes flux rates for roof disconnection.
 //  Input:   x = vector of storage levels
@@ -516,20 +495,22 @@ void roofFluxRates(double x[], double f[])
 {
     double surfaceDepth = x[SURF];
 
-    getEvapRates(surfaceDepth, 0.0, 0.0, 0.0, 1.0);
-    SurfaceVolume = surfaceDepth;
-    SurfaceInfil = 0.0;
-    if ( theLidProc->surface.alpha > 0.0 )
-      SurfaceOutflow = getSurfaceOutflowRate(surfaceDepth);
-    else getSurfaceOverflowRate(&surfaceDepth);
-    StorageDrain = MIN(theLidProc->drain.coeff/UCF(RAINFALL), SurfaceOutflow);
-    SurfaceOutflow -= StorageDrain;
-    f[SURF] = (SurfaceInflow - SurfaceEvap - StorageDrain - SurfaceOutflow);
+    getEvapRates(s, surfaceDepth, 0.0, 0.0, 0.0, 1.0);
+    s->surfaceVolume = surfaceDepth;
+    s->surfaceInfil = 0.0;
+    if ( s->lidProc->surface.alpha > 0.0 )
+      s->surfaceOutflow = getSurfaceOutflowRate(s, surfaceDepth);
+    else getSurfaceOverflowRate(s, &surfaceDepth);
+    s->storageDrain = MIN(s->lidProc->drain.coeff/UCF(RAINFALL),
+                          s->surfaceOutflow);
+    s->surfaceOutflow -= s->storageDrain;
+    f[SURF] = (s->surfaceInflow - s->surfaceEvap - s->storageDrain -
+               s->surfaceOutflow);
 }
 
 //=============================================================================
 
-void greenRoofFluxRates(double x[], double f[])
+void greenRoofFluxRates(TLidState* s, double x[], double f[])
 //
 //  Purpose: computes flux rates from the layers of a green roof.
 //  Input:   x = vector of storage levels
@@ -546,12 +527,12 @@ void greenRoofFluxRates(double x[], double f[])
     double maxRate;
 
     // Green roof properties
-    double soilThickness    = theLidProc->soil.thickness;
-    double storageThickness = theLidProc->storage.thickness;
-    double soilPorosity     = theLidProc->soil.porosity;
-    double storageVoidFrac  = theLidProc->storage.voidFrac;
-    double soilFieldCap     = theLidProc->soil.fieldCap;
-    double soilWiltPoint    = theLidProc->soil.wiltPoint;
+    double soilThickness    = s->lidProc->soil.thickness;
+    double storageThickness = s->lidProc->storage.thickness;
+    double soilPorosity     = s->lidProc->soil.porosity;
+    double storageVoidFrac  = s->lidProc->storage.voidFrac;
+    double soilFieldCap     = s->lidProc->soil.fieldCap;
+    double soilWiltPoint    = s->lidProc->soil.wiltPoint;
 
     //... retrieve moisture levels from input vector
     surfaceDepth = x[SURF];
@@ -559,75 +540,75 @@ void greenRoofFluxRates(double x[], double f[])
     storageDepth = x[STOR];
 
     //... convert moisture levels to volumes
-    SurfaceVolume = surfaceDepth * theLidProc->surface.voidFrac;
-    SoilVolume = soilTheta * soilThickness;
-    StorageVolume = storageDepth * storageVoidFrac;
+    s->surfaceVolume = surfaceDepth * s->lidProc->surface.voidFrac;
+    s->soilVolume = soilTheta * soilThickness;
+    s->storageVolume = storageDepth * storageVoidFrac;
 
     //... get ET rates
-    availVolume = SoilVolume - soilWiltPoint * soilThickness;
-    getEvapRates(SurfaceVolume, 0.0, availVolume, StorageVolume, 1.0);
-    if ( soilTheta >= soilPorosity ) StorageEvap = 0.0;
+    availVolume = s->soilVolume - soilWiltPoint * soilThickness;
+    getEvapRates(s, s->surfaceVolume, 0.0, availVolume, s->storageVolume, 1.0);
+    if ( soilTheta >= soilPorosity ) s->storageEvap = 0.0;
 
     //... soil layer perc rate
-    SoilPerc = getSoilPercRate(soilTheta);
+    s->soilPerc = getSoilPercRate(s, soilTheta);
 
     //... limit perc rate by available water
     availVolume = (soilTheta - soilFieldCap) * soilThickness;
-    maxRate = MAX(availVolume, 0.0) / Tstep - SoilEvap;
-    SoilPerc = MIN(SoilPerc, maxRate);
-    SoilPerc = MAX(SoilPerc, 0.0);
+    maxRate = MAX(availVolume, 0.0) / s->tStep - s->soilEvap;
+    s->soilPerc = MIN(s->soilPerc, maxRate);
+    s->soilPerc = MAX(s->soilPerc, 0.0);
 
     //... storage (drain mat) outflow rate
-    StorageExfil = 0.0;
-    StorageDrain = getDrainMatOutflow(storageDepth);
+    s->storageExfil = 0.0;
+    s->storageDrain = getDrainMatOutflow(s, storageDepth);
 
     //... unit is full
     if ( soilTheta >= soilPorosity && storageDepth >= storageThickness )
     {
         //... outflow from both layers equals limiting rate
-        maxRate = MIN(SoilPerc, StorageDrain);
-        SoilPerc = maxRate;
-        StorageDrain = maxRate;
+        maxRate = MIN(s->soilPerc, s->storageDrain);
+        s->soilPerc = maxRate;
+        s->storageDrain = maxRate;
 
         //... adjust inflow rate to soil layer
-        SurfaceInfil = MIN(SurfaceInfil, maxRate);
+        s->surfaceInfil = MIN(s->surfaceInfil, maxRate);
     }
 
     //... unit not full
     else
     {
         //... limit drainmat outflow by available storage volume
-        maxRate = storageDepth * storageVoidFrac / Tstep - StorageEvap;
-        if ( storageDepth >= storageThickness ) maxRate += SoilPerc;
+        maxRate = storageDepth * storageVoidFrac / s->tStep - s->storageEvap;
+        if ( storageDepth >= storageThickness ) maxRate += s->soilPerc;
         maxRate = MAX(maxRate, 0.0);
-        StorageDrain = MIN(StorageDrain, maxRate);
+        s->storageDrain = MIN(s->storageDrain, maxRate);
 
         //... limit soil perc inflow by unused storage volume
-        maxRate = (storageThickness - storageDepth) * storageVoidFrac / Tstep +
-                  StorageDrain + StorageEvap;
-        SoilPerc = MIN(SoilPerc, maxRate);
+        maxRate = (storageThickness - storageDepth) * storageVoidFrac /
+                  s->tStep + s->storageDrain + s->storageEvap;
+        s->soilPerc = MIN(s->soilPerc, maxRate);
                 
         //... adjust surface infil. so soil porosity not exceeded
-        maxRate = (soilPorosity - soilTheta) * soilThickness / Tstep +
-                  SoilPerc + SoilEvap;
-        SurfaceInfil = MIN(SurfaceInfil, maxRate);
+        maxRate = (soilPorosity - soilTheta) * soilThickness / s->tStep +
+                  s->soilPerc + s->soilEvap;
+        s->surfaceInfil = MIN(s->surfaceInfil, maxRate);
     }
 
     // ... find surface outflow rate
-    SurfaceOutflow = getSurfaceOutflowRate(surfaceDepth);
+    s->surfaceOutflow = getSurfaceOutflowRate(s, surfaceDepth);
 
     // ... compute overall layer flux rates
-    f[SURF] = (SurfaceInflow - SurfaceEvap - SurfaceInfil - SurfaceOutflow) /
-              theLidProc->surface.voidFrac;
-    f[SOIL] = (SurfaceInfil - SoilEvap - SoilPerc) /
-              theLidProc->soil.thickness;
-    f[STOR] = (SoilPerc - StorageEvap - StorageDrain) /
-              theLidProc->storage.voidFrac;
+    f[SURF] = (s->surfaceInflow - s->surfaceEvap - s->surfaceInfil -
+               s->surfaceOutflow) / s->lidProc->surface.voidFrac;
+    f[SOIL] = (s->surfaceInfil - s->soilEvap - s->soilPerc) /
+              s->lidProc->soil.thickness;
+    f[STOR] = (s->soilPerc - s->storageEvap - s->storageDrain) /
+              s->lidProc->storage.voidFrac;
 }
 
 //=============================================================================
 
-void biocellFluxRates(double x[], double f[])
+void biocellFluxRates(TLidState* s, double x[], double f[])
 //
 //  Purpose: computes flux rates from the layers of a bio-retention cell LID.
 //  Input:   x = vector of storage levels
@@ -644,12 +625,12 @@ void biocellFluxRates(double x[], double f[])
     double maxRate;
 
     // LID layer properties
-    double soilThickness    = theLidProc->soil.thickness;
-    double soilPorosity     = theLidProc->soil.porosity;
-    double soilFieldCap     = theLidProc->soil.fieldCap;
-    double soilWiltPoint    = theLidProc->soil.wiltPoint;
-    double storageThickness = theLidProc->storage.thickness;
-    double storageVoidFrac  = theLidProc->storage.voidFrac;
+    double soilThickness    = s->lidProc->soil.thickness;
+    double soilPorosity     = s->lidProc->soil.porosity;
+    double soilFieldCap     = s->lidProc->soil.fieldCap;
+    double soilWiltPoint    = s->lidProc->soil.wiltPoint;
+    double storageThickness = s->lidProc->storage.thickness;
+    double storageVoidFrac  = s->lidProc->storage.voidFrac;
 
     //... retrieve moisture levels from input vector
     surfaceDepth = x[SURF];
@@ -657,47 +638,47 @@ void biocellFluxRates(double x[], double f[])
     storageDepth = x[STOR];
 
     //... convert moisture levels to volumes
-    SurfaceVolume = surfaceDepth * theLidProc->surface.voidFrac;
-    SoilVolume    = soilTheta * soilThickness;
-    StorageVolume = storageDepth * storageVoidFrac;
+    s->surfaceVolume = surfaceDepth * s->lidProc->surface.voidFrac;
+    s->soilVolume    = soilTheta * soilThickness;
+    s->storageVolume = storageDepth * storageVoidFrac;
 
     //... get ET rates
-    availVolume = SoilVolume - soilWiltPoint * soilThickness;
-    getEvapRates(SurfaceVolume, 0.0, availVolume, StorageVolume, 1.0);
-    if ( soilTheta >= soilPorosity ) StorageEvap = 0.0;
+    availVolume = s->soilVolume - soilWiltPoint * soilThickness;
+    getEvapRates(s, s->surfaceVolume, 0.0, availVolume, s->storageVolume, 1.0);
+    if ( soilTheta >= soilPorosity ) s->storageEvap = 0.0;
 
     //... soil layer perc rate
-    SoilPerc = getSoilPercRate(soilTheta);
+    s->soilPerc = getSoilPercRate(s, soilTheta);
 
     //... limit perc rate by available water
     availVolume =  (soilTheta - soilFieldCap) * soilThickness;
-    maxRate = MAX(availVolume, 0.0) / Tstep - SoilEvap;
-    SoilPerc = MIN(SoilPerc, maxRate);
-    SoilPerc = MAX(SoilPerc, 0.0);
+    maxRate = MAX(availVolume, 0.0) / s->tStep - s->soilEvap;
+    s->soilPerc = MIN(s->soilPerc, maxRate);
+    s->soilPerc = MAX(s->soilPerc, 0.0);
 
     //... exfiltration rate out of storage layer
-    StorageExfil = getStorageExfilRate();
+    s->storageExfil = getStorageExfilRate(s);
 
     //... underdrain flow rate
-    StorageDrain = 0.0;
-    if ( theLidProc->drain.coeff > 0.0 )
+    s->storageDrain = 0.0;
+    if ( s->lidProc->drain.coeff > 0.0 )
     {
-        StorageDrain = getStorageDrainRate(storageDepth, soilTheta, 0.0,
+        s->storageDrain = getStorageDrainRate(s, storageDepth, soilTheta, 0.0,
                                            surfaceDepth);
     }
 
     //... special case of no storage layer present
     if ( storageThickness == 0.0 )
     {
-        StorageEvap = 0.0;
-        maxRate = MIN(SoilPerc, StorageExfil);
-        SoilPerc = maxRate;
-        StorageExfil = maxRate;
+        s->storageEvap = 0.0;
+        maxRate = MIN(s->soilPerc, s->storageExfil);
+        s->soilPerc = maxRate;
+        s->storageExfil = maxRate;
 
         //... limit surface infil. by unused soil volume
-        maxRate = (soilPorosity - soilTheta) * soilThickness / Tstep +
-                  SoilPerc + SoilEvap;
-        SurfaceInfil = MIN(SurfaceInfil, maxRate);
+        maxRate = (soilPorosity - soilTheta) * soilThickness / s->tStep +
+                  s->soilPerc + s->soilEvap;
+        s->surfaceInfil = MIN(s->surfaceInfil, maxRate);
 
 	}
 
@@ -705,73 +686,75 @@ void biocellFluxRates(double x[], double f[])
     else if ( soilTheta >= soilPorosity && storageDepth >= storageThickness )
     {
         //... limiting rate is smaller of soil perc and storage outflow
-        maxRate = StorageExfil + StorageDrain;
-        if ( SoilPerc < maxRate )
+        maxRate = s->storageExfil + s->storageDrain;
+        if ( s->soilPerc < maxRate )
         {
-            maxRate = SoilPerc;
-            if ( maxRate > StorageExfil ) StorageDrain = maxRate - StorageExfil;
+            maxRate = s->soilPerc;
+            if ( maxRate > s->storageExfil )
+                s->storageDrain = maxRate - s->storageExfil;
             else
             {
-                StorageExfil = maxRate;
-                StorageDrain = 0.0;
+                s->storageExfil = maxRate;
+                s->storageDrain = 0.0;
             }
         }
-        else SoilPerc = maxRate;
+        else s->soilPerc = maxRate;
 
         //... apply limiting rate to surface infil.
-        SurfaceInfil = MIN(SurfaceInfil, maxRate);
+        s->surfaceInfil = MIN(s->surfaceInfil, maxRate);
     }
 
     //... either layer not full
     else if ( storageThickness > 0.0 )
     {
         //... limit storage exfiltration by available storage volume
-        maxRate = SoilPerc - StorageEvap + storageDepth*storageVoidFrac/Tstep;
-        StorageExfil = MIN(StorageExfil, maxRate);
-        StorageExfil = MAX(StorageExfil, 0.0);
+        maxRate = s->soilPerc - s->storageEvap +
+                  storageDepth*storageVoidFrac/s->tStep;
+        s->storageExfil = MIN(s->storageExfil, maxRate);
+        s->storageExfil = MAX(s->storageExfil, 0.0);
 
         //... limit underdrain flow by volume above drain offset
-        if ( StorageDrain > 0.0 )
+        if ( s->storageDrain > 0.0 )
         {
-            maxRate = -StorageExfil - StorageEvap;
-            if ( storageDepth >= storageThickness) maxRate += SoilPerc;
-            if ( theLidProc->drain.offset <= storageDepth )
+            maxRate = -s->storageExfil - s->storageEvap;
+            if ( storageDepth >= storageThickness) maxRate += s->soilPerc;
+            if ( s->lidProc->drain.offset <= storageDepth )
             {
-                maxRate += (storageDepth - theLidProc->drain.offset) *
-                           storageVoidFrac/Tstep;
+                maxRate += (storageDepth - s->lidProc->drain.offset) *
+                           storageVoidFrac/s->tStep;
             }
             maxRate = MAX(maxRate, 0.0);
-            StorageDrain = MIN(StorageDrain, maxRate);
+            s->storageDrain = MIN(s->storageDrain, maxRate);
         }
 
         //... limit soil perc by unused storage volume
-        maxRate = StorageExfil + StorageDrain + StorageEvap +
+        maxRate = s->storageExfil + s->storageDrain + s->storageEvap +
                   (storageThickness - storageDepth) *
-                  storageVoidFrac/Tstep;
-        SoilPerc = MIN(SoilPerc, maxRate);
+                  storageVoidFrac/s->tStep;
+        s->soilPerc = MIN(s->soilPerc, maxRate);
 
         //... limit surface infil. by unused soil volume
-        maxRate = (soilPorosity - soilTheta) * soilThickness / Tstep +
-                  SoilPerc + SoilEvap;
-        SurfaceInfil = MIN(SurfaceInfil, maxRate);
+        maxRate = (soilPorosity - soilTheta) * soilThickness / s->tStep +
+                  s->soilPerc + s->soilEvap;
+        s->surfaceInfil = MIN(s->surfaceInfil, maxRate);
     }
 
     //... find surface layer outflow rate
-    SurfaceOutflow = getSurfaceOutflowRate(surfaceDepth);
+    s->surfaceOutflow = getSurfaceOutflowRate(s, surfaceDepth);
 
     //... compute overall layer flux rates
-    f[SURF] = (SurfaceInflow - SurfaceEvap - SurfaceInfil - SurfaceOutflow) /
-              theLidProc->surface.voidFrac;
-    f[SOIL] = (SurfaceInfil - SoilEvap - SoilPerc) / 
-              theLidProc->soil.thickness;
+    f[SURF] = (s->surfaceInflow - s->surfaceEvap - s->surfaceInfil -
+               s->surfaceOutflow) / s->lidProc->surface.voidFrac;
+    f[SOIL] = (s->surfaceInfil - s->soilEvap - s->soilPerc) / 
+              s->lidProc->soil.thickness;
     if ( storageThickness == 0.0 ) f[STOR] = 0.0;
-    else f[STOR] = (SoilPerc - StorageEvap - StorageExfil - StorageDrain) /
-                   theLidProc->storage.voidFrac;
+    else f[STOR] = (s->soilPerc - s->storageEvap - s->storageExfil -
+                    s->storageDrain) / s->lidProc->storage.voidFrac;
 }
 
 //=============================================================================
 
-void trenchFluxRates(double x[], double f[])
+void trenchFluxRates(TLidState* s, double x[], double f[])
 //
 //  Purpose: computes flux rates from the layers of an infiltration trench LID.
 //  Input:   x = vector of storage levels
@@ -787,79 +770,81 @@ void trenchFluxRates(double x[], double f[])
     double maxRate;
 
     // Storage layer properties
-    double storageThickness = theLidProc->storage.thickness;
-    double storageVoidFrac = theLidProc->storage.voidFrac;
+    double storageThickness = s->lidProc->storage.thickness;
+    double storageVoidFrac = s->lidProc->storage.voidFrac;
 
     //... retrieve moisture levels from input vector
     surfaceDepth = x[SURF];
     storageDepth = x[STOR];
 
     //... convert moisture levels to volumes
-    SurfaceVolume = surfaceDepth * theLidProc->surface.voidFrac;
-    SoilVolume = 0.0;
-    StorageVolume = storageDepth * storageVoidFrac;
+    s->surfaceVolume = surfaceDepth * s->lidProc->surface.voidFrac;
+    s->soilVolume = 0.0;
+    s->storageVolume = storageDepth * storageVoidFrac;
 
     //... get ET rates
     availVolume = (storageThickness - storageDepth) * storageVoidFrac;
-    getEvapRates(SurfaceVolume, 0.0, 0.0, StorageVolume, 1.0);
+    getEvapRates(s, s->surfaceVolume, 0.0, 0.0, s->storageVolume, 1.0);
 
     //... no storage evap if surface ponded
-    if ( surfaceDepth > 0.0 ) StorageEvap = 0.0;
+    if ( surfaceDepth > 0.0 ) s->storageEvap = 0.0;
 
     //... nominal storage inflow
-    StorageInflow = SurfaceInflow + SurfaceVolume / Tstep;
+    s->storageInflow = s->surfaceInflow + s->surfaceVolume / s->tStep;
 
     //... exfiltration rate out of storage layer
-   StorageExfil = getStorageExfilRate();
+   s->storageExfil = getStorageExfilRate(s);
 
     //... underdrain flow rate
-    StorageDrain = 0.0;
-    if ( theLidProc->drain.coeff > 0.0 )
+    s->storageDrain = 0.0;
+    if ( s->lidProc->drain.coeff > 0.0 )
     {
-        StorageDrain = getStorageDrainRate(storageDepth, 0.0, 0.0, surfaceDepth);
+        s->storageDrain = getStorageDrainRate(s, storageDepth, 0.0, 0.0,
+                                              surfaceDepth);
     }
 
     //... limit storage exfiltration by available storage volume
-    maxRate = StorageInflow - StorageEvap + storageDepth*storageVoidFrac/Tstep;
-    StorageExfil = MIN(StorageExfil, maxRate);
-    StorageExfil = MAX(StorageExfil, 0.0);
+    maxRate = s->storageInflow - s->storageEvap +
+              storageDepth*storageVoidFrac/s->tStep;
+    s->storageExfil = MIN(s->storageExfil, maxRate);
+    s->storageExfil = MAX(s->storageExfil, 0.0);
 
     //... limit underdrain flow by volume above drain offset
-    if ( StorageDrain > 0.0 )
+    if ( s->storageDrain > 0.0 )
     {
-        maxRate = -StorageExfil - StorageEvap;
-        if (storageDepth >= storageThickness ) maxRate += StorageInflow;
-        if ( theLidProc->drain.offset <= storageDepth )
+        maxRate = -s->storageExfil - s->storageEvap;
+        if (storageDepth >= storageThickness ) maxRate += s->storageInflow;
+        if ( s->lidProc->drain.offset <= storageDepth )
         {
-            maxRate += (storageDepth - theLidProc->drain.offset) *
-                       storageVoidFrac/Tstep;
+            maxRate += (storageDepth - s->lidProc->drain.offset) *
+                       storageVoidFrac/s->tStep;
         }
         maxRate = MAX(maxRate, 0.0);
-        StorageDrain = MIN(StorageDrain, maxRate);
+        s->storageDrain = MIN(s->storageDrain, maxRate);
     }
 
     //... limit storage inflow to not exceed storage layer capacity
-    maxRate = (storageThickness - storageDepth)*storageVoidFrac/Tstep +
-              StorageExfil + StorageEvap + StorageDrain;
-    StorageInflow = MIN(StorageInflow, maxRate);
+    maxRate = (storageThickness - storageDepth)*storageVoidFrac/s->tStep +
+              s->storageExfil + s->storageEvap + s->storageDrain;
+    s->storageInflow = MIN(s->storageInflow, maxRate);
 
     //... equate surface infil to storage inflow
-    SurfaceInfil = StorageInflow;
+    s->surfaceInfil = s->storageInflow;
 
     //... find surface outflow rate
-    SurfaceOutflow = getSurfaceOutflowRate(surfaceDepth);
+    s->surfaceOutflow = getSurfaceOutflowRate(s, surfaceDepth);
 
     // ... find net fluxes for each layer
-    f[SURF] = SurfaceInflow - SurfaceEvap - StorageInflow - SurfaceOutflow /
-              theLidProc->surface.voidFrac;;
-    f[STOR] = (StorageInflow - StorageEvap - StorageExfil - StorageDrain) /
-              theLidProc->storage.voidFrac;
+    f[SURF] = s->surfaceInflow - s->surfaceEvap - s->storageInflow -
+              s->surfaceOutflow / s->lidProc->surface.voidFrac;;
+    f[STOR] = (s->storageInflow - s->storageEvap - s->storageExfil -
+               s->storageDrain) / s->lidProc->storage.voidFrac;
     f[SOIL] = 0.0;
 }
 
 //=============================================================================
 
-void pavementFluxRates(double x[], double f[])
+void pavementFluxRates(TLidState* s, double x[], double f[])
 //
 //  Purpose: computes flux rates for the layers of a porous pavement LID.
 //  Input:   x = vector of storage levels
@@ -873,20 +858,20 @@ void pavementFluxRates(double x[], double f[])
     double storageDepth;
 
     //... Intermediate variables
-    double pervFrac = (1.0 - theLidProc->pavement.impervFrac);
+    double pervFrac = (1.0 - s->lidProc->pavement.impervFrac);
     double storageInflow;    // inflow rate to storage layer (ft/s)
     double availVolume;
     double maxRate;
 
     //... LID layer properties
-    double paveVoidFrac     = theLidProc->pavement.voidFrac * pervFrac;
-    double paveThickness    = theLidProc->pavement.thickness;
-    double soilThickness    = theLidProc->soil.thickness;
-    double soilPorosity     = theLidProc->soil.porosity;
-    double soilFieldCap     = theLidProc->soil.fieldCap;
-    double soilWiltPoint    = theLidProc->soil.wiltPoint;
-    double storageThickness = theLidProc->storage.thickness;
-    double storageVoidFrac  = theLidProc->storage.voidFrac;
+    double paveVoidFrac     = s->lidProc->pavement.voidFrac * pervFrac;
+    double paveThickness    = s->lidProc->pavement.thickness;
+    double soilThickness    = s->lidProc->soil.thickness;
+    double soilPorosity     = s->lidProc->soil.porosity;
+    double soilFieldCap     = s->lidProc->soil.fieldCap;
+    double soilWiltPoint    = s->lidProc->soil.wiltPoint;
+    double storageThickness = s->lidProc->storage.thickness;
+    double storageVoidFrac  = s->lidProc->storage.voidFrac;
 
     //... retrieve moisture levels from input vector
     surfaceDepth = x[SURF];
@@ -895,55 +880,55 @@ void pavementFluxRates(double x[], double f[])
     storageDepth = x[STOR];
 
     //... convert moisture levels to volumes
-    SurfaceVolume = surfaceDepth * theLidProc->surface.voidFrac;
-    PaveVolume = paveDepth * paveVoidFrac;
-    SoilVolume = soilTheta * soilThickness;
-    StorageVolume = storageDepth * storageVoidFrac;
+    s->surfaceVolume = surfaceDepth * s->lidProc->surface.voidFrac;
+    s->paveVolume = paveDepth * paveVoidFrac;
+    s->soilVolume = soilTheta * soilThickness;
+    s->storageVolume = storageDepth * storageVoidFrac;
 
     //... get ET rates
-    availVolume = SoilVolume - soilWiltPoint * soilThickness;
-    getEvapRates(SurfaceVolume, PaveVolume, availVolume, StorageVolume,
-                 pervFrac);
+    availVolume = s->soilVolume - soilWiltPoint * soilThickness;
+    getEvapRates(s, s->surfaceVolume, s->paveVolume, availVolume,
+                 s->storageVolume, pervFrac);
 
     //... no storage evap if soil or pavement layer saturated
     if ( paveDepth >= paveThickness ||
        ( soilThickness > 0.0 && soilTheta >= soilPorosity )
-       ) StorageEvap = 0.0;
+       ) s->storageEvap = 0.0;
 
     //... find nominal rate of surface infiltration into pavement layer
-    SurfaceInfil = SurfaceInflow + (SurfaceVolume / Tstep);
+    s->surfaceInfil = s->surfaceInflow + (s->surfaceVolume / s->tStep);
 
     //... find perc rate out of pavement layer
-    PavePerc = getPavementPermRate();
+    s->pavePerc = getPavementPermRate(s);
 
     //... surface infiltration can't exceed pavement permeability              //(5.1.013)
-    SurfaceInfil = MIN(SurfaceInfil, PavePerc);                                //
+    s->surfaceInfil = MIN(s->surfaceInfil, s->pavePerc);                       //
 
     //... limit pavement perc by available water
-    maxRate = PaveVolume/Tstep + SurfaceInfil - PaveEvap;
+    maxRate = s->paveVolume/s->tStep + s->surfaceInfil - s->paveEvap;
     maxRate = MAX(maxRate, 0.0);
-    PavePerc = MIN(PavePerc, maxRate);
+    s->pavePerc = MIN(s->pavePerc, maxRate);
 
     //... find soil layer perc rate
     if ( soilThickness > 0.0 )
     {
-        SoilPerc = getSoilPercRate(soilTheta);
+        s->soilPerc = getSoilPercRate(s, soilTheta);
         availVolume = (soilTheta - soilFieldCap) * soilThickness;
-        maxRate = MAX(availVolume, 0.0) / Tstep - SoilEvap;
-        SoilPerc = MIN(SoilPerc, maxRate);
-        SoilPerc = MAX(SoilPerc, 0.0);
+        maxRate = MAX(availVolume, 0.0) / s->tStep - s->soilEvap;
+        s->soilPerc = MIN(s->soilPerc, maxRate);
+        s->soilPerc = MAX(s->soilPerc, 0.0);
     }
-    else SoilPerc = PavePerc;
+    else s->soilPerc = s->pavePerc;
 
     //... exfiltration rate out of storage layer
-    StorageExfil = getStorageExfilRate();
+    s->storageExfil = getStorageExfilRate(s);
 
     //... underdrain flow rate
-    StorageDrain = 0.0;
-    if ( theLidProc->drain.coeff > 0.0 )
+    s->storageDrain = 0.0;
+    if ( s->lidProc->drain.coeff > 0.0 )
     {
-        StorageDrain = getStorageDrainRate(storageDepth, soilTheta, paveDepth,
-                                           surfaceDepth);
+        s->storageDrain = getStorageDrainRate(s, storageDepth, soilTheta,
+                                              paveDepth, surfaceDepth);
     }
 
     //... check for adjacent saturated layers
@@ -954,22 +939,22 @@ void pavementFluxRates(double x[], double f[])
          paveDepth >= paveThickness )
     {
         //... pavement outflow can't exceed storage outflow
-        maxRate = StorageEvap + StorageDrain + StorageExfil;
-        if ( PavePerc > maxRate ) PavePerc = maxRate;
+        maxRate = s->storageEvap + s->storageDrain + s->storageExfil;
+        if ( s->pavePerc > maxRate ) s->pavePerc = maxRate;
 
         //... storage outflow can't exceed pavement outflow
         else
         {
             //... use up available exfiltration capacity first
-            StorageExfil = MIN(StorageExfil, PavePerc);
-            StorageDrain = PavePerc - StorageExfil;
+            s->storageExfil = MIN(s->storageExfil, s->pavePerc);
+            s->storageDrain = s->pavePerc - s->storageExfil;
         }
 
         //... set soil perc to pavement perc
-        SoilPerc = PavePerc;
+        s->soilPerc = s->pavePerc;
 
         //... limit surface infil. by pavement perc
-        SurfaceInfil = MIN(SurfaceInfil, PavePerc);
+        s->surfaceInfil = MIN(s->surfaceInfil, s->pavePerc);
     }
 
     //... pavement, soil & storage layers are full
@@ -979,22 +964,23 @@ void pavementFluxRates(double x[], double f[])
               paveDepth >= paveThickness )
     {
         //... find which layer has limiting flux rate
-        maxRate = StorageExfil + StorageDrain;
-        if ( SoilPerc < maxRate) maxRate = SoilPerc;
-        else maxRate = MIN(maxRate, PavePerc);
+        maxRate = s->storageExfil + s->storageDrain;
+        if ( s->soilPerc < maxRate) maxRate = s->soilPerc;
+        else maxRate = MIN(maxRate, s->pavePerc);
 
         //... use up available storage exfiltration capacity first
-        if ( maxRate > StorageExfil ) StorageDrain = maxRate - StorageExfil;
+        if ( maxRate > s->storageExfil )
+            s->storageDrain = maxRate - s->storageExfil;
         else
         {
-            StorageExfil = maxRate;
-            StorageDrain = 0.0;
+            s->storageExfil = maxRate;
+            s->storageDrain = 0.0;
         }
-        SoilPerc = maxRate;
-        PavePerc = maxRate;
+        s->soilPerc = maxRate;
+        s->pavePerc = maxRate;
 
         //... limit surface infil. by pavement perc
-        SurfaceInfil = MIN(SurfaceInfil, PavePerc);
+        s->surfaceInfil = MIN(s->surfaceInfil, s->pavePerc);
     }
 
     //... storage & soil layers are full
@@ -1003,21 +989,21 @@ void pavementFluxRates(double x[], double f[])
               soilTheta >= soilPorosity )
     {
         //... soil perc can't exceed storage outflow
-        maxRate = StorageDrain + StorageExfil;
-        if ( SoilPerc > maxRate ) SoilPerc = maxRate;
+        maxRate = s->storageDrain + s->storageExfil;
+        if ( s->soilPerc > maxRate ) s->soilPerc = maxRate;
 
         //... storage outflow can't exceed soil perc
         else
         {
             //... use up available exfiltration capacity first
-            StorageExfil = MIN(StorageExfil, SoilPerc);
-            StorageDrain = SoilPerc - StorageExfil;
+            s->storageExfil = MIN(s->storageExfil, s->soilPerc);
+            s->storageDrain = s->soilPerc - s->storageExfil;
         }
 
         //... limit surface infil. by available pavement volume
         availVolume = (paveThickness - paveDepth) * paveVoidFrac;
-        maxRate = availVolume / Tstep + PavePerc + PaveEvap;
-        SurfaceInfil = MIN(SurfaceInfil, maxRate);
+        maxRate = availVolume / s->tStep + s->pavePerc + s->paveEvap;
+        s->surfaceInfil = MIN(s->surfaceInfil, maxRate);
     }
 
     //... soil and pavement layers are full
@@ -1025,76 +1011,78 @@ void pavementFluxRates(double x[], double f[])
               paveDepth >= paveThickness &&
               soilTheta >= soilPorosity )
     {
-        PavePerc = MIN(PavePerc, SoilPerc);
-        SoilPerc = PavePerc;
-        SurfaceInfil = MIN(SurfaceInfil,PavePerc); 
+        s->pavePerc = MIN(s->pavePerc, s->soilPerc);
+        s->soilPerc = s->pavePerc;
+        s->surfaceInfil = MIN(s->surfaceInfil,s->pavePerc); 
     }
 
     //... no adjoining layers are full
     else
     {
         //... limit storage exfiltration by available storage volume
-        //    (if no soil layer, SoilPerc is same as PavePerc)
-        maxRate = SoilPerc - StorageEvap + StorageVolume / Tstep;
+        //    (if no soil layer, s->soilPerc is same as s->pavePerc)
+        maxRate = s->soilPerc - s->storageEvap + s->storageVolume / s->tStep;
         maxRate = MAX(0.0, maxRate);
-        StorageExfil = MIN(StorageExfil, maxRate);
+        s->storageExfil = MIN(s->storageExfil, maxRate);
 
         //... limit underdrain flow by volume above drain offset
-        if ( StorageDrain > 0.0 )
+        if ( s->storageDrain > 0.0 )
         {
-            maxRate = -StorageExfil - StorageEvap;
-            if (storageDepth >= storageThickness ) maxRate += SoilPerc;
-            if ( theLidProc->drain.offset <= storageDepth ) 
+            maxRate = -s->storageExfil - s->storageEvap;
+            if (storageDepth >= storageThickness ) maxRate += s->soilPerc;
+            if ( s->lidProc->drain.offset <= storageDepth ) 
             {
-                maxRate += (storageDepth - theLidProc->drain.offset) *
-                           storageVoidFrac/Tstep;
+                maxRate += (storageDepth - s->lidProc->drain.offset) *
+                           storageVoidFrac/s->tStep;
             }
             maxRate = MAX(maxRate, 0.0);
-            StorageDrain = MIN(StorageDrain, maxRate);
+            s->storageDrain = MIN(s->storageDrain, maxRate);
         }
 
         //... limit soil & pavement outflow by unused storage volume
         availVolume = (storageThickness - storageDepth) * storageVoidFrac;
-        maxRate = availVolume/Tstep + StorageEvap + StorageDrain + StorageExfil;
+        maxRate = availVolume/s->tStep + s->storageEvap + s->storageDrain +
+                  s->storageExfil;
         maxRate = MAX(maxRate, 0.0);
         if ( soilThickness > 0.0 )
         {
-            SoilPerc = MIN(SoilPerc, maxRate);
-            maxRate = (soilPorosity - soilTheta) * soilThickness / Tstep +
-                      SoilPerc;
+            s->soilPerc = MIN(s->soilPerc, maxRate);
+            maxRate = (soilPorosity - soilTheta) * soilThickness / s->tStep +
+                      s->soilPerc;
         }
-        PavePerc = MIN(PavePerc, maxRate);
+        s->pavePerc = MIN(s->pavePerc, maxRate);
 
         //... limit surface infil. by available pavement volume
         availVolume = (paveThickness - paveDepth) * paveVoidFrac;
-        maxRate = availVolume / Tstep + PavePerc + PaveEvap;
-        SurfaceInfil = MIN(SurfaceInfil, maxRate);
+        maxRate = availVolume / s->tStep + s->pavePerc + s->paveEvap;
+        s->surfaceInfil = MIN(s->surfaceInfil, maxRate);
     }
 
     //... surface outflow
-    SurfaceOutflow = getSurfaceOutflowRate(surfaceDepth);
+    s->surfaceOutflow = getSurfaceOutflowRate(s, surfaceDepth);
 
     //... compute overall layer flux rates
-    f[SURF] = SurfaceInflow - SurfaceEvap - SurfaceInfil - SurfaceOutflow;
-    f[PAVE] = (SurfaceInfil - PaveEvap - PavePerc) / paveVoidFrac;
-    if ( theLidProc->soil.thickness > 0.0)
+    f[SURF] = s->surfaceInflow - s->surfaceEvap - s->surfaceInfil -
+              s->surfaceOutflow;
+    f[PAVE] = (s->surfaceInfil - s->paveEvap - s->pavePerc) / paveVoidFrac;
+    if ( s->lidProc->soil.thickness > 0.0)
     {
-        f[SOIL] = (PavePerc - SoilEvap - SoilPerc) / soilThickness;
-        storageInflow = SoilPerc;
+        f[SOIL] = (s->pavePerc - s->soilEvap - s->soilPerc) / soilThickness;
+        storageInflow = s->soilPerc;
     }
     else
     {
         f[SOIL] = 0.0;
-        storageInflow = PavePerc;
-        SoilPerc = 0.0;
+        storageInflow = s->pavePerc;
+        s->soilPerc = 0.0;
     }
-    f[STOR] = (storageInflow - StorageEvap - StorageExfil - StorageDrain) /
-              storageVoidFrac;
+    f[STOR] = (storageInflow - s->storageEvap - s->storageExfil -
+               s->storageDrain) / storageVoidFrac;
 }
 
 //=============================================================================
 
-void swaleFluxRates(double x[], double f[])
+void swaleFluxRates(TLidState* s, double x[], double f[])
 //
 //  Purpose: computes flux rates from a vegetative swale LID.
 //  Input:   x = vector of storage levels
@@ -1119,57 +1107,57 @@ void swaleFluxRates(double x[], double f[])
 
     //... retrieve state variable from work vector
     depth = x[SURF];
-    depth = MIN(depth, theLidProc->surface.thickness);
+    depth = MIN(depth, s->lidProc->surface.thickness);
 
     //... depression storage depth
     dStore = 0.0;
 
     //... get swale's bottom width
     //    (0.5 ft minimum to avoid numerical problems)
-    slope = theLidProc->surface.sideSlope;
-    topWidth = theLidUnit->fullWidth;
+    slope = s->lidProc->surface.sideSlope;
+    topWidth = s->lidUnit->fullWidth;
     topWidth = MAX(topWidth, 0.5);
-    botWidth = topWidth - 2.0 * slope * theLidProc->surface.thickness;
+    botWidth = topWidth - 2.0 * slope * s->lidProc->surface.thickness;
     if ( botWidth < 0.5 )
     {
         botWidth = 0.5;
-        slope = 0.5 * (topWidth - 0.5) / theLidProc->surface.thickness;
+        slope = 0.5 * (topWidth - 0.5) / s->lidProc->surface.thickness;
     }
 
     //... swale's length
-    lidArea = theLidUnit->area;
+    lidArea = s->lidUnit->area;
     length = lidArea / topWidth;
 
     //... top width, surface area and flow area of current ponded depth
     surfWidth = botWidth + 2.0 * slope * depth;
     surfArea = length * surfWidth;
     flowArea = (depth * (botWidth + slope * depth)) *
-               theLidProc->surface.voidFrac;
+               s->lidProc->surface.voidFrac;
 
     //... wet volume and effective depth
     volume = length * flowArea;
 
     //... surface inflow into swale (cfs)
-    surfInflow = SurfaceInflow * lidArea;
+    surfInflow = s->surfaceInflow * lidArea;
 
     //... ET rate in cfs
-    SurfaceEvap = EvapRate * surfArea;
-    SurfaceEvap = MIN(SurfaceEvap, volume/Tstep);
+    s->surfaceEvap = s->evapRate * surfArea;
+    s->surfaceEvap = MIN(s->surfaceEvap, volume/s->tStep);
 
     //... infiltration rate to native soil in cfs
-    StorageExfil = SurfaceInfil * surfArea;
+    s->storageExfil = s->surfaceInfil * surfArea;
 
     //... no surface outflow if depth below depression storage
     xDepth = depth - dStore;
-    if ( xDepth <= ZERO ) SurfaceOutflow = 0.0;
+    if ( xDepth <= ZERO ) s->surfaceOutflow = 0.0;
 
     //... otherwise compute a surface outflow
     else
     {
         //... modify flow area to remove depression storage,
         flowArea -= (dStore * (botWidth + slope * dStore)) *
-                     theLidProc->surface.voidFrac;
-        if ( flowArea < ZERO ) SurfaceOutflow = 0.0;
+                     s->lidProc->surface.voidFrac;
+        if ( flowArea < ZERO ) s->surfaceOutflow = 0.0;
         else
         {
             //... compute hydraulic radius
@@ -1178,38 +1166,38 @@ void swaleFluxRates(double x[], double f[])
             hydRadius = flowArea / hydRadius;
 
             //... use Manning Eqn. to find outflow rate in cfs
-            SurfaceOutflow = theLidProc->surface.alpha * flowArea *
+            s->surfaceOutflow = s->lidProc->surface.alpha * flowArea *
                              pow(hydRadius, 2./3.);
         }
     }
 
     //... net flux rate (dV/dt) in cfs
-    dVdT = surfInflow - SurfaceEvap - StorageExfil - SurfaceOutflow;
+    dVdT = surfInflow - s->surfaceEvap - s->storageExfil - s->surfaceOutflow;
 
     //... when full, any net positive inflow becomes spillage
-    if ( depth == theLidProc->surface.thickness && dVdT > 0.0 )
+    if ( depth == s->lidProc->surface.thickness && dVdT > 0.0 )
     {
-        SurfaceOutflow += dVdT;
+        s->surfaceOutflow += dVdT;
         dVdT = 0.0;
     }
 
     //... convert flux rates to ft/s
-    SurfaceEvap /= lidArea;
-    StorageExfil /= lidArea;
-    SurfaceOutflow /= lidArea;
+    s->surfaceEvap /= lidArea;
+    s->storageExfil /= lidArea;
+    s->surfaceOutflow /= lidArea;
     f[SURF] = dVdT / surfArea;
     f[SOIL] = 0.0;
     f[STOR] = 0.0;
 
     //... assign values to layer volumes
-    SurfaceVolume = volume / lidArea;
-    SoilVolume = 0.0;
-    StorageVolume = 0.0;
+    s->surfaceVolume = volume / lidArea;
+    s->soilVolume = 0.0;
+    s->storageVolume = 0.0;
 }
 
 //=============================================================================
 
-void barrelFluxRates(double x[], double f[])
+void barrelFluxRates(TLidState* s, double x[], double f[])
 //
 //  Purpose: computes flux rates for a rain barrel LID.
 //  Input:   x = vector of storage levels
@@ -1221,45 +1209,45 @@ void barrelFluxRates(double x[], double f[])
     double maxValue;
 
     //... assign values to layer volumes
-    SurfaceVolume = 0.0;
-    SoilVolume = 0.0;
-    StorageVolume = storageDepth;
+    s->surfaceVolume = 0.0;
+    s->soilVolume = 0.0;
+    s->storageVolume = storageDepth;
 
     //... initialize flows
-    SurfaceInfil = 0.0;
-    SurfaceOutflow = 0.0;
-    StorageDrain = 0.0;
+    s->surfaceInfil = 0.0;
+    s->surfaceOutflow = 0.0;
+    s->storageDrain = 0.0;
 
     //... compute outflow if time since last rain exceeds drain delay
     //    (dryTime is updated in lid.evalLidUnit at each time step)
-    if ( theLidProc->drain.delay == 0.0 ||
-	     theLidUnit->dryTime >= theLidProc->drain.delay )
+    if ( s->lidProc->drain.delay == 0.0 ||
+	     s->lidUnit->dryTime >= s->lidProc->drain.delay )
 	{
-	    head = storageDepth - theLidProc->drain.offset;
+	    head = storageDepth - s->lidProc->drain.offset;
 		if ( head > 0.0 )
 	    {
-	        StorageDrain = getStorageDrainRate(storageDepth, 0.0, 0.0, 0.0);
-		    maxValue = (head/Tstep);
-			StorageDrain = MIN(StorageDrain, maxValue);
+	        s->storageDrain = getStorageDrainRate(s, storageDepth, 0.0, 0.0, 0.0);
+		    maxValue = (head/s->tStep);
+			s->storageDrain = MIN(s->storageDrain, maxValue);
 		}
 	}
 
     //... limit inflow to available storage
-    StorageInflow = SurfaceInflow;
-    maxValue = (theLidProc->storage.thickness - storageDepth) / Tstep +
-        StorageDrain;
-    StorageInflow = MIN(StorageInflow, maxValue);
-    SurfaceInfil = StorageInflow;
+    s->storageInflow = s->surfaceInflow;
+    maxValue = (s->lidProc->storage.thickness - storageDepth) / s->tStep +
+        s->storageDrain;
+    s->storageInflow = MIN(s->storageInflow, maxValue);
+    s->surfaceInfil = s->storageInflow;
 
     //... assign values to layer flux rates
-    f[SURF] = SurfaceInflow - StorageInflow;
-    f[STOR] = StorageInflow - StorageDrain;
+    f[SURF] = s->surfaceInflow - s->storageInflow;
+    f[STOR] = s->storageInflow - s->storageDrain;
     f[SOIL] = 0.0;
 }
 
 //=============================================================================
 
-double getSurfaceOutflowRate(double depth)
+double getSurfaceOutflowRate(TLidState* s, double depth)
 //
 //  Purpose: computes outflow rate from a LID's surface layer.
 //  Input:   depth = depth of ponded water on surface layer (ft)
@@ -1272,19 +1260,19 @@ double getSurfaceOutflowRate(double depth)
     double outflow;
 
     //... no outflow if ponded depth below storage depth
-    delta = depth - theLidProc->surface.thickness;
+    delta = depth - s->lidProc->surface.thickness;
     if ( delta < 0.0 ) return 0.0;
 
     //... compute outflow from overland flow Manning equation
-    outflow = theLidProc->surface.alpha * pow(delta, 5.0/3.0) *
-              theLidUnit->fullWidth / theLidUnit->area;
-    outflow = MIN(outflow, delta / Tstep);
+    outflow = s->lidProc->surface.alpha * pow(delta, 5.0/3.0) *
+              s->lidUnit->fullWidth / s->lidUnit->area;
+    outflow = MIN(outflow, delta / s->tStep);
     return outflow;
 }
 
 //=============================================================================
 
-double getPavementPermRate()
+double getPavementPermRate(TLidState* s)
 //
 //  Purpose: computes reduced permeability of a pavement layer due to
 //           clogging.
@@ -1293,8 +1281,8 @@ double getPavementPermRate()
 //
 {
     double permReduction = 0.0;
-    double clogFactor= theLidProc->pavement.clogFactor;
-    double regenDays = theLidProc->pavement.regenDays;
+    double clogFactor= s->lidProc->pavement.clogFactor;
+    double regenDays = s->lidProc->pavement.regenDays;
 
     // ... find permeability reduction due to clogging     
     if ( clogFactor > 0.0 )
@@ -1304,29 +1292,30 @@ double getPavementPermRate()
         //      volumetric loading that the pavement has received)
         if ( regenDays > 0.0 )
         {
-            if ( OldRunoffTime / 1000.0 / SECperDAY >= theLidUnit->nextRegenDay )
+            if ( OldRunoffTime / 1000.0 / SECperDAY >=
+                 s->lidUnit->nextRegenDay )
             {
                 // ... reduce total volume treated by degree of regeneration
-                theLidUnit->volTreated *= 
-                    (1.0 - theLidProc->pavement.regenDegree);
+                s->lidUnit->volTreated *= 
+                    (1.0 - s->lidProc->pavement.regenDegree);
 
                 // ... update next day that regenration occurs
-                theLidUnit->nextRegenDay += regenDays;
+                s->lidUnit->nextRegenDay += regenDays;
             }
         }
 
         // ... find permeabiity reduction factor
-        permReduction = theLidUnit->volTreated / clogFactor;
+        permReduction = s->lidUnit->volTreated / clogFactor;
         permReduction = MIN(permReduction, 1.0);
     }
 
     // ... return the effective pavement permeability
-    return theLidProc->pavement.kSat * (1.0 - permReduction);
+    return s->lidProc->pavement.kSat * (1.0 - permReduction);
 }
 
 //=============================================================================
 
-double getSoilPercRate(double theta)
+double getSoilPercRate(TLidState* s, double theta)
 //
 //  Purpose: computes percolation rate of water through a LID's soil layer.
 //  Input:   theta = moisture content (fraction)
@@ -1336,17 +1325,17 @@ double getSoilPercRate(double theta)
     double delta;            // moisture deficit
 
     // ... no percolation if soil moisture <= field capacity
-    if ( theta <= theLidProc->soil.fieldCap ) return 0.0;
+    if ( theta <= s->lidProc->soil.fieldCap ) return 0.0;
 
     // ... perc rate = unsaturated hydraulic conductivity
-    delta = theLidProc->soil.porosity - theta;
-    return theLidProc->soil.kSat * exp(-delta * theLidProc->soil.kSlope);
+    delta = s->lidProc->soil.porosity - theta;
+    return s->lidProc->soil.kSat * exp(-delta * s->lidProc->soil.kSlope);
 
 }
 
 //=============================================================================
 
-double getStorageExfilRate()
+double getStorageExfilRate(TLidState* s)
 //
 //  Purpose: computes exfiltration rate from storage zone into
 //           native soil beneath a LID.
@@ -1357,28 +1346,29 @@ double getStorageExfilRate()
     double infil = 0.0;
     double clogFactor = 0.0;
 
-    if ( theLidProc->storage.kSat == 0.0 ) return 0.0;
-    if ( MaxNativeInfil == 0.0 ) return 0.0;
+    if ( s->lidProc->storage.kSat == 0.0 ) return 0.0;
+    if ( s->maxNativeInfil == 0.0 ) return 0.0;
 
     //... reduction due to clogging
-    clogFactor = theLidProc->storage.clogFactor;
+    clogFactor = s->lidProc->storage.clogFactor;
     if ( clogFactor > 0.0 )
     {
-        clogFactor = theLidUnit->waterBalance.inflow / clogFactor;
+        clogFactor = s->lidUnit->waterBalance.inflow / clogFactor;
         clogFactor = MIN(clogFactor, 1.0);
     }
 
     //... infiltration rate = storage Ksat reduced by any clogging
-    infil = theLidProc->storage.kSat * (1.0 - clogFactor);
+    infil = s->lidProc->storage.kSat * (1.0 - clogFactor);
 
     //... limit infiltration rate by any groundwater-imposed limit
-    return MIN(infil, MaxNativeInfil);
+    return MIN(infil, s->maxNativeInfil);
 }
 
 //=============================================================================
 
-double  getStorageDrainRate(double storageDepth, double soilTheta, 
-                            double paveDepth, double surfaceDepth)
+double  getStorageDrainRate(TLidState* s, double storageDepth,
+                            double soilTheta, double paveDepth,
+                            double surfaceDepth)
 //
 //  Purpose: computes underdrain flow rate in a LID's storage layer.
 //  Input:   storageDepth = depth of water in storage layer (ft)
@@ -1392,14 +1382,14 @@ double  getStorageDrainRate(double storageDepth, double soilTheta,
 //           layers above it (soil, pavement, and surface in that order)
 //           minus the drain outlet offset.
 {
-    int    curve = theLidProc->drain.qCurve;                                   //(5.1.013)
+    int    curve = s->lidProc->drain.qCurve;                                   //(5.1.013)
     double head = storageDepth;
     double outflow = 0.0;
-    double paveThickness    = theLidProc->pavement.thickness;
-    double soilThickness    = theLidProc->soil.thickness;
-    double soilPorosity     = theLidProc->soil.porosity;
-    double soilFieldCap     = theLidProc->soil.fieldCap;
-    double storageThickness = theLidProc->storage.thickness;
+    double paveThickness    = s->lidProc->pavement.thickness;
+    double soilThickness    = s->lidProc->soil.thickness;
+    double soilPorosity     = s->lidProc->soil.porosity;
+    double soilFieldCap     = s->lidProc->soil.fieldCap;
+    double storageThickness = s->lidProc->storage.thickness;
 
     // --- storage layer is full
     if ( storageDepth >= storageThickness )
@@ -1435,13 +1425,13 @@ double  getStorageDrainRate(double storageDepth, double soilTheta,
     // --- no outflow if:                                                      //(5.1.013)
     //     a) no prior outflow and head below open threshold                   //
     //     b) prior outflow and head below closed threshold                    //
-    if ( theLidUnit->oldDrainFlow == 0.0 &&                                    //
-         head <= theLidProc->drain.hOpen ) return 0.0;                         //
-    if ( theLidUnit->oldDrainFlow > 0.0 &&                                     //
-         head <= theLidProc->drain.hClose ) return 0.0;                        //
+    if ( s->lidUnit->oldDrainFlow == 0.0 &&                                    //
+         head <= s->lidProc->drain.hOpen ) return 0.0;                         //
+    if ( s->lidUnit->oldDrainFlow > 0.0 &&                                     //
+         head <= s->lidProc->drain.hClose ) return 0.0;                        //
 
     // --- make head relative to drain offset
-    head -= theLidProc->drain.offset;
+    head -= s->lidProc->drain.offset;
 
     // --- compute drain outflow from underdrain flow equation in user units
     //     (head in inches or mm, flow rate in in/hr or mm/hr)
@@ -1451,8 +1441,8 @@ double  getStorageDrainRate(double storageDepth, double soilTheta,
         head *= UCF(RAINDEPTH);
 
         // --- compute drain outflow in user units
-        outflow = theLidProc->drain.coeff *
-                  pow(head, theLidProc->drain.expon);
+        outflow = s->lidProc->drain.coeff *
+                  pow(head, s->lidProc->drain.expon);
 
         // --- apply user-supplied control curve to outflow
         if (curve >= 0)  outflow *= table_lookup(&Curve[curve], head);         //(5.1.013)
@@ -1465,7 +1455,7 @@ double  getStorageDrainRate(double storageDepth, double soilTheta,
 
 //=============================================================================
 
-double getDrainMatOutflow(double depth)
+double getDrainMatOutflow(TLidState* s, double depth)
 //
 //  Purpose: computes flow rate through a green roof's drainage mat.
 //  Input:   depth = depth of water in drainage mat (ft)
@@ -1473,21 +1463,21 @@ double getDrainMatOutflow(double depth)
 //
 {
     //... default is to pass all inflow
-    double result = SoilPerc;
+    double result = s->soilPerc;
 
     //... otherwise use Manning eqn. if its parameters were supplied
-    if ( theLidProc->drainMat.alpha > 0.0 )
+    if ( s->lidProc->drainMat.alpha > 0.0 )
     {
-        result = theLidProc->drainMat.alpha * pow(depth, 5.0/3.0) *
-                 theLidUnit->fullWidth / theLidUnit->area *
-                 theLidProc->drainMat.voidFrac;
+        result = s->lidProc->drainMat.alpha * pow(depth, 5.0/3.0) *
+                 s->lidUnit->fullWidth / s->lidUnit->area *
+                 s->lidProc->drainMat.voidFrac;
     }
     return result;
 }
 
 //=============================================================================
 
-void getEvapRates(double surfaceVol, double paveVol, double soilVol,
+void getEvapRates(TLidState* s, double surfaceVol, double paveVol, double soilVol,
     double storageVol, double pervFrac)
 //
 //  Purpose: computes surface, pavement, soil, and storage evaporation rates.
@@ -1502,53 +1492,54 @@ void getEvapRates(double surfaceVol, double paveVol, double soilVol,
     double availEvap;
 
     //... surface evaporation flux
-    availEvap = EvapRate;
-    SurfaceEvap = MIN(availEvap, surfaceVol/Tstep);
-    SurfaceEvap = MAX(0.0, SurfaceEvap);
-    availEvap = MAX(0.0, (availEvap - SurfaceEvap));
+    availEvap = s->evapRate;
+    s->surfaceEvap = MIN(availEvap, surfaceVol/s->tStep);
+    s->surfaceEvap = MAX(0.0, s->surfaceEvap);
+    availEvap = MAX(0.0, (availEvap - s->surfaceEvap));
     availEvap *= pervFrac;
 
     //... no subsurface evap if water is infiltrating
-    if ( SurfaceInfil > 0.0 )
+    if ( s->surfaceInfil > 0.0 )
     {
-        PaveEvap = 0.0;
-        SoilEvap = 0.0;
-        StorageEvap = 0.0;
+        s->paveEvap = 0.0;
+        s->soilEvap = 0.0;
+        s->storageEvap = 0.0;
     }
     else
     {
         //... pavement evaporation flux
-        PaveEvap = MIN(availEvap, paveVol / Tstep);
-        availEvap = MAX(0.0, (availEvap - PaveEvap));
+        s->paveEvap = MIN(availEvap, paveVol / s->tStep);
+        availEvap = MAX(0.0, (availEvap - s->paveEvap));
 
         //... soil evaporation flux
-        SoilEvap = MIN(availEvap, soilVol / Tstep);
-        availEvap = MAX(0.0, (availEvap - SoilEvap));
+        s->soilEvap = MIN(availEvap, soilVol / s->tStep);
+        availEvap = MAX(0.0, (availEvap - s->soilEvap));
 
         //... storage evaporation flux
-        StorageEvap = MIN(availEvap, storageVol / Tstep);
+        s->storageEvap = MIN(availEvap, storageVol / s->tStep);
     }
 }
 
 //=============================================================================
 
-double getSurfaceOverflowRate(double* surfaceDepth)
+double getSurfaceOverflowRate(TLidState* s, double* surfaceDepth)
 //
 //  Purpose: finds surface overflow rate from a LID unit.
 //  Input:   surfaceDepth = depth of water stored in surface layer (ft)
 //  Output:  returns the overflow rate (ft/s)
 //
 {
-    double delta = *surfaceDepth - theLidProc->surface.thickness;
+    double delta = *surfaceDepth - s->lidProc->surface.thickness;
     if (  delta <= 0.0 ) return 0.0;
-    *surfaceDepth = theLidProc->surface.thickness;
-    return delta * theLidProc->surface.voidFrac / Tstep;
+    *surfaceDepth = s->lidProc->surface.thickness;
+    return delta * s->lidProc->surface.voidFrac / s->tStep;
 }
 
 //=============================================================================
 
 void updateWaterBalance(TLidUnit *lidUnit, double inflow, double evap,
-    double infil, double surfFlow, double drainFlow, double storage)
+    double infil, double surfFlow, double drainFlow, double storage,
+    double tStep)
 //
 //  Purpose: updates components of the water mass balance for a LID unit
 //           over the current time step.
@@ -1559,16 +1550,16 @@ void updateWaterBalance(TLidUnit *lidUnit, double inflow, double evap,
 //           surfFlow  = surface runoff from the unit (ft/s)
 //           drainFlow = underdrain flow from the unit
 //           storage   = volume of water stored in the unit (ft)
-//           tstep     = current time step (s)
+//           tStep     = current time step (s)
 //  Output:  none
 //
 {
-    lidUnit->volTreated += inflow * Tstep;                                     //(5.1.013)
-    lidUnit->waterBalance.inflow += inflow * Tstep;
-    lidUnit->waterBalance.evap += evap * Tstep;
-    lidUnit->waterBalance.infil += infil * Tstep;
-    lidUnit->waterBalance.surfFlow += surfFlow * Tstep;
-    lidUnit->waterBalance.drainFlow += drainFlow * Tstep;
+    lidUnit->volTreated += inflow * tStep;                                     //(5.1.013)
+    lidUnit->waterBalance.inflow += inflow * tStep;
+    lidUnit->waterBalance.evap += evap * tStep;
+    lidUnit->waterBalance.infil += infil * tStep;
+    lidUnit->waterBalance.surfFlow += surfFlow * tStep;
+    lidUnit->waterBalance.drainFlow += drainFlow * tStep;
     lidUnit->waterBalance.finalVol = storage;
 }
 
@@ -1617,7 +1608,7 @@ void updateWaterRate(TLidUnit *lidUnit, double evap, double maxNativeInfil,
 int modpuls_solve(int n, double* x, double* xOld, double* xPrev,
                   double* xMin, double* xMax, double* xTol,
                   double* qOld, double* q, double dt, double omega,
-                  void (*derivs)(double*, double*))
+                  TLidState* s, void (*derivs)(TLidState*, double*, double*))
 //
 //  Purpose: solves system of equations dx/dt = q(x) for x at end of time step
 //           dt using a modified Puls method.
@@ -1633,6 +1624,7 @@ int modpuls_solve(int n, double* x, double* xOld, double* xPrev,
 //           dt = time step (sec)
 //           omega = time weighting parameter (use 0 for Euler method
 //                   or 0.5 for modified Puls method)
+//           s = LID unit analysis variables passed on to derivs
 //           derivs = pointer to function that computes flux rates q as a
 //                    function of state variables x
 //  Output:  returns number of steps required for convergence (or 0 if
@@ -1656,7 +1648,7 @@ int modpuls_solve(int n, double* x, double* xOld, double* xPrev,
     {
         //... compute flux rates for current state levels
         canStop = 1;
-        derivs(x, q);
+        derivs(s, x, q);
 
         //... update state levels based on current flux rates
         for (i=0; i<n; i++)
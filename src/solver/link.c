@@ -50,6 +50,13 @@
 //  Build 5.1.014:
 //  - Conduit evap. and seepage losses initialized to 0 in conduit_initState()
 //    and not allowed to exceed current flow rate in conduit_getLossRate().
+//
+//  Build 5.1.015:
+//  - Outlet rating curve qualifier parsed with reentrant sstrtok().
+//  - Extension of end node depths to a link's crown moved from
+//    link_validate() to link_setNodeDepths() so that conduits can be
+//    validated in parallel.
+//  - Conduit validation stops on errors found for the conduit itself.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -71,6 +78,7 @@ static const double MIN_DELTA_Z = 0.001; // minimum elevation change for conduit
 //  link_readXsectParams   (called by parseLine in input.c)
 //  link_readLossParams    (called by parseLine in input.c)
 //  link_validate          (called by project_validate in project.c)
+//  link_setNodeDepths     (called by project_validate in project.c)
 //  link_initState         (called by initObjects in swmm5.c)
 //  link_setOldHydState    (called by routing_execute in routing.c)
 //  link_setOldQualState   (called by routing_execute in routing.c)
@@ -387,8 +395,6 @@ void  link_validate(int j)
 //  Purpose: validates a link's properties.
 //
 {
-    int   n;
-
     if ( LinkOffsets == ELEV_OFFSET ) link_convertOffsets(j);
     switch ( Link[j].type )
     {
@@ -416,9 +422,19 @@ void  link_validate(int j)
               else report_writeWarningMsg(WARN10a, Link[j].ID);                //(5.1.013)
           }
     }    
+}
 
-    // --- force max. depth of end nodes to be >= link crown height
-    //     at non-storage nodes
+//=============================================================================
+
+void  link_setNodeDepths(int j)
+//
+//  Input:   j = link index
+//  Output:  none
+//  Purpose: forces max. depth of a link's end nodes to be >= link crown
+//           height at non-storage nodes.
+//
+{
+    int   n;
 
     // --- skip pumps and bottom orifices
     if ( Link[j].type == PUMP ||
@@ -975,6 +991,7 @@ void  conduit_validate(int j, int k)
 //  Purpose: validates a conduit's properties.
 //
 {
+    int    err = FALSE;                                                        //(5.1.015)
     double aa;
     double lengthFactor, roughness, slope;
 
@@ -1004,26 +1021,46 @@ void  conduit_validate(int j, int k)
     {
         if ( ForceMainEqn == D_W ) Link[j].xsect.rBot /= UCF(RAINDEPTH);
         if ( Link[j].xsect.rBot <= 0.0 )
-            report_writeErrorMsg(ERR_XSECT, Link[j].ID);
+        {                                                                      //(5.1.015)
+            report_writeErrorMsg(ERR_XSECT, Link[j].ID);                       //
+            err = TRUE;                                                        //
+        }                                                                      //
     }
 
     // --- check for valid length & roughness
     if ( Conduit[k].length <= 0.0 )
-        report_writeErrorMsg(ERR_LENGTH, Link[j].ID);
+    {                                                                          //(5.1.015)
+        report_writeErrorMsg(ERR_LENGTH, Link[j].ID);                          //
+        err = TRUE;                                                            //
+    }                                                                          //
     if ( Conduit[k].roughness <= 0.0 )
-        report_writeErrorMsg(ERR_ROUGHNESS, Link[j].ID);
+    {                                                                          //(5.1.015)
+        report_writeErrorMsg(ERR_ROUGHNESS, Link[j].ID);                       //
+        err = TRUE;                                                            //
+    }                                                                          //
     if ( Conduit[k].barrels <= 0 )
-        report_writeErrorMsg(ERR_BARRELS, Link[j].ID);
+    {                                                                          //(5.1.015)
+        report_writeErrorMsg(ERR_BARRELS, Link[j].ID);                         //
+        err = TRUE;                                                            //
+    }                                                                          //
 
     // --- check for valid xsection
     if ( Link[j].xsect.type != DUMMY )
     {
         if ( Link[j].xsect.type < 0 )
-            report_writeErrorMsg(ERR_NO_XSECT, Link[j].ID);
+        {                                                                      //(5.1.015)
+            report_writeErrorMsg(ERR_NO_XSECT, Link[j].ID);                    //
+            err = TRUE;                                                        //
+        }                                                                      //
         else if ( Link[j].xsect.aFull <= 0.0 )
-            report_writeErrorMsg(ERR_XSECT, Link[j].ID);
+        {                                                                      //(5.1.015)
+            report_writeErrorMsg(ERR_XSECT, Link[j].ID);                       //
+            err = TRUE;                                                        //
+        }                                                                      //
     }
-    if ( ErrorCode ) return;
+    // --- stop if conduit has invalid data                                    //(5.1.015)
+    //     (ErrorCode is not updated while conduits are validated in parallel) //
+    if ( ErrorCode || err ) return;                                            //(5.1.015)
 
     // --- check for negative offsets
     if ( Link[j].offset1 < 0.0 )
@@ -1317,6 +1354,7 @@ double conduit_getLossRate(int j, double q)
     double depth = 0.5 * (Link[j].oldDepth + Link[j].newDepth);
     double length;
     double topWidth;
+    double evapRate;                                                           //(5.1.015)
     double evapLossRate = 0.0,
            seepLossRate = 0.0,
            totalLossRate = 0.0;
@@ -1327,10 +1365,11 @@ double conduit_getLossRate(int j, double q)
         length = conduit_getLength(j);
 
         // --- find evaporation rate for open conduits
-        if ( xsect_isOpen(xsect->type) && Evap.rate > 0.0 )
+        evapRate = runoff_getEvapRate();                                       //(5.1.015)
+        if ( xsect_isOpen(xsect->type) && evapRate > 0.0 )                     //(5.1.015)
         {
             topWidth = xsect_getWofY(xsect, depth);
-            evapLossRate = topWidth * length * Evap.rate;
+            evapLossRate = topWidth * length * evapRate;                       //(5.1.015)
         }
 
         // --- compute seepage loss rate
@@ -1342,7 +1381,7 @@ double conduit_getLossRate(int j, double q)
             // compute seepage loss rate across length of conduit
             seepLossRate = Link[j].seepRate * xsect_getWofY(xsect, depth) *
                            length;
-            seepLossRate *= Adjust.hydconFactor;
+            seepLossRate *= runoff_getHydconFactor();                          //(5.1.015)
         }
 
         // --- compute total loss rate
@@ -2501,6 +2540,7 @@ int outlet_readParams(int j, int k, char* tok[], int ntoks)
     double x[6];
     char*  id;
     char*  s;
+    char*  next;                                                               //(5.1.015)
 
     // --- check for valid ID and end node IDs
     if ( ntoks < 6 ) return error_setInpError(ERR_ITEMS, "");
@@ -2530,8 +2570,8 @@ int outlet_readParams(int j, int k, char* tok[], int ntoks)
 
     // --- see if rating curve is head or depth based
     x[5] = NODE_DEPTH;                                //default is depth-based
-    s = strtok(tok[4], "/");                          //parse token for
-    s = strtok(NULL, "/");                            //  qualifier term
+    s = sstrtok(tok[4], "/", &next);                  //parse token for
+    s = sstrtok(NULL, "/", &next);                    //  qualifier term
     if ( strcomp(s, w_HEAD) ) x[5] = NODE_HEAD;       //check if its "HEAD"
 
     // --- get params. for functional outlet device
@@ -37,6 +37,9 @@
 //
 //   Build 5.1.013:
 //   - Volume from MinSurfArea no longer included in initial & final storage.
+//
+//   Build 5.1.015:
+//   - New function massbal_snapshot() saves and restores continuity totals.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -93,6 +96,7 @@ double   TotalArea;               // total drainage area (ft2)
 //  massbal_addSeepageLoss      (called from routing.c)
 //  massbal_addToFinalStorage   (called from qualrout.c)
 //  massbal_getStepFlowError    (called from routing.c)
+//  massbal_snapshot            (called from visitState in snapshot.c)
 
 //-----------------------------------------------------------------------------
 //  Local Functions   
@@ -269,6 +273,30 @@ void massbal_close()
 
 //=============================================================================
 
+void massbal_snapshot(TSnapshot* s)
+//
+//  Input:   s = a simulation state snapshot
+//  Output:  none
+//  Purpose: saves or restores the mass balance continuity totals.
+//
+{
+    int nPolluts = Nobjects[POLLUT];
+    int nNodes = Nobjects[NODE];
+
+    snapshot_add(s, &RunoffTotals, sizeof(TRunoffTotals));
+    snapshot_add(s, LoadingTotals, nPolluts * sizeof(TLoadingTotals));
+    snapshot_add(s, &GwaterTotals, sizeof(TGwaterTotals));
+    snapshot_add(s, &FlowTotals, sizeof(TRoutingTotals));
+    snapshot_add(s, QualTotals, nPolluts * sizeof(TRoutingTotals));
+    snapshot_add(s, &StepFlowTotals, sizeof(TRoutingTotals));
+    snapshot_add(s, &OldStepFlowTotals, sizeof(TRoutingTotals));
+    snapshot_add(s, StepQualTotals, nPolluts * sizeof(TRoutingTotals));
+    snapshot_add(s, NodeInflow, nNodes * sizeof(double));
+    snapshot_add(s, NodeOutflow, nNodes * sizeof(double));
+}
+
+//=============================================================================
+
 void massbal_report()
 //
 //  Input:   none
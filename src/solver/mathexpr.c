@@ -6,8 +6,13 @@
 **                 operators.
 **  AUTHORS:       L. Rossman, US EPA - NRMRL
 **                 F. Shang, University of Cincinnati
-**  VERSION:       5.1.008
+**  VERSION:       5.1.015
 **  LAST UPDATE:   04/01/15
+**
+**  Build 5.1.015:
+**  - Expressions can be compiled into a contiguous instruction array that
+**    reads its variables from an array of values instead of through a
+**    callback function, allowing concurrent evaluation.
 ******************************************************************************/
 /*
 **   Operand codes:
@@ -99,6 +104,7 @@ static ExprTree * getOp(int *);
 static ExprTree * getTree(void);
 static void       traverseTree(ExprTree *, MathExpr **);
 static void       deleteTree(ExprTree *);
+static int        applyOp(int, double *, int);
 
 // Callback functions
 static int    (*getVariableIndex) (char *); // return index of named variable
@@ -541,13 +547,92 @@ double mathexpr_eval(MathExpr *expr, double (*getVariableValue) (int))
 
     double ExprStack[MAX_STACK_SIZE];
     MathExpr *node = expr;
-    double r1, r2;
+    double r1;
     int stackindex = 0;
     
     ExprStack[0] = 0.0;
     while(node != NULL)
     {
 	switch (node->opcode)
+	{
+        case 7:  
+		stackindex++;
+		ExprStack[stackindex] = node->fvalue;
+		break;
+
+        case 8:
+        if (getVariableValue != NULL)
+        {
+           r1 = getVariableValue(node->ivar);
+        }
+        else r1 = 0.0;
+		stackindex++;
+		ExprStack[stackindex] = r1;
+		break;
+
+        default:
+        stackindex = applyOp(node->opcode, ExprStack, stackindex);
+        }
+        node = node->next;
+    }
+    r1 = ExprStack[stackindex];
+
+    // Set result to 0 if it is NaN due to an illegal math op
+    if ( r1 != r1 ) r1 = 0.0;
+
+    return r1;
+}
+
+//=============================================================================
+
+double mathexpr_evalCompiled(MathExprCode *code, double *values)
+//  Evaluates a compiled math expression whose variable values are
+//  supplied in the values array (indexed by variable index)
+{
+    double ExprStack[MAX_STACK_SIZE];
+    ExprCode *instr;
+    ExprCode *last;
+    double r1;
+    int stackindex = 0;
+
+    if (code == NULL) return 0.0;
+    ExprStack[0] = 0.0;
+    last = code->instr + code->size;
+    for (instr = code->instr; instr < last; instr++)
+    {
+        switch (instr->opcode)
+        {
+        case 7:
+            stackindex++;
+            ExprStack[stackindex] = instr->fvalue;
+            break;
+
+        case 8:
+            stackindex++;
+            ExprStack[stackindex] = values[instr->ivar];
+            break;
+
+        default:
+            stackindex = applyOp(instr->opcode, ExprStack, stackindex);
+        }
+    }
+    r1 = ExprStack[stackindex];
+
+    // Set result to 0 if it is NaN due to an illegal math op
+    if ( r1 != r1 ) r1 = 0.0;
+
+    return r1;
+}
+
+//=============================================================================
+
+int applyOp(int opcode, double *ExprStack, int stackindex)
+//  Applies an arithmetic operator or math function to the top of the
+//  expression stack and returns the new stack index
+{
+    double r1, r2;
+
+	switch (opcode)
 	{
 	    case 3:  
 		r1 = ExprStack[stackindex];
@@ -577,21 +662,6 @@ double mathexpr_eval(MathExpr *expr, double (*getVariableValue) (int))
 		ExprStack[stackindex] = r2 / r1;
 		break;				
 
-        case 7:  
-		stackindex++;
-		ExprStack[stackindex] = node->fvalue;
-		break;
-
-        case 8:
-        if (getVariableValue != NULL)
-        {
-           r1 = getVariableValue(node->ivar);
-        }
-        else r1 = 0.0;
-		stackindex++;
-		ExprStack[stackindex] = r1;
-		break;
-
         case 9: 
 		ExprStack[stackindex] = -ExprStack[stackindex];
 		break;
@@ -726,14 +796,7 @@ double mathexpr_eval(MathExpr *expr, double (*getVariableValue) (int))
 		stackindex--;
 		break;
         }
-        node = node->next;
-    }
-    r1 = ExprStack[stackindex];
-
-    // Set result to 0 if it is NaN due to an illegal math op
-    if ( r1 != r1 ) r1 = 0.0;
-
-    return r1;
+    return stackindex;
 }
 
 // Turn off "precise" floating point option
@@ -749,6 +812,46 @@ void mathexpr_delete(MathExpr *expr)
 
 //=============================================================================
 
+MathExprCode * mathexpr_compile(MathExpr *expr)
+//  Flattens a tokenized math expression into a contiguous array of
+//  instructions (returns NULL if expr is NULL or memory runs out)
+{
+    int n = 0;
+    MathExpr *node;
+    MathExprCode *code;
+
+    if (expr == NULL) return NULL;
+    for (node = expr; node != NULL; node = node->next) n++;
+    code = (MathExprCode *) malloc(sizeof(MathExprCode));
+    if (code == NULL) return NULL;
+    code->instr = (ExprCode *) calloc(n, sizeof(ExprCode));
+    if (code->instr == NULL)
+    {
+        free(code);
+        return NULL;
+    }
+    code->size = n;
+    n = 0;
+    for (node = expr; node != NULL; node = node->next)
+    {
+        code->instr[n].opcode = node->opcode;
+        code->instr[n].ivar = node->ivar;
+        code->instr[n].fvalue = node->fvalue;
+        n++;
+    }
+    return code;
+}
+
+//=============================================================================
+
+void mathexpr_deleteCompiled(MathExprCode *code)
+{
+    if (code) free(code->instr);
+    free(code);
+}
+
+//=============================================================================
+
 MathExpr * mathexpr_create(char *formula, int (*getVar) (char *))
 {
     ExprTree *tree;
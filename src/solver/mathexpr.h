@@ -19,6 +19,21 @@ struct ExprNode
 };
 typedef struct ExprNode MathExpr;
 
+//  Instruction in a compiled math expression
+typedef struct
+{
+    int    opcode;                // operator code
+    int    ivar;                  // variable index
+    double fvalue;                // numerical value
+}   ExprCode;
+
+//  Compiled math expression (contiguous array of instructions)
+typedef struct
+{
+    int       size;               // number of instructions
+    ExprCode* instr;              // array of instructions
+}   MathExprCode;
+
 //  Creates a tokenized math expression from a string
 MathExpr* mathexpr_create(char* s, int (*getVar) (char *));
 
@@ -27,3 +42,12 @@ double mathexpr_eval(MathExpr* expr, double (*getVal) (int));
 
 //  Deletes a tokenized math expression
 void  mathexpr_delete(MathExpr* expr);
+
+//  Compiles a tokenized math expression into an instruction array
+MathExprCode* mathexpr_compile(MathExpr* expr);
+
+//  Evaluates a compiled math expression using an array of variable values
+double mathexpr_evalCompiled(MathExprCode* code, double* values);
+
+//  Deletes a compiled math expression
+void  mathexpr_deleteCompiled(MathExprCode* code);
@@ -8,24 +8,48 @@
 //
 //  Modified by L. Rossman, 8/13/94.
 //
+//  Build 5.1.015:
+//  - Functions that work on an explicit pool (AllocCreate, AllocFrom,
+//    AllocDelete) added so that several pools can be used at once, each
+//    from its own thread.
+//  - Blocks grow geometrically in size and requests too large for a block
+//    get a block of their own.
+//  - Memory is aligned to 8 bytes so that it can hold doubles & pointers.
+//  - Large blocks are mapped with a request for huge pages where supported.
+//
 //  AllocInit()     - create an alloc pool, returns the old pool handle
 //  Alloc()         - allocate memory
 //  AllocReset()    - reset the current pool
 //  AllocSetPool()  - set the current pool
 //  AllocFree()     - free the memory used by the current pool.
+//  AllocCreate()   - create an alloc pool without making it current
+//  AllocFrom()     - allocate memory from a given pool
+//  AllocDelete()   - free the memory used by a given pool
 //-----------------------------------------------------------------------------
 
 
-#include <stdlib.h>
 #include <stdlib.h>
 #include "mempool.h"
 
+#if defined(__linux__)
+  #include <sys/mman.h>
+  #define ALLOC_USE_MMAP
+#endif
+
 /*
 **  ALLOC_BLOCK_SIZE - adjust this size to suit your installation - it
 **  should be reasonably large otherwise you will be mallocing a lot.
+**
+**  ALLOC_MAX_BLOCK_SIZE - each new block in a pool is twice the size of
+**  the previous one up to this size.
+**
+**  ALLOC_HUGE_PAGE - blocks at least this large are mapped directly from
+**  the operating system and advised to use huge pages.
 */
 
-#define ALLOC_BLOCK_SIZE   64000       /*(62*1024)*/
+#define ALLOC_BLOCK_SIZE      64000       /*(62*1024)*/
+#define ALLOC_MAX_BLOCK_SIZE  (4*1024*1024)
+#define ALLOC_HUGE_PAGE       (2*1024*1024)
 
 /*
 **  alloc_hdr_t - Header for each block of memory.
@@ -37,6 +61,7 @@ typedef struct alloc_hdr_s
     char               *block,  /* Start of block      */
                        *free,   /* Next free in block  */
                        *end;    /* block + block size  */
+    int                mapped;  /* TRUE if block was mapped */
 }  alloc_hdr_t;
 
 /*
@@ -47,6 +72,7 @@ typedef struct alloc_root_s
 {
     alloc_hdr_t *first,    /* First header in pool */
                 *current;  /* Current header       */
+    long        size;      /* Size of next new block */
 }  alloc_root_t;
 
 /*
@@ -59,93 +85,150 @@ static alloc_root_t *root;
 /*
 **  AllocHdr()
 **
-**  Private routine to allocate a header and memory block.
+**  Private routine to allocate a header and a memory block
+**  of at least the given size.
 */
 
-static alloc_hdr_t *AllocHdr(void);
-                
-static alloc_hdr_t * AllocHdr()
+static alloc_hdr_t *AllocHdr(long);
+
+static alloc_hdr_t * AllocHdr(long size)
 {
     alloc_hdr_t     *hdr;
-    char            *block;
+    char            *block = NULL;
+    int             mapped = 0;
 
-    block = (char *) malloc(ALLOC_BLOCK_SIZE);
-    hdr   = (alloc_hdr_t *) malloc(sizeof(alloc_hdr_t));
+#ifdef ALLOC_USE_MMAP
+    if (size >= ALLOC_HUGE_PAGE)
+    {
+        size = (size + ALLOC_HUGE_PAGE - 1) / ALLOC_HUGE_PAGE * ALLOC_HUGE_PAGE;
+        block = (char *) mmap(NULL, size, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (block == (char *) MAP_FAILED) block = NULL;
+        else
+        {
+  #ifdef MADV_HUGEPAGE
+            madvise(block, size, MADV_HUGEPAGE);
+  #endif
+            mapped = 1;
+        }
+    }
+#endif
+    if (block == NULL) block = (char *) malloc(size);
+    hdr = (alloc_hdr_t *) malloc(sizeof(alloc_hdr_t));
 
-    if (hdr == NULL || block == NULL) return(NULL);
-    hdr->block = block;
-    hdr->free  = block;
-    hdr->next  = NULL;
-    hdr->end   = block + ALLOC_BLOCK_SIZE;
+    if (hdr == NULL || block == NULL)
+    {
+#ifdef ALLOC_USE_MMAP
+        if (mapped) munmap(block, size);
+        else
+#endif
+        free(block);
+        free(hdr);
+        return(NULL);
+    }
+    hdr->block  = block;
+    hdr->free   = block;
+    hdr->next   = NULL;
+    hdr->end    = block + size;
+    hdr->mapped = mapped;
 
     return(hdr);
 }
 
 
 /*
-**  AllocInit()
+**  AllocCreate()
 **
 **  Create a new memory pool with one block.
 **  Returns pointer to the new pool.
 */
 
-alloc_handle_t * AllocInit()
+alloc_handle_t * AllocCreate()
 {
-    alloc_handle_t *newpool;
+    alloc_root_t *pool;
 
-    root = (alloc_root_t *) malloc(sizeof(alloc_root_t));
-    if (root == NULL) return(NULL);
-    if ( (root->first = AllocHdr()) == NULL) return(NULL);
-    root->current = root->first;
-    newpool = (alloc_handle_t *) root;
-    return(newpool);
+    pool = (alloc_root_t *) malloc(sizeof(alloc_root_t));
+    if (pool == NULL) return(NULL);
+    if ( (pool->first = AllocHdr(ALLOC_BLOCK_SIZE)) == NULL)
+    {
+        free(pool);
+        return(NULL);
+    }
+    pool->current = pool->first;
+    pool->size = 2 * ALLOC_BLOCK_SIZE;
+    return((alloc_handle_t *) pool);
 }
 
 
 /*
-**  Alloc()
+**  AllocInit()
+**
+**  Create a new memory pool with one block and make it the current pool.
+**  Returns pointer to the new pool.
+*/
+
+alloc_handle_t * AllocInit()
+{
+    root = (alloc_root_t *) AllocCreate();
+    return((alloc_handle_t *) root);
+}
+
+
+/*
+**  AllocFrom()
 **
 **  Use as a direct replacement for malloc().  Allocates
-**  memory from the current pool.
+**  memory from the given pool.
 */
 
-char * Alloc(long size)
+char * AllocFrom(alloc_handle_t *handle, long size)
 {
-    alloc_hdr_t  *hdr = root->current;
+    alloc_root_t *pool = (alloc_root_t *) handle;
+    alloc_hdr_t  *hdr = pool->current;
+    alloc_hdr_t  *next;
     char         *ptr;
 
     /*
-    **  Align to 4 byte boundary - should be ok for most machines.
-    **  Change this if your machine has weird alignment requirements.
+    **  Align to 8 byte boundary - enough for doubles and pointers.
     */
-    size = (size + 3) & 0xfffffffc;
-
-    ptr = hdr->free;
-    hdr->free += size;
+    size = (size + 7) & ~7L;
 
-    /* Check if the current block is exhausted. */
+    /* Use the current block if the request fits in it. */
 
-    if (hdr->free >= hdr->end)
+    if (size <= hdr->end - hdr->free)
     {
-        /* Is the next block already allocated? */
+        ptr = hdr->free;
+        hdr->free += size;
+        return(ptr);
+    }
 
-        if (hdr->next != NULL)
-        {
-            /* re-use block */
-            hdr->next->free = hdr->next->block;
-            root->current = hdr->next;
-        }
+    /* Is the next block already allocated and large enough? */
+
+    next = hdr->next;
+    if (next != NULL && size <= next->end - next->block)
+    {
+        /* re-use block */
+        next->free = next->block;
+    }
+    else
+    {
+        /* insert a new block into the pool - a request that would fill
+           more than a quarter of it gets a block of its own */
+        if (4 * size > pool->size) next = AllocHdr(size);
         else
         {
-            /* extend the pool with a new block */
-            if ( (hdr->next = AllocHdr()) == NULL) return(NULL);
-            root->current = hdr->next;
+            next = AllocHdr(pool->size);
+            if (pool->size < ALLOC_MAX_BLOCK_SIZE) pool->size *= 2;
         }
-
-        /* set ptr to the first location in the next block */
-        ptr = root->current->free;
-        root->current->free += size;
+        if (next == NULL) return(NULL);
+        next->next = hdr->next;
+        hdr->next = next;
     }
+    pool->current = next;
+
+    /* set ptr to the first location in the next block */
+    ptr = next->free;
+    next->free += size;
 
     /* Return pointer to allocated memory. */
 
@@ -153,6 +236,19 @@ char * Alloc(long size)
 }
 
 
+/*
+**  Alloc()
+**
+**  Use as a direct replacement for malloc().  Allocates
+**  memory from the current pool.
+*/
+
+char * Alloc(long size)
+{
+    return(AllocFrom((alloc_handle_t *) root, size));
+}
+
+
 /*
 **  AllocSetPool()
 **
@@ -182,24 +278,43 @@ void  AllocReset()
 
 
 /*
-**  AllocFreePool()
+**  AllocDelete()
 **
-**  Free the memory used by the current pool.
-**  Don't use where AllocReset() could be used.
+**  Free the memory used by the given pool.
 */
 
-void  AllocFreePool()
+void  AllocDelete(alloc_handle_t *handle)
 {
+    alloc_root_t *pool = (alloc_root_t *) handle;
     alloc_hdr_t  *tmp,
-                 *hdr = root->first;
+                 *hdr;
 
+    if (pool == NULL) return;
+    hdr = pool->first;
     while (hdr != NULL)
     {
         tmp = hdr->next;
+#ifdef ALLOC_USE_MMAP
+        if (hdr->mapped) munmap(hdr->block, hdr->end - hdr->block);
+        else
+#endif
         free((char *) hdr->block);
         free((char *) hdr);
         hdr = tmp;
     }
-    free((char *) root);
+    free((char *) pool);
+}
+
+
+/*
+**  AllocFreePool()
+**
+**  Free the memory used by the current pool.
+**  Don't use where AllocReset() could be used.
+*/
+
+void  AllocFreePool()
+{
+    AllocDelete((alloc_handle_t *) root);
     root = NULL;
 }
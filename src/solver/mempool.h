@@ -17,3 +17,6 @@ char           *Alloc(long);
 alloc_handle_t *AllocSetPool(alloc_handle_t *);
 void            AllocReset(void);
 void            AllocFreePool(void);
+alloc_handle_t *AllocCreate(void);
+char           *AllocFrom(alloc_handle_t *, long);
+void            AllocDelete(alloc_handle_t *);
@@ -922,7 +922,7 @@ double storage_getLosses(int j, double tStep)
 
         // --- get node's evap. rate (ft/s) &  exfiltration object
         k = Node[j].subIndex;
-        evapRate = Evap.rate * Storage[k].fEvap;
+        evapRate = runoff_getEvapRate() * Storage[k].fEvap;                    //(5.1.015)
         exfil = Storage[k].exfil;
 
         // --- if either of these apply
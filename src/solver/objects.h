@@ -54,6 +54,14 @@
 //   - Adjustment patterns added to TSubcatch structure.
 //   - Members impervRunoff and pervRunoff added to TSubcatchStats structure.
 //   - Member cdCurve (weir coeff. curve) added to TWeir structure.
+//
+//   Build 5.1.015:
+//   - Compiled GW flow expressions added to TSubcatch structure.
+//   - TRunoffFrame structure added to hold the runoff results used by the
+//     routing and reporting processors.
+//   - TSnapshot type added for in-memory snapshots of simulation state.
+//   - TTable records where a time series' data lies in the input file and
+//     the period of dates loaded from it.
 //-----------------------------------------------------------------------------
 
 #include "mathexpr.h"
@@ -85,6 +93,18 @@ struct  TableEntry
 };
 typedef struct TableEntry TTableEntry;
 
+//------------------------------------------------
+// RUN OF INPUT FILE LINES HOLDING TIME SERIES DATA
+//------------------------------------------------
+struct  TableLines
+{
+   size_t  start;                      // offset of first line in input file
+   size_t  end;                        // offset just past last line
+   long    lineCount;                  // line number of first line
+   struct  TableLines* next;
+};
+typedef struct TableLines TTableLines;
+
 //-------------------------
 // CURVE/TIME SERIES OBJECT
 //-------------------------
@@ -101,6 +121,10 @@ typedef struct
    TTableEntry*  lastEntry;       // last data point
    TTableEntry*  thisEntry;       // current data point
    TFile         file;            // external data file
+   TTableLines*  firstLines;      // first run of input lines with data        //(5.1.015)
+   TTableLines*  lastLines;       // last run of input lines with data         //(5.1.015)
+   DateTime      loadStart;       // start of period of dates loaded           //(5.1.015)
+   DateTime      loadEnd;         // end of period of dates loaded             //(5.1.015)
 }  TTable;
 
 //-----------------
@@ -382,6 +406,8 @@ typedef struct
    TGroundwater* groundwater;     // associated groundwater data
    MathExpr*     gwLatFlowExpr;   // user-supplied lateral outflow expression
    MathExpr*     gwDeepFlowExpr;  // user-supplied deep percolation expression
+   MathExprCode* gwLatFlowCode;   // compiled lateral outflow expression
+   MathExprCode* gwDeepFlowCode;  // compiled deep percolation expression
    TSnowpack*    snowpack;        // associated snow pack data
    int           nPervPattern;    // pervious N pattern index                  //(5.1.013)
    int           dStorePattern;   // depression storage pattern index          //
@@ -404,6 +430,50 @@ typedef struct
    double*       surfaceBuildup;  // current surface buildup (mass)
 }  TSubcatch;
 
+//-----------------------
+// RUNOFF RESULTS FRAMES
+//-----------------------
+// Runoff results saved at the end of a runoff time step that the flow
+// routing and reporting processors use until the next step is taken.
+typedef struct
+{
+   double        oldRunoff;       // previous runoff rate (cfs)
+   double        newRunoff;       // current runoff rate (cfs)
+   double        oldSnowDepth;    // previous snow depth (ft)
+   double        newSnowDepth;    // current snow depth (ft)
+   double        evapLoss;        // current evap losses (ft/s)
+   double        infilLoss;       // current infil losses (ft/s)
+   double        oldLidDrain;     // previous LID drain flow (cfs)
+   double        newLidDrain;     // current LID drain flow (cfs)
+   double        oldGwFlow;       // previous GW flow (cfs/ft2)
+   double        newGwFlow;       // current GW flow (cfs/ft2)
+   double        gwElev;          // GW table elevation (ft)
+   double        gwTheta;         // GW upper zone moisture content
+   double        gwEvapLoss;      // GW evap losses (ft/s)
+   double*       oldQual;         // previous runoff quality (mass/L)
+   double*       newQual;         // current runoff quality (mass/L)
+   double*       lidDrains;       // prev. & current flows of LID unit drains
+}  TSubcatchFrame;
+
+typedef struct
+{
+   double        rainfall;        // current rainfall (in/hr or mm/hr)
+   double        nextRainfall;    // next rainfall (in/hr or mm/hr)
+   DateTime      endDate;         // end date of current rainfall
+   DateTime      nextDate;        // next date with recorded rainfall
+}  TGageFrame;
+
+typedef struct
+{
+   double          oldTime;       // previous runoff time (msec)
+   double          newTime;       // current runoff time (msec)
+   double          evapRate;      // evaporation rate (ft/s)
+   double          hydconFactor;  // hyd. conductivity adjustment factor
+   double          temperature;   // air temperature (deg F)
+   TSubcatchFrame* subcatch;      // results for each subcatchment
+   TGageFrame*     gage;          // rainfall state of each rain gage
+}  TRunoffFrame;
+
 //-----------------------
 // TIME PATTERN DATA
 //-----------------------
@@ -1064,3 +1134,8 @@ typedef struct
    char          Enabled;         // TRUE if appears in report table
    int           Precision;       // number of decimal places when reported
 }  TRptField;
+
+//--------------------------
+// SIMULATION STATE SNAPSHOT
+//--------------------------
+typedef SM_Snapshot TSnapshot;         // defined in snapshot.c
@@ -7,6 +7,11 @@
 //
 //   Date:     11/15/06
 //   Author:   L. Rossman
+//
+//   Build 5.1.015:
+//   - Work arrays gathered into a workspace structure and a reentrant
+//     version of the integrator that uses a caller-supplied workspace
+//     and passes a user data pointer to the derivative function added.
 //-----------------------------------------------------------------------------
 
 #include <stdlib.h>
@@ -24,21 +29,40 @@
 //-----------------------------------------------------------------------------
 //    Local declarations
 //-----------------------------------------------------------------------------
+typedef void (*DerivFunc)(double, double*, double*, void*);
+
+typedef struct
+{
+    double*  y;     // dependent variable
+    double*  yscal; // scaling factors
+    double*  yerr;  // integration errors
+    double*  ytemp; // temporary values of y
+    double*  dydx;  // derivatives of y
+    double*  ak;    // derivatives at intermediate points
+}   TOdeWork;
+
+typedef struct
+{
+    void (*derivs)(double, double*, double*);
+}   TLegacyDerivs;
+
 int      nmax;      // max. number of equations
-double*  y;         // dependent variable
-double*  yscal;     // scaling factors
-double*  yerr;      // integration errors
-double*  ytemp;     // temporary values of y
-double*  dydx;      // derivatives of y
-double*  ak;        // derivatives at intermediate points
+double*  work;      // work space used by odesolve_integrate
+
 
+// function that partitions a work space array into its work vectors
+static void setWork(TOdeWork* w, double* ws, int n);
+
+// function that adapts a legacy derivative function to a DerivFunc
+static void legacyDerivs(double x, double* y, double* dydx, void* data);
 
 // function that integrates over an error-controlled stepsize
-int rkqs(double* x, int n, double htry, double eps, double* hdid,
-         double* hnext, void (*derivs)(double, double*, double*));
+int rkqs(TOdeWork* w, double* x, int n, double htry, double eps, double* hdid,
+         double* hnext, DerivFunc derivs, void* data);
 
 // function that performs the Runge-Kutta integration step
-void rkck(double x, int n, double h, void (*derivs)(double, double*, double*));
+void rkck(TOdeWork* w, double x, int n, double h, DerivFunc derivs,
+          void* data);
 
 
 //-----------------------------------------------------------------------------
@@ -47,14 +71,9 @@ void rkck(double x, int n, double h, void (*derivs)(double, double*, double*));
 //-----------------------------------------------------------------------------
 int odesolve_open(int n)
 {
-    nmax  = 0;
-    y     = (double *) calloc(n, sizeof(double));
-    yscal = (double *) calloc(n, sizeof(double));
-    dydx  = (double *) calloc(n, sizeof(double));
-    yerr  = (double *) calloc(n, sizeof(double));
-    ytemp = (double *) calloc(n, sizeof(double));
-    ak    = (double *) calloc(5*n, sizeof(double));
-    if ( !y || !yscal || !dydx || !yerr || !ytemp || !ak ) return 0;
+    nmax = 0;
+    work = (double *) calloc(ODESOLVE_WORKSIZE(n), sizeof(double));
+    if ( !work ) return 0;
     nmax = n;
     return 1;
 }
@@ -65,18 +84,8 @@ int odesolve_open(int n)
 //-----------------------------------------------------------------------------
 void odesolve_close()
 {
-    if ( y ) free(y);
-    y = NULL;
-    if ( yscal ) free(yscal);
-    yscal = NULL;
-    if ( dydx ) free(dydx);
-    dydx = NULL;
-    if ( yerr ) free(yerr);
-    yerr = NULL;
-    if ( ytemp ) free(ytemp);
-    ytemp = NULL;
-    if ( ak ) free(ak);
-    ak = NULL;
+    if ( work ) free(work);
+    work = NULL;
     nmax = 0;
 }
 
@@ -91,24 +100,44 @@ int odesolve_integrate(double ystart[], int n, double x1, double x2,
 //   derivatives dy/dx of y. On completion, ystart[] contains the
 //   new values of y at the end of the integration interval.
 //---------------------------------------------------------------
+{
+    TLegacyDerivs f;
+    if (nmax < n) return 1;
+    f.derivs = derivs;
+    return odesolve_integrateEx(ystart, n, x1, x2, eps, h1, legacyDerivs,
+                                &f, work);
+}
+
+
+int odesolve_integrateEx(double ystart[], int n, double x1, double x2,
+      double eps, double h1, void (*derivs)(double, double*, double*, void*),
+      void* data, double ws[])
+//---------------------------------------------------------------
+//   Reentrant version of odesolve_integrate. The user data pointer
+//   is passed on to each call of derivs and ws[] is a caller-
+//   supplied work space of at least ODESOLVE_WORKSIZE(n) doubles,
+//   so concurrent integrations only need separate work spaces.
+//---------------------------------------------------------------
 {
     int    i, errcode, nstp;
     double hdid, hnext;
     double x = x1;
     double h = h1;
-    if (nmax < n) return 1;
-    for (i=0; i<n; i++) y[i] = ystart[i];
+    TOdeWork w;
+
+    setWork(&w, ws, n);
+    for (i=0; i<n; i++) w.y[i] = ystart[i];
     for (nstp=1; nstp<=MAXSTP; nstp++)
     {
-        derivs(x,y,dydx);
+        derivs(x,w.y,w.dydx,data);
         for (i=0; i<n; i++)
-            yscal[i] = fabs(y[i]) + fabs(dydx[i]*h) + TINY;
+            w.yscal[i] = fabs(w.y[i]) + fabs(w.dydx[i]*h) + TINY;
         if ((x+h-x2)*(x+h-x1) > 0.0) h = x2 - x;
-        errcode = rkqs(&x,n,h,eps,&hdid,&hnext,derivs);
+        errcode = rkqs(&w,&x,n,h,eps,&hdid,&hnext,derivs,data);
         if (errcode) break;
         if ((x-x2)*(x2-x1) >= 0.0)
         {
-            for (i=0; i<n; i++) ystart[i] = y[i];
+            for (i=0; i<n; i++) ystart[i] = w.y[i];
             return 0;
         }
         if (fabs(hnext) <= 0.0) return 2;
@@ -118,8 +147,28 @@ int odesolve_integrate(double ystart[], int n, double x1, double x2,
 }
 
 
-int rkqs(double* x, int n, double htry, double eps, double* hdid,
-         double* hnext, void (*derivs)(double, double*, double*))
+void setWork(TOdeWork* w, double* ws, int n)
+//---------------------------------------------------------------
+//   Partitions work space ws[] into the solver's work vectors.
+//---------------------------------------------------------------
+{
+    w->y     = ws;
+    w->yscal = ws + n;
+    w->yerr  = ws + 2*n;
+    w->ytemp = ws + 3*n;
+    w->dydx  = ws + 4*n;
+    w->ak    = ws + 5*n;
+}
+
+
+void legacyDerivs(double x, double* y, double* dydx, void* data)
+{
+    ((TLegacyDerivs *)data)->derivs(x, y, dydx);
+}
+
+
+int rkqs(TOdeWork* w, double* x, int n, double htry, double eps, double* hdid,
+         double* hnext, DerivFunc derivs, void* data)
 //---------------------------------------------------------------
 //   Fifth-order Runge-Kutta integration step with monitoring of
 //   local truncation error to assure accuracy and adjust stepsize.
@@ -136,13 +185,13 @@ int rkqs(double* x, int n, double htry, double eps, double* hdid,
     for (;;)
     {
         // --- take a Runge-Kutta-Cash-Karp step
-        rkck(xold, n, h, derivs);
+        rkck(w, xold, n, h, derivs, data);
 
         // --- compute scaled maximum error
         errmax = 0.0;
         for (i=0; i<n; i++)
         {
-            err = fabs(yerr[i]/yscal[i]);
+            err = fabs(w->yerr[i]/w->yscal[i]);
             if (err > errmax) errmax = err;
         }
         errmax /= eps;
@@ -172,14 +221,15 @@ int rkqs(double* x, int n, double htry, double eps, double* hdid,
             if (errmax > ERRCON) *hnext = SAFETY*h*pow(errmax,PGROW);
             else *hnext = 5.0*h;
             *x += (*hdid=h);
-            for (i=0; i<n; i++) y[i] = ytemp[i];
+            for (i=0; i<n; i++) w->y[i] = w->ytemp[i];
             return 0;
         }
     }
 }
 
 
-void rkck(double x, int n, double h, void (*derivs)(double, double*, double*))
+void rkck(TOdeWork* w, double x, int n, double h, DerivFunc derivs,
+          void* data)
 //----------------------------------------------------------------------
 //   Uses the Runge-Kutta-Cash-Karp method to advance y[] at x
 //   over stepsize h.
@@ -195,32 +245,36 @@ void rkck(double x, int n, double h, void (*derivs)(double, double*, double*))
     double dc1=c1-2825.0/27648.0, dc3=c3-18575.0/48384.0,
            dc4=c4-13525.0/55296.0, dc6=c6-0.25;
     int i;
-    double *ak2 = (ak);
-    double *ak3 = ((ak)+(n));
-    double *ak4 = ((ak)+(2*n));
-    double *ak5 = ((ak)+(3*n));
-    double *ak6 = ((ak)+(4*n));
+    double *y = w->y;
+    double *dydx = w->dydx;
+    double *ytemp = w->ytemp;
+    double *yerr = w->yerr;
+    double *ak2 = (w->ak);
+    double *ak3 = ((w->ak)+(n));
+    double *ak4 = ((w->ak)+(2*n));
+    double *ak5 = ((w->ak)+(3*n));
+    double *ak6 = ((w->ak)+(4*n));
 
     for (i=0; i<n; i++)
         ytemp[i] = y[i] + b21*h*dydx[i];
-    derivs(x+a2*h,ytemp,ak2);
+    derivs(x+a2*h,ytemp,ak2,data);
 
     for (i=0; i<n; i++)
         ytemp[i] = y[i] + h*(b31*dydx[i]+b32*ak2[i]);
-    derivs(x+a3*h,ytemp,ak3);
+    derivs(x+a3*h,ytemp,ak3,data);
 
     for (i=0; i<n; i++)
         ytemp[i] = y[i] + h*(b41*dydx[i]+b42*ak2[i] + b43*ak3[i]);
-    derivs(x+a4*h,ytemp,ak4);
+    derivs(x+a4*h,ytemp,ak4,data);
 
     for (i=0; i<n; i++)
         ytemp[i] = y[i] + h*(b51*dydx[i]+b52*ak2[i] + b53*ak3[i] + b54*ak4[i]);
-    derivs(x+a5*h,ytemp,ak5);
+    derivs(x+a5*h,ytemp,ak5,data);
 
     for (i=0; i<n; i++)
         ytemp[i] = y[i] + h*(b61*dydx[i]+b62*ak2[i] + b63*ak3[i] + b64*ak4[i]
                    + b65*ak5[i]);
-    derivs(x+a6*h,ytemp,ak6);
+    derivs(x+a6*h,ytemp,ak6,data);
 
     for (i=0; i<n; i++)
         ytemp[i] = y[i] + h*(c1*dydx[i] + c3*ak3[i] + c4*ak4[i] + c6*ak6[i]);
@@ -5,8 +5,16 @@
 //
 //-----------------------------------------------------------------------------
 
+// size of the work space needed to integrate a system of n equations
+#define ODESOLVE_WORKSIZE(n) (10*(n))
+
 // functions that open, close, and use the ODE solver
 int  odesolve_open(int n);
 void odesolve_close(void);
 int  odesolve_integrate(double ystart[], int n, double x1, double x2,
      double eps, double h1, void (*derivs)(double, double*, double*));
+
+// reentrant version of odesolve_integrate using a caller-supplied work space
+int  odesolve_integrateEx(double ystart[], int n, double x1, double x2,
+     double eps, double h1, void (*derivs)(double, double*, double*, void*),
+     void* data, double work[]);
@@ -28,12 +28,28 @@
 //   Build 5.1.014:
 //   - Incorrect loop limit fixed in function output_saveAvgResults.
 //
+//   Build 5.1.015:
+//   - Subcatchment results taken from the runoff frame being reported.
+//   - Compressed output format added, saving results in chunks of periods
+//     by blocks of result values with 64-bit file offsets.
+//   - Standard format results buffered into large aligned writes, made by
+//     a background thread when the simulation runs on several threads.
+//   - Each period's results gathered in parallel into a single array that
+//     is written in one piece, with system-wide results summed in element
+//     order.
+//   - Optional hash table index of element names saved after the names.
+//   - Results being averaged over a reporting period can be saved to and
+//     restored from a simulation state snapshot.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#if defined(_OPENMP)                                                           //(5.1.015)
+#include <omp.h>                                                               //
+#endif                                                                         //
 #include "headers.h"
 
 
@@ -41,6 +57,17 @@
 #define INT4  int
 #define REAL4 float
 #define REAL8 double
+#define INT8  long long                                                        //(5.1.015)
+
+// Compressed output format parameters                                         //(5.1.015)
+#define CHUNK_BYTES    33554432    // max. bytes of uncompressed chunk values  //
+#define CHUNK_PERIODS  512         // max. reporting periods per chunk         //
+#define CHUNK_COLUMNS  256         // result values per chunk                  //
+#define CHUNK_CODEC    1           // XOR delta + byte shuffle + run length    //
+#define WRITE_BYTES    1048576     // size of buffered writes to file (bytes)  //
+#define WRITE_BUFFERS  2           // number of write buffers                  //
+#define SUBCATCH_TERMS 6           // subcatch contributions to system results //
+#define NAME_MAGIC     516114531   // identifies an index of element names     //
 
 enum InputDataType {INPUT_TYPE_CODE, INPUT_AREA, INPUT_INVERT, INPUT_MAX_DEPTH,
                     INPUT_OFFSET, INPUT_LENGTH};
@@ -50,6 +77,12 @@ typedef struct                                                                 /
     REAL4* xAvg;                                                               //
 }   TAvgResults;                                                               //
 
+typedef struct                                                                 //(5.1.015)
+{                                                                              //
+    INT8  offset;                   // file position of compressed chunk       //
+    INT8  size;                     // size of compressed chunk (bytes)        //
+}   TChunkEntry;                                                               //
+
 //-----------------------------------------------------------------------------
 //  Shared variables    
 //-----------------------------------------------------------------------------
@@ -70,6 +103,46 @@ static TAvgResults* AvgLinkResults;                                            /
 static TAvgResults* AvgNodeResults;                                            //
 static int          Nsteps;                                                    //
 
+static int           NumColumns;     // # result values saved per period       //(5.1.015)
+static int           ChunkPeriods;   // # reporting periods per chunk          //
+static int           ChunkBlocks;    // # blocks of result values per period   //
+static int           ChunkCount;     // # periods held in current chunk        //
+static int           ChunkRows;      // # rows of chunks saved to file         //
+static REAL4*        ChunkValues;    // values of current chunk periods        //
+static REAL4*        PeriodValues;   // values of period being saved           //
+static int           PeriodPos;      // # values saved for current period      //
+static int*          SubcatchColumn; // position of each element's values      //
+static int*          NodeColumn;     //   within its period section (-1 if     //
+static int*          LinkColumn;     //   element is not reported on)          //
+static REAL4*        SysTerms;       // element contributions to SysResults    //
+static REAL4*        ScratchValues;  // per-thread values of unlisted elements //
+static int           ScratchSize;    // # scratch values per thread            //
+static REAL8*        PeriodDates;    // dates of all saved periods             //
+static int           DateCapacity;   // size of PeriodDates array              //
+static TChunkEntry*  ChunkIndex;     // file location of each chunk            //
+static int           IndexCapacity;  // size of ChunkIndex array               //
+static INT8          NextChunkPos;   // file position of next chunk            //
+static unsigned int* CodecWords;     // codec work arrays                      //
+static unsigned char* CodecBytes;                                              //
+static unsigned char* CodecPacked;                                             //
+static REAL4*        CachedValues;   // decoded chunk read back from file      //
+static int           CachedChunk;    // index of decoded chunk                 //
+
+static char*  WriteBuffers[WRITE_BUFFERS]; // buffers of results to write      //(5.1.015)
+static int    WriteSizes[WRITE_BUFFERS];   // # bytes held in each buffer      //
+static int    WritePos;             // # bytes held in buffer being filled     //
+static int    WriteLimit;           // # bytes that fill the current buffer    //
+static int    BuffersFilled;        // # buffers handed off for writing        //
+static int    BuffersWritten;       // # buffers written to file               //
+static int    WriteFailed;          // TRUE if a buffer failed to be written   //
+static int    Threaded;             // TRUE if writer thread writes buffers    //
+static int    HasWriter;            // TRUE if writer lock was created         //
+static int    WriterDone;           // TRUE if no more buffers handed off      //
+#if defined(_OPENMP)                                                           //
+static omp_lock_t WriteLock;        // guards buffer counters                  //
+static int    MaxActiveLevels;      // saved OpenMP nesting level              //
+#endif                                                                         //
+
 //-----------------------------------------------------------------------------
 //  Exportable variables (shared with report.c)
 //-----------------------------------------------------------------------------
@@ -83,14 +156,38 @@ REAL4*           LinkResults;
 //-----------------------------------------------------------------------------
 static void output_openOutFile(void);
 static void output_saveID(char* id, FILE* file);
-static void output_saveSubcatchResults(double reportTime, FILE* file);
-static void output_saveNodeResults(double reportTime, FILE* file);
-static void output_saveLinkResults(double reportTime, FILE* file);
+static void output_saveSubcatchResults(double reportTime);
+static void output_saveNodeResults(double reportTime);
+static void output_saveLinkResults(double reportTime);
 
 static int  output_openAvgResults(void);                                       //(5.1.013)
 static void output_closeAvgResults(void);                                      //
 static void output_initAvgResults(void);                                       //
-static void output_saveAvgResults(FILE* file);                                 //
+static void output_saveAvgResults(void);                                       //
+
+static int  output_openPeriod(void);                                           //(5.1.015)
+static void output_closePeriod(void);                                          //
+static REAL4* output_getResultsPtr(int column);                                //
+static int  output_openChunks(void);                                           //
+static void output_closeChunks(void);                                          //
+static void output_putValues(REAL4* x, int n);                                 //
+static void output_endPeriod(REAL8 date);                                      //
+static int  output_saveChunks(void);                                           //
+static void output_endChunks(void);                                            //
+static void output_readValues(int period, int column, int n, REAL4* x);        //
+static int  output_seek(FILE* file, INT8 pos);                                 //
+static int  encodeChunk(REAL4* x, int stride, int n, int m);                   //
+static int  decodeChunk(int size, int n, int m, REAL4* x);                     //
+
+static int  output_openBuffers(void);                                          //(5.1.015)
+static void output_closeBuffers(void);                                         //
+static void output_putBytes(void* x, int n);                                   //
+static void output_flushBuffer(void);                                          //
+static void output_writeBuffer(int i);                                         //
+static void output_waitForBuffer(void);                                        //
+
+static int  output_saveNameIndex(void);                                        //(5.1.015)
+static unsigned int output_hashName(char* name);                               //
 
 
 //-----------------------------------------------------------------------------
@@ -106,6 +203,10 @@ static void output_saveAvgResults(FILE* file);                                 /
 //  output_readSubcatchResults    (called by report_Subcatchments)
 //  output_readNodeResults        (called by report_Nodes)
 //  output_readLinkResults        (called by report_Links)
+//  output_startWriter            (called by swmm_run_cb in toolkit.c)         //(5.1.015)
+//  output_execWriter             (called by swmm_run_cb in toolkit.c)         //
+//  output_stopWriter             (called by swmm_run_cb in toolkit.c)         //
+//  output_snapshot               (called by visitState in snapshot.c)         //
 
 
 //=============================================================================
@@ -179,6 +280,15 @@ int output_open()
         return ErrorCode;                                                      //
     }                                                                          //
 
+    // --- allocate memory to gather period results & assemble compressed      //(5.1.015)
+    //     chunks of results                                                   //
+    if ( !output_openPeriod() || !output_openChunks() ||                       //
+         !output_openBuffers() )                                               //
+    {                                                                          //
+        report_writeErrorMsg(ERR_MEMORY, "");                                  //
+        return ErrorCode;                                                      //
+    }                                                                          //
+
     fseek(Fout.file, 0, SEEK_SET);
     k = MAGICNUMBER;
     fwrite(&k, sizeof(INT4), 1, Fout.file);   // Magic number
@@ -211,6 +321,13 @@ int output_open()
     }
     for (j=0; j<NumPolluts; j++) output_saveID(Pollut[j].ID, Fout.file);
 
+    // --- save hash table index of ID names                                   //(5.1.015)
+    if ( OutputNameIndex && !output_saveNameIndex() )                          //
+    {                                                                          //
+        report_writeErrorMsg(ERR_MEMORY, "");                                  //
+        return ErrorCode;                                                      //
+    }                                                                          //
+
     // --- save codes of pollutant concentration units
     for (j=0; j<NumPolluts; j++)
     {
@@ -386,6 +503,8 @@ int output_open()
         return ErrorCode;
     }
     OutputStartPos = ftell(Fout.file);
+    NextChunkPos = OutputStartPos;                                             //(5.1.015)
+    WriteLimit = WRITE_BYTES - OutputStartPos % WRITE_BYTES;                   //(5.1.015)
     if ( Fout.mode == SCRATCH_FILE ) output_checkFileSize();
     return ErrorCode;
 }
@@ -400,6 +519,7 @@ void  output_checkFileSize()
 //           to access using an integer file pointer variable.
 //
 {
+    if ( OutputFormat == COMPRESSED_OUTPUT ) return;                           //(5.1.015)
     if ( RptFlags.subcatchments != NONE ||
          RptFlags.nodes != NONE ||
          RptFlags.links != NONE )
@@ -463,22 +583,22 @@ void output_saveResults(double reportTime)
 
     // --- save date corresponding to this elapsed reporting time
     date = reportDate;
-    fwrite(&date, sizeof(REAL8), 1, Fout.file);
+    PeriodPos = 0;                                                             //(5.1.015)
 
     // --- save subcatchment results
     if (Nobjects[SUBCATCH] > 0)
-        output_saveSubcatchResults(reportTime, Fout.file);
+        output_saveSubcatchResults(reportTime);
 
     // --- save average routing results over reporting period if called for    //(5.1.013)
-    if ( RptFlags.averages ) output_saveAvgResults(Fout.file);                 //
+    if ( RptFlags.averages ) output_saveAvgResults();                          //
 
     // --- otherwise save interpolated point routing results                   //(5.1.013)
     else                                                                       //
     {
         if (Nobjects[NODE] > 0)
-            output_saveNodeResults(reportTime, Fout.file);
+            output_saveNodeResults(reportTime);
         if (Nobjects[LINK] > 0)
-            output_saveLinkResults(reportTime, Fout.file);
+            output_saveLinkResults(reportTime);
     }
 
     // --- update & save system-wide flows 
@@ -493,7 +613,15 @@ void output_saveResults(double reportTime)
                              SysResults[SYS_GWFLOW] +
                              SysResults[SYS_IIFLOW] +
                              SysResults[SYS_EXFLOW];
-    fwrite(SysResults, sizeof(REAL4), MAX_SYS_RESULTS, Fout.file);
+    output_putValues(SysResults, MAX_SYS_RESULTS);                             //(5.1.015)
+
+    // --- write the period's date & values to file                            //(5.1.015)
+    if ( OutputFormat == STANDARD_OUTPUT )                                     //
+    {                                                                          //
+        output_putBytes(&date, sizeof(REAL8));                                 //
+        output_putBytes(PeriodValues, PeriodPos * sizeof(REAL4));              //
+    }                                                                          //
+    else output_endPeriod(date);                                               //
 
     // --- save outfall flows to interface file if called for
     if ( Foutflows.mode == SAVE_FILE && !IgnoreRouting ) 
@@ -511,6 +639,25 @@ void output_end()
 //
 {
     INT4 k;
+    if ( OutputFormat == COMPRESSED_OUTPUT )                                   //(5.1.015)
+    {                                                                          //
+        output_endChunks();                                                    //
+        return;                                                                //
+    }                                                                          //
+#if defined(_OPENMP)                                                           //(5.1.015)
+    if ( HasWriter )                                                           //
+    {                                                                          //
+        omp_destroy_lock(&WriteLock);                                          //
+        omp_set_max_active_levels(MaxActiveLevels);                            //
+        HasWriter = FALSE;                                                     //
+    }                                                                          //
+#endif                                                                         //
+    output_flushBuffer();                                                      //
+    if ( WriteFailed )                                                         //
+    {                                                                          //
+        report_writeErrorMsg(ERR_OUT_WRITE, "");                               //
+        return;                                                                //
+    }                                                                          //
     fwrite(&IDStartPos, sizeof(INT4), 1, Fout.file);
     fwrite(&InputStartPos, sizeof(INT4), 1, Fout.file);
     fwrite(&OutputStartPos, sizeof(INT4), 1, Fout.file);
@@ -538,6 +685,9 @@ void output_close()
     FREE(NodeResults);
     FREE(LinkResults);
     output_closeAvgResults();                                                  //(5.1.013)
+    output_closePeriod();                                                      //(5.1.015)
+    output_closeChunks();                                                      //(5.1.015)
+    output_closeBuffers();                                                     //(5.1.015)
 }
 
 //=============================================================================
@@ -557,19 +707,21 @@ void output_saveID(char* id, FILE* file)
 
 //=============================================================================
 
-void output_saveSubcatchResults(double reportTime, FILE* file)
+void output_saveSubcatchResults(double reportTime)
 //
 //  Input:   reportTime = elapsed simulation time (millisec)
-//           file = ptr. to binary output file
 //  Output:  none
-//  Purpose: writes computed subcatchment results to binary file.
+//  Purpose: saves computed subcatchment results to the period's values.
 //
 {
     int      j;
     double   f;
     double   area;
     REAL4    totalArea = 0.0f; 
+    REAL4*   x;                                                                //(5.1.015)
+    REAL4*   t;                                                                //(5.1.015)
     DateTime reportDate = getDateTime(reportTime);
+    TRunoffFrame* frame = runoff_getFrame();                                   //(5.1.015)
 
     // --- update reported rainfall at each rain gage
     for ( j=0; j<Nobjects[GAGE]; j++ )
@@ -578,30 +730,43 @@ void output_saveSubcatchResults(double reportTime, FILE* file)
     }
 
     // --- find where current reporting time lies between latest runoff times
-    f = (reportTime - OldRunoffTime) / (NewRunoffTime - OldRunoffTime);
+    f = (reportTime - frame->oldTime) / (frame->newTime - frame->oldTime);     //(5.1.015)
 
-    // --- write subcatchment results to file
+    // --- retrieve interpolated results for reporting time & each           //(5.1.015)
+    //     subcatchment's contributions to system-wide results in parallel    //
+#pragma omp parallel num_threads(NumThreads) private(x, t, area)              //(5.1.015)
+{
+    #pragma omp for
     for ( j=0; j<Nobjects[SUBCATCH]; j++)
     {
-        // --- retrieve interpolated results for reporting time & write to file
-        subcatch_getResults(j, f, SubcatchResults);
-        if ( Subcatch[j].rptFlag )
-            fwrite(SubcatchResults, sizeof(REAL4), NumSubcatchVars, file);
+        x = output_getResultsPtr(SubcatchColumn[j]);                           //(5.1.015)
+        subcatch_getResults(j, f, x);
+
+        area = Subcatch[j].area * UCF(LANDAREA);
+        t = &SysTerms[j * SUBCATCH_TERMS];                                     //(5.1.015)
+        t[0] = (REAL4)(x[SUBCATCH_RAINFALL] * area);                           //
+        t[1] = (REAL4)(x[SUBCATCH_SNOWDEPTH] * area);                          //
+        t[2] = (REAL4)(x[SUBCATCH_EVAP] * area);                               //
+        if ( Subcatch[j].groundwater ) t[3] =                                  //
+            (REAL4)(frame->subcatch[j].gwEvapLoss * UCF(EVAPRATE) * area);     //
+        t[4] = (REAL4)(x[SUBCATCH_INFIL] * area);                              //
+        t[5] = (REAL4)x[SUBCATCH_RUNOFF];                                      //
+    }
+}
+    PeriodPos += NumSubcatch * NumSubcatchVars;                                //(5.1.015)
 
-        // --- update system-wide results
+    // --- update system-wide results in subcatchment order                   //(5.1.015)
+    for ( j=0; j<Nobjects[SUBCATCH]; j++)
+    {
         area = Subcatch[j].area * UCF(LANDAREA);
         totalArea += (REAL4)area;
-        SysResults[SYS_RAINFALL] +=
-            (REAL4)(SubcatchResults[SUBCATCH_RAINFALL] * area);
-        SysResults[SYS_SNOWDEPTH] +=
-            (REAL4)(SubcatchResults[SUBCATCH_SNOWDEPTH] * area);
-        SysResults[SYS_EVAP] +=
-            (REAL4)(SubcatchResults[SUBCATCH_EVAP] * area);
-        if ( Subcatch[j].groundwater ) SysResults[SYS_EVAP] += 
-            (REAL4)(Subcatch[j].groundwater->evapLoss * UCF(EVAPRATE) * area);
-        SysResults[SYS_INFIL] +=
-            (REAL4)(SubcatchResults[SUBCATCH_INFIL] * area);
-        SysResults[SYS_RUNOFF] += (REAL4)SubcatchResults[SUBCATCH_RUNOFF];
+        t = &SysTerms[j * SUBCATCH_TERMS];                                     //(5.1.015)
+        SysResults[SYS_RAINFALL] += t[0];                                      //
+        SysResults[SYS_SNOWDEPTH] += t[1];                                     //
+        SysResults[SYS_EVAP] += t[2];                                          //
+        if ( Subcatch[j].groundwater ) SysResults[SYS_EVAP] += t[3];           //
+        SysResults[SYS_INFIL] += t[4];                                         //
+        SysResults[SYS_RUNOFF] += t[5];                                        //
     }
 
     // --- normalize system-wide results to catchment area
@@ -614,10 +779,10 @@ void output_saveSubcatchResults(double reportTime, FILE* file)
     }
 
     // --- update system temperature and PET
-    if ( UnitSystem == SI ) f = (5./9.) * (Temp.ta - 32.0);
-    else f = Temp.ta;
+    if ( UnitSystem == SI ) f = (5./9.) * (frame->temperature - 32.0);        //(5.1.015)
+    else f = frame->temperature;                                               //(5.1.015)
     SysResults[SYS_TEMPERATURE] = (REAL4)f;
-    f = Evap.rate * UCF(EVAPRATE);
+    f = frame->evapRate * UCF(EVAPRATE);                                       //(5.1.015)
     SysResults[SYS_PET] = (REAL4)f;
 
 }
@@ -626,42 +791,48 @@ void output_saveSubcatchResults(double reportTime, FILE* file)
 
 ////  This function was re-written for release 5.1.013.  ////                  //(5.1.013)
 
-void output_saveNodeResults(double reportTime, FILE* file)
+void output_saveNodeResults(double reportTime)
 //
 //  Input:   reportTime = elapsed simulation time (millisec)
-//           file = ptr. to binary output file
 //  Output:  none
-//  Purpose: writes computed node results to binary file.
+//  Purpose: saves computed node results to the period's values.
 //
 {
     int j;
+    REAL4* x;                                                                  //(5.1.015)
 
     // --- find where current reporting time lies between latest routing times
     double f = (reportTime - OldRoutingTime) /
                (NewRoutingTime - OldRoutingTime);
 
-    // --- write node results to file
+    // --- retrieve interpolated results for reporting time in parallel       //(5.1.015)
+#pragma omp parallel num_threads(NumThreads) private(x)                       //(5.1.015)
+{
+    #pragma omp for
     for (j=0; j<Nobjects[NODE]; j++)
     {
-        // --- retrieve interpolated results for reporting time & write to file
-        node_getResults(j, f, NodeResults);
-        if ( Node[j].rptFlag )
-            fwrite(NodeResults, sizeof(REAL4), NumNodeVars, file);
-        stats_updateMaxNodeDepth(j, NodeResults[NODE_DEPTH]);
+        x = output_getResultsPtr(NodeColumn[j]);                               //(5.1.015)
+        node_getResults(j, f, x);
+        stats_updateMaxNodeDepth(j, x[NODE_DEPTH]);
+        SysTerms[j] = x[NODE_VOLUME];                                          //(5.1.015)
+    }
+}
+    PeriodPos += NumNodes * NumNodeVars;                                       //(5.1.015)
 
-        // --- update system-wide storage volume 
-        SysResults[SYS_STORAGE] += NodeResults[NODE_VOLUME];
+    // --- update system-wide storage volume in node order                    //(5.1.015)
+    for (j=0; j<Nobjects[NODE]; j++)
+    {
+        SysResults[SYS_STORAGE] += SysTerms[j];                                //(5.1.015)
     }
 }
 
 //=============================================================================
 
-void output_saveLinkResults(double reportTime, FILE* file)
+void output_saveLinkResults(double reportTime)
 //
 //  Input:   reportTime = elapsed simulation time (millisec)
-//           file = ptr. to binary output file
 //  Output:  none
-//  Purpose: writes computed link results to binary file.
+//  Purpose: saves computed link results to the period's values.
 //
 {
     int j;
@@ -671,19 +842,26 @@ void output_saveLinkResults(double reportTime, FILE* file)
     // --- find where current reporting time lies between latest routing times
     f = (reportTime - OldRoutingTime) / (NewRoutingTime - OldRoutingTime);
 
-    // --- write link results to file
+    // --- retrieve interpolated results for reporting time in parallel       //(5.1.015)
+#pragma omp parallel num_threads(NumThreads) private(z)                       //(5.1.015)
+{
+    #pragma omp for
     for (j=0; j<Nobjects[LINK]; j++)
     {
-        // --- retrieve interpolated results for reporting time & write to file
         if (Link[j].rptFlag)
         {
-            link_getResults(j, f, LinkResults);
-            fwrite(LinkResults, sizeof(REAL4), NumLinkVars, file);
+            link_getResults(j, f, &PeriodValues[PeriodPos + LinkColumn[j]]);   //(5.1.015)
         }
-
-        // --- update system-wide results
         z = ((1.0-f)*Link[j].oldVolume + f*Link[j].newVolume) * UCF(VOLUME);
-        SysResults[SYS_STORAGE] += (REAL4)z;
+        SysTerms[j] = (REAL4)z;                                                //(5.1.015)
+    }
+}
+    PeriodPos += NumLinks * NumLinkVars;                                       //(5.1.015)
+
+    // --- update system-wide storage volume in link order                    //(5.1.015)
+    for (j=0; j<Nobjects[LINK]; j++)
+    {
+        SysResults[SYS_STORAGE] += SysTerms[j];                                //(5.1.015)
     }
 }
 
@@ -698,6 +876,12 @@ void output_readDateTime(int period, DateTime* days)
 //
 {
     INT4 bytePos = OutputStartPos + (period-1)*BytesPerPeriod;
+    if ( OutputFormat == COMPRESSED_OUTPUT )                                   //(5.1.015)
+    {                                                                          //
+        if ( period >= 1 && period <= Nperiods ) *days = PeriodDates[period-1];//
+        else *days = NO_DATE;                                                  //
+        return;                                                                //
+    }                                                                          //
     fseek(Fout.file, bytePos, SEEK_SET);
     *days = NO_DATE;
     fread(days, sizeof(REAL8), 1, Fout.file);
@@ -716,6 +900,12 @@ void output_readSubcatchResults(int period, int index)
 {
     INT4 bytePos = OutputStartPos + (period-1)*BytesPerPeriod;
     bytePos += sizeof(REAL8) + index*NumSubcatchVars*sizeof(REAL4);
+    if ( OutputFormat == COMPRESSED_OUTPUT )                                   //(5.1.015)
+    {                                                                          //
+        output_readValues(period-1, index*NumSubcatchVars, NumSubcatchVars,    //
+                          SubcatchResults);                                    //
+        return;                                                                //
+    }                                                                          //
     fseek(Fout.file, bytePos, SEEK_SET);
     fread(SubcatchResults, sizeof(REAL4), NumSubcatchVars, Fout.file);
 }
@@ -733,6 +923,12 @@ void output_readNodeResults(int period, int index)
     INT4 bytePos = OutputStartPos + (period-1)*BytesPerPeriod;
     bytePos += sizeof(REAL8) + NumSubcatch*NumSubcatchVars*sizeof(REAL4);
     bytePos += index*NumNodeVars*sizeof(REAL4);
+    if ( OutputFormat == COMPRESSED_OUTPUT )                                   //(5.1.015)
+    {                                                                          //
+        output_readValues(period-1, NumSubcatch*NumSubcatchVars +              //
+                          index*NumNodeVars, NumNodeVars, NodeResults);        //
+        return;                                                                //
+    }                                                                          //
     fseek(Fout.file, bytePos, SEEK_SET);
     fread(NodeResults, sizeof(REAL4), NumNodeVars, Fout.file);
 }
@@ -751,6 +947,13 @@ void output_readLinkResults(int period, int index)
     bytePos += sizeof(REAL8) + NumSubcatch*NumSubcatchVars*sizeof(REAL4);
     bytePos += NumNodes*NumNodeVars*sizeof(REAL4);
     bytePos += index*NumLinkVars*sizeof(REAL4);
+    if ( OutputFormat == COMPRESSED_OUTPUT )                                   //(5.1.015)
+    {                                                                          //
+        output_readValues(period-1, NumSubcatch*NumSubcatchVars +              //
+                          NumNodes*NumNodeVars + index*NumLinkVars,            //
+                          NumLinkVars, LinkResults);                           //
+        return;                                                                //
+    }                                                                          //
     fseek(Fout.file, bytePos, SEEK_SET);
     fread(LinkResults, sizeof(REAL4), NumLinkVars, Fout.file);
     fread(SysResults, sizeof(REAL4), MAX_SYS_RESULTS, Fout.file);
@@ -902,7 +1105,7 @@ void output_updateAvgResults()
 
 //=============================================================================
 
-void output_saveAvgResults(FILE* file)
+void output_saveAvgResults()
 {
     int i, j;
 
@@ -916,7 +1119,7 @@ void output_saveAvgResults(FILE* file)
         }
 
         // --- save average results to file
-        fwrite(NodeResults, sizeof(REAL4), NumNodeVars, file);
+        output_putValues(NodeResults, NumNodeVars);                            //(5.1.015)
     }
 
     // --- update each node's max depth and contribution to system storage
@@ -936,7 +1139,7 @@ void output_saveAvgResults(FILE* file)
         }
 
         // --- save average results to file
-        fwrite(LinkResults, sizeof(REAL4), NumLinkVars, file);
+        output_putValues(LinkResults, NumLinkVars);                            //(5.1.015)
     }
  
     // --- add each link's volume to total system storage
@@ -948,3 +1151,901 @@ void output_saveAvgResults(FILE* file)
     // --- re-initialize average results for all nodes and links
     output_initAvgResults();
 }
+
+//=============================================================================
+
+////  The following functions were added for release 5.1.015.  ////            //(5.1.015)
+
+//=============================================================================
+//  Functions for gathering the results of a reporting period.
+//
+//  Each element's results are retrieved directly into its place in the
+//  period's array of values, with elements processed in parallel. An
+//  element's contributions to the system-wide results are saved in SysTerms
+//  and summed afterwards in element order, so that SysResults does not
+//  depend on the number of threads used.
+//=============================================================================
+
+int output_openPeriod()
+//
+//  Input:   none
+//  Output:  returns TRUE if successful, FALSE if not
+//  Purpose: allocates memory used to gather a reporting period's results.
+//
+{
+    int j, k, n;
+
+    PeriodValues = NULL;
+    SubcatchColumn = NULL;
+    NodeColumn = NULL;
+    LinkColumn = NULL;
+    SysTerms = NULL;
+    ScratchValues = NULL;
+
+    // --- allocate arrays
+    NumColumns = NumSubcatch * NumSubcatchVars + NumNodes * NumNodeVars +
+                 NumLinks * NumLinkVars + MAX_SYS_RESULTS;
+    n = MAX(SUBCATCH_TERMS * Nobjects[SUBCATCH], Nobjects[NODE]);
+    n = MAX(n, Nobjects[LINK]);
+    ScratchSize = MAX(NumSubcatchVars, NumNodeVars);
+    PeriodValues = (REAL4 *) calloc(NumColumns, sizeof(REAL4));
+    SubcatchColumn = (int *) calloc(Nobjects[SUBCATCH] + 1, sizeof(int));
+    NodeColumn = (int *) calloc(Nobjects[NODE] + 1, sizeof(int));
+    LinkColumn = (int *) calloc(Nobjects[LINK] + 1, sizeof(int));
+    SysTerms = (REAL4 *) calloc(n + 1, sizeof(REAL4));
+    ScratchValues = (REAL4 *) calloc(ScratchSize * MAX(NumThreads, 1),
+                                     sizeof(REAL4));
+    if ( !PeriodValues || !SubcatchColumn || !NodeColumn || !LinkColumn ||
+         !SysTerms || !ScratchValues ) return FALSE;
+
+    // --- find where each element's results lie within its period section
+    k = 0;
+    for (j=0; j<Nobjects[SUBCATCH]; j++)
+    {
+        if ( Subcatch[j].rptFlag ) SubcatchColumn[j] = NumSubcatchVars * k++;
+        else SubcatchColumn[j] = -1;
+    }
+    k = 0;
+    for (j=0; j<Nobjects[NODE]; j++)
+    {
+        if ( Node[j].rptFlag ) NodeColumn[j] = NumNodeVars * k++;
+        else NodeColumn[j] = -1;
+    }
+    k = 0;
+    for (j=0; j<Nobjects[LINK]; j++)
+    {
+        if ( Link[j].rptFlag ) LinkColumn[j] = NumLinkVars * k++;
+        else LinkColumn[j] = -1;
+    }
+    return TRUE;
+}
+
+//=============================================================================
+
+void output_closePeriod()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees memory used to gather a reporting period's results.
+//
+{
+    FREE(PeriodValues);
+    FREE(SubcatchColumn);
+    FREE(NodeColumn);
+    FREE(LinkColumn);
+    FREE(SysTerms);
+    FREE(ScratchValues);
+}
+
+//=============================================================================
+
+REAL4* output_getResultsPtr(int column)
+//
+//  Input:   column = position of an element's results within the current
+//                    period section (-1 if element is not reported on)
+//  Output:  returns a pointer to where the element's results are retrieved
+//  Purpose: finds where to place an element's results for the current period.
+//
+{
+    int i = 0;
+
+    if ( column >= 0 ) return &PeriodValues[PeriodPos + column];
+#if defined(_OPENMP)
+    i = omp_get_thread_num();
+#endif
+    return &ScratchValues[i * ScratchSize];
+}
+
+//=============================================================================
+
+void output_putValues(REAL4* x, int n)
+//
+//  Input:   x = array of result values
+//           n = number of values
+//  Output:  none
+//  Purpose: adds result values to the current reporting period's values.
+//
+{
+    memcpy(&PeriodValues[PeriodPos], x, n * sizeof(REAL4));
+    PeriodPos += n;
+}
+
+//=============================================================================
+//  Functions for saving results in the compressed output format.
+//
+//  Results are saved in chunks of up to ChunkPeriods reporting periods by
+//  CHUNK_COLUMNS result values. Each chunk stores its values column by
+//  column, XORs each value with the one before it in its column, splits the
+//  resulting words into byte planes and run-length encodes the planes.
+//  Period dates and the file position of every chunk are written after the
+//  last chunk, followed by a fixed-size epilogue with 64-bit file offsets:
+//    IDStartPos, InputStartPos, OutputStartPos, IndexPos (INT8 each),
+//    ChunkPeriods, CHUNK_COLUMNS, CHUNK_CODEC, Nperiods, error code and
+//    MAGICNUMBER2 (INT4 each).
+//
+//  CHUNK_CODEC identifies how chunks are compressed. Codec 1, the one
+//  described above, is the only one implemented and needs no external
+//  library. Other codec ids (such as for LZ4 or zstd compressed chunks)
+//  are reserved; readers reject files that name a codec they do not know.
+//=============================================================================
+
+int output_openChunks()
+//
+//  Input:   none
+//  Output:  returns TRUE if successful, FALSE if not
+//  Purpose: allocates memory used to assemble compressed chunks of results.
+//
+{
+    int n;
+
+    ChunkValues = NULL;
+    PeriodDates = NULL;
+    ChunkIndex = NULL;
+    CodecWords = NULL;
+    CodecBytes = NULL;
+    CodecPacked = NULL;
+    CachedValues = NULL;
+    CachedChunk = -1;
+    ChunkCount = 0;
+    ChunkRows = 0;
+    DateCapacity = 0;
+    IndexCapacity = 0;
+    if ( OutputFormat != COMPRESSED_OUTPUT ) return TRUE;
+
+    // --- determine chunk dimensions
+    ChunkBlocks = (NumColumns + CHUNK_COLUMNS - 1) / CHUNK_COLUMNS;
+    ChunkPeriods = CHUNK_BYTES / (NumColumns * (int)sizeof(REAL4));
+    ChunkPeriods = MAX(1, MIN(ChunkPeriods, CHUNK_PERIODS));
+
+    // --- allocate chunk value array and codec work arrays
+    n = ChunkPeriods * CHUNK_COLUMNS;
+    ChunkValues = (REAL4 *) calloc((size_t)ChunkPeriods * NumColumns,
+                                   sizeof(REAL4));
+    CodecWords = (unsigned int *) calloc(n, sizeof(unsigned int));
+    CodecBytes = (unsigned char *) calloc(4 * n, sizeof(unsigned char));
+    CodecPacked = (unsigned char *) calloc(4 * n + 4 * n / 128 + 16,
+                                           sizeof(unsigned char));
+    CachedValues = (REAL4 *) calloc(n, sizeof(REAL4));
+    if ( !ChunkValues || !CodecWords || !CodecBytes ||
+         !CodecPacked || !CachedValues ) return FALSE;
+    return TRUE;
+}
+
+//=============================================================================
+
+void output_closeChunks()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees memory used to assemble compressed chunks of results.
+//
+{
+    FREE(ChunkValues);
+    FREE(PeriodDates);
+    FREE(ChunkIndex);
+    FREE(CodecWords);
+    FREE(CodecBytes);
+    FREE(CodecPacked);
+    FREE(CachedValues);
+}
+
+//=============================================================================
+
+//=============================================================================
+
+void output_endPeriod(REAL8 date)
+//
+//  Input:   date = date of current reporting period
+//  Output:  none
+//  Purpose: adds the current period's results to the current chunk,
+//           saving the chunk to file once it is full.
+//
+{
+    int    j;
+    REAL8* dates;
+
+    // --- save period's date
+    if ( Nperiods >= DateCapacity )
+    {
+        j = MAX(1024, 2 * DateCapacity);
+        dates = (REAL8 *) realloc(PeriodDates, j * sizeof(REAL8));
+        if ( dates == NULL )
+        {
+            report_writeErrorMsg(ERR_MEMORY, "");
+            return;
+        }
+        PeriodDates = dates;
+        DateCapacity = j;
+    }
+    PeriodDates[Nperiods] = date;
+
+    // --- add period's values to current chunk (stored column by column)
+    for (j = 0; j < NumColumns; j++)
+    {
+        ChunkValues[(size_t)j * ChunkPeriods + ChunkCount] = PeriodValues[j];
+    }
+    ChunkCount++;
+    if ( ChunkCount == ChunkPeriods && !output_saveChunks() )
+    {
+        report_writeErrorMsg(ERR_OUT_WRITE, "");
+    }
+}
+
+//=============================================================================
+
+int output_saveChunks()
+//
+//  Input:   none
+//  Output:  returns TRUE if successful, FALSE if not
+//  Purpose: compresses the current chunk of periods, one block of result
+//           values at a time, and writes it to the binary output file.
+//
+{
+    int          b, m, size, k;
+    REAL4*       x;
+    TChunkEntry* index;
+
+    if ( ChunkCount == 0 ) return TRUE;
+
+    // --- make room in chunk index for another row of chunks
+    k = ChunkRows * ChunkBlocks;
+    if ( k + ChunkBlocks > IndexCapacity )
+    {
+        m = MAX(2 * IndexCapacity, k + ChunkBlocks);
+        index = (TChunkEntry *) realloc(ChunkIndex, m * sizeof(TChunkEntry));
+        if ( index == NULL ) return FALSE;
+        ChunkIndex = index;
+        IndexCapacity = m;
+    }
+
+    // --- compress & save each block of result values
+    if ( output_seek(Fout.file, NextChunkPos) != 0 ) return FALSE;
+    for (b = 0; b < ChunkBlocks; b++)
+    {
+        m = MIN(CHUNK_COLUMNS, NumColumns - b * CHUNK_COLUMNS);
+        x = &ChunkValues[(size_t)b * CHUNK_COLUMNS * ChunkPeriods];
+        size = encodeChunk(x, ChunkPeriods, ChunkCount, m);
+        if ( fwrite(CodecPacked, 1, size, Fout.file) < (size_t)size )
+            return FALSE;
+        ChunkIndex[k + b].offset = NextChunkPos;
+        ChunkIndex[k + b].size = size;
+        NextChunkPos += size;
+    }
+    ChunkCount = 0;
+    ChunkRows++;
+    return TRUE;
+}
+
+//=============================================================================
+
+void output_endChunks()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: saves the last partial chunk, the period dates, the chunk index
+//           and the closing records of a compressed binary output file.
+//
+{
+    int  n;
+    INT4 k;
+    INT8 pos, indexPos;
+
+    // --- save remaining periods
+    if ( !output_saveChunks() )
+    {
+        report_writeErrorMsg(ERR_OUT_WRITE, "");
+        return;
+    }
+
+    // --- save period dates and chunk index
+    indexPos = NextChunkPos;
+    output_seek(Fout.file, indexPos);
+    n = ChunkRows * ChunkBlocks;
+    if ( Nperiods > 0 ) fwrite(PeriodDates, sizeof(REAL8), Nperiods, Fout.file);
+    if ( n > 0 ) fwrite(ChunkIndex, sizeof(TChunkEntry), n, Fout.file);
+
+    // --- save epilogue
+    pos = IDStartPos;
+    fwrite(&pos, sizeof(INT8), 1, Fout.file);
+    pos = InputStartPos;
+    fwrite(&pos, sizeof(INT8), 1, Fout.file);
+    pos = OutputStartPos;
+    fwrite(&pos, sizeof(INT8), 1, Fout.file);
+    fwrite(&indexPos, sizeof(INT8), 1, Fout.file);
+    k = ChunkPeriods;
+    fwrite(&k, sizeof(INT4), 1, Fout.file);
+    k = CHUNK_COLUMNS;
+    fwrite(&k, sizeof(INT4), 1, Fout.file);
+    k = CHUNK_CODEC;
+    fwrite(&k, sizeof(INT4), 1, Fout.file);
+    k = Nperiods;
+    fwrite(&k, sizeof(INT4), 1, Fout.file);
+    k = (INT4)error_getCode(ErrorCode);
+    fwrite(&k, sizeof(INT4), 1, Fout.file);
+    k = MAGICNUMBER2;
+    if (fwrite(&k, sizeof(INT4), 1, Fout.file) < 1)
+    {
+        report_writeErrorMsg(ERR_OUT_WRITE, "");
+    }
+}
+
+//=============================================================================
+
+void output_readValues(int period, int column, int n, REAL4* x)
+//
+//  Input:   period = index of reporting time period (starting from 0)
+//           column = position of first result value within a period
+//           n = number of result values
+//  Output:  x = result values
+//  Purpose: reads consecutive result values of a reporting period from a
+//           compressed binary output file.
+//
+{
+    int i, c, g, b, k, m, rows;
+
+    for (i = 0; i < n; i++)
+    {
+        // --- locate chunk holding value
+        c = column + i;
+        g = period / ChunkPeriods;
+        b = c / CHUNK_COLUMNS;
+        k = g * ChunkBlocks + b;
+        m = MIN(CHUNK_COLUMNS, NumColumns - b * CHUNK_COLUMNS);
+        rows = MIN(ChunkPeriods, Nperiods - g * ChunkPeriods);
+
+        // --- read & decode chunk if not already done
+        if ( k != CachedChunk )
+        {
+            CachedChunk = -1;
+            x[i] = 0.0f;
+            if ( ChunkIndex[k].size > 4 * ChunkPeriods * CHUNK_COLUMNS +
+                 4 * ChunkPeriods * CHUNK_COLUMNS / 128 + 16 ) continue;
+            if ( output_seek(Fout.file, ChunkIndex[k].offset) != 0 ) continue;
+            if ( fread(CodecPacked, 1, (size_t)ChunkIndex[k].size, Fout.file) <
+                 (size_t)ChunkIndex[k].size ) continue;
+            if ( !decodeChunk((int)ChunkIndex[k].size, rows, m, CachedValues) )
+                continue;
+            CachedChunk = k;
+        }
+        x[i] = CachedValues[(c - b * CHUNK_COLUMNS) * rows +
+                            period - g * ChunkPeriods];
+    }
+}
+
+//=============================================================================
+
+int output_seek(FILE* file, INT8 pos)
+//
+//  Input:   file = ptr. to binary output file
+//           pos = file position
+//  Output:  returns 0 if successful
+//  Purpose: positions a file using a 64-bit offset.
+//
+{
+#ifdef _MSC_VER
+    return _fseeki64(file, pos, SEEK_SET);
+#elif defined(_WIN32)
+    return fseeko64(file, pos, SEEK_SET);
+#else
+    return fseeko(file, (off_t)pos, SEEK_SET);
+#endif
+}
+
+//=============================================================================
+
+int encodeChunk(REAL4* x, int stride, int n, int m)
+//
+//  Input:   x = chunk values stored column by column
+//           stride = distance between the start of successive columns
+//           n = number of periods (rows) in chunk
+//           m = number of result values (columns) in chunk
+//  Output:  returns size of compressed chunk placed in CodecPacked
+//  Purpose: compresses a chunk of result values.
+//
+{
+    int i, j, k, r, len, size = 0;
+    unsigned int w, prev;
+    int nWords = n * m;
+
+    // --- XOR each value with the previous one in its column
+    for (j = 0; j < m; j++)
+    {
+        prev = 0;
+        for (i = 0; i < n; i++)
+        {
+            memcpy(&w, &x[(size_t)j * stride + i], sizeof(w));
+            CodecWords[j * n + i] = w ^ prev;
+            prev = w;
+        }
+    }
+
+    // --- split words into byte planes
+    for (k = 0; k < 4; k++)
+    {
+        for (i = 0; i < nWords; i++)
+            CodecBytes[k * nWords + i] =
+                (unsigned char)((CodecWords[i] >> (8 * k)) & 0xFF);
+    }
+
+    // --- run-length encode the byte planes
+    len = 4 * nWords;
+    i = 0;
+    while ( i < len )
+    {
+        // --- a run of 3 to 129 identical bytes is saved as a count & byte
+        r = 1;
+        while ( i + r < len && r < 129 && CodecBytes[i + r] == CodecBytes[i] )
+            r++;
+        if ( r >= 3 )
+        {
+            CodecPacked[size++] = (unsigned char)(r + 126);
+            CodecPacked[size++] = CodecBytes[i];
+            i += r;
+            continue;
+        }
+
+        // --- otherwise save up to 128 bytes literally
+        j = i;
+        while ( j < len && j - i < 128 )
+        {
+            if ( j + 2 < len && CodecBytes[j] == CodecBytes[j + 1] &&
+                 CodecBytes[j] == CodecBytes[j + 2] ) break;
+            j++;
+        }
+        CodecPacked[size++] = (unsigned char)(j - i - 1);
+        memcpy(&CodecPacked[size], &CodecBytes[i], j - i);
+        size += j - i;
+        i = j;
+    }
+    return size;
+}
+
+//=============================================================================
+
+int decodeChunk(int size, int n, int m, REAL4* x)
+//
+//  Input:   size = size of compressed chunk held in CodecPacked
+//           n = number of periods (rows) in chunk
+//           m = number of result values (columns) in chunk
+//  Output:  x = chunk values stored column by column;
+//           returns TRUE if successful, FALSE if chunk is corrupt
+//  Purpose: decompresses a chunk of result values.
+//
+{
+    int i = 0, j, k, t, r, len, pos = 0;
+    unsigned int w, prev;
+    int nWords = n * m;
+
+    // --- expand runs into byte planes
+    len = 4 * nWords;
+    while ( i < size && pos < len )
+    {
+        t = CodecPacked[i++];
+        if ( t < 128 )
+        {
+            r = t + 1;
+            if ( i + r > size || pos + r > len ) return FALSE;
+            memcpy(&CodecBytes[pos], &CodecPacked[i], r);
+            i += r;
+        }
+        else
+        {
+            r = t - 126;
+            if ( i >= size || pos + r > len ) return FALSE;
+            memset(&CodecBytes[pos], CodecPacked[i++], r);
+        }
+        pos += r;
+    }
+    if ( pos != len ) return FALSE;
+
+    // --- reassemble words and undo XOR with previous value in column
+    for (j = 0; j < m; j++)
+    {
+        prev = 0;
+        for (i = 0; i < n; i++)
+        {
+            k = j * n + i;
+            w = (unsigned int)CodecBytes[k] |
+                ((unsigned int)CodecBytes[nWords + k] << 8) |
+                ((unsigned int)CodecBytes[2 * nWords + k] << 16) |
+                ((unsigned int)CodecBytes[3 * nWords + k] << 24);
+            prev ^= w;
+            memcpy(&x[k], &prev, sizeof(prev));
+        }
+    }
+    return TRUE;
+}
+
+//=============================================================================
+//  Functions for buffering writes of standard format results.
+//
+//  Results of each reporting period are copied into one of WRITE_BUFFERS
+//  buffers. A full buffer is written to file in a single call, either
+//  directly or, when swmm_run_cb() runs on several threads, by a writer
+//  thread while the simulation goes on filling the next buffer. The first
+//  buffer ends on a WRITE_BYTES boundary of the file so that each full
+//  buffer after it is written to an aligned file position.
+//=============================================================================
+
+int output_openBuffers()
+//
+//  Input:   none
+//  Output:  returns TRUE if successful, FALSE if not
+//  Purpose: allocates memory used to buffer writes of results to file.
+//
+{
+    int i;
+
+    for (i = 0; i < WRITE_BUFFERS; i++)
+    {
+        WriteBuffers[i] = NULL;
+        WriteSizes[i] = 0;
+    }
+    WritePos = 0;
+    WriteLimit = WRITE_BYTES;
+    BuffersFilled = 0;
+    BuffersWritten = 0;
+    WriteFailed = FALSE;
+    Threaded = FALSE;
+    HasWriter = FALSE;
+    WriterDone = FALSE;
+    if ( OutputFormat != STANDARD_OUTPUT ) return TRUE;
+    for (i = 0; i < WRITE_BUFFERS; i++)
+    {
+        WriteBuffers[i] = (char *) malloc(WRITE_BYTES);
+        if ( WriteBuffers[i] == NULL ) return FALSE;
+    }
+    return TRUE;
+}
+
+//=============================================================================
+
+void output_closeBuffers()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees memory used to buffer writes of results to file.
+//
+{
+    int i;
+    for (i = 0; i < WRITE_BUFFERS; i++) FREE(WriteBuffers[i]);
+}
+
+//=============================================================================
+
+void output_putBytes(void* x, int n)
+//
+//  Input:   x = bytes of result values
+//           n = number of bytes
+//  Output:  none
+//  Purpose: copies bytes of results into the buffer being filled, handing
+//           the buffer off to be written once it is full.
+//
+{
+    int   m;
+    char* bytes = (char *)x;
+
+    while ( n > 0 )
+    {
+        // --- make sure that the writer is done with the buffer
+        if ( WritePos == 0 && Threaded ) output_waitForBuffer();
+
+        // --- copy as many bytes as the buffer can hold
+        m = MIN(n, WriteLimit - WritePos);
+        memcpy(&WriteBuffers[BuffersFilled % WRITE_BUFFERS][WritePos],
+               bytes, m);
+        WritePos += m;
+        bytes += m;
+        n -= m;
+        if ( WritePos == WriteLimit ) output_flushBuffer();
+    }
+}
+
+//=============================================================================
+
+void output_flushBuffer()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: hands the buffer being filled off to the writer thread or
+//           writes it directly to file.
+//
+{
+    int i = BuffersFilled % WRITE_BUFFERS;
+
+    if ( WritePos == 0 ) return;
+    WriteSizes[i] = WritePos;
+#if defined(_OPENMP)
+    if ( Threaded )
+    {
+        omp_set_lock(&WriteLock);
+        BuffersFilled++;
+        omp_unset_lock(&WriteLock);
+    }
+    else
+#endif
+    {
+        output_writeBuffer(i);
+        BuffersFilled++;
+        BuffersWritten++;
+    }
+    WritePos = 0;
+    WriteLimit = WRITE_BYTES;
+}
+
+//=============================================================================
+
+void output_writeBuffer(int i)
+//
+//  Input:   i = index of a write buffer
+//  Output:  none
+//  Purpose: writes the contents of a buffer to the binary output file.
+//
+{
+    if ( fwrite(WriteBuffers[i], 1, WriteSizes[i], Fout.file) <
+         (size_t)WriteSizes[i] ) WriteFailed = TRUE;
+}
+
+//=============================================================================
+
+void output_waitForBuffer()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: waits until the writer thread is done with the buffer to be
+//           filled next.
+//
+{
+#if defined(_OPENMP)
+    int isFree = FALSE;
+    int tries = 0;
+    while ( TRUE )
+    {
+        omp_set_lock(&WriteLock);
+        isFree = (BuffersFilled - BuffersWritten < WRITE_BUFFERS);
+        omp_unset_lock(&WriteLock);
+        if ( isFree ) break;
+        pauseThread(tries++);
+    }
+#endif
+}
+
+//=============================================================================
+
+int output_startWriter()
+//
+//  Input:   none
+//  Output:  returns TRUE if results are to be written by their own thread
+//  Purpose: prepares for results to be written to file by a writer thread.
+//
+{
+#if defined(_OPENMP)
+    if ( NumThreads < 2 || OutputFormat != STANDARD_OUTPUT ||
+         WriteBuffers[0] == NULL ) return FALSE;
+
+    // --- the writer thread would only compete for a single core with
+    //     the simulation thread's parallel loops
+    if ( omp_get_num_procs() < 2 ) return FALSE;
+    omp_init_lock(&WriteLock);
+    WriterDone = FALSE;
+
+    // --- allow the simulation thread to run its own parallel loops
+    MaxActiveLevels = omp_get_max_active_levels();
+    omp_set_max_active_levels(MAX(MaxActiveLevels, 2));
+    Threaded = TRUE;
+    HasWriter = TRUE;
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
+//=============================================================================
+
+void output_execWriter()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: writes each buffer of results handed off by the simulation
+//           thread until no more buffers are to come.
+//
+//  NOTE:    this function runs on its own thread concurrently with the
+//           calls to output_saveResults() made by the simulation thread.
+//
+{
+#if defined(_OPENMP)
+    int isReady;
+    int isDone;
+    int tries;
+
+    while ( TRUE )
+    {
+        // --- wait for the simulation thread to fill a buffer
+        isReady = FALSE;
+        isDone = FALSE;
+        tries = 0;
+        while ( TRUE )
+        {
+            omp_set_lock(&WriteLock);
+            isReady = (BuffersWritten < BuffersFilled);
+            isDone = WriterDone;
+            omp_unset_lock(&WriteLock);
+            if ( isReady || isDone ) break;
+            pauseThread(tries++);
+        }
+        if ( !isReady ) break;
+
+        // --- write the buffer & release it back to the simulation thread
+        output_writeBuffer(BuffersWritten % WRITE_BUFFERS);
+        omp_set_lock(&WriteLock);
+        BuffersWritten++;
+        omp_unset_lock(&WriteLock);
+    }
+#endif
+}
+
+//=============================================================================
+
+void output_stopWriter()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: lets the writer thread know that no more buffers will be
+//           handed off to it.
+//
+//  NOTE:    if called before the writer thread has started, all further
+//           writes are made by the simulation thread itself.
+//
+{
+#if defined(_OPENMP)
+    if ( !Threaded ) return;
+    omp_set_lock(&WriteLock);
+    WriterDone = TRUE;
+    omp_unset_lock(&WriteLock);
+    Threaded = FALSE;
+#endif
+}
+
+//=============================================================================
+
+void output_snapshot(TSnapshot* s)
+//
+//  Input:   s = a simulation state snapshot
+//  Output:  none
+//  Purpose: saves or restores the results being averaged over the current
+//           reporting period.
+//
+//  NOTE:    results already saved to the output file are not part of a
+//           snapshot and are never rewound.
+//
+{
+    int i;
+
+    if ( AvgNodeResults == NULL || AvgLinkResults == NULL ) return;
+    snapshot_add(s, &Nsteps, sizeof(int));
+    for (i = 0; i < NumNodes; i++)
+    {
+        snapshot_add(s, AvgNodeResults[i].xAvg, NumNodeVars * sizeof(REAL4));
+    }
+    for (i = 0; i < NumLinks; i++)
+    {
+        snapshot_add(s, AvgLinkResults[i].xAvg, NumLinkVars * sizeof(REAL4));
+    }
+}
+
+//=============================================================================
+//  Functions for saving an index of element names.
+//
+//  When the OUTPUT_NAME_INDEX option is set, a hash table of the names of
+//  reported elements is saved between their names and the pollutant units
+//  codes. It lets a reader find an element's index from its name without
+//  reading every name in the file. The index holds:
+//      NAME_MAGIC, # names, # hash slots,
+//      position + 1 of the name held in each slot (0 if empty),
+//      byte offset of each name from the start of the names,
+//      size of the index (bytes), NAME_MAGIC.
+//  Names are hashed without regard to case with the 32-bit FNV-1a hash and
+//  collisions are resolved by linear probing.
+//=============================================================================
+
+int output_saveNameIndex(void)
+//
+//  Input:   none
+//  Output:  returns TRUE if successful, FALSE if not
+//  Purpose: saves a hash table of reported element names to the output file.
+//
+{
+    int    i, j, n, slots;
+    INT4   k, offset;
+    INT4*  table;
+    char** names;
+
+    // --- list names in the order they were saved to file
+    n = NumSubcatch + NumNodes + NumLinks + NumPolluts;
+    if ( n == 0 ) return TRUE;
+    slots = 2;
+    while ( slots < 2 * n ) slots *= 2;
+    names = (char **) calloc(n, sizeof(char *));
+    table = (INT4 *) calloc(slots + n, sizeof(INT4));
+    if ( !names || !table )
+    {
+        free(names);
+        free(table);
+        return FALSE;
+    }
+    i = 0;
+    for (j=0; j<Nobjects[SUBCATCH]; j++)
+        if ( Subcatch[j].rptFlag ) names[i++] = Subcatch[j].ID;
+    for (j=0; j<Nobjects[NODE]; j++)
+        if ( Node[j].rptFlag ) names[i++] = Node[j].ID;
+    for (j=0; j<Nobjects[LINK]; j++)
+        if ( Link[j].rptFlag ) names[i++] = Link[j].ID;
+    for (j=0; j<NumPolluts; j++) names[i++] = Pollut[j].ID;
+
+    // --- place each name in the first free slot from its hash
+    //     & record where its entry starts among the saved names
+    offset = 0;
+    for (i=0; i<n; i++)
+    {
+        j = output_hashName(names[i]) & (slots - 1);
+        while ( table[j] != 0 ) j = (j + 1) & (slots - 1);
+        table[j] = i + 1;
+        table[slots + i] = offset;
+        offset += (INT4)(sizeof(INT4) + strlen(names[i]));
+    }
+
+    // --- write the index
+    k = NAME_MAGIC;
+    fwrite(&k, sizeof(INT4), 1, Fout.file);
+    k = n;
+    fwrite(&k, sizeof(INT4), 1, Fout.file);
+    k = slots;
+    fwrite(&k, sizeof(INT4), 1, Fout.file);
+    fwrite(table, sizeof(INT4), slots + n, Fout.file);
+    k = (5 + slots + n) * sizeof(INT4);
+    fwrite(&k, sizeof(INT4), 1, Fout.file);
+    k = NAME_MAGIC;
+    fwrite(&k, sizeof(INT4), 1, Fout.file);
+    free(names);
+    free(table);
+    return TRUE;
+}
+
+//=============================================================================
+
+unsigned int output_hashName(char* name)
+//
+//  Input:   name = element name
+//  Output:  returns a hash value of the name
+//  Purpose: computes the case insensitive FNV-1a hash of an element name.
+//
+{
+    unsigned int h = 2166136261u;
+    while ( *name )
+    {
+        h ^= (unsigned char)UCHAR(*name);
+        h *= 16777619u;
+        name++;
+    }
+    return h;
+}
@@ -55,6 +55,13 @@
 //   - More robust parsing of MinSurfarea option provided.
 //   - Support added for new RuleStep analysis option.
 //
+//   Build 5.1.015:
+//   - Object ID names, water quality & land use arrays, table entries and
+//     LID units are allocated from separate memory pools (one for each
+//     subsystem) that are freed in bulk when the project is closed.
+//   - Subcatchments, conduits and nodes are validated in parallel, with any
+//     error and warning messages written in order of object index.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -74,11 +81,17 @@
 #include "hash.h"
 #include "mempool.h"
 
+//-----------------------------------------------------------------------------
+//  Constants
+//-----------------------------------------------------------------------------
+static const int MIN_THREAD_OBJECTS = 1000; // fewest objects validated by     //(5.1.015)
+                                            //   each parallel thread          //
+
 //-----------------------------------------------------------------------------
 //  Shared variables
 //-----------------------------------------------------------------------------
 static HTtable* Htable[MAX_OBJ_TYPES]; // Hash tables for object ID names
-static char     MemPoolAllocated;      // TRUE if memory pool allocated
+static alloc_handle_t* MemPool[MAX_POOLS]; // Memory pools for project data    //(5.1.015)
 
 //-----------------------------------------------------------------------------
 //  External Functions (declared in funcs.h)
@@ -94,6 +107,7 @@ static char     MemPoolAllocated;      // TRUE if memory pool allocated
 //  project_freeMatrix     (called from iface_closeRoutingFiles)
 //  project_findObject
 //  project_findID
+//  project_alloc
 
 //-----------------------------------------------------------------------------
 //  Function declarations
@@ -105,6 +119,10 @@ static void createObjects(void);
 static void deleteObjects(void);
 static void createHashTables(void);
 static void deleteHashTables(void);
+static double* newQualArray(void);                                             //(5.1.015)
+static int  getValidationThreads(int n);                                       //(5.1.015)
+static void validateObjects(int n, void (*validate)(int));                     //
+static void validateLinks(void);                                               //
 
 
 //=============================================================================
@@ -214,7 +232,7 @@ void project_validate()
     if ( Nobjects[SNOWMELT] == 0 ) IgnoreSnowmelt = TRUE;
     if ( Nobjects[AQUIFER]  == 0 ) IgnoreGwater   = TRUE;
     for ( i=0; i<Nobjects[AQUIFER]; i++ )  gwater_validateAquifer(i);
-    for ( i=0; i<Nobjects[SUBCATCH]; i++ ) subcatch_validate(i);
+    validateObjects(Nobjects[SUBCATCH], subcatch_validate);                    //(5.1.015)
     for ( i=0; i<Nobjects[GAGE]; i++ )     gage_validate(i);                   //(5.1.013)
     for ( i=0; i<Nobjects[SNOWMELT]; i++ ) snow_validateSnowmelt(i);
 
@@ -235,8 +253,8 @@ void project_validate()
     // --- validate links before nodes, since the latter can
     //     result in adjustment of node depths
     for ( i=0; i<Nobjects[NODE]; i++) Node[i].oldDepth = Node[i].fullDepth;
-    for ( i=0; i<Nobjects[LINK]; i++) link_validate(i);
-    for ( i=0; i<Nobjects[NODE]; i++) node_validate(i);
+    validateLinks();                                                           //(5.1.015)
+    validateObjects(Nobjects[NODE], node_validate);                            //(5.1.015)
 
     // --- adjust time steps if necessary
     if ( DryStep < WetStep )
@@ -280,6 +298,7 @@ void project_close()
 //  Purpose: closes a SWMM project.
 //
 {
+    climate_close();                                                           //(5.1.015)
     deleteObjects();
     deleteHashTables();
 }
@@ -325,7 +344,8 @@ int   project_addObject(int type, char *id, int n)
     // --- use memory from the hash tables' common memory pool to store
     //     a copy of the object's ID string
     len = strlen(id) + 1;
-    newID = (char *) Alloc(len*sizeof(char));
+    newID = (char *) project_alloc(ID_POOL, len, sizeof(char));                //(5.1.015)
+    if ( newID == NULL ) return -1;                                            //(5.1.015)
     strcpy(newID, id);
 
     // --- insert object's ID into the hash table for that type of object
@@ -365,6 +385,27 @@ char  *project_findID(int type, char *id)
 
 //=============================================================================
 
+void* project_alloc(int pool, int n, int size)
+//
+//  Input:   pool = memory pool type
+//           n    = number of items
+//           size = size of each item (bytes)
+//  Output:  returns pointer to zeroed memory, or NULL if none is available
+//  Purpose: allocates memory from one of the project's memory pools.
+//
+//  NOTE: the memory is only released when the project is closed.
+//
+{
+    char* p;
+    long  bytes = (long)n * size;
+    if ( MemPool[pool] == NULL ) return NULL;
+    p = AllocFrom(MemPool[pool], bytes);
+    if ( p ) memset(p, 0, bytes);
+    return p;
+}
+
+//=============================================================================
+
 double ** project_createMatrix(int nrows, int ncols)
 //
 //  Input:   nrows = number of rows (0-based)
@@ -579,6 +620,7 @@ int project_readOption(char* s1, char* s2)
       case IGNORE_ROUTING:
       case IGNORE_QUALITY:
       case IGNORE_RDII:
+      case OUTPUT_NAME_INDEX:                                                  //(5.1.015)
         m = findmatch(s2, NoYesWords);
         if ( m < 0 ) return error_setInpError(ERR_KEYWORD, s2);
         switch ( k )
@@ -592,6 +634,7 @@ int project_readOption(char* s1, char* s2)
           case IGNORE_ROUTING:    IgnoreRouting   = m;  break;
           case IGNORE_QUALITY:    IgnoreQuality   = m;  break;
           case IGNORE_RDII:       IgnoreRDII      = m;  break;
+          case OUTPUT_NAME_INDEX: OutputNameIndex = m;  break;                 //(5.1.015)
         }
         break;
 
@@ -662,6 +705,13 @@ int project_readOption(char* s1, char* s2)
         NumThreads = m;
         break;
 
+      // --- format of binary output file                                      //(5.1.015)
+      case OUTPUT_FORMAT:                                                      //
+        m = findmatch(s2, OutputFormatWords);                                  //
+        if ( m < 0 ) return error_setInpError(ERR_KEYWORD, s2);                //
+        OutputFormat = m;                                                      //
+        break;                                                                 //
+
       // --- safety factor applied to variable time step estimates under
       //     dynamic wave flow routing (value of 0 indicates that variable
       //     time step option not used)
@@ -747,6 +797,7 @@ void initPointers()
 //  Purpose: assigns NULL to all dynamic arrays for a new project.
 //
 {
+    int j;                                                                     //(5.1.015)
     Gage     = NULL;
     Subcatch = NULL;
     Node     = NULL;
@@ -770,7 +821,7 @@ void initPointers()
     UnitHyd    = NULL;
     Snowmelt   = NULL;
     Event      = NULL;
-    MemPoolAllocated = FALSE;
+    for (j = 0; j < MAX_POOLS; j++) MemPool[j] = NULL;                         //(5.1.015)
 }
 
 //=============================================================================
@@ -797,6 +848,8 @@ void setDefaults()
    Fhotstart2.mode = NO_FILE;
    Finflows.mode   = NO_FILE;
    Foutflows.mode  = NO_FILE;
+   Fclimtable.mode = NO_FILE;                                                  //(5.1.015)
+   Frecord.mode    = NO_FILE;                                                  //(5.1.015)
    Frain.file      = NULL;
    Fclimate.file   = NULL;
    Frunoff.file    = NULL;
@@ -805,6 +858,8 @@ void setDefaults()
    Fhotstart2.file = NULL;
    Finflows.file   = NULL;
    Foutflows.file  = NULL;
+   Fclimtable.file = NULL;                                                     //(5.1.015)
+   Frecord.file    = NULL;                                                     //(5.1.015)
    Fout.file       = NULL;
    Fout.mode       = NO_FILE;
 
@@ -814,6 +869,8 @@ void setDefaults()
    InfilModel      = HORTON;           // Horton infiltration method
    RouteModel      = KW;               // Kin. wave flow routing method
    SurchargeMethod = EXTRAN;           // Use EXTRAN method for surcharging    //(5.1.013)
+   OutputFormat    = STANDARD_OUTPUT;  // Fixed-size binary output records     //(5.1.015)
+   OutputNameIndex = FALSE;            // No name index in output file         //(5.1.015)
    CrownCutoff     = 0.96;                                                     //(5.1.013)
    AllowPonding    = FALSE;            // No ponding at nodes
    InertDamping    = SOME;             // Partial inertial damping
@@ -1010,6 +1067,9 @@ void createObjects()
     // --- create LID objects
     lid_create(Nobjects[LID], Nobjects[SUBCATCH]);
 
+    // --- create result recorders                                             //(5.1.015)
+    record_create();                                                           //(5.1.015)
+
     // --- create control rules
     ErrorCode = controls_create(Nobjects[CONTROL]);
     if ( ErrorCode ) return;
@@ -1024,19 +1084,18 @@ void createObjects()
     // --- allocate memory for water quality state variables
     for (j = 0; j < Nobjects[SUBCATCH]; j++)
     {
-        Subcatch[j].initBuildup =
-                              (double *) calloc(Nobjects[POLLUT], sizeof(double));
-        Subcatch[j].oldQual = (double *) calloc(Nobjects[POLLUT], sizeof(double));
-        Subcatch[j].newQual = (double *) calloc(Nobjects[POLLUT], sizeof(double));
-        Subcatch[j].pondedQual = (double *) calloc(Nobjects[POLLUT], sizeof(double));
-        Subcatch[j].concPonded = (double *) calloc(Nobjects[POLLUT], sizeof(double));
-        Subcatch[j].totalLoad  = (double *) calloc(Nobjects[POLLUT], sizeof(double));
-        Subcatch[j].surfaceBuildup = (double *) calloc(Nobjects[POLLUT], sizeof(double));
+        Subcatch[j].initBuildup = newQualArray();                              //(5.1.015)
+        Subcatch[j].oldQual = newQualArray();                                  //(5.1.015)
+        Subcatch[j].newQual = newQualArray();                                  //(5.1.015)
+        Subcatch[j].pondedQual = newQualArray();                               //(5.1.015)
+        Subcatch[j].concPonded = newQualArray();                               //(5.1.015)
+        Subcatch[j].totalLoad  = newQualArray();                               //(5.1.015)
+        Subcatch[j].surfaceBuildup = newQualArray();                           //(5.1.015)
     }
     for (j = 0; j < Nobjects[NODE]; j++)
     {
-        Node[j].oldQual = (double *) calloc(Nobjects[POLLUT], sizeof(double));
-        Node[j].newQual = (double *) calloc(Nobjects[POLLUT], sizeof(double));
+        Node[j].oldQual = newQualArray();                                      //(5.1.015)
+        Node[j].newQual = newQualArray();                                      //(5.1.015)
         Node[j].extInflow = NULL;
         Node[j].dwfInflow = NULL;
         Node[j].rdiiInflow = NULL;
@@ -1044,29 +1103,28 @@ void createObjects()
     }
     for (j = 0; j < Nobjects[LINK]; j++)
     {
-        Link[j].oldQual = (double *) calloc(Nobjects[POLLUT], sizeof(double));
-        Link[j].newQual = (double *) calloc(Nobjects[POLLUT], sizeof(double));
-        Link[j].totalLoad = (double *) calloc(Nobjects[POLLUT], sizeof(double));
+        Link[j].oldQual = newQualArray();                                      //(5.1.015)
+        Link[j].newQual = newQualArray();                                      //(5.1.015)
+        Link[j].totalLoad = newQualArray();                                    //(5.1.015)
     }
 
     // --- allocate memory for land use buildup/washoff functions
     for (j = 0; j < Nobjects[LANDUSE]; j++)
     {
-        Landuse[j].buildupFunc =
-            (TBuildup *) calloc(Nobjects[POLLUT], sizeof(TBuildup));
-        Landuse[j].washoffFunc =
-            (TWashoff *) calloc(Nobjects[POLLUT], sizeof(TWashoff));
+        Landuse[j].buildupFunc = (TBuildup *)                                  //(5.1.015)
+            project_alloc(QUAL_POOL, Nobjects[POLLUT], sizeof(TBuildup));      //(5.1.015)
+        Landuse[j].washoffFunc = (TWashoff *)                                  //(5.1.015)
+            project_alloc(QUAL_POOL, Nobjects[POLLUT], sizeof(TWashoff));      //(5.1.015)
     }
 
     // --- allocate memory for subcatchment landuse factors
     for (j = 0; j < Nobjects[SUBCATCH]; j++)
     {
-        Subcatch[j].landFactor =
-            (TLandFactor *) calloc(Nobjects[LANDUSE], sizeof(TLandFactor));
+        Subcatch[j].landFactor = (TLandFactor *)                               //(5.1.015)
+            project_alloc(QUAL_POOL, Nobjects[LANDUSE], sizeof(TLandFactor));  //(5.1.015)
         for (k = 0; k < Nobjects[LANDUSE]; k++)
         {
-            Subcatch[j].landFactor[k].buildup =
-                (double *) calloc(Nobjects[POLLUT], sizeof(double));
+            Subcatch[j].landFactor[k].buildup = newQualArray();                //(5.1.015)
         }
     }
 
@@ -1097,6 +1155,8 @@ void createObjects()
         Subcatch[j].groundwater = NULL;
         Subcatch[j].gwLatFlowExpr = NULL;
         Subcatch[j].gwDeepFlowExpr = NULL;
+        Subcatch[j].gwLatFlowCode = NULL;
+        Subcatch[j].gwDeepFlowCode = NULL;
         Subcatch[j].snowpack    = NULL;
         Subcatch[j].lidArea     = 0.0;
         for (k = 0; k < Nobjects[POLLUT]; k++)
@@ -1149,49 +1209,18 @@ void deleteObjects()
 //        subcatchment's land use factors before freeing the subcatchment).
 //
 {
-    int j, k;
+    int j;
 
-    // --- free memory for landuse factors & groundwater
+    // --- free memory for groundwater
+    //     (land use factors, buildup/washoff functions and water quality
+    //     state variables are freed with the memory pool they came from)
     if ( Subcatch ) for (j = 0; j < Nobjects[SUBCATCH]; j++)
     {
-        for (k = 0; k < Nobjects[LANDUSE]; k++)
-        {
-            FREE(Subcatch[j].landFactor[k].buildup);
-        }
-        FREE(Subcatch[j].landFactor);
         FREE(Subcatch[j].groundwater);
         gwater_deleteFlowExpression(j);
         FREE(Subcatch[j].snowpack);
     }
 
-    // --- free memory for buildup/washoff functions
-    if ( Landuse ) for (j = 0; j < Nobjects[LANDUSE]; j++)
-    {
-        FREE(Landuse[j].buildupFunc);
-        FREE(Landuse[j].washoffFunc)
-    }
-
-    // --- free memory for water quality state variables
-    if ( Subcatch ) for (j = 0; j < Nobjects[SUBCATCH]; j++)
-    {
-        FREE(Subcatch[j].initBuildup);
-        FREE(Subcatch[j].oldQual);
-        FREE(Subcatch[j].newQual);
-        FREE(Subcatch[j].pondedQual);
-        FREE(Subcatch[j].totalLoad);
-    }
-    if ( Node ) for (j = 0; j < Nobjects[NODE]; j++)
-    {
-        FREE(Node[j].oldQual);
-        FREE(Node[j].newQual);
-    }
-    if ( Link ) for (j = 0; j < Nobjects[LINK]; j++)
-    {
-        FREE(Link[j].oldQual);
-        FREE(Link[j].newQual);
-        FREE(Link[j].totalLoad);
-    }
-
     // --- free memory used for rainfall infiltration
     infil_delete();
 
@@ -1219,7 +1248,8 @@ void deleteObjects()
         treatmnt_delete(j);
     }
 
-    // --- delete table entries for curves and time series
+    // --- close files used by curves and time series
+    //     (table entries are freed with their memory pools)
     if ( Tseries ) for (j = 0; j < Nobjects[TSERIES]; j++)
         table_deleteEntries(&Tseries[j]);
     if ( Curve ) for (j = 0; j < Nobjects[CURVE]; j++)
@@ -1234,6 +1264,9 @@ void deleteObjects()
     // --- delete LIDs
     lid_delete();
 
+    // --- delete result recorders                                             //(5.1.015)
+    record_delete();                                                           //(5.1.015)
+
     // --- now free each major category of object
     FREE(Gage);
     FREE(Subcatch);
@@ -1261,6 +1294,112 @@ void deleteObjects()
 
 //=============================================================================
 
+double* newQualArray()
+//
+//  Input:   none
+//  Output:  returns pointer to a zeroed array, or NULL if out of memory
+//  Purpose: allocates an array of values for each pollutant.
+//
+{
+    return (double *)
+        project_alloc(QUAL_POOL, Nobjects[POLLUT], sizeof(double));
+}
+
+//=============================================================================
+
+int getValidationThreads(int n)
+//
+//  Input:   n = number of objects to validate
+//  Output:  returns number of threads to use
+//  Purpose: finds how many parallel threads should validate a set of objects.
+//
+{
+    int nThreads = 1;
+
+#if defined(_OPENMP)
+    nThreads = NumThreads > 0 ? NumThreads : omp_get_max_threads();
+#endif
+    nThreads = MIN(nThreads, n / MIN_THREAD_OBJECTS);
+    return MAX(nThreads, 1);
+}
+
+//=============================================================================
+
+void validateObjects(int n, void (*validate)(int))
+//
+//  Input:   n = number of objects
+//           validate = function that validates an object given its index
+//  Output:  none
+//  Purpose: validates a set of independent objects in parallel.
+//
+//  Messages issued while validating are held back and then written in
+//  order of object index, so the report does not depend on the number of
+//  threads used.
+//
+{
+    int i;
+    int nThreads = getValidationThreads(n);
+
+    if ( !report_startDeferredMsgs(nThreads) )
+    {
+        report_writeErrorMsg(ERR_MEMORY, "");
+        return;
+    }
+#pragma omp parallel for num_threads(nThreads) schedule(static)
+    for (i = 0; i < n; i++)
+    {
+        report_deferMsgs(i);
+        validate(i);
+        report_deferMsgs(-1);
+    }
+    report_endDeferredMsgs();
+}
+
+//=============================================================================
+
+void validateLinks()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: validates all links, with conduits validated in parallel.
+//
+//  Pumps and regulators share curves and node properties with other
+//  links, as do the end node depths extended to each link's crown, so
+//  these are handled one link at a time in link order once the conduits
+//  are done.
+//
+{
+    int i;
+    int nThreads = getValidationThreads(Nlinks[CONDUIT]);
+
+    if ( !report_startDeferredMsgs(nThreads) )
+    {
+        report_writeErrorMsg(ERR_MEMORY, "");
+        return;
+    }
+
+    // --- validate conduits in parallel
+#pragma omp parallel for num_threads(nThreads) schedule(static)
+    for (i = 0; i < Nobjects[LINK]; i++)
+    {
+        if ( Link[i].type != CONDUIT ) continue;
+        report_deferMsgs(i);
+        link_validate(i);
+        report_deferMsgs(-1);
+    }
+
+    // --- validate other links and extend node depths in link order
+    for (i = 0; i < Nobjects[LINK]; i++)
+    {
+        if ( Link[i].type == CONDUIT ) report_writeDeferredMsgs(i);
+        else link_validate(i);
+        link_setNodeDepths(i);
+    }
+    report_endDeferredMsgs();
+}
+
+//=============================================================================
+
 void createHashTables()
 //
 //  Input:   none
@@ -1268,16 +1407,19 @@ void createHashTables()
 //  Purpose: allocates memory for object ID hash tables
 //
 {   int j;
-    MemPoolAllocated = FALSE;
     for (j = 0; j < MAX_OBJ_TYPES ; j++)
     {
         Htable[j] = HTcreate();
         if ( Htable[j] == NULL ) report_writeErrorMsg(ERR_MEMORY, "");
     }
 
-    // --- initialize memory pool used to store object ID's
-    if ( AllocInit() == NULL ) report_writeErrorMsg(ERR_MEMORY, "");
-    else MemPoolAllocated = TRUE;
+    // --- initialize memory pools used to store object ID's and other
+    //     project data
+    for (j = 0; j < MAX_POOLS; j++)                                            //(5.1.015)
+    {                                                                          //(5.1.015)
+        MemPool[j] = AllocCreate();                                            //(5.1.015)
+        if ( MemPool[j] == NULL ) report_writeErrorMsg(ERR_MEMORY, "");        //(5.1.015)
+    }                                                                          //(5.1.015)
 }
 
 //=============================================================================
@@ -1295,8 +1437,12 @@ void deleteHashTables()
         if ( Htable[j] != NULL ) HTfree(Htable[j]);
     }
 
-    // --- free object ID memory pool
-    if ( MemPoolAllocated ) AllocFreePool();
+    // --- free object ID and project data memory pools
+    for (j = 0; j < MAX_POOLS; j++)                                            //(5.1.015)
+    {                                                                          //(5.1.015)
+        AllocDelete(MemPool[j]);                                               //(5.1.015)
+        MemPool[j] = NULL;                                                     //(5.1.015)
+    }                                                                          //(5.1.015)
 }
 
 //=============================================================================
@@ -22,6 +22,9 @@
 //
 //   Build 5.1.014:
 //   - Fixes bug related to isUsed property of a unit hydrograph's rain gage.
+//
+//   Build 5.1.015:
+//   - New function rdii_snapshot saves and restores the RDII inflows in use.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -108,6 +111,7 @@ extern double Qcf[];                   // flow units conversion factors
 //  rdii_closeRdii          (called from rain_close)
 //  rdii_getNumRdiiFlows    (called from addRdiiInflows in routing.c)
 //  rdii_getRdiiFlow        (called from addRdiiInflows in routing.c)
+//  rdii_snapshot           (called from visitState in snapshot.c)
 
 //-----------------------------------------------------------------------------
 // Function Declarations
@@ -512,6 +516,23 @@ void rdii_closeRdii()
 
 //=============================================================================
 
+void rdii_snapshot(TSnapshot* s)
+//
+//  Input:   s = a simulation state snapshot
+//  Output:  none
+//  Purpose: saves or restores the RDII inflows in use and the position
+//           reached in the RDII interface file.
+//
+{
+    if ( NumRdiiNodes == 0 || !Frdii.file ) return;
+    snapshot_add(s, RdiiNodeFlow, NumRdiiNodes * sizeof(REAL4));
+    snapshot_add(s, &RdiiStartDate, sizeof(DateTime));
+    snapshot_add(s, &RdiiEndDate, sizeof(DateTime));
+    snapshot_addFile(s, Frdii.file);
+}
+
+//=============================================================================
+
 int rdii_getNumRdiiFlows(DateTime aDate)
 //
 //  Input:   aDate = current date/time
@@ -0,0 +1,578 @@
+//-----------------------------------------------------------------------------
+//   record.c
+//
+//   Project:  EPA SWMM5
+//   Version:  5.1
+//   Date:     (Build 5.1.015)
+//
+//   Selective result recording functions.
+//
+//   A [RECORDING] section lets chosen variables of chosen elements be saved
+//   to a recording file at their own time interval, independently of the
+//   reporting time step and the elements reported on in the binary output
+//   file. Each line of the section has the format:
+//
+//     ObjType  Name  Interval  Var1 Var2 ...  <TRIGGER Var Value Interval>
+//
+//   where ObjType is SUBCATCH, NODE or LINK, Name is an element's name or *
+//   for all elements of the type, Interval is the recording interval
+//   (seconds or hh:mm:ss) and each Var is a variable keyword or pollutant
+//   name. With the optional TRIGGER clause results are recorded at the
+//   trigger's interval whenever the value of its variable exceeds Value
+//   (e.g., NODE J1 01:00:00 DEPTH TRIGGER OVERFLOW 0 10 records the depth
+//   of node J1 every 10 seconds while it floods and hourly otherwise).
+//
+//   Recordings are saved to the file named by a SAVE RECORDING line of the
+//   [FILES] section. The file is written in the machine's byte order with
+//   no padding, using 4-byte integers (INT4), 4-byte reals (REAL4) and
+//   8-byte reals (REAL8). It contains:
+//
+//   Header:
+//     INT4   RECORDMAGIC (516114540)
+//     INT4   engine version (as returned by swmm_getVersion)
+//     INT4   flow units code (0 = CFS, ... as in the binary output file)
+//     INT4   number of pollutants (0 if quality is ignored)
+//     REAL8  simulation start date (days since 12/30/1899)
+//     INT4   number of recorders, N
+//   N recorders, each with:
+//     INT4   object type (1 = SUBCATCH, 2 = NODE, 3 = LINK)
+//     INT4   element index
+//     INT4   length of element's name, L
+//     char   L characters of the name (not null terminated)
+//     INT4   number of variables recorded, V
+//     INT4   V variable codes (the result codes of the binary output
+//            file, where pollutant p has code (first pollutant code) + p)
+//   Any number of records, in time order, each with:
+//     INT4   index of the recorder (0 to N-1)
+//     REAL8  date of the record (days since 12/30/1899)
+//     REAL4  V values of the recorder's variables, in the units of the
+//            binary output file
+//   Closing records:
+//     INT4   number of records saved
+//     INT4   error code of the run (0 if none)
+//     INT4   RECORDMAGIC
+//
+//-----------------------------------------------------------------------------
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdlib.h>
+#include <string.h>
+#include "headers.h"
+
+// Definition of 4-byte integer, 4-byte real and 8-byte real types
+#define INT4  int
+#define REAL4 float
+#define REAL8 double
+
+//-----------------------------------------------------------------------------
+//  Constants
+//-----------------------------------------------------------------------------
+#define RECORDMAGIC  516114540         // begins & ends a recording file
+
+//-----------------------------------------------------------------------------
+//  Data Structures
+//-----------------------------------------------------------------------------
+typedef struct
+{
+    int     nVars;                     // number of variables recorded
+    int*    vars;                      // codes of variables recorded
+    double  step;                      // recording interval (sec)
+    int     trigVar;                   // code of triggering variable (or -1)
+    double  trigValue;                 // value that triggers recording
+    double  trigStep;                  // recording interval when triggered
+}   TRecordSpec;
+
+typedef struct
+{
+    int     spec;                      // index of recording specification
+    int     type;                      // SUBCATCH, NODE or LINK
+    int     index;                     // index of recorded element
+    double  nextTime;                  // elapsed time of next record (msec)
+}   TRecorder;
+
+//-----------------------------------------------------------------------------
+//  Shared variables
+//-----------------------------------------------------------------------------
+static TRecordSpec* Specs;             // array of recording specifications
+static int          NumSpecs;          // number of recording specifications
+static TRecorder*   Recorders;         // array of element recorders
+static int          NumRecorders;      // number of element recorders
+static int          MaxRecorders;      // size of Recorders array
+static float*       Values;            // results of a recorded element
+static int          NumValues;         // size of Values array
+static double       NextRecordTime;    // earliest time of next record (msec)
+static int          NumRecords;        // number of records saved
+
+//-----------------------------------------------------------------------------
+//  External functions (declared in funcs.h)
+//-----------------------------------------------------------------------------
+//  record_create           (called by createObjects in project.c)
+//  record_delete           (called by deleteObjects in project.c)
+//  record_readParams       (called by parseLine in input.c)
+//  record_open             (called by swmm_start in swmm5.c)
+//  record_saveResults      (called by swmm_step in swmm5.c)
+//  record_close            (called by swmm_end in swmm5.c)
+//  record_snapshot         (called by visitState in snapshot.c)
+
+//-----------------------------------------------------------------------------
+//  Local functions
+//-----------------------------------------------------------------------------
+static int  readVariable(int type, char* s);
+static int  readInterval(char* s, double* step);
+static int  addRecorder(int spec, int type, int index);
+static char* getID(int type, int index);
+static void saveRecord(TRecorder* r);
+static void getResults(int type, int index, double t, float* x);
+
+//=============================================================================
+
+void record_create()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: initializes the collection of result recorders.
+//
+{
+    Specs = NULL;
+    NumSpecs = 0;
+    Recorders = NULL;
+    NumRecorders = 0;
+    MaxRecorders = 0;
+    Values = NULL;
+}
+
+//=============================================================================
+
+void record_delete()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees memory used by the collection of result recorders.
+//
+{
+    int i;
+    for (i = 0; i < NumSpecs; i++) FREE(Specs[i].vars);
+    FREE(Specs);
+    FREE(Recorders);
+    FREE(Values);
+    NumSpecs = 0;
+    NumRecorders = 0;
+    MaxRecorders = 0;
+}
+
+//=============================================================================
+
+int record_readParams(char* tok[], int ntoks)
+//
+//  Input:   tok[] = array of string tokens
+//           ntoks = number of tokens
+//  Output:  returns an error code
+//  Purpose: reads a recording specification from a line of input data.
+//
+//  Data format is:
+//    ObjType  Name  Interval  Var1 Var2 ...  <TRIGGER Var Value Interval>
+//
+{
+    int  i, j, n, type;
+    int  vars[MAXTOKS];
+    TRecordSpec  spec;
+    TRecordSpec* specs;
+
+    // --- check for enough tokens
+    if ( ntoks < 4 ) return error_setInpError(ERR_ITEMS, "");
+
+    // --- get object type & recording interval
+    i = findmatch(tok[0], RecordTypeWords);
+    if ( i < 0 ) return error_setInpError(ERR_KEYWORD, tok[0]);
+    switch ( i )
+    {
+      case 0:  type = SUBCATCH; break;
+      case 1:  type = NODE;     break;
+      default: type = LINK;
+    }
+    if ( !readInterval(tok[2], &spec.step) )
+        return error_setInpError(ERR_NUMBER, tok[2]);
+
+    // --- get codes of recorded variables
+    n = 0;
+    for (i = 3; i < ntoks; i++)
+    {
+        if ( match(tok[i], w_TRIGGER) ) break;
+        vars[n] = readVariable(type, tok[i]);
+        if ( vars[n] < 0 ) return error_setInpError(ERR_KEYWORD, tok[i]);
+        n++;
+    }
+    if ( n == 0 ) return error_setInpError(ERR_ITEMS, "");
+
+    // --- get optional trigger
+    spec.trigVar = -1;
+    spec.trigValue = 0.0;
+    spec.trigStep = spec.step;
+    if ( i < ntoks )
+    {
+        if ( ntoks < i + 4 ) return error_setInpError(ERR_ITEMS, "");
+        spec.trigVar = readVariable(type, tok[i+1]);
+        if ( spec.trigVar < 0 ) return error_setInpError(ERR_KEYWORD, tok[i+1]);
+        if ( !getDouble(tok[i+2], &spec.trigValue) )
+            return error_setInpError(ERR_NUMBER, tok[i+2]);
+        if ( !readInterval(tok[i+3], &spec.trigStep) )
+            return error_setInpError(ERR_NUMBER, tok[i+3]);
+    }
+
+    // --- add a recorder for each element named
+    if ( strcomp(tok[1], "*") )
+    {
+        for (j = 0; j < Nobjects[type]; j++)
+        {
+            if ( !addRecorder(NumSpecs, type, j) )
+                return error_setInpError(ERR_MEMORY, "");
+        }
+    }
+    else
+    {
+        j = project_findObject(type, tok[1]);
+        if ( j < 0 ) return error_setInpError(ERR_NAME, tok[1]);
+        if ( !addRecorder(NumSpecs, type, j) )
+            return error_setInpError(ERR_MEMORY, "");
+    }
+
+    // --- save the specification
+    spec.nVars = n;
+    spec.vars = (int *) calloc(n, sizeof(int));
+    specs = (TRecordSpec *) realloc(Specs, (NumSpecs+1) * sizeof(TRecordSpec));
+    if ( spec.vars == NULL || specs == NULL )
+    {
+        FREE(spec.vars);
+        if ( specs ) Specs = specs;
+        return error_setInpError(ERR_MEMORY, "");
+    }
+    memcpy(spec.vars, vars, n * sizeof(int));
+    Specs = specs;
+    Specs[NumSpecs] = spec;
+    NumSpecs++;
+    return 0;
+}
+
+//=============================================================================
+
+int record_open()
+//
+//  Input:   none
+//  Output:  returns an error code
+//  Purpose: opens the recording file and writes its header records.
+//
+{
+    int   i, j, n;
+    INT4  k;
+    REAL8 z;
+    TRecorder* r;
+
+    Frecord.file = NULL;
+    NumRecords = 0;
+    NextRecordTime = BIG;
+    if ( Frecord.mode != SAVE_FILE || NumRecorders == 0 ) return ErrorCode;
+
+    // --- allocate memory for the results of a recorded element
+    n = MAX(MAX_SUBCATCH_RESULTS, MAX(MAX_NODE_RESULTS, MAX_LINK_RESULTS));
+    NumValues = n - 1 + Nobjects[POLLUT];
+    Values = (float *) calloc(NumValues, sizeof(float));
+    if ( Values == NULL )
+    {
+        report_writeErrorMsg(ERR_MEMORY, "");
+        return ErrorCode;
+    }
+
+    // --- open the recording file
+    if ( (Frecord.file = fopen(Frecord.name, "wb")) == NULL)
+    {
+        report_writeErrorMsg(ERR_RECORD_FILE_OPEN, Frecord.name);
+        return ErrorCode;
+    }
+
+    // --- write file header
+    k = RECORDMAGIC;
+    fwrite(&k, sizeof(INT4), 1, Frecord.file);
+    k = VERSION;
+    fwrite(&k, sizeof(INT4), 1, Frecord.file);
+    k = FlowUnits;
+    fwrite(&k, sizeof(INT4), 1, Frecord.file);
+    k = IgnoreQuality ? 0 : Nobjects[POLLUT];
+    fwrite(&k, sizeof(INT4), 1, Frecord.file);
+    z = StartDateTime;
+    fwrite(&z, sizeof(REAL8), 1, Frecord.file);
+
+    // --- write each recorder's element & variables
+    k = NumRecorders;
+    fwrite(&k, sizeof(INT4), 1, Frecord.file);
+    for (i = 0; i < NumRecorders; i++)
+    {
+        r = &Recorders[i];
+        k = r->type;
+        fwrite(&k, sizeof(INT4), 1, Frecord.file);
+        k = r->index;
+        fwrite(&k, sizeof(INT4), 1, Frecord.file);
+        k = (INT4)strlen(getID(r->type, r->index));
+        fwrite(&k, sizeof(INT4), 1, Frecord.file);
+        fwrite(getID(r->type, r->index), sizeof(char), k, Frecord.file);
+        k = Specs[r->spec].nVars;
+        fwrite(&k, sizeof(INT4), 1, Frecord.file);
+        for (j = 0; j < Specs[r->spec].nVars; j++)
+        {
+            k = Specs[r->spec].vars[j];
+            fwrite(&k, sizeof(INT4), 1, Frecord.file);
+        }
+
+        // --- first record is made one interval into the simulation
+        r->nextTime = 1000.0 * Specs[r->spec].step;
+        NextRecordTime = MIN(NextRecordTime, r->nextTime);
+    }
+    if ( ferror(Frecord.file) )
+        report_writeErrorMsg(ERR_RECORD_FILE_WRITE, Frecord.name);
+    return ErrorCode;
+}
+
+//=============================================================================
+
+void record_saveResults()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: saves the results of each recorder whose recording time has
+//           been reached by the latest routing time step.
+//
+{
+    int i;
+    TRecorder* r;
+
+    if ( Frecord.file == NULL || NewRoutingTime < NextRecordTime ) return;
+    NextRecordTime = BIG;
+    for (i = 0; i < NumRecorders; i++)
+    {
+        r = &Recorders[i];
+        while ( r->nextTime <= NewRoutingTime ) saveRecord(r);
+        NextRecordTime = MIN(NextRecordTime, r->nextTime);
+    }
+}
+
+//=============================================================================
+
+void record_snapshot(TSnapshot* s)
+//
+//  Input:   s = a simulation state snapshot
+//  Output:  none
+//  Purpose: saves or restores the time when each recorder next records.
+//
+//  Records already saved to the recording file are not rewound.
+//
+{
+    if ( Frecord.file == NULL ) return;
+    snapshot_add(s, Recorders, NumRecorders * sizeof(TRecorder));
+    snapshot_add(s, &NextRecordTime, sizeof(double));
+}
+
+//=============================================================================
+
+void record_close()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: writes the closing records of the recording file and closes it.
+//
+{
+    INT4 k;
+
+    if ( Frecord.file == NULL ) return;
+    k = NumRecords;
+    fwrite(&k, sizeof(INT4), 1, Frecord.file);
+    k = (INT4)error_getCode(ErrorCode);
+    fwrite(&k, sizeof(INT4), 1, Frecord.file);
+    k = RECORDMAGIC;
+    fwrite(&k, sizeof(INT4), 1, Frecord.file);
+    if ( ferror(Frecord.file) )
+        report_writeErrorMsg(ERR_RECORD_FILE_WRITE, Frecord.name);
+    fclose(Frecord.file);
+    Frecord.file = NULL;
+    FREE(Values);
+}
+
+//=============================================================================
+
+int readVariable(int type, char* s)
+//
+//  Input:   type = SUBCATCH, NODE or LINK
+//           s = a variable keyword or pollutant name
+//  Output:  returns the code of a recorded variable (or -1 if not found)
+//  Purpose: finds the result code of a variable of an object type.
+//
+{
+    int p = project_findObject(POLLUT, s);
+
+    switch ( type )
+    {
+      case SUBCATCH:
+        if ( p >= 0 ) return SUBCATCH_WASHOFF + p;
+        return findmatch(s, RecordSubcatchWords);
+      case NODE:
+        if ( p >= 0 ) return NODE_QUAL + p;
+        return findmatch(s, RecordNodeWords);
+      default:
+        if ( p >= 0 ) return LINK_QUAL + p;
+        return findmatch(s, RecordLinkWords);
+    }
+}
+
+//=============================================================================
+
+int readInterval(char* s, double* step)
+//
+//  Input:   s = an interval in seconds or in hh:mm:ss format
+//  Output:  step = interval (sec);
+//           returns TRUE if a valid interval was read, FALSE if not
+//  Purpose: reads a recording interval from a string.
+//
+{
+    DateTime t;
+    int h, m, sec;
+
+    if ( strchr(s, ':') )
+    {
+        if ( !datetime_strToTime(s, &t) ) return FALSE;
+        datetime_decodeTime(t, &h, &m, &sec);
+        h += 24*(int)t;
+        *step = sec + 60*m + 3600*h;
+    }
+    else if ( !getDouble(s, step) ) return FALSE;
+    return ( *step > 0.0 );
+}
+
+//=============================================================================
+
+int addRecorder(int spec, int type, int index)
+//
+//  Input:   spec = index of a recording specification
+//           type = SUBCATCH, NODE or LINK
+//           index = index of the recorded element
+//  Output:  returns TRUE if successful, FALSE if not
+//  Purpose: adds a recorder for an element to the collection of recorders.
+//
+{
+    int n;
+    TRecorder* recorders;
+
+    if ( NumRecorders == MaxRecorders )
+    {
+        n = MAX(16, 2 * MaxRecorders);
+        recorders = (TRecorder *) realloc(Recorders, n * sizeof(TRecorder));
+        if ( recorders == NULL ) return FALSE;
+        Recorders = recorders;
+        MaxRecorders = n;
+    }
+    Recorders[NumRecorders].spec = spec;
+    Recorders[NumRecorders].type = type;
+    Recorders[NumRecorders].index = index;
+    Recorders[NumRecorders].nextTime = 0.0;
+    NumRecorders++;
+    return TRUE;
+}
+
+//=============================================================================
+
+char* getID(int type, int index)
+//
+//  Input:   type = SUBCATCH, NODE or LINK
+//           index = element index
+//  Output:  returns the element's name
+//  Purpose: retrieves the name of a recorded element.
+//
+{
+    switch ( type )
+    {
+      case SUBCATCH: return Subcatch[index].ID;
+      case NODE:     return Node[index].ID;
+      default:       return Link[index].ID;
+    }
+}
+
+//=============================================================================
+
+void saveRecord(TRecorder* r)
+//
+//  Input:   r = a recorder whose recording time has been reached
+//  Output:  none
+//  Purpose: saves a record of an element's results at the recorder's
+//           recording time and schedules its next record.
+//
+{
+    int   j;
+    INT4  k;
+    REAL4 x;
+    REAL8 date;
+    TRecordSpec* spec = &Specs[r->spec];
+
+    // --- find element's results at recording time
+    memset(Values, 0, NumValues * sizeof(float));
+    getResults(r->type, r->index, r->nextTime, Values);
+
+    // --- save them if reporting period has begun
+    date = getDateTime(r->nextTime);
+    if ( date >= ReportStart )
+    {
+        k = (INT4)(r - Recorders);
+        fwrite(&k, sizeof(INT4), 1, Frecord.file);
+        fwrite(&date, sizeof(REAL8), 1, Frecord.file);
+        for (j = 0; j < spec->nVars; j++)
+        {
+            x = Values[spec->vars[j]];
+            fwrite(&x, sizeof(REAL4), 1, Frecord.file);
+        }
+        NumRecords++;
+    }
+
+    // --- use trigger's interval if trigger value exceeded
+    if ( spec->trigVar >= 0 && Values[spec->trigVar] > spec->trigValue )
+        r->nextTime += 1000.0 * spec->trigStep;
+    else
+        r->nextTime += 1000.0 * spec->step;
+}
+
+//=============================================================================
+
+void getResults(int type, int index, double t, float* x)
+//
+//  Input:   type = SUBCATCH, NODE or LINK
+//           index = element index
+//           t = elapsed simulation time (msec)
+//  Output:  x = element's results interpolated to time t
+//  Purpose: finds the reported results of an element at a given time.
+//
+{
+    int    j;
+    double f, dt;
+    TRunoffFrame* frame;
+
+    switch ( type )
+    {
+      case SUBCATCH:
+        frame = runoff_getFrame();
+        for (j = 0; j < Nobjects[GAGE]; j++)
+        {
+            gage_setReportRainfall(j, getDateTime(t));
+        }
+        dt = frame->newTime - frame->oldTime;
+        f = ( dt > 0.0 ) ? (t - frame->oldTime) / dt : 1.0;
+        subcatch_getResults(index, f, x);
+        break;
+
+      case NODE:
+        dt = NewRoutingTime - OldRoutingTime;
+        f = ( dt > 0.0 ) ? (t - OldRoutingTime) / dt : 1.0;
+        node_getResults(index, f, x);
+        break;
+
+      case LINK:
+        dt = NewRoutingTime - OldRoutingTime;
+        f = ( dt > 0.0 ) ? (t - OldRoutingTime) / dt : 1.0;
+        link_getResults(index, f, x);
+        break;
+    }
+}
@@ -43,6 +43,11 @@
 //
 //   Build 5.1.014:
 //   - Fixed bug in confusing keywords with ID names in report_readOptions().
+//
+//   Build 5.1.015:
+//   - Imported ErrString declared with its actual size and as thread private.
+//   - Error and warning messages issued while objects are validated in
+//     parallel are held back and then written in object order.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -50,6 +55,10 @@
 #include <string.h>
 #include <math.h>
 #include <time.h>
+#include <limits.h>                                                            //(5.1.015)
+#if defined(_OPENMP)                                                           //
+#include <omp.h>                                                               //
+#endif                                                                         //
 #include "headers.h"
 
 #define WRITE(x) (report_writeLine((x)))
@@ -61,10 +70,34 @@
 "----------------------------------------------------------------"
 
 
+//-----------------------------------------------------------------------------
+//  Data Structures
+//-----------------------------------------------------------------------------
+typedef struct                         // message held back by a thread        //(5.1.015)
+{                                                                              //
+    int    object;                     // index of object being validated      //
+    int    code;                       // error code (0 for a warning)         //
+    char*  msg;                        // warning message text                 //
+    char*  id;                         // ID name of object message refers to  //
+}  TDeferredMsg;                                                               //
+                                                                               //
+typedef struct                         // messages held back by a thread       //
+{                                                                              //
+    TDeferredMsg* msgs;                // messages in the order issued         //
+    int           count;               // number of messages                   //
+    int           capacity;            // size of msgs array                   //
+    int           next;                // next message to be written           //
+    int           failed;              // TRUE if out of memory                //
+}  TDeferredMsgs;                                                              //
+
 //-----------------------------------------------------------------------------
 //  Shared variables
 //-----------------------------------------------------------------------------
 static time_t SysTime;
+static TDeferredMsgs* DeferredMsgs;    // messages held back by each thread    //(5.1.015)
+static int            NumDeferred;     // number of threads holding messages   //
+static int            DeferredObject = -1; // object a thread is validating    //
+#pragma omp threadprivate(DeferredObject)                                      //
 
 //-----------------------------------------------------------------------------
 //  Imported variables
@@ -73,7 +106,8 @@ static time_t SysTime;
 extern REAL4* SubcatchResults;         // Results vectors defined in OUTPUT.C
 extern REAL4* NodeResults;             //  "
 extern REAL4* LinkResults;             //  "
-extern char   ErrString[81];           // defined in ERROR.C
+extern char   ErrString[256];          // defined in ERROR.C                   //(5.1.015)
+#pragma omp threadprivate(ErrString)                                           //
 
 //-----------------------------------------------------------------------------
 //  Local functions
@@ -86,6 +120,7 @@ static void report_Nodes(void);
 static void report_NodeHeader(char *id);
 static void report_Links(void);
 static void report_LinkHeader(char *id);
+static void report_deferMsg(int code, char* msg, char* id);                    //(5.1.015)
 
 
 //=============================================================================
@@ -1391,6 +1426,11 @@ void report_writeErrorMsg(int code, char* s)
 //  Purpose: writes error message to report file.
 //
 {
+    if ( DeferredObject >= 0 )                                                 //(5.1.015)
+    {                                                                          //
+        report_deferMsg(code, NULL, s);                                        //
+        return;                                                                //
+    }                                                                          //
     if ( Frpt.file )
     {
         WRITE("");
@@ -1454,6 +1494,11 @@ void report_writeWarningMsg(char* msg, char* id)
 //  Purpose: writes a warning message to the report file.
 //
 {
+    if ( DeferredObject >= 0 )                                                 //(5.1.015)
+    {                                                                          //
+        report_deferMsg(0, msg, id);                                           //
+        return;                                                                //
+    }                                                                          //
     fprintf(Frpt.file, "\n  %s %s", msg, id);
     Warnings++;
 }
@@ -1481,3 +1526,135 @@ void report_writeTseriesErrorMsg(int code, TTable *tseries)
     }
     else report_writeErrorMsg(code, tseries->ID);
 }
+
+//=============================================================================
+
+int report_startDeferredMsgs(int nThreads)
+//
+//  Input:   nThreads = number of threads that will validate objects
+//  Output:  returns TRUE if successful, FALSE if out of memory
+//  Purpose: prepares to hold back the messages issued by threads that
+//           validate objects in parallel.
+//
+{
+    NumDeferred = 0;
+    DeferredMsgs = (TDeferredMsgs *) calloc(nThreads, sizeof(TDeferredMsgs));
+    if ( DeferredMsgs == NULL ) return FALSE;
+    NumDeferred = nThreads;
+    return TRUE;
+}
+
+//=============================================================================
+
+void report_deferMsgs(int object)
+//
+//  Input:   object = index of object about to be validated (or -1)
+//  Output:  none
+//  Purpose: has the messages issued by the calling thread held back as
+//           referring to an object, or written directly if object is -1.
+//
+//  Each thread must validate its objects in increasing order of index.
+//
+{
+    DeferredObject = object;
+}
+
+//=============================================================================
+
+void report_writeDeferredMsgs(int object)
+//
+//  Input:   object = index of an object
+//  Output:  none
+//  Purpose: writes the messages held back for all objects up to and
+//           including a given one, in order of object index.
+//
+{
+    int i, k;
+    TDeferredMsg* m;
+
+    for (;;)
+    {
+        // --- find the thread whose next message is for the lowest object
+        k = -1;
+        for (i = 0; i < NumDeferred; i++)
+        {
+            if ( DeferredMsgs[i].next >= DeferredMsgs[i].count ) continue;
+            if ( k < 0 ||
+                 DeferredMsgs[i].msgs[DeferredMsgs[i].next].object <
+                 DeferredMsgs[k].msgs[DeferredMsgs[k].next].object ) k = i;
+        }
+        if ( k < 0 ) return;
+        m = &DeferredMsgs[k].msgs[DeferredMsgs[k].next];
+        if ( m->object > object ) return;
+        DeferredMsgs[k].next++;
+
+        // --- write the message
+        if ( m->code > 0 ) report_writeErrorMsg(m->code, m->id);
+        else report_writeWarningMsg(m->msg, m->id);
+    }
+}
+
+//=============================================================================
+
+void report_endDeferredMsgs()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: writes any messages still held back and stops holding back
+//           messages.
+//
+{
+    int i, failed = FALSE;
+
+    report_writeDeferredMsgs(INT_MAX);
+    for (i = 0; i < NumDeferred; i++)
+    {
+        if ( DeferredMsgs[i].failed ) failed = TRUE;
+        FREE(DeferredMsgs[i].msgs);
+    }
+    FREE(DeferredMsgs);
+    NumDeferred = 0;
+    if ( failed ) report_writeErrorMsg(ERR_MEMORY, "");
+}
+
+//=============================================================================
+
+void report_deferMsg(int code, char* msg, char* id)
+//
+//  Input:   code = error code (0 for a warning)
+//           msg = text of warning message
+//           id = ID name of object that message refers to
+//  Output:  none
+//  Purpose: holds back a message issued by a thread validating an object.
+//
+//  The message's text and ID name are not copied, so they must not change
+//  before the message is written.
+//
+{
+    int            n;
+    int            i = 0;
+    TDeferredMsg*  msgs;
+    TDeferredMsgs* list;
+
+#if defined(_OPENMP)
+    i = omp_get_thread_num();
+#endif
+    list = &DeferredMsgs[i];
+    if ( list->count == list->capacity )
+    {
+        n = MAX(2 * list->capacity, 16);
+        msgs = (TDeferredMsg *) realloc(list->msgs, n * sizeof(TDeferredMsg));
+        if ( msgs == NULL )
+        {
+            list->failed = TRUE;
+            return;
+        }
+        list->msgs = msgs;
+        list->capacity = n;
+    }
+    list->msgs[list->count].object = DeferredObject;
+    list->msgs[list->count].code = code;
+    list->msgs[list->count].msg = msg;
+    list->msgs[list->count].id = id;
+    list->count++;
+}
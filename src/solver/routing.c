@@ -44,6 +44,11 @@
 //     mass balance purposes.
 //   - Global infiltration factor for storage seepage set in routing_execute.
 //
+//   Build 5.1.015:
+//   - Runoff inflows are taken from the runoff results frame that routing
+//     currently uses rather than from the runoff processor's live state.
+//   - New function routing_snapshot() saves and restores the routing state.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -68,6 +73,7 @@ static double NewRuleTime;                                                     /
 // routing_getRoutingStep  (called by swmm_step in swmm5.c)
 // routing_execute         (called by swmm_step in swmm5.c)
 // routing_close           (called by swmm_end in swmm5.c)
+// routing_snapshot        (called by visitState in snapshot.c)
 
 //-----------------------------------------------------------------------------
 // Function declarations
@@ -146,6 +152,21 @@ void routing_close(int routingModel)
 
 //=============================================================================
 
+void routing_snapshot(TSnapshot* s)
+//
+//  Input:   s = a simulation state snapshot
+//  Output:  none
+//  Purpose: saves or restores the state of the routing analyzer.
+//
+{
+    snapshot_add(s, &NextEvent, sizeof(int));
+    snapshot_add(s, &BetweenEvents, sizeof(int));
+    snapshot_add(s, &NewRuleTime, sizeof(double));
+    if ( RouteModel == DW ) dynwave_snapshot(s);
+}
+
+//=============================================================================
+
 ////  This function was modified for release 5.1.013.  ////                    //(5.1.013)
 
 double routing_getRoutingStep(int routingModel, double fixedStep)
@@ -158,13 +179,15 @@ double routing_getRoutingStep(int routingModel, double fixedStep)
 {
     double date1, date2, nextTime;
     double routingStep = 0.0, nextRuleTime, nextRoutingTime;
+    TRunoffFrame* frame = runoff_getFrame();                                   //(5.1.015)
 
     if ( Nobjects[LINK] == 0 ) return fixedStep;
 
     // --- find largest step possible if between routing events
     if ( NumEvents > 0 && BetweenEvents )
     {
-        nextTime = MIN(NewRunoffTime, ReportTime);
+        if ( frame ) nextTime = MIN(frame->newTime, ReportTime);               //(5.1.015)
+        else nextTime = MIN(NewRunoffTime, ReportTime);
         date1 = getDateTime(NewRoutingTime);
         date2 = getDateTime(nextTime);
         if ( date2 > date1 && date2 < Event[NextEvent].start )
@@ -269,7 +292,8 @@ void routing_execute(int routingModel, double routingStep)
 
     // --- set infiltration factor for storage unit seepage                    //(5.1.013)
     //     (-1 argument indicates global factor is used)                       //(5.1.013)
-    infil_setInfilFactor(-1);                                                  //(5.1.013)
+    //     (when pipelined, the runoff thread owns this factor)                //(5.1.015)
+    if ( !runoff_isPipelined() ) infil_setInfilFactor(-1);                     //(5.1.015)
 
     // --- initialize lateral inflows at nodes
     for (j = 0; j < Nobjects[NODE]; j++)
@@ -515,10 +539,11 @@ void addWetWeatherInflows(double routingTime)
     int    i, j, p;
     double q, w;
     double f;
+    TRunoffFrame* frame = runoff_getFrame();
 
     // --- find where current routing time lies between latest runoff times
-    if ( Nobjects[SUBCATCH] == 0 ) return;
-    f = (routingTime - OldRunoffTime) / (NewRunoffTime - OldRunoffTime);
+    if ( Nobjects[SUBCATCH] == 0 || frame == NULL ) return;
+    f = (routingTime - frame->oldTime) / (frame->newTime - frame->oldTime);
     if ( f < 0.0 ) f = 0.0;
     if ( f > 1.0 ) f = 1.0;
 
@@ -558,10 +583,12 @@ void addGroundwaterInflows(double routingTime)
     double q, w;
     double f;
     TGroundwater* gw;
+    TSubcatchFrame* s;
+    TRunoffFrame* frame = runoff_getFrame();
 
     // --- find where current routing time lies between latest runoff times
-    if ( Nobjects[SUBCATCH] == 0 ) return;
-    f = (routingTime - OldRunoffTime) / (NewRunoffTime - OldRunoffTime);
+    if ( Nobjects[SUBCATCH] == 0 || frame == NULL ) return;
+    f = (routingTime - frame->oldTime) / (frame->newTime - frame->oldTime);
     if ( f < 0.0 ) f = 0.0;
     if ( f > 1.0 ) f = 1.0;
 
@@ -577,7 +604,8 @@ void addGroundwaterInflows(double routingTime)
             if ( j >= 0 )
             {
                 // add groundwater flow to lateral inflow
-                q = ( (1.0 - f)*(gw->oldFlow) + f*(gw->newFlow) )
+                s = &frame->subcatch[i];
+                q = ( (1.0 - f)*(s->oldGwFlow) + f*(s->newGwFlow) )
                     * Subcatch[i].area;
                 if ( fabs(q) < FLOW_TOL ) continue;
                 Node[j].newLatFlow += q;
@@ -609,10 +637,11 @@ void addLidDrainInflows(double routingTime)
 {
     int j;
     double f;
+    TRunoffFrame* frame = runoff_getFrame();
 
     // for each subcatchment
-    if ( Nobjects[SUBCATCH] == 0 ) return;
-    f = (routingTime - OldRunoffTime) / (NewRunoffTime - OldRunoffTime);
+    if ( Nobjects[SUBCATCH] == 0 || frame == NULL ) return;
+    f = (routingTime - frame->oldTime) / (frame->newTime - frame->oldTime);
     if ( f < 0.0 ) f = 0.0;
     if ( f > 1.0 ) f = 1.0;
     for (j = 0; j < Nobjects[SUBCATCH]; j++)
@@ -33,6 +33,21 @@
 //
 //   Build 5.1.014:
 //   - Fixed street sweeping bug.
+//
+//   Build 5.1.015:
+//   - Groundwater updated for all subcatchments after their surface runoff
+//     has been computed.
+//   - Snow melt computed for all subcatchments before their surface runoff
+//     is computed.
+//   - Results used by the routing & reporting processors are saved to a
+//     runoff results frame at the end of each runoff time step.
+//   - Runoff can be computed ahead of routing on a separate thread that
+//     fills a ring buffer of runoff results frames.
+//   - LID units of all subcatchments are analyzed together after the runoff
+//     from the non-LID areas of all subcatchments has been computed.
+//   - New function runoff_snapshot saves and restores the runoff state.
+//   - Errors raised on the runoff thread are held until the routing thread
+//     reaches the time step they occurred in and are reported there.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -40,7 +55,16 @@
 #include <string.h>
 #include <stdlib.h>
 #include "headers.h"
+#include "lid.h"
 #include "odesolve.h"
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// Constants
+//-----------------------------------------------------------------------------
+#define MAXFRAMES 4                    // size of pipelined frame ring buffer
 
 //-----------------------------------------------------------------------------
 // Shared variables
@@ -53,11 +77,33 @@ static int   MaxSteps;                 // final number of runoff time steps
 static long  MaxStepsPos;              // position in Runoff interface file
                                        //    where MaxSteps is saved
 
+// Runoff results frames
+static TRunoffFrame* Frames;           // ring buffer of results frames
+static double*  FrameData[MAXFRAMES];  // quality & LID drain values of frames
+static int      FrameValues;           // number of values in a frame's data
+static int      NumFrames;             // number of frames in ring buffer
+static int      FramesSaved;           // number of frames saved by runoff
+static int      FrameUsed;             // number of frame used by routing
+static int      Pipelined;             // TRUE if runoff computed ahead
+static int      HasPipeline;           // TRUE if pipeline lock was created
+static int      PipelineDone;          // TRUE if runoff computations ended
+static int      PipelineStopped;       // TRUE if routing needs no more frames
+static int      PipelineError;         // error code raised by runoff thread
+static int      PipelineErrorMsg;      // TRUE if error has a message to write
+static char     PipelineErrorText[MAXMSG+1]; // text of runoff thread's error
+static int      OnRunoffThread;        // TRUE on the runoff thread
+#if defined(_OPENMP)
+#pragma omp threadprivate(OnRunoffThread)
+static omp_lock_t FrameLock;           // guards frame counters & runoff error
+#endif
+
 //-----------------------------------------------------------------------------
 //  Exportable variables 
 //-----------------------------------------------------------------------------
 char    HasWetLids;  // TRUE if any LIDs are wet (used in lidproc.c)
 double* OutflowLoad; // exported pollutant mass load (used in surfqual.c)
+int     RunoffThreads; // threads used by runoff's parallel loops
+                       // (used in snow.c, gwater.c & lid.c)
 
 //-----------------------------------------------------------------------------
 //  Imported variables
@@ -67,9 +113,18 @@ extern float* SubcatchResults;         // Results vector defined in OUTPUT.C
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)
 //-----------------------------------------------------------------------------
-// runoff_open     (called from swmm_start in swmm5.c)
-// runoff_execute  (called from swmm_step in swmm5.c)
-// runoff_close    (called from swmm_end in swmm5.c)
+// runoff_open            (called from swmm_start in swmm5.c)
+// runoff_execute         (called from swmm_step in swmm5.c)
+// runoff_close           (called from swmm_end in swmm5.c)
+// runoff_getFrame        (called by routing & reporting functions)
+// runoff_getEvapRate     (called by node & link loss functions)
+// runoff_getHydconFactor (called from conduit_getLossRate in link.c)
+// runoff_isPipelined     (called from execRouting & routing_execute)
+// runoff_startPipeline   (called from swmm_run_cb in toolkit.c)
+// runoff_execPipeline    (called from swmm_run_cb in toolkit.c)
+// runoff_stopPipeline    (called from swmm_run_cb in toolkit.c)
+// runoff_waitForFrame    (called from execRouting in swmm5.c)
+// runoff_snapshot        (called from visitState in snapshot.c)
 
 //-----------------------------------------------------------------------------
 // Local functions
@@ -79,6 +134,16 @@ static void   runoff_initFile(void);
 static void   runoff_readFromFile(void);
 static void   runoff_saveToFile(float tStep);
 static void   runoff_getOutfallRunon(double tStep);
+static void   execRunoff(void);
+
+static int    createFrames(int n);
+static void   deleteFrames(void);
+static void   saveFrame(TRunoffFrame* frame);
+static int    canPipeline(void);
+static int    isRoutingTseries(int k);
+static int    waitForFreeFrame(void);
+static void   raiseError(int code, char* s);
+static int    hasError(void);
 
 //=============================================================================
 
@@ -97,6 +162,15 @@ int runoff_open()
     // --- open the Ordinary Differential Equation solver
     if ( !odesolve_open(MAXODES) ) report_writeErrorMsg(ERR_ODE_SOLVER, "");
 
+    // --- allocate memory for groundwater time step results
+    if ( gwater_open() ) report_writeErrorMsg(ERR_MEMORY, "");
+
+    // --- allocate memory for snow melt results
+    if ( snow_open() ) report_writeErrorMsg(ERR_MEMORY, "");
+
+    // --- allocate memory for non-LID runoff & LID unit results
+    if ( subcatch_open() || lid_open() ) report_writeErrorMsg(ERR_MEMORY, "");
+
     // --- allocate memory for pollutant runoff loads
     OutflowLoad = NULL;
     if ( Nobjects[POLLUT] > 0 )
@@ -119,6 +193,13 @@ int runoff_open()
         else runoff_initFile();
         break;
     }
+
+    // --- allocate memory for the frame of results seen by routing
+    Pipelined = FALSE;
+    HasPipeline = FALSE;
+    RunoffThreads = NumThreads;
+    if ( !createFrames(1) ) report_writeErrorMsg(ERR_MEMORY, "");
+    else saveFrame(&Frames[0]);
     return ErrorCode;
 }
 
@@ -134,9 +215,27 @@ void runoff_close()
     // --- close the ODE solver
     odesolve_close();
 
+    // --- free memory for groundwater time step results
+    gwater_close();
+
+    // --- free memory for snow melt results
+    snow_close();
+
+    // --- free memory for non-LID runoff & LID unit results
+    subcatch_close();
+    lid_close();
+
     // --- free memory for pollutant runoff loads
     FREE(OutflowLoad);
 
+    // --- free memory for runoff results frames
+#if defined(_OPENMP)
+    if ( HasPipeline ) omp_destroy_lock(&FrameLock);
+#endif
+    Pipelined = FALSE;
+    HasPipeline = FALSE;
+    deleteFrames();
+
     // --- close runoff interface file if in use
     if ( Frunoff.file )
     {
@@ -159,6 +258,255 @@ void runoff_execute()
 //
 //  Input:   none
 //  Output:  none
+//  Purpose: computes runoff from each subcatchment at current runoff time
+//           and saves the results used by the routing processor.
+//
+{
+    execRunoff();
+    saveFrame(&Frames[0]);
+}
+
+//=============================================================================
+
+TRunoffFrame* runoff_getFrame()
+//
+//  Input:   none
+//  Output:  returns a pointer to a runoff results frame (or NULL)
+//  Purpose: retrieves the runoff results to use at the current routing time.
+//
+{
+    if ( Frames == NULL ) return NULL;
+    return &Frames[FrameUsed % NumFrames];
+}
+
+//=============================================================================
+
+double runoff_getEvapRate()
+//
+//  Input:   none
+//  Output:  returns evaporation rate (ft/sec)
+//  Purpose: retrieves the evaporation rate that applies at the current
+//           routing time.
+//
+{
+    if ( Frames == NULL ) return Evap.rate;
+    return Frames[FrameUsed % NumFrames].evapRate;
+}
+
+//=============================================================================
+
+double runoff_getHydconFactor()
+//
+//  Input:   none
+//  Output:  returns hydraulic conductivity adjustment factor
+//  Purpose: retrieves the conductivity adjustment factor that applies at the
+//           current routing time.
+//
+{
+    if ( Frames == NULL ) return Adjust.hydconFactor;
+    return Frames[FrameUsed % NumFrames].hydconFactor;
+}
+
+//=============================================================================
+
+int runoff_isPipelined()
+//
+//  Input:   none
+//  Output:  returns TRUE if runoff is computed ahead of routing
+//  Purpose: checks if runoff is being computed on its own thread.
+//
+{
+    return Pipelined;
+}
+
+//=============================================================================
+
+int runoff_startPipeline()
+//
+//  Input:   none
+//  Output:  returns TRUE if runoff can be computed ahead of routing
+//  Purpose: prepares a ring buffer of results frames so that runoff can be
+//           computed on its own thread ahead of the routing processor.
+//
+{
+#if defined(_OPENMP)
+    if ( !canPipeline() ) return FALSE;
+
+    // --- replace the single results frame with a ring buffer of frames
+    //     whose first frame holds the current results
+    deleteFrames();
+    if ( !createFrames(MAXFRAMES) )
+    {
+        report_writeErrorMsg(ERR_MEMORY, "");
+        return FALSE;
+    }
+    saveFrame(&Frames[0]);
+    FramesSaved = 1;
+    FrameUsed = 0;
+    PipelineDone = FALSE;
+    PipelineStopped = FALSE;
+    PipelineError = 0;
+    omp_init_lock(&FrameLock);
+
+    // --- the runoff thread takes the place of the threads its parallel
+    //     loops would otherwise use (so that, if nested parallelism is
+    //     enabled, the cores are not oversubscribed)
+    RunoffThreads = 1;
+    Pipelined = TRUE;
+    HasPipeline = TRUE;
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
+//=============================================================================
+
+void runoff_execPipeline()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: computes runoff over the entire simulation period, saving the
+//           results of each time step to the next frame of the ring buffer.
+//
+//  NOTE:    this function runs on its own thread concurrently with
+//           calls to runoff_waitForFrame() made by the routing processor.
+//           Any error is held in PipelineError rather than being reported
+//           (see raiseError()).
+//
+{
+#if defined(_OPENMP)
+    OnRunoffThread = TRUE;
+    while ( NewRunoffTime < TotalDuration )
+    {
+        // --- wait until routing is done with the oldest frame
+        if ( !waitForFreeFrame() ) break;
+
+        // --- compute runoff over the next time step & save its results
+        execRunoff();
+        if ( PipelineError ) break;
+        saveFrame(&Frames[FramesSaved % NumFrames]);
+        omp_set_lock(&FrameLock);
+        FramesSaved++;
+        omp_unset_lock(&FrameLock);
+    }
+    omp_set_lock(&FrameLock);
+    PipelineDone = TRUE;
+    omp_unset_lock(&FrameLock);
+    OnRunoffThread = FALSE;
+#endif
+}
+
+//=============================================================================
+
+void runoff_stopPipeline()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: lets the runoff thread know that routing needs no more frames.
+//
+//  NOTE:    if called before the runoff thread has started, any further
+//           runoff computations are made by the routing thread itself.
+//
+{
+#if defined(_OPENMP)
+    if ( !Pipelined ) return;
+    omp_set_lock(&FrameLock);
+    PipelineStopped = TRUE;
+    omp_unset_lock(&FrameLock);
+    Pipelined = FALSE;
+#endif
+}
+
+//=============================================================================
+
+void runoff_waitForFrame(double routingTime)
+//
+//  Input:   routingTime = elapsed time of next routing step (msec)
+//  Output:  none
+//  Purpose: advances to the first frame in the ring buffer whose runoff
+//           time has reached the next routing time, reporting any error
+//           the runoff thread raised before it could save that frame.
+//
+{
+#if defined(_OPENMP)
+    int isReady;
+    int isDone;
+    int tries;
+    int code;
+
+    if ( !Pipelined ) return;
+    while ( Frames[FrameUsed % NumFrames].newTime < routingTime )
+    {
+        // --- wait for the runoff thread to save another frame
+        isReady = FALSE;
+        isDone = FALSE;
+        tries = 0;
+        while ( TRUE )
+        {
+            omp_set_lock(&FrameLock);
+            isReady = (FrameUsed + 1 < FramesSaved);
+            isDone = PipelineDone;
+            omp_unset_lock(&FrameLock);
+            if ( isReady || isDone ) break;
+            pauseThread(tries++);
+        }
+        if ( !isReady )
+        {
+            // --- the runoff thread no longer writes PipelineError once done
+            omp_set_lock(&FrameLock);
+            code = PipelineError;
+            omp_unset_lock(&FrameLock);
+            if ( code && PipelineErrorMsg )
+                report_writeErrorMsg(code, PipelineErrorText);
+            else if ( code ) ErrorCode = code;
+            break;
+        }
+
+        // --- release the current frame back to the runoff thread
+        omp_set_lock(&FrameLock);
+        FrameUsed++;
+        omp_unset_lock(&FrameLock);
+    }
+#endif
+}
+
+//=============================================================================
+
+void runoff_snapshot(TSnapshot* s)
+//
+//  Input:   s = a simulation state snapshot
+//  Output:  none
+//  Purpose: saves or restores the state of the runoff analyzer, including
+//           the results frame used by routing.
+//
+//  Snapshots are not taken while runoff is pipelined, so only the single
+//  frame used when routing follows runoff step by step is included.
+//
+{
+    snapshot_add(s, &IsRaining, sizeof(char));
+    snapshot_add(s, &HasRunoff, sizeof(char));
+    snapshot_add(s, &HasSnow, sizeof(char));
+    snapshot_add(s, &HasWetLids, sizeof(char));
+    snapshot_add(s, &Nsteps, sizeof(int));
+    snapshot_addFile(s, Frunoff.file);
+
+    if ( Frames == NULL ) return;
+    snapshot_add(s, &Frames[0], sizeof(TRunoffFrame));
+    snapshot_add(s, Frames[0].subcatch,
+                 Nobjects[SUBCATCH] * sizeof(TSubcatchFrame));
+    snapshot_add(s, Frames[0].gage, Nobjects[GAGE] * sizeof(TGageFrame));
+    snapshot_add(s, FrameData[0], FrameValues * sizeof(double));
+    snapshot_add(s, &FramesSaved, sizeof(int));
+    snapshot_add(s, &FrameUsed, sizeof(int));
+}
+
+//=============================================================================
+
+void execRunoff()
+//
+//  Input:   none
+//  Output:  none
 //  Purpose: computes runoff from each subcatchment at current runoff time.
 //
 {
@@ -170,7 +518,7 @@ void runoff_execute()
     DateTime currentDate;              // current date/time 
     char     canSweep;                 // TRUE if street sweeping can occur
 
-    if ( ErrorCode ) return;
+    if ( hasError() ) return;
 
     // --- find previous runoff time step in sec
     oldRunoffStep = (NewRunoffTime - OldRunoffTime) / 1000.0;
@@ -220,7 +568,7 @@ void runoff_execute()
     runoffStep = runoff_getTimeStep(currentDate);
     if ( runoffStep <= 0.0 )
     {
-        ErrorCode = ERR_TIMESTEP;
+        raiseError(ERR_TIMESTEP, NULL);
         return;
     }
 
@@ -248,7 +596,20 @@ void runoff_execute()
         subcatch_getRunon(j);
         if ( !IgnoreSnowmelt ) snow_plowSnow(j, runoffStep);
     }
+
+    // --- compute snow melt from all snow packs
+    if ( !IgnoreSnowmelt ) snow_execute(runoffStep);
     
+    // --- compute runoff from the non-LID area of each subcatchment
+    for (j = 0; j < Nobjects[SUBCATCH]; j++)
+    {
+        if ( Subcatch[j].area == 0.0 ) continue;
+        subcatch_getSurfaceRunoff(j, runoffStep);
+    }
+
+    // --- analyze the LID units placed in all subcatchments
+    lid_execute(runoffStep);
+
     // --- determine runoff and pollutant buildup/washoff in each subcatchment
     HasSnow = FALSE;
     HasRunoff = FALSE;
@@ -279,6 +640,9 @@ void runoff_execute()
         surfqual_getWashoff(j, runoff, runoffStep);
     }
 
+    // --- update groundwater levels & flows in each subcatchment
+    if ( !IgnoreGwater ) gwater_execute(runoffStep);
+
     // --- update tracking of system-wide max. runoff rate
     stats_updateMaxRunoff();
 
@@ -286,6 +650,8 @@ void runoff_execute()
     Nsteps++;
     if ( Frunoff.mode == SAVE_FILE )
     {
+        // --- the results written to file are read from the results frame
+        saveFrame(&Frames[0]);
         runoff_saveToFile((float)runoffStep);
     }
 
@@ -424,7 +790,7 @@ void  runoff_readFromFile(void)
     // --- make sure not past end of file
     if ( Nsteps > MaxSteps )
     {
-         report_writeErrorMsg(ERR_RUNOFF_FILE_END, "");
+         raiseError(ERR_RUNOFF_FILE_END, "");
          return;
     }
 
@@ -473,7 +839,7 @@ void  runoff_readFromFile(void)
     // --- report error if not enough values were read
     if ( kount < 1 + Nobjects[SUBCATCH] * nResults )
     {
-         report_writeErrorMsg(ERR_RUNOFF_FILE_READ, "");
+         raiseError(ERR_RUNOFF_FILE_READ, "");
          return;
     }
 
@@ -524,3 +890,303 @@ void runoff_getOutfallRunon(double tStep)
         }
     }
 }
+
+//=============================================================================
+
+int createFrames(int n)
+//
+//  Input:   n = number of frames
+//  Output:  returns TRUE if successful
+//  Purpose: allocates memory for a ring buffer of runoff results frames.
+//
+{
+    int i, j, k;
+    int nQual = Nobjects[POLLUT];
+    int nValues = 0;
+    double* x;
+
+    // --- find number of quality & LID drain values saved in a frame
+    for (j = 0; j < Nobjects[SUBCATCH]; j++)
+    {
+        nValues += 2 * (nQual + lid_getLidUnitCount(j));
+    }
+
+    Frames = (TRunoffFrame *) calloc(n, sizeof(TRunoffFrame));
+    if ( Frames == NULL ) return FALSE;
+    NumFrames = n;
+    FrameValues = nValues;
+    FramesSaved = 0;
+    FrameUsed = 0;
+    for (i = 0; i < n; i++)
+    {
+        Frames[i].subcatch = (TSubcatchFrame *)
+            calloc(MAX(Nobjects[SUBCATCH], 1), sizeof(TSubcatchFrame));
+        Frames[i].gage = (TGageFrame *)
+            calloc(MAX(Nobjects[GAGE], 1), sizeof(TGageFrame));
+        FrameData[i] = (double *) calloc(MAX(nValues, 1), sizeof(double));
+        if ( !Frames[i].subcatch || !Frames[i].gage || !FrameData[i] )
+            return FALSE;
+
+        // --- assign each subcatchment its share of the frame's values
+        x = FrameData[i];
+        for (j = 0; j < Nobjects[SUBCATCH]; j++)
+        {
+            k = lid_getLidUnitCount(j);
+            Frames[i].subcatch[j].oldQual = x;
+            Frames[i].subcatch[j].newQual = x + nQual;
+            Frames[i].subcatch[j].lidDrains = x + 2 * nQual;
+            x += 2 * (nQual + k);
+        }
+    }
+    return TRUE;
+}
+
+//=============================================================================
+
+void deleteFrames()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees memory used for runoff results frames.
+//
+{
+    int i;
+
+    if ( Frames == NULL ) return;
+    for (i = 0; i < NumFrames; i++)
+    {
+        FREE(Frames[i].subcatch);
+        FREE(Frames[i].gage);
+        FREE(FrameData[i]);
+    }
+    FREE(Frames);
+    NumFrames = 0;
+    FramesSaved = 0;
+    FrameUsed = 0;
+}
+
+//=============================================================================
+
+void saveFrame(TRunoffFrame* frame)
+//
+//  Input:   frame = a runoff results frame
+//  Output:  none
+//  Purpose: saves the current runoff results used by the routing and
+//           reporting processors to a results frame.
+//
+{
+    int j, p;
+    TSubcatchFrame* s;
+    TGageFrame*     g;
+    TGroundwater*   gw;
+
+    frame->oldTime = OldRunoffTime;
+    frame->newTime = NewRunoffTime;
+    frame->evapRate = Evap.rate;
+    frame->hydconFactor = Adjust.hydconFactor;
+    frame->temperature = Temp.ta;
+
+    for (j = 0; j < Nobjects[SUBCATCH]; j++)
+    {
+        s = &frame->subcatch[j];
+        s->oldRunoff = Subcatch[j].oldRunoff;
+        s->newRunoff = Subcatch[j].newRunoff;
+        s->oldSnowDepth = Subcatch[j].oldSnowDepth;
+        s->newSnowDepth = Subcatch[j].newSnowDepth;
+        s->evapLoss = Subcatch[j].evapLoss;
+        s->infilLoss = Subcatch[j].infilLoss;
+        s->oldLidDrain = lid_getDrainFlow(j, PREVIOUS);
+        s->newLidDrain = lid_getDrainFlow(j, CURRENT);
+        gw = Subcatch[j].groundwater;
+        if ( gw )
+        {
+            s->oldGwFlow = gw->oldFlow;
+            s->newGwFlow = gw->newFlow;
+            s->gwElev = gw->bottomElev + gw->lowerDepth;
+            s->gwTheta = gw->theta;
+            s->gwEvapLoss = gw->evapLoss;
+        }
+        for (p = 0; p < Nobjects[POLLUT]; p++)
+        {
+            s->oldQual[p] = Subcatch[j].oldQual[p];
+            s->newQual[p] = Subcatch[j].newQual[p];
+        }
+        lid_saveDrainFlows(j, s->lidDrains);
+    }
+
+    for (j = 0; j < Nobjects[GAGE]; j++)
+    {
+        g = &frame->gage[j];
+        g->rainfall = Gage[j].rainfall;
+        g->nextRainfall = Gage[j].nextRainfall;
+        g->endDate = Gage[j].endDate;
+        g->nextDate = Gage[j].nextDate;
+    }
+}
+
+//=============================================================================
+
+int canPipeline()
+//
+//  Input:   none
+//  Output:  returns TRUE if runoff can be computed ahead of routing
+//  Purpose: checks that runoff computations do not depend on any routing
+//           results and share no time series with the routing processor.
+//
+{
+    int i, j, p, k;
+
+    if ( Frames == NULL || NumThreads < 2 ) return FALSE;
+
+    // --- the runoff & routing threads need a core each
+#if defined(_OPENMP)
+    if ( omp_get_num_procs() < 2 ) return FALSE;
+#endif
+
+    // --- runoff results saved to interface file include reported rainfall
+    if ( Frunoff.mode == SAVE_FILE ) return FALSE;
+
+    // --- groundwater flow depends on the receiving node's depth & inflow
+    if ( !IgnoreGwater ) for (j = 0; j < Nobjects[SUBCATCH]; j++)
+    {
+        if ( Subcatch[j].groundwater ) return FALSE;
+    }
+
+    // --- storage exfiltration shares the infiltration module's state
+    for (i = 0; i < Nnodes[STORAGE]; i++)
+    {
+        if ( Storage[i].exfil ) return FALSE;
+    }
+
+    // --- outfall discharge can be routed back onto subcatchments
+    for (i = 0; i < Nnodes[OUTFALL]; i++)
+    {
+        if ( Outfall[i].routeTo >= 0 ) return FALSE;
+    }
+
+    // --- time series used by runoff can't also be used by routing
+    for (i = 0; i < Nobjects[GAGE]; i++)
+    {
+        if ( Gage[i].dataSource == RAIN_TSERIES &&
+             isRoutingTseries(Gage[i].tSeries) ) return FALSE;
+    }
+    if ( Temp.dataSource == TSERIES_TEMP && isRoutingTseries(Temp.tSeries) )
+        return FALSE;
+    if ( Evap.type == TIMESERIES_EVAP && isRoutingTseries(Evap.tSeries) )
+        return FALSE;
+    for (i = 0; i < Nobjects[LANDUSE]; i++)
+    {
+        for (p = 0; p < Nobjects[POLLUT]; p++)
+        {
+            if ( Landuse[i].buildupFunc[p].funcType != EXTERNAL_BUILDUP )
+                continue;
+            k = (int)Landuse[i].buildupFunc[p].coeff[2];
+            if ( isRoutingTseries(k) ) return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+//=============================================================================
+
+int isRoutingTseries(int k)
+//
+//  Input:   k = time series index
+//  Output:  returns TRUE if time series is used by the routing processor
+//  Purpose: checks if a time series supplies external inflows, outfall
+//           stages or control settings.
+//
+{
+    int i;
+    TExtInflow* inflow;
+
+    if ( k < 0 ) return FALSE;
+    for (i = 0; i < Nobjects[NODE]; i++)
+    {
+        for (inflow = Node[i].extInflow; inflow; inflow = inflow->next)
+        {
+            if ( inflow->tSeries == k ) return TRUE;
+        }
+    }
+    for (i = 0; i < Nnodes[OUTFALL]; i++)
+    {
+        if ( Outfall[i].type == TIMESERIES_OUTFALL &&
+             Outfall[i].stageSeries == k ) return TRUE;
+    }
+    return controls_usesTseries(k);
+}
+
+//=============================================================================
+
+int waitForFreeFrame()
+//
+//  Input:   none
+//  Output:  returns FALSE if routing no longer needs any frames
+//  Purpose: waits until the frame about to be saved is no longer in use
+//           by the routing processor.
+//
+{
+    int isFree = FALSE;
+    int isStopped = FALSE;
+    int tries = 0;
+
+#if defined(_OPENMP)
+    while ( TRUE )
+    {
+        omp_set_lock(&FrameLock);
+        isFree = (FramesSaved - FrameUsed < NumFrames);
+        isStopped = PipelineStopped;
+        omp_unset_lock(&FrameLock);
+        if ( isFree || isStopped ) break;
+        pauseThread(tries++);
+    }
+#endif
+    return !isStopped;
+}
+
+//=============================================================================
+
+void raiseError(int code, char* s)
+//
+//  Input:   code = error code
+//           s = text of error message (or NULL if none is written)
+//  Output:  none
+//  Purpose: raises an error found while computing runoff.
+//
+//  On the runoff thread the error is held, guarded by FrameLock, until the
+//  routing thread needs the frame it kept from being saved, so that only
+//  the routing thread sets ErrorCode and writes to the report file.
+//
+{
+#if defined(_OPENMP)
+    if ( OnRunoffThread )
+    {
+        omp_set_lock(&FrameLock);
+        if ( !PipelineError )
+        {
+            PipelineError = code;
+            PipelineErrorMsg = (s != NULL);
+            if ( s ) sstrncpy(PipelineErrorText, s, MAXMSG);
+        }
+        omp_unset_lock(&FrameLock);
+        return;
+    }
+#endif
+    if ( s ) report_writeErrorMsg(code, s);
+    else ErrorCode = code;
+}
+
+//=============================================================================
+
+int hasError()
+//
+//  Input:   none
+//  Output:  returns TRUE if an error keeps runoff from being computed
+//  Purpose: checks for an error raised by the thread computing runoff.
+//
+{
+#if defined(_OPENMP)
+    if ( OnRunoffThread ) return PipelineError != 0;
+#endif
+    return ErrorCode != 0;
+}
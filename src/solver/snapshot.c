@@ -0,0 +1,386 @@
+//-----------------------------------------------------------------------------
+//   snapshot.c
+//
+//   Project:  EPA SWMM5
+//   Version:  5.1
+//   Date:     (Build 5.1.015)
+//
+//   In-memory simulation state snapshots.
+//
+//   A snapshot is a copy, held in memory, of all of the state that a
+//   running simulation carries from one time step to the next: the
+//   simulation clocks, the dynamic properties of every gage, subcatchment,
+//   node and link (including groundwater, snow packs, LID units, pollutant
+//   buildup and quality), snow melt coefficients, infiltration and climate
+//   state, control rule PID errors, positions reached in input data files,
+//   the runoff results used by routing, mass balance totals and summary
+//   statistics. Restoring a snapshot returns the simulation to the time
+//   when it was taken, from which it proceeds exactly as it did before.
+//
+//   Each module that keeps such state in variables of its own supplies a
+//   xxx_snapshot() function that passes each of them, always in the same
+//   order, to snapshot_add(). The same function saves the state, checks
+//   that a snapshot matches the current project and restores the state,
+//   according to the snapshot's mode. A snapshot can only be restored
+//   into the run it was taken from.
+//
+//   Results already written to the binary output, report, recording and
+//   routing interface files are not rewound. Reporting periods reached
+//   again after a restore are saved once more, so these files hold the
+//   results in the order they were computed.
+//
+//-----------------------------------------------------------------------------
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdlib.h>
+#include <string.h>
+#include "headers.h"
+
+//-----------------------------------------------------------------------------
+//  Constants
+//-----------------------------------------------------------------------------
+enum SnapshotMode {SNAPSHOT_SAVE, SNAPSHOT_CHECK, SNAPSHOT_RESTORE};
+
+#define SNAPSHOT_BLOCK 65536           // initial size of snapshot data (bytes)
+
+//-----------------------------------------------------------------------------
+//  Data Structures
+//-----------------------------------------------------------------------------
+struct SM_Snapshot
+{
+    int     mode;                      // SNAPSHOT_SAVE, _CHECK or _RESTORE
+    int     run;                       // run in which snapshot was taken
+    int     failed;                    // TRUE if save or check failed
+    char*   data;                      // saved state values
+    size_t  size;                      // # bytes of data saved
+    size_t  capacity;                  // # bytes allocated for data
+    size_t  pos;                       // # bytes of data checked or restored
+};
+
+//-----------------------------------------------------------------------------
+//  Shared variables
+//-----------------------------------------------------------------------------
+static int  RunCount;                  // number of simulation runs started
+
+//-----------------------------------------------------------------------------
+//  Imported functions
+//-----------------------------------------------------------------------------
+extern void snapshotResultsStreams(TSnapshot* s);  // defined in toolkit.c
+
+//-----------------------------------------------------------------------------
+//  External functions (declared in funcs.h)
+//-----------------------------------------------------------------------------
+//  snapshot_newRun         (called by swmm_start in swmm5.c)
+//  snapshot_save           (called by swmm_saveSnapshot in toolkit.c)
+//  snapshot_restore        (called by swmm_restoreSnapshot in toolkit.c)
+//  snapshot_delete         (called by swmm_deleteSnapshot in toolkit.c)
+//  snapshot_add            (called by each module's xxx_snapshot function)
+//  snapshot_addFile        (called by each module's xxx_snapshot function)
+
+//-----------------------------------------------------------------------------
+//  Local functions
+//-----------------------------------------------------------------------------
+static void visitState(TSnapshot* s);
+static void visitObjects(TSnapshot* s);
+static int  growData(TSnapshot* s, size_t size);
+
+//=============================================================================
+
+void snapshot_newRun()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: marks the start of a new simulation run, making snapshots taken
+//           in earlier runs invalid.
+//
+{
+    RunCount++;
+}
+
+//=============================================================================
+
+TSnapshot* snapshot_save()
+//
+//  Input:   none
+//  Output:  returns a new snapshot (or NULL if out of memory)
+//  Purpose: saves the current state of a running simulation to a snapshot.
+//
+{
+    TSnapshot* s = (TSnapshot *) calloc(1, sizeof(TSnapshot));
+    if ( s == NULL ) return NULL;
+    s->mode = SNAPSHOT_SAVE;
+    s->run = RunCount;
+    visitState(s);
+    if ( s->failed )
+    {
+        snapshot_delete(s);
+        return NULL;
+    }
+    return s;
+}
+
+//=============================================================================
+
+int snapshot_restore(TSnapshot* s)
+//
+//  Input:   s = a snapshot
+//  Output:  returns TRUE if the snapshot was restored
+//  Purpose: returns a running simulation to the state saved in a snapshot.
+//
+{
+    if ( s == NULL || s->run != RunCount ) return FALSE;
+
+    // --- check that the whole snapshot matches the project before
+    //     changing any state
+    s->mode = SNAPSHOT_CHECK;
+    s->failed = FALSE;
+    s->pos = 0;
+    visitState(s);
+    if ( s->failed || s->pos != s->size ) return FALSE;
+
+    // --- restore the state
+    s->mode = SNAPSHOT_RESTORE;
+    s->pos = 0;
+    visitState(s);
+    return TRUE;
+}
+
+//=============================================================================
+
+void snapshot_delete(TSnapshot* s)
+//
+//  Input:   s = a snapshot
+//  Output:  none
+//  Purpose: frees the memory used by a snapshot.
+//
+{
+    if ( s == NULL ) return;
+    FREE(s->data);
+    free(s);
+}
+
+//=============================================================================
+
+void snapshot_add(TSnapshot* s, void* data, size_t size)
+//
+//  Input:   s = a snapshot
+//           data = pointer to a state variable or array (may be NULL)
+//           size = size of the data (bytes)
+//  Output:  none
+//  Purpose: saves, checks or restores the value of a block of state data.
+//
+//  Each block is preceded in the snapshot by its size so that a snapshot
+//  which does not match the current project is detected when checked.
+//
+{
+    size_t n;
+
+    if ( s->failed ) return;
+    if ( data == NULL ) size = 0;
+    switch ( s->mode )
+    {
+    case SNAPSHOT_SAVE:
+        if ( !growData(s, sizeof(size_t) + size) ) return;
+        memcpy(s->data + s->size, &size, sizeof(size_t));
+        if ( size > 0 ) memcpy(s->data + s->size + sizeof(size_t), data, size);
+        s->size += sizeof(size_t) + size;
+        break;
+
+    case SNAPSHOT_CHECK:
+        if ( s->pos + sizeof(size_t) > s->size )
+        {
+            s->failed = TRUE;
+            return;
+        }
+        memcpy(&n, s->data + s->pos, sizeof(size_t));
+        if ( n != size || s->pos + sizeof(size_t) + n > s->size )
+        {
+            s->failed = TRUE;
+            return;
+        }
+        s->pos += sizeof(size_t) + n;
+        break;
+
+    case SNAPSHOT_RESTORE:
+        if ( size > 0 ) memcpy(data, s->data + s->pos + sizeof(size_t), size);
+        s->pos += sizeof(size_t) + size;
+        break;
+    }
+}
+
+//=============================================================================
+
+void snapshot_addFile(TSnapshot* s, FILE* f)
+//
+//  Input:   s = a snapshot
+//           f = a data file being read or written (may be NULL)
+//  Output:  none
+//  Purpose: saves, checks or restores the position reached in a file.
+//
+{
+    long pos = -1;
+
+    if ( f && s->mode == SNAPSHOT_SAVE ) pos = ftell(f);
+    snapshot_add(s, &pos, sizeof(long));
+    if ( f && pos >= 0 && s->mode == SNAPSHOT_RESTORE )
+    {
+        fseek(f, pos, SEEK_SET);
+    }
+}
+
+//=============================================================================
+
+void visitState(TSnapshot* s)
+//
+//  Input:   s = a snapshot
+//  Output:  none
+//  Purpose: passes all of a running simulation's state to a snapshot.
+//
+{
+    // --- simulation clocks & counters
+    snapshot_add(s, &ReportTime, sizeof(double));
+    snapshot_add(s, &OldRunoffTime, sizeof(double));
+    snapshot_add(s, &NewRunoffTime, sizeof(double));
+    snapshot_add(s, &OldRoutingTime, sizeof(double));
+    snapshot_add(s, &NewRoutingTime, sizeof(double));
+    snapshot_add(s, &ElapsedTime, sizeof(double));
+    snapshot_add(s, &StepCount, sizeof(long));
+    snapshot_add(s, &NonConvergeCount, sizeof(long));
+
+    // --- state of each object
+    visitObjects(s);
+
+    // --- state kept by each computational module
+    climate_snapshot(s);
+    infil_snapshot(s);
+    lid_snapshot(s);
+    rdii_snapshot(s);
+    iface_snapshot(s);
+    controls_snapshot(s);
+    runoff_snapshot(s);
+    routing_snapshot(s);
+    massbal_snapshot(s);
+    stats_snapshot(s);
+    output_snapshot(s);
+    record_snapshot(s);
+    snapshotResultsStreams(s);
+}
+
+//=============================================================================
+
+void visitObjects(TSnapshot* s)
+//
+//  Input:   s = a snapshot
+//  Output:  none
+//  Purpose: passes the state of each project object to a snapshot.
+//
+//  Object arrays are saved whole; their pointer members refer to memory
+//  that lasts for the entire run and so are restored unchanged.
+//
+{
+    int i, j;
+    int nPolluts = Nobjects[POLLUT];
+    int nLanduses = Nobjects[LANDUSE];
+    size_t qualSize = nPolluts * sizeof(double);
+    TSubcatch* subcatch;
+    TExfil*    exfil;
+
+    // --- rain gages & time series (including their place in a data file)
+    snapshot_add(s, Gage, Nobjects[GAGE] * sizeof(TGage));
+    snapshot_add(s, Tseries, Nobjects[TSERIES] * sizeof(TTable));
+    for (i = 0; i < Nobjects[TSERIES]; i++)
+    {
+        snapshot_addFile(s, Tseries[i].file.file);
+    }
+
+    // --- snow melt parameter sets (whose melt coeffs. change daily)
+    snapshot_add(s, Snowmelt, Nobjects[SNOWMELT] * sizeof(TSnowmelt));
+
+    // --- subcatchments with their quality, buildup, groundwater & snow
+    snapshot_add(s, Subcatch, Nobjects[SUBCATCH] * sizeof(TSubcatch));
+    for (j = 0; j < Nobjects[SUBCATCH]; j++)
+    {
+        subcatch = &Subcatch[j];
+        snapshot_add(s, subcatch->oldQual, qualSize);
+        snapshot_add(s, subcatch->newQual, qualSize);
+        snapshot_add(s, subcatch->pondedQual, qualSize);
+        snapshot_add(s, subcatch->concPonded, qualSize);
+        snapshot_add(s, subcatch->totalLoad, qualSize);
+        snapshot_add(s, subcatch->surfaceBuildup, qualSize);
+        if ( subcatch->landFactor )
+        {
+            snapshot_add(s, subcatch->landFactor,
+                         nLanduses * sizeof(TLandFactor));
+            for (i = 0; i < nLanduses; i++)
+            {
+                snapshot_add(s, subcatch->landFactor[i].buildup, qualSize);
+            }
+        }
+        snapshot_add(s, subcatch->groundwater, sizeof(TGroundwater));
+        snapshot_add(s, subcatch->snowpack, sizeof(TSnowpack));
+    }
+
+    // --- nodes with their quality & storage unit exfiltration
+    snapshot_add(s, Node, Nobjects[NODE] * sizeof(TNode));
+    snapshot_add(s, Outfall, Nnodes[OUTFALL] * sizeof(TOutfall));
+    snapshot_add(s, Divider, Nnodes[DIVIDER] * sizeof(TDivider));
+    snapshot_add(s, Storage, Nnodes[STORAGE] * sizeof(TStorage));
+    for (j = 0; j < Nobjects[NODE]; j++)
+    {
+        snapshot_add(s, Node[j].oldQual, qualSize);
+        snapshot_add(s, Node[j].newQual, qualSize);
+    }
+    for (j = 0; j < Nnodes[OUTFALL]; j++)
+    {
+        snapshot_add(s, Outfall[j].wRouted, qualSize);
+    }
+    for (j = 0; j < Nnodes[STORAGE]; j++)
+    {
+        exfil = Storage[j].exfil;
+        if ( exfil == NULL ) continue;
+        snapshot_add(s, exfil, sizeof(TExfil));
+        snapshot_add(s, exfil->btmExfil, sizeof(TGrnAmpt));
+        snapshot_add(s, exfil->bankExfil, sizeof(TGrnAmpt));
+    }
+
+    // --- links with their quality
+    snapshot_add(s, Link, Nobjects[LINK] * sizeof(TLink));
+    snapshot_add(s, Conduit, Nlinks[CONDUIT] * sizeof(TConduit));
+    snapshot_add(s, Pump, Nlinks[PUMP] * sizeof(TPump));
+    snapshot_add(s, Orifice, Nlinks[ORIFICE] * sizeof(TOrifice));
+    snapshot_add(s, Weir, Nlinks[WEIR] * sizeof(TWeir));
+    snapshot_add(s, Outlet, Nlinks[OUTLET] * sizeof(TOutlet));
+    for (j = 0; j < Nobjects[LINK]; j++)
+    {
+        snapshot_add(s, Link[j].oldQual, qualSize);
+        snapshot_add(s, Link[j].newQual, qualSize);
+        snapshot_add(s, Link[j].totalLoad, qualSize);
+    }
+}
+
+//=============================================================================
+
+int growData(TSnapshot* s, size_t size)
+//
+//  Input:   s = a snapshot being saved
+//           size = # bytes about to be added to the snapshot
+//  Output:  returns TRUE if the snapshot has room for the bytes
+//  Purpose: enlarges the memory that holds a snapshot's data.
+//
+{
+    size_t capacity = s->capacity;
+    char*  data;
+
+    if ( s->size + size <= capacity ) return TRUE;
+    if ( capacity == 0 ) capacity = SNAPSHOT_BLOCK;
+    while ( capacity < s->size + size ) capacity *= 2;
+    data = (char *) realloc(s->data, capacity);
+    if ( data == NULL )
+    {
+        s->failed = TRUE;
+        return FALSE;
+    }
+    s->data = data;
+    s->capacity = capacity;
+    return TRUE;
+}
@@ -15,6 +15,12 @@
 //   - Area covered by snow now included in calculation of rate that liquid
 //     water leaves a snowpack.
 //
+//   Build 5.1.015:
+//   - Snow melt computed for all snow packs in a single batched pass that
+//     runs in parallel, with terms that are constant over a time step
+//     evaluated only once per step. Degree-day melt rates are found once
+//     per step for each set of melt parameters rather than for each pack.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -29,6 +35,37 @@
 // These symbolize the keywords listed in SnowmeltWords in keywords.c
 enum SnowKeywords {SNOW_PLOWABLE, SNOW_IMPERV, SNOW_PERV, SNOW_REMOVAL};
 
+//-----------------------------------------------------------------------------
+//  Data Structures
+//-----------------------------------------------------------------------------
+//  Melt process terms that are constant over a runoff time step
+typedef struct
+{
+    double tStep;             // time step (sec)
+    double ta;                // air temperature (deg F)
+    double rmeltT1;           // rain melt temperature term
+    double rmeltT2;           // rain melt wind/psychrometric term
+    double rmeltT3;           // rain melt vapor pressure term
+    double tipm;              // ATI weighting factor for time step
+}  TSnowStep;
+
+//-----------------------------------------------------------------------------
+//  Imported variables
+//-----------------------------------------------------------------------------
+// Declared in RUNOFF.C
+extern int     RunoffThreads;      // threads used by runoff's parallel loops
+
+//-----------------------------------------------------------------------------
+//  Shared variables
+//-----------------------------------------------------------------------------
+static int     NumPacks;           // number of subcatchments with snow packs
+static int*    PackSubcatch;       // subcatchment index of each snow pack
+static double* MeltPrecip[3];      // net precip. on each snow sub-area of
+                                   // each subcatchment (ft/sec)
+static double* DegDayMelt[3];      // degree-day melt rate on each snow
+                                   // sub-area of each melt parameter set
+                                   // for current time step (ft/sec)
+
 //-----------------------------------------------------------------------------
 //  External functions (declared in funcs.h)
 //-----------------------------------------------------------------------------
@@ -38,8 +75,11 @@ enum SnowKeywords {SNOW_PLOWABLE, SNOW_IMPERV, SNOW_PERV, SNOW_REMOVAL};
 //  snow_validateSnowmelt(called from project_validate)
 //  snow_readMeltParams  (called from parseLine in input.c)
 //  snow_setMeltCoeffs   (called from setTemp in climate.c)
+//  snow_open            (called from runoff_open)
+//  snow_close           (called from runoff_close)
 //  snow_plowSnow        (called from runoff_execute)
-//  snow_getSnowMelt     (called from subcatch_getRunoff)
+//  snow_execute         (called from runoff_execute)
+//  snow_getNetPrecip    (called from subcatch_getRunoff)
 //  snow_getSnowCover    (called from massbal_open)
 //  snow_getState        (called from saveRunoff in hotstart.c)
 
@@ -47,18 +87,20 @@ enum SnowKeywords {SNOW_PLOWABLE, SNOW_IMPERV, SNOW_PERV, SNOW_REMOVAL};
 //  Local functions
 //-----------------------------------------------------------------------------
 static void   setMeltParams(int i, int k, double x[]);
-static double getRainmelt(double rainfall);
+static void   setStepTerms(TSnowStep* step, double tStep);
+static void   getSnowMelt(TSnowStep* step, int j);
+static double getRainmelt(TSnowStep* step, double rainfall);
 static double getArealDepletion(TSnowpack* snowpack, int i, double snowfall,
               double tStep);
 static double getArealSnowCover(int i, double awesi);
-static double meltSnowpack(TSnowpack* snowpack, int i, double rmelt, double asc,
-              double snowfall, double tStep);
+static double meltSnowpack(TSnowStep* step, TSnowpack* snowpack, int i,
+              double rmelt, double asc, double snowfall);
 static double reduceColdContent(TSnowpack* snowpack, int i, double smelt,
               double ccFactor);
 static double routeSnowmelt(TSnowpack* snowpack, int i, double smelt, double asc,
               double rainfall, double tStep);
-static void   updateColdContent(TSnowpack* snowpack, int i, double asc,
-              double snowfall, double tStep);
+static void   updateColdContent(TSnowStep* step, TSnowpack* snowpack, int i,
+              double asc, double snowfall);
 
 
 //=============================================================================
@@ -214,6 +256,70 @@ void  snow_initSnowmelt(int j)
 
 //=============================================================================
 
+int snow_open()
+//
+//  Input:   none
+//  Output:  returns error code
+//  Purpose: allocates memory used to compute snow melt for all snow packs.
+//
+{
+    int i, j, n;
+
+    NumPacks = 0;
+    PackSubcatch = NULL;
+    for (i=0; i<3; i++)
+    {
+        MeltPrecip[i] = NULL;
+        DegDayMelt[i] = NULL;
+    }
+
+    // --- count subcatchments with snow packs
+    n = 0;
+    for (j=0; j<Nobjects[SUBCATCH]; j++)
+    {
+        if ( Subcatch[j].snowpack ) n++;
+    }
+    if ( n == 0 ) return 0;
+
+    // --- allocate memory
+    PackSubcatch = (int *) calloc(n, sizeof(int));
+    if ( PackSubcatch == NULL ) return ERR_MEMORY;
+    for (i=0; i<3; i++)
+    {
+        MeltPrecip[i] = (double *) calloc(Nobjects[SUBCATCH], sizeof(double));
+        DegDayMelt[i] = (double *) calloc(Nobjects[SNOWMELT], sizeof(double));
+        if ( MeltPrecip[i] == NULL || DegDayMelt[i] == NULL ) return ERR_MEMORY;
+    }
+
+    // --- build packed list of snow pack subcatchments
+    for (j=0; j<Nobjects[SUBCATCH]; j++)
+    {
+        if ( Subcatch[j].snowpack ) PackSubcatch[NumPacks++] = j;
+    }
+    return 0;
+}
+
+//=============================================================================
+
+void snow_close()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees memory used to compute snow melt for all snow packs.
+//
+{
+    int i;
+    FREE(PackSubcatch);
+    for (i=0; i<3; i++)
+    {
+        FREE(MeltPrecip[i]);
+        FREE(DegDayMelt[i]);
+    }
+    NumPacks = 0;
+}
+
+//=============================================================================
+
 void snow_validateSnowmelt(int j)
 //
 //  Input:   j = snowmelt parameter set index
@@ -452,32 +558,120 @@ void snow_plowSnow(int j, double tStep)
 
 //=============================================================================
 
-double snow_getSnowMelt(int j, double rainfall, double snowfall, double tStep,
-                        double netPrecip[])
+void snow_execute(double tStep)
+//
+//  Input:   tStep = time step (sec)
+//  Output:  none
+//  Purpose: computes snow melt from the snow packs of all subcatchments
+//           and updates their snow depths.
+//
+//  Snow packs are independent of one another once snow has been plowed
+//  between subcatchments, so they are analyzed in parallel. The resulting
+//  net precipitation on each sub-area is retrieved by snow_getNetPrecip.
+//
+{
+    int n;
+    TSnowStep step;
+
+    if ( NumPacks == 0 ) return;
+    setStepTerms(&step, tStep);
+
+#pragma omp parallel num_threads(RunoffThreads)
+{
+    #pragma omp for
+    for (n = 0; n < NumPacks; n++)
+    {
+        if ( Subcatch[PackSubcatch[n]].area > 0.0 )
+            getSnowMelt(&step, PackSubcatch[n]);
+    }
+}
+}
+
+//=============================================================================
+
+void snow_getNetPrecip(int j, double netPrecip[])
 //
 //  Input:   j = subcatchment index
-//           rainfall = rainfall (ft/sec)
-//           snowfall = snowfall (ft/sec)
-//           tStep = time step (sec)
-//  Output:  netPrecip = rainfall + snowmelt on each runoff sub-area (ft/sec),
-//           returns new snow depth over subcatchment
-//  Purpose: modifies rainfall input to subcatchment's sub-areas based on
-//           possible snow melt and updates snow depth over entire subcatchment.
+//  Output:  netPrecip = rainfall + snowmelt on each runoff sub-area (ft/sec)
+//  Purpose: retrieves the net precipitation found by snow_execute for a
+//           subcatchment's sub-areas.
+//
+{
+    int i;
+    for (i=SNOW_PLOWABLE; i<=SNOW_PERV; i++) netPrecip[i] = MeltPrecip[i][j];
+}
+
+//=============================================================================
+
+void setStepTerms(TSnowStep* step, double tStep)
+//
+//  Input:   tStep = time step (sec)
+//  Output:  step = melt process terms for current time step
+//  Purpose: evaluates melt process terms that are the same for all snow packs
+//           over the current time step.
+//
+{
+    int    i;                          // snow sub-area index
+    int    k;                          // snowmelt parameter set index
+    double uadj;                       // adjusted wind speed
+
+    step->tStep = tStep;
+    step->ta = Temp.ta;
+
+    // --- terms of the rain melt equation
+    uadj = 0.006 * Wind.ws;
+    step->rmeltT1 = Temp.ta - 32.0;
+    step->rmeltT2 = 7.5 * Temp.gamma * uadj;
+    step->rmeltT3 = 8.5 * uadj * (Temp.ea - 0.18);
+
+    // --- convert ATI weighting factor from 6-hr to tStep time basis
+    step->tipm = 1.0 - pow(1.0 - Snow.tipm, tStep / (6.0*3600.0));
+
+    // --- degree-day melt rates from the day's melt coeffs. (set by
+    //     snow_setMeltCoeffs) for each set of melt parameters
+    for (k=0; k<Nobjects[SNOWMELT]; k++)
+    {
+        for (i=SNOW_PLOWABLE; i<=SNOW_PERV; i++)
+        {
+            DegDayMelt[i][k] = Snowmelt[k].dhm[i] *
+                               (Temp.ta - Snowmelt[k].tbase[i]);
+        }
+    }
+}
+
+//=============================================================================
+
+void getSnowMelt(TSnowStep* step, int j)
+//
+//  Input:   step = melt process terms for current time step
+//           j = subcatchment index
+//  Output:  none
+//  Purpose: finds rainfall + snowmelt on each of a subcatchment's sub-areas
+//           and updates snow depth over the entire subcatchment.
 //
 {
     int     i;                         // snow sub-area index
+    int     k;                         // rain gage index
+    double  rainfall = 0.0;            // rainfall (ft/sec)
+    double  snowfall = 0.0;            // snowfall (ft/sec)
     double  rmelt;                     // melt rate when rain falling (ft/sec)
     double  smelt;                     // snow melt from sub-area (ft/sec)
     double  asc;                       // frac. of sub-area snow covered
     double  snowDepth = 0.0;           // snow depth on entire subcatchment (ft)
     double  impervPrecip;              // net precip. on imperv. area (ft/sec)
+    double  netPrecip[3];              // net precip. on each sub-area (ft/sec)
+    double  tStep = step->tStep;
     TSnowpack* snowpack;               // ptr. to snow pack object
 
     // --- get ptr. to subcatchment's snowpack
     snowpack = Subcatch[j].snowpack;
 
+    // --- get current rainfall or snowfall from rain gage (in ft/sec)
+    k = Subcatch[j].gage;
+    if ( k >= 0 ) gage_getPrecip(k, &rainfall, &snowfall);
+
     // --- compute snowmelt over entire subcatchment when rain falling
-    rmelt = getRainmelt(rainfall);
+    rmelt = getRainmelt(step, rainfall);
 
     // --- compute snow melt from each type of subarea
     for (i=SNOW_PLOWABLE; i<=SNOW_PERV; i++)
@@ -499,7 +693,7 @@ double snow_getSnowMelt(int j, double rainfall, double snowfall, double tStep,
         else
         {
             asc   = getArealDepletion(snowpack, i, snowfall, tStep);
-            smelt = meltSnowpack(snowpack, i, rmelt, asc, snowfall, tStep);
+            smelt = meltSnowpack(step, snowpack, i, rmelt, asc, snowfall);
             smelt = routeSnowmelt(snowpack, i, smelt, asc, rainfall, tStep);
         }
 
@@ -521,7 +715,10 @@ double snow_getSnowMelt(int j, double rainfall, double snowfall, double tStep,
         netPrecip[IMPERV0] = impervPrecip;
         netPrecip[IMPERV1] = impervPrecip;
     }
-    return snowDepth;
+
+    // --- save results
+    for (i=SNOW_PLOWABLE; i<=SNOW_PERV; i++) MeltPrecip[i][j] = netPrecip[i];
+    Subcatch[j].newSnowDepth = snowDepth;
 }
 
 //=============================================================================
@@ -668,15 +865,15 @@ double getArealSnowCover(int i, double awesi)
 
 //=============================================================================
 
-double meltSnowpack(TSnowpack* snowpack, int i, double rmelt, double asc,
-                    double snowfall, double tStep)
+double meltSnowpack(TSnowStep* step, TSnowpack* snowpack, int i, double rmelt,
+                    double asc, double snowfall)
 //
-//  Input:   snowpack = ptr. to snow pack object
+//  Input:   step     = melt process terms for current time step
+//           snowpack = ptr. to snow pack object
 //           i        = snow sub-area index
 //           rmelt    = melt rate if raining (ft/sec)
 //           asc      = fraction of area covered with snow
 //           snowfall = rate of snow fall (ft/sec)
-//           tStep    = time step (sec)
 //  Output:  returns snow melt rate (ft/sec)
 //  Purpose: computes rate of snow melt from snow sub-area.
 //
@@ -690,15 +887,12 @@ double meltSnowpack(TSnowpack* snowpack, int i, double rmelt, double asc,
     if ( rmelt > 0.0 ) smelt = rmelt;
 
     // --- else if air temp. >= base melt temp. then use degree-day eqn.
-    else if ( Temp.ta >= Snowmelt[k].tbase[i] )
-    {
-         smelt = Snowmelt[k].dhm[i] * (Temp.ta - Snowmelt[k].tbase[i]);
-    }
+    else if ( step->ta >= Snowmelt[k].tbase[i] ) smelt = DegDayMelt[i][k];
 
     // --- otherwise alter cold content and return 0
     else
     {
-        updateColdContent(snowpack, i, asc, snowfall, tStep);
+        updateColdContent(step, snowpack, i, asc, snowfall);
         return 0.0;
     }
 
@@ -706,7 +900,7 @@ double meltSnowpack(TSnowpack* snowpack, int i, double rmelt, double asc,
     smelt *= asc;
 
     // --- reduce cold content of melting pack
-    ccFactor = tStep * Snow.rnm * asc;
+    ccFactor = step->tStep * Snow.rnm * asc;
     smelt = reduceColdContent(snowpack, i, smelt, ccFactor);
     snowpack->ati[i] = Snowmelt[k].tbase[i];
     return smelt;
@@ -714,25 +908,21 @@ double meltSnowpack(TSnowpack* snowpack, int i, double rmelt, double asc,
 
 //=============================================================================
 
-double getRainmelt(double rainfall)
+double getRainmelt(TSnowStep* step, double rainfall)
 //
-//  Input:   rainfall = rainfall rate (ft/sec)
+//  Input:   step     = melt process terms for current time step
+//           rainfall = rainfall rate (ft/sec)
 //  Output:  returns snow melt rate (ft/sec)
 //  Purpose: computes rate of snow melt when rainfall occurs.
 //
 {
-    double uadj;                       // adjusted wind speed
-    double t1, t2, t3;
     double smelt;                      // snow melt in in/hr
 
     rainfall = rainfall * 43200.0;     // convert rain to in/hr
     if ( rainfall > 0.02 )
     {
-        uadj = 0.006 * Wind.ws;
-        t1 = Temp.ta - 32.0;
-        t2 = 7.5 * Temp.gamma * uadj;
-        t3 = 8.5 * uadj * (Temp.ea - 0.18);
-        smelt =  t1 * (0.001167 + t2 +  0.007 * rainfall) + t3;
+        smelt = step->rmeltT1 * (0.001167 + step->rmeltT2 + 0.007 * rainfall)
+                + step->rmeltT3;
         return smelt / 43200.0;
     }
     else return 0.0;
@@ -740,14 +930,14 @@ double getRainmelt(double rainfall)
 
 //=============================================================================
 
-void updateColdContent(TSnowpack* snowpack, int i, double asc, double snowfall,
-                       double tStep)
+void updateColdContent(TSnowStep* step, TSnowpack* snowpack, int i, double asc,
+                       double snowfall)
 //
-//  Input:   snowpack = ptr. to snow pack object
+//  Input:   step     = melt process terms for current time step
+//           snowpack = ptr. to snow pack object
 //           i        = snow sub-area index
 //           asc      = fraction of area snow covered
 //           snowfall = snow fall rate (ft/sec)
-//           tStep    = time step (sec)
 //  Output:  none
 //  Purpose: updates cold content of snow pack under non-melting conditions.
 //
@@ -756,21 +946,18 @@ void updateColdContent(TSnowpack* snowpack, int i, double asc, double snowfall,
     double ati;                        // antecdent temperature index (deg F)
     double cc;                         // snow pack cold content (ft)
     double ccMax;                      // max. possible cold content (ft)
-    double tipm;                       // adjusted ATI weighting factor
+    double ta = step->ta;              // air temperature (deg F)
 
     // --- retrieve ATI & CC from snow pack object
     ati = snowpack->ati[i];
     cc = snowpack->coldc[i];
 
     // --- if snowing, ATI = snow (air) temperature
-    if ( snowfall * 43200.0 > 0.02) ati = Temp.ta;
+    if ( snowfall * 43200.0 > 0.02) ati = ta;
 	else
 	{
-	    // convert ATI weighting factor from 6-hr to tStep time basis
-	    tipm = 1.0 - pow(1.0 - Snow.tipm, tStep / (6.0*3600.0));
-		
-		// update ATI
-		ati += tipm * (Temp.ta - ati);
+		// update ATI (using weighting factor for tStep time basis)
+		ati += step->tipm * (ta - ati);
 	}
 
     // --- ATI cannot exceed snow melt base temperature
@@ -778,7 +965,7 @@ void updateColdContent(TSnowpack* snowpack, int i, double asc, double snowfall,
     ati = MIN(ati, Snowmelt[k].tbase[i]);
 
     // --- update cold content
-    cc += Snow.rnm * Snowmelt[k].dhm[i] * (ati - Temp.ta) * tStep * asc;
+    cc += Snow.rnm * Snowmelt[k].dhm[i] * (ati - ta) * step->tStep * asc;
     cc = MAX(cc, 0.0);
 
     // --- maximum cold content based on assumed specific heat of snow
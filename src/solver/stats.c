@@ -36,6 +36,9 @@
 //   - Statistics on impervious and pervious runoff totals added.
 //   - Storage nodes with a non-zero surcharge depth (e.g. enclosed tanks)
 //     can now be classified as being surcharged.
+//
+//   Build 5.1.015:
+//   - New function stats_snapshot() saves and restores the statistics.
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -87,6 +90,7 @@ extern double*         NodeOutflow;    // defined in massbal.c
 //  stats_updateFlowStats         (called from routing_execute)
 //  stats_updateCriticalTimeCount (called from getVariableStep in dynwave.c)
 //  stats_updateMaxNodeDepth      (called from output_saveNodeResults)
+//  stats_snapshot                (called from visitState in snapshot.c)
 
 //-----------------------------------------------------------------------------
 //  Local functions
@@ -315,6 +319,33 @@ void  stats_close()
 
 //=============================================================================
 
+void  stats_snapshot(TSnapshot* s)
+//
+//  Input:   s = a simulation state snapshot
+//  Output:  none
+//  Purpose: saves or restores the simulation statistics gathered so far.
+//
+{
+    int j;
+
+    snapshot_add(s, &SysStats, sizeof(TSysStats));
+    snapshot_add(s, &MaxOutfallFlow, sizeof(double));
+    snapshot_add(s, &MaxRunoffFlow, sizeof(double));
+    snapshot_add(s, SubcatchStats, Nobjects[SUBCATCH] * sizeof(TSubcatchStats));
+    snapshot_add(s, NodeStats, Nobjects[NODE] * sizeof(TNodeStats));
+    snapshot_add(s, LinkStats, Nobjects[LINK] * sizeof(TLinkStats));
+    snapshot_add(s, StorageStats, Nnodes[STORAGE] * sizeof(TStorageStats));
+    snapshot_add(s, OutfallStats, Nnodes[OUTFALL] * sizeof(TOutfallStats));
+    snapshot_add(s, PumpStats, Nlinks[PUMP] * sizeof(TPumpStats));
+    if ( OutfallStats ) for ( j = 0; j < Nnodes[OUTFALL]; j++ )
+    {
+        snapshot_add(s, OutfallStats[j].totalLoad,
+                     Nobjects[POLLUT] * sizeof(double));
+    }
+}
+
+//=============================================================================
+
 void  stats_report()
 //
 //  Input:   none
@@ -45,6 +45,19 @@
 //   - Support added for monthly adjustment of subcatchment's depression
 //     storage, pervious N, and infiltration.
 //
+//   Build 5.1.015:
+//   - Groundwater is updated after all subcatchments are analyzed instead
+//     of from within subcatch_getRunoff().
+//   - Snow melt is computed for all subcatchments before they are analyzed.
+//   - Weighted outflows and reported results are taken from the runoff
+//     results frame currently used by routing.
+//   - Runoff from a subcatchment's non-LID area is computed by
+//     subcatch_getSurfaceRunoff() for all subcatchments before their LID
+//     units are analyzed together, and the results are then combined by
+//     subcatch_getRunoff().
+//   - Rain gage isUsed property set atomically so that subcatchments can be
+//     validated in parallel.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -76,9 +89,28 @@ double     VlidOut;       // surface outflow from LID units
 double     VlidDrain;     // drain outflow from LID units
 double     VlidReturn;    // LID outflow returned to pervious area
 
+//-----------------------------------------------------------------------------
+// Data Structures
+//-----------------------------------------------------------------------------
+// Volumes (ft3) and runoff found for a subcatchment's non-LID area by
+// subcatch_getSurfaceRunoff() for use by subcatch_getRunoff()
+typedef struct
+{
+    double    vRunon;             // runon volume from other areas
+    double    vImpervRunoff;      // impervious area runoff volume
+    double    vPervRunoff;        // pervious area runoff volume
+    double    runoff;             // total runoff flow on subcatch (cfs)
+    double    vEvap;              // evaporation
+    double    vPevap;             // pervious area evaporation
+    double    vInfil;             // non-LID infiltration
+    double    vInflow;            // precip + snowmelt + runon + ponded water
+    double    vOutflow;           // runoff to subcatchment's outlet
+}   TSubcatchStep;
+
 //-----------------------------------------------------------------------------
 // Locally shared variables   
 //-----------------------------------------------------------------------------
+static  TSubcatchStep* SubStep;   // non-LID results for each subcatchment     //(5.1.015)
 static  TSubarea* theSubarea;     // subarea to which getDdDt() is applied
 static  double    Dstore;         // monthly adjusted depression storage (ft)  //(5.1.013)
 static  double    Alpha;          // monthly adjusted runoff coeff.            //
@@ -94,11 +126,14 @@ static  char *RunoffRoutingWords[] = { w_OUTLET,  w_IMPERV, w_PERV, NULL};
 
 //  subcatch_validate          (called from project_validate)
 //  subcatch_initState         (called from project_init)
+//  subcatch_open              (called from runoff_open)
+//  subcatch_close             (called from runoff_close)
 
 //  subcatch_setOldState       (called from runoff_execute)
 //  subcatch_getRunon          (called from runoff_execute)
 //  subcatch_addRunon          (called from subcatch_getRunon,
 //                              lid_addDrainRunon, & runoff_getOutfallRunon)
+//  subcatch_getSurfaceRunoff  (called from runoff_execute)
 //  subcatch_getRunoff         (called from runoff_execute)
 //  subcatch_hadRunoff         (called from runoff_execute)
 
@@ -113,7 +148,7 @@ static  char *RunoffRoutingWords[] = { w_OUTLET,  w_IMPERV, w_PERV, NULL};
 //-----------------------------------------------------------------------------
 // Function declarations
 //-----------------------------------------------------------------------------
-static void   getNetPrecip(int j, double* netPrecip, double tStep);
+static void   getNetPrecip(int j, double* netPrecip);                          //(5.1.015)
 static double getSubareaRunoff(int subcatch, int subarea, double area,
               double rainfall, double evap, double tStep);
 static double getSubareaInfil(int j, TSubarea* subarea, double precip,
@@ -419,7 +454,11 @@ void  subcatch_validate(int j)
 
     // --- set isUsed property of subcatchment's rain gage                     //(5.1.013)
     i = Subcatch[j].gage;                                                      //
-    if (i >= 0) Gage[i].isUsed = TRUE;                                         //
+    if (i >= 0)                                                                //(5.1.015)
+    {                                                                          //
+#pragma omp atomic write                                                       //
+        Gage[i].isUsed = TRUE;                                                 //
+    }                                                                          //
 
 }
 
@@ -637,29 +676,61 @@ void  subcatch_addRunonFlow(int k, double q)
 
 //=============================================================================
 
-double subcatch_getRunoff(int j, double tStep)
+////  New function added to release 5.1.015.  ////                             //(5.1.015)
+
+int subcatch_open()
+//
+//  Input:   none
+//  Output:  returns an error code
+//  Purpose: allocates memory used to save the non-LID runoff results of
+//           each subcatchment over a time step.
+//
+{
+    SubStep = NULL;
+    if ( Nobjects[SUBCATCH] == 0 ) return 0;
+    SubStep = (TSubcatchStep *) calloc(Nobjects[SUBCATCH],
+                                       sizeof(TSubcatchStep));
+    if ( SubStep == NULL ) return ERR_MEMORY;
+    return 0;
+}
+
+//=============================================================================
+
+////  New function added to release 5.1.015.  ////                             //(5.1.015)
+
+void subcatch_close()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees memory used to save subcatchment non-LID runoff results.
+//
+{
+    FREE(SubStep);
+}
+
+//=============================================================================
+
+////  New function added to release 5.1.015.  ////                             //(5.1.015)
+
+void subcatch_getSurfaceRunoff(int j, double tStep)
 //
 //  Input:   j = subcatchment index
 //           tStep = time step (sec)
-//  Output:  returns total runoff produced by subcatchment (ft/sec)
-//  Purpose: Computes runoff & new storage depth for subcatchment.
-//
-//  The 'runoff' value returned by this function is the total runoff
-//  generated (in ft/sec) by the subcatchment before any internal
-//  re-routing is applied. It is used to compute pollutant washoff.
+//  Output:  none
+//  Purpose: computes runoff & new storage depth for the non-LID area of a
+//           subcatchment and the inflow it sends to the subcatchment's
+//           LID units.
 //
-//  The 'outflow' value computed here (in cfs) is the surface runoff
-//  that actually leaves the subcatchment after any LID controls are
-//  applied and is saved to Subcatch[j].newRunoff. 
+//  The LID units of all subcatchments are analyzed by lid_execute once
+//  this function has been called for each subcatchment. The results saved
+//  here are then used by subcatch_getRunoff.
 //
 {
     int    i;                          // subarea index
     double nonLidArea;                 // non-LID portion of subcatch area (ft2)
     double area;                       // sub-area or subcatchment area (ft2)
     double netPrecip[3];               // subarea net precipitation (ft/sec)
-    double vRain;                      // rainfall (+ snowfall) volume (ft3)
     double vRunon    = 0.0;            // runon volume from other areas (ft3)
-    double vOutflow  = 0.0;            // runoff volume leaving subcatch (ft3)
     double runoff    = 0.0;            // total runoff flow on subcatch (cfs)
     double evapRate  = 0.0;            // potential evaporation rate (ft/sec)
     double subAreaRunoff;              // sub-area runoff rate (cfs)           //(5.1.013)
@@ -671,11 +742,6 @@ double subcatch_getRunoff(int j, double tStep)
     Vpevap    = 0.0;
     Vinfil    = 0.0;
     Voutflow  = 0.0;
-    VlidIn    = 0.0;
-    VlidInfil = 0.0;
-    VlidOut   = 0.0;
-    VlidDrain = 0.0;
-    VlidReturn = 0.0;
 
     // --- find volume of inflow to non-LID portion of subcatchment as existing
     //     ponded water + any runon volume from upstream areas;
@@ -690,7 +756,7 @@ double subcatch_getRunoff(int j, double tStep)
 
     // --- get net precip. (rainfall + snowfall + snowmelt) on the 3 types
     //     of subcatchment sub-areas and update Vinflow with it
-    getNetPrecip(j, netPrecip, tStep);
+    getNetPrecip(j, netPrecip);                                                //(5.1.015)
 
     // --- find potential evaporation rate
     if ( Evap.dryOnly && Subcatch[j].rainfall > 0.0 ) evapRate = 0.0;
@@ -714,6 +780,61 @@ double subcatch_getRunoff(int j, double tStep)
         runoff += subAreaRunoff;                                               //
     }
 
+    // --- find the inflow to any LID units to be analyzed by lid_execute
+    if ( Subcatch[j].lidArea > 0.0 )
+    {
+        lid_setGroupInflows(j, tStep);
+    }
+
+    // --- save results for use by subcatch_getRunoff
+    SubStep[j].vRunon = vRunon;
+    SubStep[j].vImpervRunoff = vImpervRunoff;
+    SubStep[j].vPervRunoff = vPervRunoff;
+    SubStep[j].runoff = runoff;
+    SubStep[j].vEvap = Vevap;
+    SubStep[j].vPevap = Vpevap;
+    SubStep[j].vInfil = Vinfil;
+    SubStep[j].vInflow = Vinflow;
+    SubStep[j].vOutflow = Voutflow;
+}
+
+//=============================================================================
+
+double subcatch_getRunoff(int j, double tStep)
+//
+//  Input:   j = subcatchment index
+//           tStep = time step (sec)
+//  Output:  returns total runoff produced by subcatchment (ft/sec)
+//  Purpose: Computes runoff & new storage depth for subcatchment.
+//
+//  The 'runoff' value returned by this function is the total runoff
+//  generated (in ft/sec) by the subcatchment before any internal
+//  re-routing is applied. It is used to compute pollutant washoff.
+//
+//  The 'outflow' value computed here (in cfs) is the surface runoff
+//  that actually leaves the subcatchment after any LID controls are
+//  applied and is saved to Subcatch[j].newRunoff. 
+//
+//  Runoff from the subcatchment's non-LID area must first have been found
+//  by subcatch_getSurfaceRunoff and its LID units analyzed by lid_execute.
+//
+{
+    double area;                       // subcatchment area (ft2)
+    double vRain;                      // rainfall (+ snowfall) volume (ft3)
+    double vOutflow  = 0.0;            // runoff volume leaving subcatch (ft3)
+
+    // --- restore shared water balance variables for the non-LID area
+    Vevap     = SubStep[j].vEvap;
+    Vpevap    = SubStep[j].vPevap;
+    Vinfil    = SubStep[j].vInfil;
+    Vinflow   = SubStep[j].vInflow;
+    Voutflow  = SubStep[j].vOutflow;
+    VlidIn    = 0.0;
+    VlidInfil = 0.0;
+    VlidOut   = 0.0;
+    VlidDrain = 0.0;
+    VlidReturn = 0.0;
+
     // --- evaluate any LID treatment provided (updating Vevap,
     //     Vpevap, VlidInfil, VlidIn, VlidOut, & VlidDrain)
     if ( Subcatch[j].lidArea > 0.0 )
@@ -721,10 +842,11 @@ double subcatch_getRunoff(int j, double tStep)
         lid_getRunoff(j, tStep);
     }
 
-    // --- update groundwater levels & flows if applicable
+    // --- save losses to groundwater if applicable (groundwater levels &
+    //     flows are updated for all subcatchments by gwater_execute)
     if ( !IgnoreGwater && Subcatch[j].groundwater )
     {
-        gwater_getGroundwater(j, Vpevap, Vinfil+VlidInfil, tStep);
+        gwater_setSurfaceLosses(j, Vpevap, Vinfil+VlidInfil);
     }
 
     // --- save subcatchment's total loss rates (ft/s)
@@ -743,8 +865,9 @@ double subcatch_getRunoff(int j, double tStep)
     vRain = Subcatch[j].rainfall * tStep * area;
 
     // --- update the cumulative stats for this subcatchment
-    stats_updateSubcatchStats(j, vRain, vRunon, Vevap, Vinfil + VlidInfil,
-        vImpervRunoff, vPervRunoff, vOutflow + VlidDrain,                      //(5.1.013)
+    stats_updateSubcatchStats(j, vRain, SubStep[j].vRunon, Vevap,
+        Vinfil + VlidInfil, SubStep[j].vImpervRunoff,                          //(5.1.013)
+        SubStep[j].vPervRunoff, vOutflow + VlidDrain,                          //
         Subcatch[j].newRunoff + VlidDrain/tStep);
 
     // --- include this subcatchment's contribution to overall flow balance
@@ -761,17 +884,16 @@ double subcatch_getRunoff(int j, double tStep)
     massbal_updateRunoffTotals(RUNOFF_RUNOFF, vOutflow);
 
     // --- return area-averaged runoff (ft/s)
-    return runoff / area;
+    return SubStep[j].runoff / area;
 }
 
 //=============================================================================
 
-void getNetPrecip(int j, double* netPrecip, double tStep)
+void getNetPrecip(int j, double* netPrecip)                                    //(5.1.015)
 {
 //
 //  Purpose: Finds combined rainfall + snowmelt on a subcatchment.
 //  Input:   j = subcatchment index
-//           tStep = time step (sec)
 //  Output:  netPrecip = rainfall + snowmelt over each type of subarea (ft/s)
 //
     int    i, k;
@@ -790,11 +912,11 @@ void getNetPrecip(int j, double* netPrecip, double tStep)
 
     // --- determine net precipitation input (netPrecip) to each sub-area
 
-    // --- if subcatch has a snowpack, then base netPrecip on possible snow melt
+    // --- if subcatch has a snowpack, then base netPrecip on the snow melt
+    //     found for the current time step by snow_execute
     if ( Subcatch[j].snowpack && !IgnoreSnowmelt )
     {
-        Subcatch[j].newSnowDepth = 
-            snow_getSnowMelt(j, rainfall, snowfall, tStep, netPrecip);
+        snow_getNetPrecip(j, netPrecip);
     }
 
     // --- otherwise netPrecip is just sum of rainfall & snowfall
@@ -857,8 +979,10 @@ double subcatch_getWtdOutflow(int j, double f)
 //  Purpose: computes wtd. combination of old and new subcatchment runoff.
 //
 {
+    TSubcatchFrame* s = &runoff_getFrame()->subcatch[j];
+
     if ( Subcatch[j].area == 0.0 ) return 0.0;
-    return (1.0 - f) * Subcatch[j].oldRunoff + f * Subcatch[j].newRunoff;
+    return (1.0 - f) * s->oldRunoff + f * s->newRunoff;
 }
 
 //=============================================================================
@@ -877,6 +1001,9 @@ void  subcatch_getResults(int j, double f, float x[])
     double z;
     double runoff;
     TGroundwater* gw;                  // ptr. to groundwater object
+    TSubcatchFrame* s;                 // ptr. to saved runoff results
+
+    s = &runoff_getFrame()->subcatch[j];
 
     // --- retrieve rainfall for current report period
     k = Subcatch[j].gage;
@@ -884,20 +1011,18 @@ void  subcatch_getResults(int j, double f, float x[])
     else          x[SUBCATCH_RAINFALL] = 0.0f;
 
     // --- retrieve snow depth
-    z = ( f1 * Subcatch[j].oldSnowDepth +
-          f * Subcatch[j].newSnowDepth ) * UCF(RAINDEPTH);
+    z = ( f1 * s->oldSnowDepth + f * s->newSnowDepth ) * UCF(RAINDEPTH);
     x[SUBCATCH_SNOWDEPTH] = (float)z;
 
     // --- retrieve runoff and losses
-    x[SUBCATCH_EVAP] = (float)(Subcatch[j].evapLoss * UCF(EVAPRATE));
-    x[SUBCATCH_INFIL] = (float)(Subcatch[j].infilLoss * UCF(RAINFALL));
-    runoff = f1 * Subcatch[j].oldRunoff + f * Subcatch[j].newRunoff;
+    x[SUBCATCH_EVAP] = (float)(s->evapLoss * UCF(EVAPRATE));
+    x[SUBCATCH_INFIL] = (float)(s->infilLoss * UCF(RAINFALL));
+    runoff = f1 * s->oldRunoff + f * s->newRunoff;
 
     // --- add any LID drain flow to reported runoff
     if ( Subcatch[j].lidArea > 0.0 )
     {
-        runoff += f1 * lid_getDrainFlow(j, PREVIOUS) +
-                  f * lid_getDrainFlow(j, CURRENT);
+        runoff += f1 * s->oldLidDrain + f * s->newLidDrain;
     }
 
     // --- if runoff is really small, report it as zero
@@ -908,11 +1033,11 @@ void  subcatch_getResults(int j, double f, float x[])
     gw = Subcatch[j].groundwater;
     if ( gw )
     {
-        z = (f1 * gw->oldFlow + f * gw->newFlow) * Subcatch[j].area * UCF(FLOW);
+        z = (f1 * s->oldGwFlow + f * s->newGwFlow) * Subcatch[j].area * UCF(FLOW);
         x[SUBCATCH_GW_FLOW] = (float)z;
-        z = (gw->bottomElev + gw->lowerDepth) * UCF(LENGTH);
+        z = s->gwElev * UCF(LENGTH);
         x[SUBCATCH_GW_ELEV] = (float)z;
-        z = gw->theta;
+        z = s->gwTheta;
         x[SUBCATCH_SOIL_MOIST] = (float)z;
     }
     else
@@ -926,7 +1051,7 @@ void  subcatch_getResults(int j, double f, float x[])
     if ( !IgnoreQuality ) for (p = 0; p < Nobjects[POLLUT]; p++ )
     {
         if ( runoff == 0.0 ) z = 0.0;
-        else z = f1 * Subcatch[j].oldQual[p] + f * Subcatch[j].newQual[p];
+        else z = f1 * s->oldQual[p] + f * s->newQual[p];
         x[SUBCATCH_WASHOFF+p] = (float)z;
     }
 }
@@ -306,8 +306,10 @@ double surfqual_getWtdWashoff(int j, int p, double f)
 //  Purpose: finds wtd. combination of old and new washoff for a pollutant.
 //
 {
-    return (1.0 - f) * Subcatch[j].oldRunoff * Subcatch[j].oldQual[p] +
-           f * Subcatch[j].newRunoff *Subcatch[j].newQual[p];
+    TSubcatchFrame* s = &runoff_getFrame()->subcatch[j];                       //(5.1.015)
+
+    return (1.0 - f) * s->oldRunoff * s->oldQual[p] +                          //(5.1.015)
+           f * s->newRunoff * s->newQual[p];                                   //(5.1.015)
 }
 
 //=============================================================================
@@ -39,6 +39,10 @@
 //   - Support added for saving average results within a reporting period.
 //   - SWMM engine now always compiled to a shared object library.
 //
+//   Build 5.1.015:
+//   - Reentrant string tokenizer sstrtok() added.
+//   - Function pauseThread() added for threads that wait on one another.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -72,6 +76,10 @@
 #ifdef EXH
   #include <excpt.h>
 #endif
+#ifndef WINDOWS                                                                //(5.1.015)
+  #include <sched.h>                                                           //
+  #include <unistd.h>                                                          //
+#endif                                                                         //
 
 
 // --- define DLLEXPORT
@@ -116,6 +124,8 @@
 #include "swmm5.h"                     // declaration of exportable functions
                                        //   callable from other programs
 #define  MAX_EXCEPTIONS 100            // max. number of exceptions handled
+#define  YIELD_TRIES    100            // checks made before a waiting         //(5.1.015)
+                                       //   thread sleeps                      //
 
 //-----------------------------------------------------------------------------
 //  Unit conversion factors
@@ -179,6 +189,11 @@ static int  xfilter(int xc, char* module, double elapsedTime, long step);
 extern int swmm_run_cb(const char *f1, const char *f2, const char *f3,
     void (*callback) (double *));
 
+// Forward declarations, defined in toolkit.c                                 //(5.1.015)
+extern void startResultsStreams(void);                                         //(5.1.015)
+extern void saveResultsStreams(void);                                          //
+extern void closeResultsStreams(void);                                         //
+
 //=============================================================================
 
 int DLLEXPORT swmm_run(const char* f1, const char* f2, const char* f3)
@@ -290,6 +305,9 @@ int DLLEXPORT swmm_start(int saveResults)
         NonConvergeCount = 0;
         IsStartedFlag = TRUE;
 
+        // --- invalidate snapshots saved in earlier runs                      //(5.1.015)
+        snapshot_newRun();                                                     //(5.1.015)
+
         // --- initialize global continuity errors
         RunoffError = 0.0;
         GwaterError = 0.0;
@@ -313,6 +331,12 @@ int DLLEXPORT swmm_start(int saveResults)
         // --- open binary output file
         output_open();
 
+        // --- open result recording file                                      //(5.1.015)
+        record_open();                                                         //(5.1.015)
+
+        // --- start streaming results to a toolkit callback                   //(5.1.015)
+        startResultsStreams();                                                 //(5.1.015)
+
         // --- open runoff processor
         if ( DoRunoff ) runoff_open();
 
@@ -407,6 +431,12 @@ int DLLEXPORT swmm_step(double* elapsedTime)
         }
 ////
 
+        // --- save results of elements whose recording time was reached       //(5.1.015)
+        record_saveResults();                                                  //(5.1.015)
+
+        // --- pass subscribed results to a toolkit callback if called for     //(5.1.015)
+        saveResultsStreams();                                                  //(5.1.015)
+
         // --- update elapsed time (days)
         if ( NewRoutingTime < TotalDuration )
         {
@@ -465,7 +495,13 @@ void execRouting()
         }
 
         // --- compute runoff until next routing time reached or exceeded
-        if ( DoRunoff ) while ( NewRunoffTime < nextRoutingTime )
+        //     (or wait for the runoff thread to do so if pipelined)
+        if ( DoRunoff && runoff_isPipelined() )                                //(5.1.015)
+        {                                                                      //(5.1.015)
+            runoff_waitForFrame(nextRoutingTime);                              //(5.1.015)
+            if ( ErrorCode ) return;                                           //(5.1.015)
+        }                                                                      //(5.1.015)
+        else if ( DoRunoff ) while ( NewRunoffTime < nextRoutingTime )
         {
             runoff_execute();
             if ( ErrorCode ) return;
@@ -512,6 +548,7 @@ int DLLEXPORT swmm_end(void)
     {
         // --- write ending records to binary output file
         if ( Fout.file ) output_end();
+        record_close();                                                        //(5.1.015)
 
         // --- report mass balance results and system statistics
         if ( !ErrorCode )
@@ -562,6 +599,7 @@ int DLLEXPORT swmm_close()
 {
     if ( Fout.file ) output_close();
     if ( IsOpenFlag ) project_close();
+    closeResultsStreams();                                                     //(5.1.015)
     report_writeSysTime();
     if ( Finp.file != NULL ) fclose(Finp.file);
     if ( Frpt.file != NULL ) fclose(Frpt.file);
@@ -687,6 +725,32 @@ char* sstrncpy(char *dest, const char *src, size_t maxlen)
 
 //=============================================================================
 
+char* sstrtok(char *s, const char *delim, char **next)
+//
+//  Input:   s = string to be parsed (or NULL to continue with the last one)
+//           delim = string of token delimiters
+//           next = where parsing of the string continues
+//  Output:  returns a pointer to the next token (or NULL if none is left)
+//  Purpose: version of standard strtok function that can be called by
+//           several threads at once.
+//
+{
+    if ( s == NULL ) s = *next;
+    if ( s == NULL ) return NULL;
+    s += strspn(s, delim);
+    if ( *s == '\0' )
+    {
+        *next = NULL;
+        return NULL;
+    }
+    *next = s + strcspn(s, delim);
+    if ( **next != '\0' ) *(*next)++ = '\0';
+    else *next = NULL;
+    return s;
+}
+
+//=============================================================================
+
 int  strcomp(char *s1, char *s2)
 //
 //  Input:   s1 = a character string
@@ -752,6 +816,26 @@ char* getTempFileName(char* fname)
 
 //=============================================================================
 
+void pauseThread(int tries)
+//
+//  Input:   tries = number of times a waiting thread has found that it
+//                   must keep waiting
+//  Output:  none
+//  Purpose: pauses a thread that waits on another one, at first yielding
+//           its processor and then sleeping for 1 msec between checks.
+//
+{
+#ifdef WINDOWS
+    if ( tries < YIELD_TRIES ) SwitchToThread();
+    else Sleep(1);
+#else
+    if ( tries < YIELD_TRIES ) sched_yield();
+    else usleep(1000);
+#endif
+}
+
+//=============================================================================
+
 void getElapsedTime(DateTime aDate, int* days, int* hrs, int* mins)
 //
 //  Input:   aDate = simulation calendar date + time
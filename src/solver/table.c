@@ -22,6 +22,14 @@
 //     table_getArea, and table_getInverseArea) were made thread-safe (thanks to
 //     suggestions by CHI).
 //
+//   Build 5.1.015:
+//   - Table entries are allocated from the project's curve and time series
+//     memory pools and are freed with them rather than one at a time.
+//   - Lines of time series files parsed with reentrant sstrtok().
+//   - Time series data in the input file are noted when first read and are
+//     only loaded, for the dates covering the simulation period, once the
+//     series is known to be used.
+//
 //-----------------------------------------------------------------------------
 #define _CRT_SECURE_NO_DEPRECATE
 
@@ -30,12 +38,37 @@
 #include <string.h>
 #include "headers.h"
 
+//-----------------------------------------------------------------------------
+//  Data Structures
+//-----------------------------------------------------------------------------
+typedef struct                                                                 //(5.1.015)
+{                                                                              //
+    TTable*  table;          // time series being loaded (or NULL)             //
+    DateTime start;          // start of period of dates kept                  //
+    DateTime end;            // end of period of dates kept                    //
+    int      trimming;       // TRUE while dates outside period are dropped    //
+    int      passedEnd;      // TRUE once a date past the period is kept       //
+    int      count;          // number of entries read so far                  //
+    int      held;           // number of entries held before period (0 - 2)   //
+    double   x[2], y[2];     // entries held before the period                 //
+    double   lastX, lastY;   // last entry read                                //
+    int      lastKept;       // TRUE if last entry was added to the series     //
+    double   dxMin;          // smallest interval between all dates read       //
+}   TTseriesLoad;                                                              //
+
+//-----------------------------------------------------------------------------
+//  Shared variables
+//-----------------------------------------------------------------------------
+static TTseriesLoad Load;              // state of time series being loaded    //(5.1.015)
+
 //-----------------------------------------------------------------------------
 //  Local functions
 //-----------------------------------------------------------------------------
 int    table_getNextFileEntry(TTable* table, double* x, double* y);
 int    table_parseFileLine(char* line, TTable* table, double* x, double* y);
 double table_interpolate(double x, double x1, double y1, double x2, double y2);
+static int  addTseriesEntry(TTable* table, double x, double y);                //(5.1.015)
+static void addHeldEntries(TTable* table);                                     //(5.1.015)
 
 
 //=============================================================================
@@ -181,7 +214,7 @@ int table_readTimeseries(char* tok[], int ntoks)
                 return error_setInpError(ERR_NUMBER, tok[k]);
 
             // --- add date/time & value to time series
-            table_addEntry(&Tseries[j], x, y);
+            addTseriesEntry(&Tseries[j], x, y);                                //(5.1.015)
 
             // --- start over looking first for a date
             k++;
@@ -194,6 +227,213 @@ int table_readTimeseries(char* tok[], int ntoks)
 
 //=============================================================================
 
+int table_markTimeseries(char* tok[], int ntoks, size_t start, size_t end,
+                         long lineCount)
+//
+//  Input:   tok[] = array of string tokens
+//           ntoks = number of tokens
+//           start = offset of the line in the input file
+//           end = offset of the line that follows it
+//           lineCount = line number of the line
+//  Output:  returns an error code
+//  Purpose: notes where a line of time series data lies in the input file
+//           so that its data can be loaded once the series is known to be
+//           used.
+//
+//  Note:    successive lines of the same time series form a single run.
+//
+{
+    int          j;
+    TTableLines* lines;
+
+    // --- check for minimum number of tokens
+    if ( ntoks < 3 ) return error_setInpError(ERR_ITEMS, "");
+
+    // --- check that time series exists in database
+    j = project_findObject(TSERIES, tok[0]);
+    if ( j < 0 ) return error_setInpError(ERR_NAME, tok[0]);
+
+    // --- if first line of data, assign ID pointer
+    if ( Tseries[j].ID == NULL )
+        Tseries[j].ID = project_findID(TSERIES, tok[0]);
+
+    // --- an external data file is only read once the simulation begins
+    if ( strcomp(tok[1], w_FILE ) )
+    {
+        sstrncpy(Tseries[j].file.name, tok[2], MAXFNAME);
+        Tseries[j].file.mode = USE_FILE;
+        return 0;
+    }
+
+    // --- extend the series' last run of lines if this line follows it
+    lines = Tseries[j].lastLines;
+    if ( lines && lines->end == start )
+    {
+        lines->end = end;
+        return 0;
+    }
+
+    // --- otherwise start a new run of lines
+    lines = (TTableLines *) project_alloc(TSERIES_POOL, 1, sizeof(TTableLines));
+    if ( !lines ) return error_setInpError(ERR_MEMORY, "");
+    lines->start = start;
+    lines->end = end;
+    lines->lineCount = lineCount;
+    lines->next = NULL;
+    if ( Tseries[j].firstLines == NULL ) Tseries[j].firstLines = lines;
+    else Tseries[j].lastLines->next = lines;
+    Tseries[j].lastLines = lines;
+    return 0;
+}
+
+//=============================================================================
+
+void table_startTseriesLoad(TTable* table, DateTime start, DateTime end,
+                            DateTime startDate)
+//
+//  Input:   table = pointer to a time series table
+//           start = start of period of dates to load
+//           end = end of period of dates to load
+//           startDate = date that times given without a date refer to
+//  Output:  none
+//  Purpose: prepares a time series to have its data loaded by
+//           table_readTimeseries.
+//
+//  Note:    besides the dates within the period, the series' first date,
+//           the two dates before the period (which rainfall volumes and
+//           evaporation rates may still apply over) and the first date
+//           after it are kept. Any data already loaded remain in the time
+//           series memory pool.
+//
+{
+    table->firstEntry = NULL;
+    table->lastEntry = NULL;
+    table->thisEntry = NULL;
+    table->lastDate = startDate;
+    table->loadStart = start;
+    table->loadEnd = end;
+
+    Load.table = table;
+    Load.start = start;
+    Load.end = end;
+    Load.trimming = TRUE;
+    Load.passedEnd = FALSE;
+    Load.count = 0;
+    Load.held = 0;
+    Load.lastKept = FALSE;
+    Load.dxMin = BIG;
+}
+
+//=============================================================================
+
+void table_endTseriesLoad(TTable* table)
+//
+//  Input:   table = pointer to a time series table
+//  Output:  none
+//  Purpose: completes the loading of a time series' data.
+//
+{
+    // --- a series whose dates all precede the period keeps its last two
+    addHeldEntries(table);
+
+    // --- table_validate checks the interval between all of the dates read
+    table->dxMin = Load.dxMin;
+    Load.table = NULL;
+}
+
+//=============================================================================
+
+int addTseriesEntry(TTable* table, double x, double y)
+//
+//  Input:   table = pointer to a time series table
+//           x = date/time value
+//           y = time series value
+//  Output:  returns TRUE if successful, FALSE if not
+//  Purpose: adds a new entry to a time series if it lies within the period
+//           of dates being loaded.
+//
+{
+    // --- add entry directly if series isn't being loaded for a period
+    if ( table != Load.table ) return table_addEntry(table, x, y);
+
+    // --- update the smallest interval between dates
+    if ( Load.count > 0 && x > Load.lastX )
+        Load.dxMin = MIN(Load.dxMin, x - Load.lastX);
+    Load.count++;
+
+    if ( Load.trimming )
+    {
+        // --- a date out of sequence stops the trimming so that
+        //     table_validate will find it
+        if ( Load.count > 1 && x <= Load.lastX )
+        {
+            Load.trimming = FALSE;
+            if ( Load.held > 0 ) addHeldEntries(table);
+            else if ( !Load.lastKept )
+                table_addEntry(table, Load.lastX, Load.lastY);
+        }
+
+        // --- hold on to the last two dates before the period (the first
+        //     date of all is always kept)
+        else if ( x < Load.start && Load.count > 1 )
+        {
+            if ( Load.held == 2 )
+            {
+                Load.x[0] = Load.x[1];
+                Load.y[0] = Load.y[1];
+                Load.held = 1;
+            }
+            Load.x[Load.held] = x;
+            Load.y[Load.held] = y;
+            Load.held++;
+            Load.lastX = x;
+            Load.lastY = y;
+            Load.lastKept = FALSE;
+            return TRUE;
+        }
+
+        // --- drop the dates after the first one past the period
+        else if ( Load.passedEnd )
+        {
+            Load.lastX = x;
+            Load.lastY = y;
+            Load.lastKept = FALSE;
+            return TRUE;
+        }
+
+        // --- otherwise the date lies within the period
+        else
+        {
+            addHeldEntries(table);
+            if ( x >= Load.end ) Load.passedEnd = TRUE;
+        }
+    }
+    Load.lastX = x;
+    Load.lastY = y;
+    Load.lastKept = TRUE;
+    return table_addEntry(table, x, y);
+}
+
+//=============================================================================
+
+void addHeldEntries(TTable* table)
+//
+//  Input:   table = pointer to a time series table
+//  Output:  none
+//  Purpose: adds the entries held before the period of dates being loaded
+//           to a time series.
+//
+{
+    int i;
+    for (i = 0; i < Load.held; i++)
+    {
+        table_addEntry(table, Load.x[i], Load.y[i]);
+    }
+    Load.held = 0;
+}
+
+//=============================================================================
+
 int table_addEntry(TTable* table, double x, double y)
 //
 //  Input:   table = pointer to a TTable structure
@@ -204,7 +444,11 @@ int table_addEntry(TTable* table, double x, double y)
 //
 {
     TTableEntry *entry;
-    entry = (TTableEntry *) malloc(sizeof(TTableEntry));
+
+    // --- time series have no curve type; each kind of table draws from
+    //     its own pool so that both can be read at the same time
+    entry = (TTableEntry *) project_alloc(table->curveType < 0 ?               //(5.1.015)
+            TSERIES_POOL : CURVE_POOL, 1, sizeof(TTableEntry));                //(5.1.015)
     if ( !entry ) return FALSE;
     entry->x = x;
     entry->y = y;
@@ -223,16 +467,9 @@ void   table_deleteEntries(TTable *table)
 //  Output:  none
 //  Purpose: deletes all x/y entries in a table.
 //
+//  NOTE: the entries' memory is released when the project is closed.
+//
 {
-    TTableEntry *entry;
-    TTableEntry *nextEntry;
-    entry = table->firstEntry;
-    while (entry)
-    {
-        nextEntry = entry->next;
-        free(entry);
-        entry = nextEntry;
-    }
     table->firstEntry = NULL;
     table->lastEntry  = NULL;
     table->thisEntry  = NULL;
@@ -267,6 +504,10 @@ void   table_init(TTable *table)
     table->file.mode = NO_FILE;
     table->file.file = NULL;
     table->curveType = -1;
+    table->firstLines = NULL;                                                  //(5.1.015)
+    table->lastLines = NULL;                                                   //(5.1.015)
+    table->loadStart = 0.0;                                                    //(5.1.015)
+    table->loadEnd = 0.0;                                                      //(5.1.015)
 }
 
 //=============================================================================
@@ -282,6 +523,10 @@ int   table_validate(TTable *table)
     double x1, x2, y1, y2;
     double dx, dxMin = BIG;
 
+    // --- a time series loaded for part of its dates starts from the
+    //     smallest interval between all of them
+    if ( table->dxMin > 0.0 ) dxMin = table->dxMin;                            //(5.1.015)
+
     // --- open external file if used as the table's data source
     if ( table->file.mode == USE_FILE )
     {
@@ -368,6 +613,8 @@ int table_getNextEntry(TTable *table, double *x, double *y)
     if ( table->file.mode == USE_FILE )
         return table_getNextFileEntry(table, x, y);
     
+    // --- a time series that isn't used has no data loaded                    //(5.1.015)
+    if ( table->thisEntry == NULL ) return FALSE;                              //(5.1.015)
     entry = table->thisEntry->next;
     if ( entry )
     {
@@ -829,6 +1076,7 @@ int  table_parseFileLine(char* line, TTable* table, double* x, double* y)
           s3[50];
     char* tStr;              // time as string
     char* yStr;              // value as string
+    char* next;              // rest of line being parsed                      //(5.1.015)
     double yy;               // value as double
     DateTime d;              // day portion of date/time value
     DateTime t;              // time portion of date/time value
@@ -837,7 +1085,7 @@ int  table_parseFileLine(char* line, TTable* table, double* x, double* y)
     n = sscanf(line, "%s %s %s", s1, s2, s3);
 
     // --- return if line is blank or is a comment
-    tStr = strtok(line, SEPSTR);
+    tStr = sstrtok(line, SEPSTR, &next);                                       //(5.1.015)
     if ( tStr == NULL || *tStr == ';' ) return -1;
 
     // --- line only has a time and a value
@@ -108,6 +108,8 @@
 #define  w_MIN_ROUTE_STEP    "MINIMUM_STEP"
 #define  w_NUM_THREADS       "THREADS"
 #define  w_SURCHARGE_METHOD  "SURCHARGE_METHOD"                                //(5.1.013)
+#define  w_OUTPUT_FORMAT     "OUTPUT_FORMAT"                                   //(5.1.015)
+#define  w_OUTPUT_NAME_INDEX "OUTPUT_NAME_INDEX"                               //(5.1.015)
 
 // Flow Units
 #define  w_CFS               "CFS"
@@ -132,6 +134,10 @@
 #define  w_EXTRAN            "EXTRAN"
 #define  w_SLOT              "SLOT"
 
+// Binary Output File Formats                                                  //(5.1.015)
+#define  w_STANDARD          "STANDARD"                                        //
+#define  w_COMPRESSED        "COMPRESSED"                                      //
+
 // Infiltration Methods
 #define  w_HORTON            "HORTON"
 #define  w_MOD_HORTON        "MODIFIED_HORTON"
@@ -329,6 +335,8 @@
 #define  w_ROUTING           "ROUTING"
 #define  w_INFLOWS           "INFLOWS"
 #define  w_OUTFLOWS          "OUTFLOWS"
+#define  w_CLIMATE           "CLIMATE"                                         //(5.1.015)
+#define  w_RECORDING         "RECORDING"                                       //(5.1.015)
 
 // Miscellaneous Keywords
 #define  w_OFF               "OFF"
@@ -380,6 +388,19 @@
 #define  w_CONCEN            "CONCEN"
 #define  w_MASS              "MASS"
 
+// Recorded Result Variables                                                  //(5.1.015)
+#define  w_SNOW_DEPTH        "SNOW_DEPTH"                                      //
+#define  w_EVAP              "EVAP"                                            //
+#define  w_INFIL             "INFIL"                                           //
+#define  w_GW_FLOW           "GW_FLOW"                                         //
+#define  w_GW_ELEV           "GW_ELEV"                                         //
+#define  w_SOIL_MOIST        "SOIL_MOIST"                                      //
+#define  w_LAT_INFLOW        "LAT_INFLOW"                                      //
+#define  w_TOTAL_INFLOW      "TOTAL_INFLOW"                                    //
+#define  w_VELOCITY          "VELOCITY"                                        //
+#define  w_CAPACITY          "CAPACITY"                                        //
+#define  w_TRIGGER           "TRIGGER"                                         //
+
 // Variable Units
 #define  w_FEET              "FEET"
 #define  w_METERS            "METERS"
@@ -445,3 +466,4 @@
 #define  ws_GWF              "[GWF"
 #define  ws_ADJUST           "[ADJUSTMENT"
 #define  ws_EVENT            "[EVENT"
+#define  ws_RECORDING        "[RECORDING"                                      //(5.1.015)
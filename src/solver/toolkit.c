@@ -13,6 +13,9 @@
 
 #include <math.h>
 #include <time.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 #include "headers.h"
 #include "shared/cstr_helper.h"
@@ -36,6 +39,31 @@ int  stats_getSubcatchStat(int index, TSubcatchStats **subcatchStats);
 
 // Utilty Function Declarations
 double* newDoubleArray(int n);
+void    runSteps(void (*callback) (double *));
+void    startResultsStreams(void);
+void    saveResultsStreams(void);
+void    snapshotResultsStreams(TSnapshot* s);
+void    closeResultsStreams(void);
+void    getStreamValues(int s);
+
+
+// Results Streaming Variables
+typedef struct
+{
+    int     objectType;        // SUBCATCH, NODE or LINK
+    int     variable;          // result code of variable
+    int     count;             // number of elements
+    int*    indexes;           // index of each element
+    double* values;            // current value for each element
+}  TResultsStream;
+
+static TResultsStream*     Streams = NULL;      // results subscriptions
+static SM_ResultsView*     StreamViews = NULL;  // views passed to callback
+static int                 StreamCount = 0;     // number of subscriptions
+static SM_ResultsCallback  StreamCallback = NULL;
+static void*               StreamUserData = NULL;
+static SM_StreamTiming     StreamTiming = SM_REPORTSTEP;
+static double              StreamReportTime;    // next reporting time (msec)
 
 
 
@@ -76,8 +104,10 @@ int DLLEXPORT  swmm_run_cb(const char* f1, const char* f2, const char* f3,
 //  Purpose: runs a SWMM simulation.
 //
 {
-    clock_t check = 0;
-    double progress, elapsedTime = 0.0;
+    double progress;
+#if defined(_OPENMP)
+    int    pipelined, nThreads;
+#endif
 
 
     // --- initialize flags
@@ -99,19 +129,35 @@ int DLLEXPORT  swmm_run_cb(const char* f1, const char* f2, const char* f3,
         // --- execute each time step until elapsed time is re-set to 0
         if ( !ErrorCode )
         {
-            do
+#if defined(_OPENMP)
+            // --- if possible, compute runoff ahead of routing and write
+            //     results to file on their own threads while this thread
+            //     carries out the time steps
+            pipelined = runoff_startPipeline();
+            nThreads = 1 + pipelined + output_startWriter();
+            if ( nThreads > 1 )
             {
-                swmm_step(&elapsedTime);
-
-                // --- callback with progress approximately twice a second
-                if ( (callback != NULL) && (clock() - check) > CLOCKS_PER_SEC )
+                #pragma omp parallel num_threads(nThreads)
                 {
-                    progress = NewRoutingTime / TotalDuration;
-                    callback(&progress);
-                    check = clock();
+                    if ( omp_get_thread_num() == 0 )
+                    {
+                        if ( omp_get_num_threads() < nThreads )
+                        {
+                            runoff_stopPipeline();
+                            output_stopWriter();
+                        }
+                        runSteps(callback);
+                        runoff_stopPipeline();
+                        output_stopWriter();
+                    }
+                    else if ( omp_get_thread_num() == 1 && pipelined )
+                        runoff_execPipeline();
+                    else output_execWriter();
                 }
-
-            } while ( elapsedTime > 0.0 && !ErrorCode );
+            }
+            else
+#endif
+            runSteps(callback);
 
             if ( callback != NULL )
             {
@@ -135,6 +181,30 @@ int DLLEXPORT  swmm_run_cb(const char* f1, const char* f2, const char* f3,
 }
 
 
+int DLLEXPORT  swmm_compile(const char* f1, const char* f2)
+///
+/// Input:   f1 = name of input file
+///          f2 = name of report file
+/// Return:  error code
+/// Purpose: saves a project's input data as a compiled project file.
+///
+{
+    // --- initialize flags
+    IsOpenFlag = FALSE;
+    IsStartedFlag = FALSE;
+
+    // --- read & validate the input file, saving what was read
+    ErrorCode = 0;
+    input_startCompiling();
+    swmm_open(f1, f2, "");
+    input_writeCompiled();
+
+    // --- close the system
+    swmm_close();
+    return error_getCode(ErrorCode);
+}
+
+
 int DLLEXPORT swmm_getAPIError(int errorCode, char **errorMsg)
 ///
 /// Input:   errorCode = error code
@@ -261,6 +331,13 @@ int DLLEXPORT swmm_setSimulationDateTime(SM_TimePropety type, int year, int mont
                 break;
             default: error_code_index = ERR_API_OUTBOUNDS; break;
         }
+
+        // Time series were only loaded for the dates of the original
+        // simulation period
+        if (error_code_index == 0 && type != SM_REPORTDATE)
+        {
+            error_code_index = input_loadTimeseries();
+        }
     }
 
     return error_getCode(error_code_index);
@@ -2837,10 +2914,474 @@ int DLLEXPORT swmm_setGagePrecip(int index, double total_precip)
     return error_getCode(error_code_index);
 }
 
+//-------------------------------
+// Results Streaming API
+//-------------------------------
+
+int DLLEXPORT swmm_subscribeResults(SM_ObjectType type, int variable,
+    int *indexes, int count, int *subscription)
+///
+/// Input:   type = object type (SM_SUBCATCH, SM_NODE or SM_LINK)
+///          variable = result code (SM_SubcResult, SM_NodeResult, SM_LinkResult)
+///          indexes = indexes of elements (NULL for all elements)
+///          count = number of indexes
+/// Output:  subscription = position of subscription's view
+/// Return:  API Error
+/// Purpose: Subscribes to the current values of a variable for a set of
+///          elements, passed in bulk to the results callback
+{
+    int i;
+    int maxVariable = 0;
+    int error_code_index = 0;
+    TResultsStream* stream;
+    *subscription = -1;
+
+    switch (type)
+    {
+        case SM_SUBCATCH: maxVariable = SM_SUBCSNOW; break;
+        case SM_NODE:     maxVariable = SM_LATINFLOW; break;
+        case SM_LINK:     maxVariable = SM_FROUDE; break;
+        default:          maxVariable = -1; break;
+    }
+
+    // Check if Open
+    if(swmm_IsOpenFlag() == FALSE)
+    {
+        error_code_index = ERR_API_INPUTNOTOPEN;
+    }
+    else if (maxVariable < 0)
+    {
+        error_code_index = ERR_API_WRONG_TYPE;
+    }
+    else if (variable < 0 || variable > maxVariable)
+    {
+        error_code_index = ERR_API_OUTBOUNDS;
+    }
+    else
+    {
+        // Check if each object index is within bounds
+        if (indexes == NULL) count = Nobjects[type];
+        else for (i = 0; i < count; i++)
+        {
+            if (indexes[i] < 0 || indexes[i] >= Nobjects[type])
+            {
+                return error_getCode(ERR_API_OBJECT_INDEX);
+            }
+        }
+
+        // Add a new stream with its own copy of the element indexes
+        stream = (TResultsStream *) realloc(Streams,
+                 (StreamCount + 1) * sizeof(TResultsStream));
+        if (stream == NULL) return error_getCode(ERR_API_MEMORY);
+        Streams = stream;
+        stream = &Streams[StreamCount];
+        stream->objectType = type;
+        stream->variable = variable;
+        stream->count = MAX(count, 0);
+        stream->indexes = (int *) calloc(stream->count + 1, sizeof(int));
+        stream->values = newDoubleArray(stream->count + 1);
+        if (stream->indexes == NULL || stream->values == NULL)
+        {
+            FREE(stream->indexes);
+            FREE(stream->values);
+            return error_getCode(ERR_API_MEMORY);
+        }
+        for (i = 0; i < stream->count; i++)
+        {
+            if (indexes) stream->indexes[i] = indexes[i];
+            else stream->indexes[i] = i;
+        }
+        *subscription = StreamCount;
+        StreamCount++;
+        FREE(StreamViews);
+    }
+    return error_getCode(error_code_index);
+}
+
+int DLLEXPORT swmm_setResultsCallback(SM_StreamTiming timing,
+    SM_ResultsCallback callback, void *userData)
+///
+/// Input:   timing = when callback is made (SM_StreamTiming)
+///          callback = function receiving subscription views (or NULL)
+///          userData = pointer passed back to callback
+/// Return:  API Error
+/// Purpose: Sets the callback that receives all results subscriptions
+{
+    int error_code_index = 0;
+
+    if (timing != SM_REPORTSTEP && timing != SM_ROUTINGSTEP)
+    {
+        error_code_index = ERR_API_OUTBOUNDS;
+    }
+    else
+    {
+        StreamTiming = timing;
+        StreamCallback = callback;
+        StreamUserData = userData;
+    }
+    return error_getCode(error_code_index);
+}
+
+int DLLEXPORT swmm_clearResultsSubscriptions(void)
+///
+/// Return:  API Error
+/// Purpose: Removes all results subscriptions and the results callback
+{
+    closeResultsStreams();
+    return 0;
+}
+
+int DLLEXPORT swmm_saveSnapshot(SM_Snapshot **snapshot)
+///
+/// Output:  snapshot = new snapshot of the running simulation
+/// Return:  API Error
+/// Purpose: Saves the current state of a running simulation in memory
+{
+    int error_code_index = 0;
+
+    if (snapshot == NULL)
+    {
+        error_code_index = ERR_API_MEMORY;
+    }
+    else
+    {
+        *snapshot = NULL;
+
+        // Check if Open
+        if (swmm_IsOpenFlag() == FALSE)
+            error_code_index = ERR_API_INPUTNOTOPEN;
+
+        // Check if Simulation is Running
+        else if (swmm_IsStartedFlag() == FALSE)
+            error_code_index = ERR_API_SIM_NRUNNING;
+
+        // Runoff computed ahead of routing cannot be captured
+        else if (runoff_isPipelined())
+            error_code_index = ERR_API_SNAPSHOT;
+
+        else
+        {
+            *snapshot = snapshot_save();
+            if (*snapshot == NULL) error_code_index = ERR_API_MEMORY;
+        }
+    }
+    return error_getCode(error_code_index);
+}
+
+int DLLEXPORT swmm_restoreSnapshot(SM_Snapshot *snapshot)
+///
+/// Input:   snapshot = snapshot saved earlier in the same simulation
+/// Return:  API Error
+/// Purpose: Returns a running simulation to the state saved in a snapshot
+{
+    int error_code_index = 0;
+
+    // Check if Open
+    if (swmm_IsOpenFlag() == FALSE)
+        error_code_index = ERR_API_INPUTNOTOPEN;
+
+    // Check if Simulation is Running
+    else if (swmm_IsStartedFlag() == FALSE)
+        error_code_index = ERR_API_SIM_NRUNNING;
+
+    else if (snapshot == NULL || runoff_isPipelined() ||
+             !snapshot_restore(snapshot))
+        error_code_index = ERR_API_SNAPSHOT;
+
+    return error_getCode(error_code_index);
+}
+
+void DLLEXPORT swmm_deleteSnapshot(SM_Snapshot *snapshot)
+///
+/// Input:   snapshot = snapshot saved by swmm_saveSnapshot (or NULL)
+/// Purpose: Frees the memory used by a snapshot
+{
+    snapshot_delete(snapshot);
+}
+
+int DLLEXPORT swmm_fork(int count, int *member)
+///
+/// Input:   count = number of ensemble members to create
+/// Output:  member = 0 in calling process or member number in a new member
+/// Return:  API Error
+/// Purpose: Forks a running simulation into an ensemble of member processes
+///
+/// NOTE: swmm_fork and swmm_waitForks are not declared in toolkit.h. They
+///       duplicate the whole calling process and only work where fork() is
+///       available, so they are kept out of the public API until members
+///       can be copied within one process from a per-project context.
+{
+    int error_code_index = 0;
+
+    if (member == NULL)
+    {
+        error_code_index = ERR_API_MEMORY;
+    }
+    else
+    {
+        *member = 0;
+
+        // Check if Open
+        if (swmm_IsOpenFlag() == FALSE)
+            error_code_index = ERR_API_INPUTNOTOPEN;
+
+        // Check if Simulation is Running
+        else if (swmm_IsStartedFlag() == FALSE)
+            error_code_index = ERR_API_SIM_NRUNNING;
+
+        else if (count < 1)
+            error_code_index = ERR_API_OUTBOUNDS;
+
+        // Threads computing runoff ahead of routing cannot be forked
+        else if (runoff_isPipelined() || !ensemble_fork(count, member))
+            error_code_index = ERR_API_FORK;
+    }
+    return error_getCode(error_code_index);
+}
+
+int DLLEXPORT swmm_waitForks(int *failures)
+///
+/// Output:  failures = number of members that did not end normally
+/// Return:  API Error
+/// Purpose: Waits for all ensemble members forked by this process to end
+{
+    int n;
+
+    if (failures == NULL) failures = &n;
+    ensemble_wait(failures);
+    return 0;
+}
+
 //-------------------------------
 // Utility Functions
 //-------------------------------
 
+void runSteps(void (*callback) (double *))
+//
+//  Input:   callback = progress callback function (or NULL)
+//  Output:  none
+//  Purpose: executes each time step of a simulation until it ends.
+//
+{
+    clock_t check = 0;
+    double progress, elapsedTime = 0.0;
+
+    do
+    {
+        swmm_step(&elapsedTime);
+
+        // --- callback with progress approximately twice a second
+        if ( (callback != NULL) && (clock() - check) > CLOCKS_PER_SEC )
+        {
+            progress = NewRoutingTime / TotalDuration;
+            callback(&progress);
+            check = clock();
+        }
+
+    } while ( elapsedTime > 0.0 && !ErrorCode );
+}
+
+void startResultsStreams()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: initializes results streaming at the start of a simulation.
+//
+{
+    StreamReportTime = (double)(1000 * ReportStep);
+}
+
+void saveResultsStreams()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: passes the current values of all subscriptions to the results
+//           callback if the current routing step calls for it.
+//
+{
+    int    s;
+    double reportTime;
+
+    if ( StreamCallback == NULL ) return;
+
+    // --- callback at reporting periods is made in the routing step that
+    //     reaches the reporting time, as when saving results to file
+    if ( StreamTiming == SM_REPORTSTEP )
+    {
+        if ( NewRoutingTime < StreamReportTime ) return;
+        reportTime = StreamReportTime;
+        StreamReportTime += (double)(1000 * ReportStep);
+        if ( getDateTime(reportTime) < ReportStart ) return;
+    }
+
+    // --- gather current values of each subscription
+    if ( StreamViews == NULL && StreamCount > 0 )
+    {
+        StreamViews = (SM_ResultsView *) calloc(StreamCount,
+                      sizeof(SM_ResultsView));
+        if ( StreamViews == NULL ) return;
+    }
+    for (s = 0; s < StreamCount; s++)
+    {
+        getStreamValues(s);
+        StreamViews[s].objectType = Streams[s].objectType;
+        StreamViews[s].variable = Streams[s].variable;
+        StreamViews[s].count = Streams[s].count;
+        StreamViews[s].indexes = Streams[s].indexes;
+        StreamViews[s].values = Streams[s].values;
+    }
+    StreamCallback(NewRoutingTime / MSECperDAY, StreamViews, StreamCount,
+                   StreamUserData);
+}
+
+void snapshotResultsStreams(TSnapshot* s)
+//
+//  Input:   s = a simulation state snapshot
+//  Output:  none
+//  Purpose: saves or restores the time of the next streamed reporting period.
+//
+{
+    snapshot_add(s, &StreamReportTime, sizeof(double));
+}
+
+void getStreamValues(int s)
+//
+//  Input:   s = subscription index
+//  Output:  none
+//  Purpose: retrieves the current values of a subscription's variable,
+//           matching those returned by the result getter functions.
+//
+{
+    int     i;
+    int     n = Streams[s].count;
+    int*    k = Streams[s].indexes;
+    double* x = Streams[s].values;
+
+    switch (Streams[s].objectType)
+    {
+    case SUBCATCH:
+        switch (Streams[s].variable)
+        {
+        case SM_SUBCRAIN:
+            for (i = 0; i < n; i++)
+                x[i] = Subcatch[k[i]].rainfall * UCF(RAINFALL);
+            break;
+        case SM_SUBCEVAP:
+            for (i = 0; i < n; i++)
+                x[i] = Subcatch[k[i]].evapLoss * UCF(EVAPRATE);
+            break;
+        case SM_SUBCINFIL:
+            for (i = 0; i < n; i++)
+                x[i] = Subcatch[k[i]].infilLoss * UCF(RAINFALL);
+            break;
+        case SM_SUBCRUNON:
+            for (i = 0; i < n; i++)
+                x[i] = Subcatch[k[i]].runon * UCF(FLOW);
+            break;
+        case SM_SUBCRUNOFF:
+            for (i = 0; i < n; i++)
+                x[i] = Subcatch[k[i]].newRunoff * UCF(FLOW);
+            break;
+        case SM_SUBCSNOW:
+            for (i = 0; i < n; i++)
+                x[i] = Subcatch[k[i]].newSnowDepth * UCF(RAINDEPTH);
+            break;
+        }
+        break;
+
+    case NODE:
+        switch (Streams[s].variable)
+        {
+        case SM_TOTALINFLOW:
+            for (i = 0; i < n; i++) x[i] = Node[k[i]].inflow * UCF(FLOW);
+            break;
+        case SM_TOTALOUTFLOW:
+            for (i = 0; i < n; i++) x[i] = Node[k[i]].outflow * UCF(FLOW);
+            break;
+        case SM_LOSSES:
+            for (i = 0; i < n; i++) x[i] = Node[k[i]].losses * UCF(FLOW);
+            break;
+        case SM_NODEVOL:
+            for (i = 0; i < n; i++)
+                x[i] = Node[k[i]].newVolume * UCF(VOLUME);
+            break;
+        case SM_NODEFLOOD:
+            for (i = 0; i < n; i++) x[i] = Node[k[i]].overflow * UCF(FLOW);
+            break;
+        case SM_NODEDEPTH:
+            for (i = 0; i < n; i++)
+                x[i] = Node[k[i]].newDepth * UCF(LENGTH);
+            break;
+        case SM_NODEHEAD:
+            for (i = 0; i < n; i++)
+                x[i] = (Node[k[i]].newDepth + Node[k[i]].invertElev) *
+                       UCF(LENGTH);
+            break;
+        case SM_LATINFLOW:
+            for (i = 0; i < n; i++)
+                x[i] = Node[k[i]].newLatFlow * UCF(FLOW);
+            break;
+        }
+        break;
+
+    case LINK:
+        switch (Streams[s].variable)
+        {
+        case SM_LINKFLOW:
+            for (i = 0; i < n; i++) x[i] = Link[k[i]].newFlow * UCF(FLOW);
+            break;
+        case SM_LINKDEPTH:
+            for (i = 0; i < n; i++)
+                x[i] = Link[k[i]].newDepth * UCF(LENGTH);
+            break;
+        case SM_LINKVOL:
+            for (i = 0; i < n; i++)
+                x[i] = Link[k[i]].newVolume * UCF(VOLUME);
+            break;
+        case SM_USSURFAREA:
+            for (i = 0; i < n; i++)
+                x[i] = Link[k[i]].surfArea1 * UCF(LENGTH) * UCF(LENGTH);
+            break;
+        case SM_DSSURFAREA:
+            for (i = 0; i < n; i++)
+                x[i] = Link[k[i]].surfArea2 * UCF(LENGTH) * UCF(LENGTH);
+            break;
+        case SM_SETTING:
+            for (i = 0; i < n; i++) x[i] = Link[k[i]].setting;
+            break;
+        case SM_TARGETSETTING:
+            for (i = 0; i < n; i++) x[i] = Link[k[i]].targetSetting;
+            break;
+        case SM_FROUDE:
+            for (i = 0; i < n; i++) x[i] = Link[k[i]].froude;
+            break;
+        }
+        break;
+    }
+}
+
+void closeResultsStreams()
+//
+//  Input:   none
+//  Output:  none
+//  Purpose: frees all results subscriptions and removes the callback.
+//
+{
+    int s;
+
+    for (s = 0; s < StreamCount; s++)
+    {
+        FREE(Streams[s].indexes);
+        FREE(Streams[s].values);
+    }
+    FREE(Streams);
+    FREE(StreamViews);
+    StreamCount = 0;
+    StreamCallback = NULL;
+    StreamUserData = NULL;
+    StreamTiming = SM_REPORTSTEP;
+}
+
 double* newDoubleArray(int n)
 ///
 ///  Warning: Caller must free memory allocated by this function.
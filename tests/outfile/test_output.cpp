@@ -17,12 +17,17 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include "swmm_output.h"
 
 // NOTE: Reference data for the unit tests is currently tied to SWMM 5.1.7
 #define DATA_PATH "./test_example1.out"
+#define DATA_PATH_COMPRESSED "./test_example1_v2.out"
+#define DATA_PATH_NAMES "./test_example1_names.out"
 
 using namespace std;
 
@@ -71,6 +76,67 @@ boost::test_tools::predicate_result check_string(std::string test,
         return false;
 }
 
+// Minimal reader of the flatbuffers holding Arrow IPC metadata. Positions
+// are byte offsets into the whole file.
+template <typename T>
+T read_at(const std::vector<unsigned char>& bytes, long pos) {
+    T x;
+    memcpy(&x, &bytes[pos], sizeof(T));
+    return x;
+}
+
+// Follows the offset stored at pos
+long fb_deref(const std::vector<unsigned char>& bytes, long pos) {
+    return pos + read_at<unsigned int>(bytes, pos);
+}
+
+// Returns the position of a table's field, 0 if it is absent
+long fb_field(const std::vector<unsigned char>& bytes, long table, int field) {
+    long           vtable = table - read_at<int>(bytes, table);
+    unsigned short size   = read_at<unsigned short>(bytes, vtable);
+
+    if (4 + 2 * field >= size)
+        return 0;
+    unsigned short offset =
+        read_at<unsigned short>(bytes, vtable + 4 + 2 * field);
+    return offset ? table + offset : 0;
+}
+
+// Returns the position of the table, vector or string a field refers to
+long fb_ref(const std::vector<unsigned char>& bytes, long table, int field) {
+    long pos = fb_field(bytes, table, field);
+    BOOST_REQUIRE(pos != 0);
+    return fb_deref(bytes, pos);
+}
+
+std::string fb_string(const std::vector<unsigned char>& bytes, long table,
+    int field) {
+    long pos = fb_ref(bytes, table, field);
+    return std::string((const char*)&bytes[pos + 4],
+                       read_at<unsigned int>(bytes, pos));
+}
+
+// Returns the file position of each buffer of a message's body
+std::vector<long> arrow_buffers(const std::vector<unsigned char>& bytes,
+    long block, long long* rows) {
+    long offset  = (long)read_at<long long>(bytes, block);
+    long body    = offset + read_at<int>(bytes, block + 8);
+    long message = fb_deref(bytes, offset + 8);
+    long header  = fb_ref(bytes, message, 2);
+
+    // --- a dictionary batch holds its data as a record batch
+    if (read_at<unsigned char>(bytes, fb_field(bytes, message, 1)) == 2)
+        header = fb_ref(bytes, header, 1);
+    *rows = read_at<long long>(bytes, fb_field(bytes, header, 0));
+
+    std::vector<long> buffers;
+    long vector = fb_ref(bytes, header, 2);
+    for (unsigned int i = 0; i < read_at<unsigned int>(bytes, vector); i++)
+        buffers.push_back(body +
+                          (long)read_at<long long>(bytes, vector + 4 + 16 * i));
+    return buffers;
+}
+
 BOOST_AUTO_TEST_SUITE(test_output_auto)
 
 BOOST_AUTO_TEST_CASE(InitTest) {
@@ -103,6 +169,402 @@ BOOST_AUTO_TEST_CASE(InitOpenCloseTest) {
     SMO_close(p_handle);
 }
 
+BOOST_AUTO_TEST_CASE(SeriesIndexTest) {
+    std::string path = std::string(DATA_PATH);
+    const char* index_path = "./test_example1_series.idx";
+
+    SMO_Handle p_handle = NULL;
+    float*     ref_array, *array;
+    int        ref_dim, array_dim;
+
+    SMO_init(&p_handle);
+    int error = SMO_open(p_handle, path.c_str());
+    BOOST_REQUIRE(error == 0);
+
+    error = SMO_getLinkSeries(p_handle, 3, SMO_flow_rate_link, 0, 36,
+                              &ref_array, &ref_dim);
+    BOOST_REQUIRE(error == 0);
+
+    error = SMO_buildSeriesIndex(p_handle, index_path);
+    BOOST_REQUIRE(error == 0);
+
+    error = SMO_getLinkSeries(p_handle, 3, SMO_flow_rate_link, 0, 36,
+                              &array, &array_dim);
+    BOOST_REQUIRE(error == 0);
+    BOOST_CHECK_EQUAL_COLLECTIONS(ref_array, ref_array + ref_dim,
+                                  array, array + array_dim);
+    SMO_freeMemory((void*)array);
+
+    // Reopen the index written above and read a partial series from it
+    error = SMO_openSeriesIndex(p_handle, index_path);
+    BOOST_REQUIRE(error == 0);
+
+    error = SMO_getLinkSeries(p_handle, 3, SMO_flow_rate_link, 10, 20,
+                              &array, &array_dim);
+    BOOST_REQUIRE(error == 0);
+    BOOST_CHECK_EQUAL_COLLECTIONS(ref_array + 10, ref_array + 20,
+                                  array, array + array_dim);
+
+    SMO_freeMemory((void*)array);
+    SMO_freeMemory((void*)ref_array);
+    SMO_close(p_handle);
+    remove(index_path);
+}
+
+BOOST_AUTO_TEST_CASE(MappedResultsTest) {
+    std::string path = std::string(DATA_PATH);
+
+    SMO_Handle p_handle = NULL;
+    float*     ref_array;
+    int        ref_dim, column, count, stride;
+    const char* results;
+
+    SMO_init(&p_handle);
+    int error = SMO_open(p_handle, path.c_str());
+    BOOST_REQUIRE(error == 0);
+
+    error = SMO_getNodeSeries(p_handle, 2, SMO_invert_depth, 0, 36,
+                              &ref_array, &ref_dim);
+    BOOST_REQUIRE(error == 0);
+
+    error = SMO_mapResults(p_handle);
+    BOOST_REQUIRE(error == 0);
+
+    error = SMO_getColumn(p_handle, SMO_node, 2, SMO_invert_depth, &column);
+    BOOST_REQUIRE(error == 0);
+    error = SMO_getColumnCount(p_handle, &count);
+    BOOST_REQUIRE(error == 0);
+
+    // Strided view into the mapped file
+    error = SMO_getResultsView(p_handle, &results, &stride);
+    BOOST_REQUIRE(error == 0);
+    std::vector<float> view(36);
+    for (int t = 0; t < 36; t++)
+        memcpy(&view[t], results + t * stride + column * 4, sizeof(float));
+    BOOST_CHECK_EQUAL_COLLECTIONS(ref_array, ref_array + ref_dim,
+                                  view.begin(), view.end());
+
+    // Bulk extraction of one column and of a range of whole periods
+    std::vector<float> series(36);
+    error = SMO_getColumnSeries(p_handle, &column, 1, 0, 36, &series[0]);
+    BOOST_REQUIRE(error == 0);
+    BOOST_CHECK_EQUAL_COLLECTIONS(ref_array, ref_array + ref_dim,
+                                  series.begin(), series.end());
+
+    std::vector<float> periods(2 * count);
+    error = SMO_getPeriodRange(p_handle, 4, 6, &periods[0]);
+    BOOST_REQUIRE(error == 0);
+    BOOST_CHECK_EQUAL(ref_array[4], periods[column]);
+    BOOST_CHECK_EQUAL(ref_array[5], periods[count + column]);
+
+    SMO_freeMemory((void*)ref_array);
+    SMO_close(p_handle);
+}
+
+BOOST_AUTO_TEST_CASE(ResultsOutOfRangeTest) {
+    const char* path = "./test_example1_long.out";
+
+    // Copy the output file with its epilogue claiming twice as many
+    // reporting periods as the file holds
+    FILE* file = fopen(DATA_PATH, "rb");
+    BOOST_REQUIRE(file != NULL);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    std::vector<char> bytes(size);
+    fseek(file, 0, SEEK_SET);
+    BOOST_REQUIRE(fread(&bytes[0], 1, size, file) == (size_t)size);
+    fclose(file);
+
+    int periods = 72;
+    memcpy(&bytes[size - 6 * 4 + 3 * 4], &periods, 4);
+    file = fopen(path, "wb");
+    BOOST_REQUIRE(file != NULL);
+    fwrite(&bytes[0], 1, size, file);
+    fclose(file);
+
+    SMO_Handle p_handle = NULL;
+    float*     array = NULL;
+    int        array_dim, column, count, stride;
+    const char* results;
+
+    SMO_init(&p_handle);
+    int error = SMO_open(p_handle, path);
+    BOOST_REQUIRE(error == 0);
+    error = SMO_getColumn(p_handle, SMO_node, 2, SMO_invert_depth, &column);
+    BOOST_REQUIRE(error == 0);
+    error = SMO_getColumnCount(p_handle, &count);
+    BOOST_REQUIRE(error == 0);
+
+    // Reads past the end of the file fail and leave no stale values
+    std::vector<float> periodRange(2 * count, 1.0f);
+    error = SMO_getPeriodRange(p_handle, 70, 72, &periodRange[0]);
+    BOOST_CHECK_EQUAL(436, error);
+    BOOST_CHECK(std::count(periodRange.begin(), periodRange.end(), 0.0f) ==
+                2 * count);
+
+    error = SMO_getNodeSeries(p_handle, 2, SMO_invert_depth, 0, 72, &array,
+                              &array_dim);
+    BOOST_CHECK_EQUAL(436, error);
+
+    error = SMO_mapResults(p_handle);
+    BOOST_REQUIRE(error == 0);
+    error = SMO_getResultsView(p_handle, &results, &stride);
+    BOOST_CHECK_EQUAL(436, error);
+    BOOST_CHECK(results == NULL);
+
+    std::vector<float> series(72, 1.0f);
+    error = SMO_getColumnSeries(p_handle, &column, 1, 0, 72, &series[0]);
+    BOOST_CHECK_EQUAL(436, error);
+    BOOST_CHECK_EQUAL(0.0f, series[71]);
+
+    SMO_close(p_handle);
+    remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(CompressedFileTest) {
+    std::string path = std::string(DATA_PATH_COMPRESSED);
+
+    SMO_Handle p_handle = NULL;
+    float*     array;
+    int        array_dim, periods, stride;
+    const char* results;
+    double     date;
+
+    SMO_init(&p_handle);
+    int error = SMO_open(p_handle, path.c_str());
+    BOOST_REQUIRE(error == 0);
+
+    error = SMO_getTimes(p_handle, SMO_numPeriods, &periods);
+    BOOST_REQUIRE(error == 0);
+    BOOST_CHECK_EQUAL(36, periods);
+
+    error = SMO_getStartDate(p_handle, &date);
+    BOOST_REQUIRE(error == 0);
+    BOOST_CHECK_EQUAL(35796., date);
+
+    error = SMO_getSubcatchSeries(p_handle, 1, SMO_runoff_rate, 0, 10, &array,
+                                  &array_dim);
+    BOOST_REQUIRE(error == 0);
+
+    // Reference values from the current solver build of test_example1.inp
+    float ref_array[10] = {
+        0.0f, 1.2438242f, 2.5639679f, 4.524055f, 2.5115132f, 0.69808137f,
+        0.040894926f, 0.011605669f, 0.0f, 0.0f};
+    std::vector<float> ref_vec(ref_array, ref_array + 10);
+    std::vector<float> test_vec(array, array + array_dim);
+    BOOST_CHECK(check_cdd_float(test_vec, ref_vec, 3));
+    SMO_freeMemory((void*)array);
+
+    // Compressed results have no fixed layout to view directly
+    error = SMO_getResultsView(p_handle, &results, &stride);
+    BOOST_CHECK_EQUAL(425, error);
+
+    SMO_close(p_handle);
+}
+
+BOOST_AUTO_TEST_CASE(ReservedCodecTest) {
+    const char* path = "./test_example1_codec.out";
+
+    // Copy the compressed file with its epilogue naming codec 2, which is
+    // reserved and has no implementation
+    FILE* file = fopen(DATA_PATH_COMPRESSED, "rb");
+    BOOST_REQUIRE(file != NULL);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    std::vector<char> bytes(size);
+    fseek(file, 0, SEEK_SET);
+    BOOST_REQUIRE(fread(&bytes[0], 1, size, file) == (size_t)size);
+    fclose(file);
+
+    int codec = 2;
+    memcpy(&bytes[size - 4 * 8 - 6 * 4 + 4 * 8 + 2 * 4], &codec, 4);
+    file = fopen(path, "wb");
+    BOOST_REQUIRE(file != NULL);
+    fwrite(&bytes[0], 1, size, file);
+    fclose(file);
+
+    SMO_Handle p_handle = NULL;
+    SMO_init(&p_handle);
+    // --- a failed open also frees the handle
+    int error = SMO_open(p_handle, path);
+    BOOST_CHECK_EQUAL(435, error);
+    remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(ArrowExportTest) {
+    std::string path = std::string(DATA_PATH);
+    const char* arrow_path = "./test_example1_links.arrow";
+
+    SMO_Handle p_handle = NULL;
+    float*     ref_array;
+    int        ref_dim;
+
+    SMO_init(&p_handle);
+    int error = SMO_open(p_handle, path.c_str());
+    BOOST_REQUIRE(error == 0);
+
+    error = SMO_exportArrow(p_handle, SMO_pollut, arrow_path, 0);
+    BOOST_CHECK_EQUAL(421, error);
+
+    error = SMO_exportArrow(p_handle, SMO_link, arrow_path, 10);
+    BOOST_REQUIRE(error == 0);
+
+    // Arrow IPC file starts with padded magic and ends with footer size
+    // and magic
+    FILE* file = fopen(arrow_path, "rb");
+    BOOST_REQUIRE(file != NULL);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    BOOST_REQUIRE(size > 20);
+    std::vector<unsigned char> bytes(size);
+    fseek(file, 0, SEEK_SET);
+    BOOST_REQUIRE(fread(&bytes[0], 1, size, file) == (size_t)size);
+    fclose(file);
+    remove(arrow_path);
+
+    BOOST_CHECK(memcmp(&bytes[0], "ARROW1\0\0", 8) == 0);
+    BOOST_CHECK(memcmp(&bytes[size - 6], "ARROW1", 6) == 0);
+    int footer_size = read_at<int>(bytes, size - 10);
+    BOOST_REQUIRE(footer_size > 0 && footer_size < size - 18);
+    long footer = fb_deref(bytes, size - 10 - footer_size);
+
+    // Schema has time, element name and one column per link variable,
+    // pollutants included
+    const char* ref_names[] = {"time", "element", "flow_rate", "flow_depth",
+        "flow_velocity", "flow_volume", "capacity", "TSS", "Lead"};
+    long fields = fb_ref(bytes, fb_ref(bytes, footer, 1), 1);
+    BOOST_REQUIRE_EQUAL(9u, read_at<unsigned int>(bytes, fields));
+    for (int i = 0; i < 9; i++) {
+        long field = fb_deref(bytes, fields + 4 + 4 * i);
+        BOOST_CHECK(check_string(fb_string(bytes, field, 0), ref_names[i]));
+        // --- Type.Timestamp, Type.Utf8 & Type.FloatingPoint
+        int type = read_at<unsigned char>(bytes, fb_field(bytes, field, 2));
+        BOOST_CHECK_EQUAL((i == 0) ? 10 : (i == 1) ? 5 : 3, type);
+        BOOST_CHECK_EQUAL(i == 1, fb_field(bytes, field, 4) != 0);
+    }
+
+    // Dictionary holds the 13 link names
+    long long rows;
+    long dictionaries = fb_ref(bytes, footer, 2);
+    BOOST_REQUIRE_EQUAL(1u, read_at<unsigned int>(bytes, dictionaries));
+    std::vector<long> buffers = arrow_buffers(bytes, dictionaries + 4, &rows);
+    BOOST_REQUIRE_EQUAL(13, rows);
+    BOOST_REQUIRE_EQUAL(3u, buffers.size());
+    int first = read_at<int>(bytes, buffers[1] + 4 * 12);
+    int last  = read_at<int>(bytes, buffers[1] + 4 * 13);
+    BOOST_CHECK(check_string(std::string((const char*)&bytes[buffers[2] + first],
+                                         last - first), "16"));
+
+    // 36 periods of 13 links in batches of 10 periods
+    error = SMO_getLinkSeries(p_handle, 3, SMO_flow_rate_link, 0, 36,
+                              &ref_array, &ref_dim);
+    BOOST_REQUIRE(error == 0);
+    SMO_close(p_handle);
+
+    std::vector<float> flows;
+    long long total = 0;
+    long batches = fb_ref(bytes, footer, 3);
+    BOOST_REQUIRE_EQUAL(4u, read_at<unsigned int>(bytes, batches));
+    for (int b = 0; b < 4; b++) {
+        buffers = arrow_buffers(bytes, batches + 4 + 24 * b, &rows);
+        BOOST_REQUIRE_EQUAL(18u, buffers.size());
+        BOOST_CHECK_EQUAL((b < 3) ? 130 : 78, rows);
+        total += rows;
+        for (int k = 3; k < rows; k += 13) {
+            BOOST_CHECK_EQUAL(3, read_at<int>(bytes, buffers[3] + 4 * k));
+            flows.push_back(read_at<float>(bytes, buffers[5] + 4 * k));
+        }
+    }
+    BOOST_CHECK_EQUAL(468, total);
+
+    // First period is one reporting step after 01/01/1998
+    buffers = arrow_buffers(bytes, batches + 4, &rows);
+    BOOST_CHECK_EQUAL((35796LL - 25569LL) * 86400000LL + 3600000LL,
+                      read_at<long long>(bytes, buffers[1]));
+    BOOST_CHECK_EQUAL_COLLECTIONS(ref_array, ref_array + ref_dim,
+                                  flows.begin(), flows.end());
+    SMO_freeMemory((void*)ref_array);
+}
+
+BOOST_AUTO_TEST_CASE(CatalogTest) {
+    const char* paths[] = {DATA_PATH_COMPRESSED, DATA_PATH_COMPRESSED,
+                           DATA_PATH_NAMES};
+
+    SMO_Catalog catalog = NULL;
+    SMO_Handle  p_handle = NULL;
+    int         files, periods, index;
+    float       series[20];
+
+    int error = SMO_openCatalog(&catalog, paths, 2);
+    BOOST_REQUIRE(error == 0);
+
+    error = SMO_getCatalogSize(catalog, &files, &periods);
+    BOOST_REQUIRE(error == 0);
+    BOOST_CHECK_EQUAL(2, files);
+    BOOST_CHECK_EQUAL(36, periods);
+
+    // Element names are shared through the first file's handle
+    error = SMO_getCatalogHandle(catalog, 0, &p_handle);
+    BOOST_REQUIRE(error == 0);
+    error = SMO_findElement(p_handle, SMO_subcatch, "2", &index);
+    BOOST_REQUIRE(error == 0);
+
+    error = SMO_getCatalogSeries(catalog, SMO_subcatch, index,
+                                 SMO_runoff_rate, 0, 10, series);
+    BOOST_REQUIRE(error == 0);
+
+    float ref_array[10] = {
+        0.0f, 1.2438242f, 2.5639679f, 4.524055f, 2.5115132f, 0.69808137f,
+        0.040894926f, 0.011605669f, 0.0f, 0.0f};
+    std::vector<float> ref_vec(ref_array, ref_array + 10);
+    for (int i = 0; i < files; i++) {
+        std::vector<float> test_vec(series + i * 10, series + i * 10 + 10);
+        BOOST_CHECK(check_cdd_float(test_vec, ref_vec, 3));
+    }
+
+    error = SMO_getCatalogSeries(catalog, SMO_subcatch, index,
+                                 SMO_runoff_rate, 0, 37, series);
+    BOOST_CHECK_EQUAL(422, error);
+    SMO_closeCatalog(catalog);
+
+    // Files must share one layout
+    error = SMO_openCatalog(&catalog, paths + 1, 2);
+    BOOST_CHECK_EQUAL(442, error);
+    BOOST_CHECK(catalog == NULL);
+}
+
+BOOST_AUTO_TEST_CASE(NameIndexTest) {
+    std::string path = std::string(DATA_PATH_NAMES);
+
+    SMO_Handle p_handle = NULL;
+    char*      name;
+    int        index, length;
+
+    SMO_init(&p_handle);
+    int error = SMO_open(p_handle, path.c_str());
+    BOOST_REQUIRE(error == 0);
+
+    // Names are found through the index saved in the file
+    error = SMO_findElement(p_handle, SMO_link, "16", &index);
+    BOOST_REQUIRE(error == 0);
+    BOOST_CHECK_EQUAL(12, index);
+
+    error = SMO_findElement(p_handle, SMO_pollut, "lead", &index);
+    BOOST_REQUIRE(error == 0);
+    BOOST_CHECK_EQUAL(1, index);
+
+    error = SMO_findElement(p_handle, SMO_subcatch, "9", &index);
+    BOOST_CHECK_EQUAL(426, error);
+
+    // The index leaves the rest of the file readable as before
+    error = SMO_getElementName(p_handle, SMO_link, 12, &name, &length);
+    BOOST_REQUIRE(error == 0);
+    BOOST_CHECK(check_string(std::string(name), std::string("16")));
+    SMO_freeMemory((void*)name);
+
+    SMO_close(p_handle);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 struct Fixture {
@@ -249,6 +711,24 @@ BOOST_FIXTURE_TEST_CASE(test_getElementName, Fixture) {
     SMO_freeMemory((void*)c_array);
 }
 
+BOOST_FIXTURE_TEST_CASE(test_findElement, Fixture) {
+    int index = -1;
+
+    error = SMO_findElement(p_handle, SMO_node, "10", &index);
+    BOOST_REQUIRE(error == 0);
+    BOOST_CHECK_EQUAL(1, index);
+
+    error = SMO_findElement(p_handle, SMO_pollut, "TSS", &index);
+    BOOST_REQUIRE(error == 0);
+    BOOST_CHECK_EQUAL(0, index);
+
+    error = SMO_findElement(p_handle, SMO_link, "missing", &index);
+    BOOST_CHECK_EQUAL(426, error);
+
+    error = SMO_findElement(p_handle, SMO_sys, "10", &index);
+    BOOST_CHECK_EQUAL(421, error);
+}
+
 BOOST_FIXTURE_TEST_CASE(test_getSubcatchSeries, Fixture) {
     error = SMO_getSubcatchSeries(p_handle, 1, SMO_runoff_rate, 0, 10, &array,
                                   &array_dim);
@@ -0,0 +1,87 @@
+/*
+ ******************************************************************************
+ Project:      OWA SWMM
+ Version:      5.1.13
+ Module:       bench_load.cpp
+ Description:  microbenchmark of the time taken to load large projects
+ Authors:      see AUTHORS
+ Copyright:    see AUTHORS
+ License:      see LICENSE
+ Last Updated: 10/19/2026
+ ******************************************************************************
+ */
+
+// Usage: bench_load [nodes] [repeats]
+//
+// Writes a project with the given number of junctions (default 200000),
+// one conduit leaving each junction and one subcatchment draining to it,
+// then reports the fastest of several swmm_open / swmm_close cycles.
+// Object ID lookups made while parsing dominate the load time of such
+// a project, so it is used to compare changes to the hash table module.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#include "swmm5.h"
+
+using namespace std;
+
+static void write_project(const char *path, int n)
+{
+    ofstream f(path);
+    f << "[OPTIONS]\nFLOW_UNITS CFS\nFLOW_ROUTING KINWAVE\n"
+         "START_DATE 01/01/2000\nEND_DATE 01/01/2000\nEND_TIME 01:00\n\n";
+    f << "[RAINGAGES]\nRG1 INTENSITY 1:00 1.0 TIMESERIES TS1\n\n";
+    f << "[TIMESERIES]\nTS1 0:00 0.5\nTS1 1:00 0.0\n\n";
+    f << "[SUBCATCHMENTS]\n";
+    for (int i = 0; i < n; i++)
+        f << "Sub" << i << " RG1 Node" << i << " 10 50 500 0.01 0\n";
+    f << "\n[SUBAREAS]\n";
+    for (int i = 0; i < n; i++)
+        f << "Sub" << i << " 0.01 0.1 0.05 0.05 25 OUTLET\n";
+    f << "\n[INFILTRATION]\n";
+    for (int i = 0; i < n; i++)
+        f << "Sub" << i << " 3.0 0.5 4 7 0\n";
+    f << "\n[JUNCTIONS]\n";
+    for (int i = 0; i < n; i++)
+        f << "Node" << i << " 100 4 0 0 0\n";
+    f << "\n[OUTFALLS]\nOut1 90 FREE NO\n\n[CONDUITS]\n";
+    for (int i = 0; i < n; i++)
+        f << "Link" << i << " Node" << i << " "
+          << (i + 1 < n ? "Node" + to_string(i + 1) : string("Out1"))
+          << " 400 0.01 0 0 0 0\n";
+    f << "\n[XSECTIONS]\n";
+    for (int i = 0; i < n; i++)
+        f << "Link" << i << " CIRCULAR 1 0 0 0 1\n";
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : 200000;
+    int repeats = argc > 2 ? atoi(argv[2]) : 5;
+    const char *inp = "bench_load.inp";
+    const char *rpt = "bench_load.rpt";
+    double best = 0.0;
+
+    write_project(inp, n);
+    for (int i = 0; i < repeats; i++)
+    {
+        auto start = chrono::steady_clock::now();
+        int error = swmm_open(inp, rpt, "");
+        swmm_close();
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        if (error)
+        {
+            printf("swmm_open failed with error %d\n", error);
+            return 1;
+        }
+        if (i == 0 || elapsed.count() < best) best = elapsed.count();
+    }
+    remove(inp);
+    remove(rpt);
+    printf("%d nodes, %d links, %d subcatchments: load %.3f s\n",
+           n + 1, n, n, best);
+    return 0;
+}
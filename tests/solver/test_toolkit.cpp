@@ -12,6 +12,19 @@
  */
 
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
 #include <boost/test/unit_test.hpp>
 
 #include "test_solver.hpp"
@@ -22,6 +35,7 @@
 #define ERR_API_SIM_NRUNNING 503
 #define ERR_API_WRONG_TYPE 504
 #define ERR_API_OBJECT_INDEX 505
+#define ERR_API_SNAPSHOT 513
 
 using namespace std;
 
@@ -103,6 +117,53 @@ BOOST_AUTO_TEST_CASE(model_not_open) {
     BOOST_CHECK_EQUAL(error, ERR_API_INPUTNOTOPEN);
 }
 
+// Runs the model and returns the flow in each link after every step
+static vector<double> run_link_flows() {
+    vector<double> flows;
+    int error, count, i;
+    double elapsedTime = 0.0, flow;
+
+    error = swmm_open(DATA_PATH_INP, DATA_PATH_RPT, DATA_PATH_OUT);
+    BOOST_REQUIRE(error == ERR_NONE);
+    error = swmm_countObjects(SM_LINK, &count);
+    BOOST_REQUIRE(error == ERR_NONE);
+    error = swmm_start(0);
+    BOOST_REQUIRE(error == ERR_NONE);
+    do
+    {
+        error = swmm_step(&elapsedTime);
+        for (i = 0; i < count; i++) {
+            swmm_getLinkResult(i, SM_LINKFLOW, &flow);
+            flows.push_back(flow);
+        }
+    }while (elapsedTime != 0 && !error);
+    BOOST_REQUIRE(error == ERR_NONE);
+    swmm_end();
+    swmm_close();
+    return flows;
+}
+
+// Test Compiled Project File
+BOOST_AUTO_TEST_CASE(compile_project) {
+    int error;
+    const char* compiled = "test_example1.swc";
+    FILE* file;
+
+    vector<double> ref = run_link_flows();
+
+    error = swmm_compile(DATA_PATH_INP, DATA_PATH_RPT);
+    BOOST_REQUIRE(error == ERR_NONE);
+    file = fopen(compiled, "rb");
+    BOOST_REQUIRE(file != NULL);
+    fclose(file);
+
+    // Opening the project now loads the compiled file
+    vector<double> test = run_link_flows();
+    BOOST_CHECK(test == ref);
+
+    remove(compiled);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
@@ -947,6 +1008,848 @@ BOOST_FIXTURE_TEST_CASE(get_result_during_sim, FixtureBeforeStep){
 }
 
 
+// Testing Results Streaming
+struct StreamCapture {
+    int calls;
+    double elapsedTime;
+    std::vector<std::vector<double>> values;
+};
+
+static void capture_results(double elapsedTime, const SM_ResultsView *views,
+    int count, void *userData)
+{
+    StreamCapture *capture = (StreamCapture *)userData;
+    capture->calls += 1;
+    capture->elapsedTime = elapsedTime;
+    capture->values.clear();
+    for (int i = 0; i < count; i++)
+        capture->values.push_back(std::vector<double>(views[i].values,
+            views[i].values + views[i].count));
+}
+
+BOOST_FIXTURE_TEST_CASE(stream_results_during_sim, FixtureBeforeStep){
+    int error, subscription, step_ind, nde_count, lnk_count;
+    int subc_inds[] = {0, 2};
+    int bad_inds[] = {0, 1000};
+    double val;
+    double elapsedTime = 0.0;
+    StreamCapture capture = {0, 0.0};
+
+    error = swmm_subscribeResults(SM_GAGE, 0, NULL, 0, &subscription);
+    BOOST_CHECK_EQUAL(error, ERR_API_WRONG_TYPE);
+    error = swmm_subscribeResults(SM_NODE, SM_LATINFLOW + 1, NULL, 0, &subscription);
+    BOOST_CHECK_EQUAL(error, ERR_API_OUTBOUNDS);
+    error = swmm_subscribeResults(SM_LINK, SM_LINKFLOW, bad_inds, 2, &subscription);
+    BOOST_CHECK_EQUAL(error, ERR_API_OBJECT_INDEX);
+
+    error = swmm_subscribeResults(SM_NODE, SM_NODEDEPTH, NULL, 0, &subscription);
+    BOOST_REQUIRE(error == ERR_NONE);
+    BOOST_CHECK_EQUAL(subscription, 0);
+    error = swmm_subscribeResults(SM_LINK, SM_LINKFLOW, NULL, 0, &subscription);
+    BOOST_REQUIRE(error == ERR_NONE);
+    error = swmm_subscribeResults(SM_SUBCATCH, SM_SUBCRUNOFF, subc_inds, 2, &subscription);
+    BOOST_REQUIRE(error == ERR_NONE);
+    BOOST_CHECK_EQUAL(subscription, 2);
+
+    error = swmm_setResultsCallback(SM_ROUTINGSTEP, capture_results, &capture);
+    BOOST_REQUIRE(error == ERR_NONE);
+
+    swmm_countObjects(SM_NODE, &nde_count);
+    swmm_countObjects(SM_LINK, &lnk_count);
+
+    step_ind = 0;
+    do
+    {
+        error = swmm_step(&elapsedTime);
+        step_ind += 1;
+        if (step_ind == 200 || elapsedTime == 0)
+        {
+            BOOST_REQUIRE_EQUAL(capture.calls, step_ind);
+            BOOST_REQUIRE_EQUAL(capture.values.size(), 3);
+            BOOST_REQUIRE_EQUAL(capture.values[0].size(), nde_count);
+            BOOST_REQUIRE_EQUAL(capture.values[1].size(), lnk_count);
+            BOOST_REQUIRE_EQUAL(capture.values[2].size(), 2);
+
+            for (int i = 0; i < nde_count; i++)
+            {
+                swmm_getNodeResult(i, SM_NODEDEPTH, &val);
+                BOOST_CHECK_EQUAL(capture.values[0][i], val);
+            }
+            for (int i = 0; i < lnk_count; i++)
+            {
+                swmm_getLinkResult(i, SM_LINKFLOW, &val);
+                BOOST_CHECK_EQUAL(capture.values[1][i], val);
+            }
+            for (int i = 0; i < 2; i++)
+            {
+                swmm_getSubcatchResult(subc_inds[i], SM_SUBCRUNOFF, &val);
+                BOOST_CHECK_EQUAL(capture.values[2][i], val);
+            }
+        }
+    }while (elapsedTime != 0 && !error);
+    BOOST_REQUIRE(error == ERR_NONE);
+
+    error = swmm_clearResultsSubscriptions();
+    BOOST_CHECK_EQUAL(error, ERR_NONE);
+    swmm_end();
+}
+
+BOOST_FIXTURE_TEST_CASE(stream_results_report_steps, FixtureBeforeStep){
+    int error, subscription;
+    double elapsedTime = 0.0;
+    StreamCapture capture = {0, 0.0};
+
+    error = swmm_subscribeResults(SM_NODE, SM_NODEHEAD, NULL, 0, &subscription);
+    BOOST_REQUIRE(error == ERR_NONE);
+    error = swmm_setResultsCallback(SM_REPORTSTEP, capture_results, &capture);
+    BOOST_REQUIRE(error == ERR_NONE);
+
+    do
+    {
+        error = swmm_step(&elapsedTime);
+    }while (elapsedTime != 0 && !error);
+    BOOST_REQUIRE(error == ERR_NONE);
+
+    // One callback per hourly reporting period over 36 hours
+    BOOST_CHECK_EQUAL(capture.calls, 36);
+    BOOST_CHECK_SMALL(capture.elapsedTime - 1.5, 0.0001);
+    swmm_end();
+}
+
+// Steps a running simulation to its end, recording the results of each step
+static void step_to_end(std::vector<double> &results)
+{
+    int error, sub_count, nde_count, lnk_count;
+    double val;
+    double elapsedTime = 0.0;
+
+    swmm_countObjects(SM_SUBCATCH, &sub_count);
+    swmm_countObjects(SM_NODE, &nde_count);
+    swmm_countObjects(SM_LINK, &lnk_count);
+    do
+    {
+        error = swmm_step(&elapsedTime);
+        BOOST_REQUIRE(error == ERR_NONE);
+        for (int i = 0; i < sub_count; i++)
+        {
+            swmm_getSubcatchResult(i, SM_SUBCRUNOFF, &val);
+            results.push_back(val);
+            swmm_getSubcatchResult(i, SM_SUBCSNOW, &val);
+            results.push_back(val);
+        }
+        for (int i = 0; i < nde_count; i++)
+        {
+            swmm_getNodeResult(i, SM_NODEDEPTH, &val);
+            results.push_back(val);
+        }
+        for (int i = 0; i < lnk_count; i++)
+        {
+            swmm_getLinkResult(i, SM_LINKFLOW, &val);
+            results.push_back(val);
+        }
+    }while (elapsedTime != 0);
+}
+
+// Saves a snapshot part way through a running simulation and requires the
+// rest of the simulation to repeat exactly once the snapshot is restored
+static SM_Snapshot *check_snapshot_restore(int steps)
+{
+    int error;
+    double elapsedTime = 0.0;
+    size_t mismatches = 0;
+    std::vector<double> first, second;
+    SM_Snapshot *snapshot = NULL;
+
+    for (int step = 0; step < steps; step++)
+    {
+        error = swmm_step(&elapsedTime);
+        BOOST_REQUIRE(error == ERR_NONE);
+    }
+    error = swmm_saveSnapshot(&snapshot);
+    BOOST_REQUIRE(error == ERR_NONE);
+    BOOST_REQUIRE(snapshot != NULL);
+
+    step_to_end(first);
+    error = swmm_restoreSnapshot(snapshot);
+    BOOST_REQUIRE(error == ERR_NONE);
+    step_to_end(second);
+
+    BOOST_REQUIRE(first.size() > 0);
+    BOOST_REQUIRE_EQUAL(first.size(), second.size());
+    for (size_t i = 0; i < first.size(); i++)
+        if (first[i] != second[i]) mismatches++;
+    BOOST_REQUIRE_EQUAL(mismatches, 0);
+    return snapshot;
+}
+
+BOOST_FIXTURE_TEST_CASE(snapshot_restore_during_sim, FixtureBeforeStep){
+    int error;
+    SM_Snapshot *snapshot = NULL;
+
+    error = swmm_restoreSnapshot(NULL);
+    BOOST_CHECK_EQUAL(error, ERR_API_SNAPSHOT);
+
+    // Results of the steps following a restored snapshot repeat exactly
+    snapshot = check_snapshot_restore(100);
+
+    // Snapshots cannot be restored into a later run
+    swmm_end();
+    error = swmm_restoreSnapshot(snapshot);
+    BOOST_CHECK_EQUAL(error, ERR_API_SIM_NRUNNING);
+    swmm_start(0);
+    error = swmm_restoreSnapshot(snapshot);
+    BOOST_CHECK_EQUAL(error, ERR_API_SNAPSHOT);
+
+    swmm_deleteSnapshot(snapshot);
+    swmm_end();
+}
+
+// Snow packs and groundwater carry state (including the daily snow melt
+// coefficients) that must also be restored
+#define DATA_PATH_INP_SNOW_GW "test_snow_gw.inp"
+
+struct FixtureSnowGW : FixtureOpenClose {
+    FixtureSnowGW() : FixtureOpenClose(DATA_PATH_INP_SNOW_GW) {}
+};
+
+BOOST_FIXTURE_TEST_CASE(snapshot_restore_snow_gw, FixtureSnowGW){
+    int error;
+
+    error = swmm_start(0);
+    BOOST_REQUIRE(error == ERR_NONE);
+
+    swmm_deleteSnapshot(check_snapshot_restore(100));
+    swmm_end();
+}
+
+static std::string read_file(const char *path)
+{
+    std::ifstream f(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(f),
+                       std::istreambuf_iterator<char>());
+}
+
+#if !defined(_WIN32)
+
+// Forking is exported by the engine but not part of the public toolkit.h
+extern "C" {
+int DLLEXPORT swmm_fork(int count, int *member);
+int DLLEXPORT swmm_waitForks(int *failures);
+}
+
+BOOST_AUTO_TEST_CASE(fork_ensemble_during_sim){
+    int error, member, failures;
+    double elapsedTime = 0.0;
+
+    // Results are compared once the project is closed, so it is opened here
+    // rather than by a fixture
+    error = swmm_open(DATA_PATH_INP, DATA_PATH_RPT, DATA_PATH_OUT);
+    BOOST_REQUIRE(error == ERR_NONE);
+    error = swmm_start(1);
+    BOOST_REQUIRE(error == ERR_NONE);
+
+    error = swmm_fork(0, &member);
+    BOOST_CHECK_EQUAL(error, ERR_API_OUTBOUNDS);
+
+    for (int step = 0; step < 100; step++)
+    {
+        error = swmm_step(&elapsedTime);
+        BOOST_REQUIRE(error == ERR_NONE);
+    }
+    error = swmm_fork(2, &member);
+
+    // Each member is a process of its own that must not return to the
+    // test runner
+    if (member > 0)
+    {
+        do
+        {
+            error = swmm_step(&elapsedTime);
+        }while (elapsedTime != 0 && !error);
+        swmm_end();
+        swmm_close();
+        _exit(error ? 1 : 0);
+    }
+    BOOST_REQUIRE(error == ERR_NONE);
+
+    do
+    {
+        error = swmm_step(&elapsedTime);
+    }while (elapsedTime != 0 && !error);
+    BOOST_REQUIRE(error == ERR_NONE);
+    swmm_end();
+    swmm_close();
+
+    error = swmm_waitForks(&failures);
+    BOOST_CHECK_EQUAL(error, ERR_NONE);
+    BOOST_CHECK_EQUAL(failures, 0);
+
+    // Members given the same inputs write the same results to their own files
+    std::string results = read_file(DATA_PATH_OUT);
+    BOOST_CHECK(results.size() > 0);
+    BOOST_CHECK(read_file("tmp_1.out") == results);
+    BOOST_CHECK(read_file("tmp_2.out") == results);
+    remove("tmp_1.out");
+    remove("tmp_2.out");
+    remove("tmp_1.rpt");
+    remove("tmp_2.rpt");
+}
+#endif
+
+// Testing Time Series Loaded For A Longer Simulation
+BOOST_AUTO_TEST_CASE(tseries_reload_for_longer_sim){
+    int error;
+    double elapsedTime = 0.0;
+    std::string inp = read_file(DATA_PATH_INP);
+
+    error = swmm_run(DATA_PATH_INP, DATA_PATH_RPT, DATA_PATH_OUT);
+    BOOST_REQUIRE(error == ERR_NONE);
+
+    // A copy of the project simulating only the first rainfall loads only
+    // the rainfall time series data for that period
+    size_t pos = inp.find("END_DATE             01/02/1998");
+    BOOST_REQUIRE(pos != std::string::npos);
+    inp.replace(pos, 31, "END_DATE             01/01/1998");
+    std::ofstream("tmp_short.inp") << inp;
+
+    error = swmm_open("tmp_short.inp", "tmp_short.rpt", "tmp_short.out");
+    BOOST_REQUIRE(error == ERR_NONE);
+    error = swmm_setSimulationDateTime(SM_ENDDATE, 1998, 1, 2, 12, 0, 0);
+    BOOST_REQUIRE(error == ERR_NONE);
+    error = swmm_start(1);
+    BOOST_REQUIRE(error == ERR_NONE);
+    do
+    {
+        error = swmm_step(&elapsedTime);
+        BOOST_REQUIRE(error == ERR_NONE);
+    }while (elapsedTime != 0);
+    swmm_end();
+    swmm_close();
+
+    // Moving the end date reloads the second rainfall
+    BOOST_CHECK(read_file("tmp_short.out") == read_file(DATA_PATH_OUT));
+    remove("tmp_short.inp");
+    remove("tmp_short.rpt");
+    remove("tmp_short.out");
+}
+
+// Copies an input file, setting the value of one of its options
+static void copy_with_option(const char *from, const char *to,
+    const std::string &option, const std::string &value)
+{
+    std::istringstream in(read_file(from));
+    std::ofstream out(to);
+    std::string line;
+
+    while (std::getline(in, line))
+    {
+        if (line.compare(0, option.size() + 1, option + " ") == 0) continue;
+        out << line << "\n";
+        if (line.compare(0, 9, "[OPTIONS]") == 0)
+            out << option << " " << value << "\n";
+    }
+}
+
+// Copies an input file, adding lines to the start of its [OPTIONS] section
+// (such as a [FILES] section placed before it)
+static void copy_with_section(const char *from, const char *to,
+    const std::string &lines)
+{
+    std::string inp = read_file(from);
+    size_t pos = inp.find("[OPTIONS]");
+    BOOST_REQUIRE(pos != std::string::npos);
+    inp.insert(pos, lines);
+    std::ofstream(to) << inp;
+}
+
+// Testing Runoff Computed Ahead Of Routing
+BOOST_AUTO_TEST_CASE(runoff_pipeline_results){
+    int error;
+
+    error = swmm_run(DATA_PATH_INP, DATA_PATH_RPT, DATA_PATH_OUT);
+    BOOST_REQUIRE(error == ERR_NONE);
+
+    // With more than one thread (and core) runoff is computed on a thread
+    // of its own, which must not change any results
+    copy_with_option(DATA_PATH_INP, "tmp_pipe.inp", "THREADS", "2");
+    error = swmm_run("tmp_pipe.inp", "tmp_pipe.rpt", "tmp_pipe.out");
+    BOOST_REQUIRE(error == ERR_NONE);
+
+    std::string results = read_file(DATA_PATH_OUT);
+    BOOST_CHECK(results.size() > 0);
+    BOOST_CHECK(read_file("tmp_pipe.out") == results);
+    remove("tmp_pipe.inp");
+    remove("tmp_pipe.rpt");
+    remove("tmp_pipe.out");
+}
+
+// Testing Runoff Errors Raised Ahead Of Routing
+BOOST_AUTO_TEST_CASE(runoff_pipeline_error){
+    int error, serial_error;
+    char msg[256];
+
+    copy_with_section(DATA_PATH_INP, "tmp_save.inp",
+                      "[FILES]\nSAVE RUNOFF \"tmp.rof\"\n\n");
+    error = swmm_run("tmp_save.inp", DATA_PATH_RPT, DATA_PATH_OUT);
+    BOOST_REQUIRE(error == ERR_NONE);
+
+    // A runoff interface file cut short ends the simulation part way
+    // through, whether or not it is read on a thread of its own
+    std::string runoff = read_file("tmp.rof");
+    std::ofstream("tmp.rof", std::ios::binary)
+        << runoff.substr(0, runoff.size() / 2);
+    copy_with_section(DATA_PATH_INP, "tmp_use.inp",
+                      "[FILES]\nUSE RUNOFF \"tmp.rof\"\n\n");
+    copy_with_option("tmp_use.inp", "tmp_pipe.inp", "THREADS", "2");
+
+    serial_error = swmm_run("tmp_use.inp", DATA_PATH_RPT, DATA_PATH_OUT);
+    BOOST_CHECK_EQUAL(serial_error, 329);
+    error = swmm_run("tmp_pipe.inp", "tmp_pipe.rpt", "tmp_pipe.out");
+    BOOST_CHECK_EQUAL(error, serial_error);
+    swmm_getError(msg, 256);
+    BOOST_CHECK(std::string(msg).find("ERROR 329") != std::string::npos);
+    BOOST_CHECK(read_file("tmp_pipe.rpt").find("ERROR 329") !=
+                std::string::npos);
+
+    remove("tmp.rof");
+    remove("tmp_save.inp");
+    remove("tmp_use.inp");
+    remove("tmp_pipe.inp");
+    remove("tmp_pipe.rpt");
+    remove("tmp_pipe.out");
+}
+
+// Testing Results Written On A Thread Of Their Own
+BOOST_AUTO_TEST_CASE(threaded_writer_results){
+    int error;
+
+    // Results reported every 5 minutes for 20 days fill more than the
+    // writer thread's buffers
+    copy_with_option("test_snow_gw.inp", "tmp_serial.inp", "REPORT_STEP",
+                     "00:05:00");
+    copy_with_option("tmp_serial.inp", "tmp_writer.inp", "THREADS", "2");
+    error = swmm_run("tmp_serial.inp", "tmp_serial.rpt", "tmp_serial.out");
+    BOOST_REQUIRE(error == ERR_NONE);
+    error = swmm_run("tmp_writer.inp", "tmp_writer.rpt", "tmp_writer.out");
+    BOOST_REQUIRE(error == ERR_NONE);
+
+    std::string results = read_file("tmp_serial.out");
+    BOOST_CHECK(results.size() > 4 * 1048576);
+    BOOST_CHECK(read_file("tmp_writer.out") == results);
+    remove("tmp_serial.inp");
+    remove("tmp_serial.rpt");
+    remove("tmp_serial.out");
+    remove("tmp_writer.inp");
+    remove("tmp_writer.rpt");
+    remove("tmp_writer.out");
+}
+
+// Reads a value from the contents of a binary file
+template <typename T>
+static T read_value(const std::string &bytes, size_t &pos)
+{
+    T value;
+    BOOST_REQUIRE(pos + sizeof(T) <= bytes.size());
+    memcpy(&value, bytes.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return value;
+}
+
+// Testing Selective Result Recording
+BOOST_AUTO_TEST_CASE(recording_with_trigger){
+    int error, index, nde_count;
+    double elapsedTime = 0.0;
+    double flow2h = -1.0;
+    std::string inp = read_file(DATA_PATH_INP);
+
+    // Link 1's flow & depth are recorded hourly, or every 5 minutes while
+    // its flow exceeds 1 cfs, and each node's total inflow every 6 hours
+    size_t pos = inp.find("[OPTIONS]");
+    BOOST_REQUIRE(pos != std::string::npos);
+    inp.insert(pos, "[FILES]\nSAVE RECORDING \"tmp_rec.rec\"\n\n"
+                    "[RECORDING]\n"
+                    "LINK 1 01:00:00 FLOW DEPTH TRIGGER FLOW 1 00:05:00\n"
+                    "NODE * 06:00:00 TOTAL_INFLOW\n\n");
+    std::ofstream("tmp_rec.inp") << inp;
+
+    error = swmm_open("tmp_rec.inp", "tmp_rec.rpt", "tmp_rec.out");
+    BOOST_REQUIRE(error == ERR_NONE);
+    error = swmm_getObjectIndex(SM_LINK, (char *)"1", &index);
+    BOOST_REQUIRE(error == ERR_NONE);
+    swmm_countObjects(SM_NODE, &nde_count);
+    error = swmm_start(0);
+    BOOST_REQUIRE(error == ERR_NONE);
+    do
+    {
+        error = swmm_step(&elapsedTime);
+        BOOST_REQUIRE(error == ERR_NONE);
+        if (fabs(elapsedTime * 24.0 - 2.0) < 1.0e-6)
+            swmm_getLinkResult(index, SM_LINKFLOW, &flow2h);
+    }while (elapsedTime != 0);
+    swmm_end();
+    swmm_close();
+    BOOST_REQUIRE(flow2h > 1.0);
+
+    // Header & recorders
+    std::string bytes = read_file("tmp_rec.rec");
+    pos = 0;
+    BOOST_CHECK_EQUAL(read_value<int>(bytes, pos), 516114540);
+    BOOST_CHECK_EQUAL(read_value<int>(bytes, pos), swmm_getVersion());
+    BOOST_CHECK_EQUAL(read_value<int>(bytes, pos), 0);
+    BOOST_CHECK_EQUAL(read_value<int>(bytes, pos), 2);
+    double start = read_value<double>(bytes, pos);
+    int recorders = read_value<int>(bytes, pos);
+    BOOST_REQUIRE_EQUAL(recorders, 1 + nde_count);
+    std::vector<int> nVars;
+    for (int i = 0; i < recorders; i++)
+    {
+        read_value<int>(bytes, pos);
+        BOOST_CHECK_EQUAL(read_value<int>(bytes, pos), i == 0 ? index : i - 1);
+        pos += read_value<int>(bytes, pos);
+        nVars.push_back(read_value<int>(bytes, pos));
+        for (int j = 0; j < nVars[i]; j++) read_value<int>(bytes, pos);
+    }
+    BOOST_REQUIRE_EQUAL(nVars[0], 2);
+
+    // Records, checking the interval after each record of link 1
+    int records = 0, nodeRecords = 0, shortSteps = 0, longSteps = 0;
+    double lastDate = 0.0;
+    float lastFlow = 0.0;
+    while (pos < bytes.size() - 3 * sizeof(int))
+    {
+        int k = read_value<int>(bytes, pos);
+        double date = read_value<double>(bytes, pos);
+        BOOST_REQUIRE(k >= 0 && k < recorders);
+        std::vector<float> x;
+        for (int j = 0; j < nVars[k]; j++)
+            x.push_back(read_value<float>(bytes, pos));
+        records++;
+        if (k > 0)
+        {
+            nodeRecords++;
+            continue;
+        }
+        double minutes = (date - start) * 1440.0;
+        if (lastDate > 0.0)
+        {
+            double step = (date - lastDate) * 1440.0;
+            if (lastFlow > 1.0)
+            {
+                BOOST_CHECK_CLOSE(step, 5.0, 1.0e-4);
+                shortSteps++;
+            }
+            else
+            {
+                BOOST_CHECK_CLOSE(step, 60.0, 1.0e-4);
+                longSteps++;
+            }
+        }
+        if (fabs(minutes - 120.0) < 1.0e-4)
+            BOOST_CHECK_EQUAL(x[0], (float)flow2h);
+        lastDate = date;
+        lastFlow = x[0];
+    }
+    BOOST_CHECK(shortSteps > 0);
+    BOOST_CHECK(longSteps > 0);
+    BOOST_CHECK_EQUAL(nodeRecords, 6 * nde_count);
+
+    // Closing records
+    BOOST_CHECK_EQUAL(read_value<int>(bytes, pos), records);
+    BOOST_CHECK_EQUAL(read_value<int>(bytes, pos), 0);
+    BOOST_CHECK_EQUAL(read_value<int>(bytes, pos), 516114540);
+    remove("tmp_rec.inp");
+    remove("tmp_rec.rpt");
+    remove("tmp_rec.out");
+    remove("tmp_rec.rec");
+}
+
+// Runs a project up to an elapsed time (in days) and saves the state of its
+// subcatchments, nodes and links at that time
+static int get_state(const char *inp, double until, std::vector<double> &state)
+{
+    int error, sub_count, nde_count, lnk_count;
+    double val;
+    double elapsedTime = 0.0;
+    char msg[256];
+
+    error = swmm_open(inp, "tmp_hs.rpt", "tmp_hs.out");
+    if (!error) error = swmm_start(1);
+    while (!error && elapsedTime < until - 1.0e-9)
+    {
+        error = swmm_step(&elapsedTime);
+        if (elapsedTime == 0) break;
+    }
+    if (error)
+    {
+        // --- the code number of a hot start file error is only returned
+        //     by swmm_getError
+        error = swmm_getError(msg, 256);
+        swmm_close();
+        return error;
+    }
+
+    swmm_countObjects(SM_SUBCATCH, &sub_count);
+    swmm_countObjects(SM_NODE, &nde_count);
+    swmm_countObjects(SM_LINK, &lnk_count);
+    for (int i = 0; i < sub_count; i++)
+    {
+        swmm_getSubcatchResult(i, SM_SUBCRUNOFF, &val);
+        state.push_back(val);
+    }
+    for (int i = 0; i < nde_count; i++)
+    {
+        swmm_getNodeResult(i, SM_NODEDEPTH, &val);
+        state.push_back(val);
+        swmm_getNodeResult(i, SM_LATINFLOW, &val);
+        state.push_back(val);
+    }
+    for (int i = 0; i < lnk_count; i++)
+    {
+        swmm_getLinkResult(i, SM_LINKFLOW, &val);
+        state.push_back(val);
+        swmm_getLinkResult(i, SM_LINKDEPTH, &val);
+        state.push_back(val);
+    }
+    swmm_end();
+    swmm_close();
+    return ERR_NONE;
+}
+
+// Writes a copy of the project whose rainfall is dated (rather than timed
+// from the start of the simulation) and the two halves of it split at 12:00
+// on its first day, the first saving a hot start file and the second using
+// one
+static void write_halves(const char *saveFile, const char *useFile)
+{
+    std::string inp = read_file(DATA_PATH_INP);
+    std::string ts = "TS1                         ";
+    for (size_t pos = inp.find(ts); pos != std::string::npos;
+         pos = inp.find(ts, pos))
+        inp.replace(pos, ts.size(), "TS1              01/01/1998 ");
+    std::ofstream("tmp_hs.inp") << inp;
+
+    copy_with_option("tmp_hs.inp", "tmp_hs0.inp", "END_DATE", "01/01/1998");
+    copy_with_option("tmp_hs0.inp", "tmp_hs0.inp", "END_TIME", "12:00:00");
+    copy_with_section("tmp_hs0.inp", "tmp_hs1.inp",
+        std::string("[FILES]\nSAVE HOTSTART \"") + saveFile + "\"\n\n");
+    copy_with_option("tmp_hs.inp", "tmp_hs0.inp", "START_TIME", "12:00:00");
+    copy_with_option("tmp_hs0.inp", "tmp_hs0.inp", "REPORT_START_TIME",
+                     "12:00:00");
+    copy_with_section("tmp_hs0.inp", "tmp_hs2.inp",
+        std::string("[FILES]\nUSE HOTSTART \"") + useFile + "\"\n\n");
+    remove("tmp_hs0.inp");
+}
+
+static void remove_halves()
+{
+    remove("tmp_hs.inp");
+    remove("tmp_hs1.inp");
+    remove("tmp_hs2.inp");
+    remove("tmp_hs.rpt");
+    remove("tmp_hs.out");
+}
+
+// Testing Hot Start File Saved And Used
+BOOST_AUTO_TEST_CASE(hotstart_v5_round_trip){
+    int error;
+    size_t mismatches = 0;
+    std::vector<double> continuous, restored;
+
+    write_halves("tmp.hsf", "tmp.hsf");
+    error = get_state("tmp_hs.inp", 0.5, continuous);
+    BOOST_REQUIRE(error == ERR_NONE);
+    error = swmm_run("tmp_hs1.inp", "tmp_hs.rpt", "tmp_hs.out");
+    BOOST_REQUIRE(error == ERR_NONE);
+    BOOST_CHECK(read_file("tmp.hsf").compare(0, 15, "SWMM5-HOTSTART5") == 0);
+
+    // The second half starts from exactly the state reached at 12:00 by
+    // the continuous run
+    error = get_state("tmp_hs2.inp", 0.0, restored);
+    BOOST_REQUIRE(error == ERR_NONE);
+    BOOST_REQUIRE(continuous.size() > 0);
+    BOOST_REQUIRE_EQUAL(restored.size(), continuous.size());
+    for (size_t i = 0; i < continuous.size(); i++)
+        if (restored[i] != continuous[i]) mismatches++;
+    BOOST_CHECK_EQUAL(mismatches, 0);
+    remove("tmp.hsf");
+    remove_halves();
+}
+
+// Testing Hot Start File Saved By An Earlier Version
+BOOST_AUTO_TEST_CASE(hotstart_v4_file){
+    int error;
+    std::vector<double> continuous, restored;
+
+    // The version 4 file holds the state of the project at 12:00 in single
+    // precision, as saved by build 5.1.014
+    BOOST_REQUIRE(read_file("test_example1_v4.hsf").compare(0, 15,
+                  "SWMM5-HOTSTART4") == 0);
+    write_halves("tmp.hsf", "test_example1_v4.hsf");
+    error = get_state("tmp_hs.inp", 0.5, continuous);
+    BOOST_REQUIRE(error == ERR_NONE);
+    error = get_state("tmp_hs2.inp", 0.0, restored);
+    BOOST_REQUIRE(error == ERR_NONE);
+    BOOST_REQUIRE(continuous.size() > 0);
+    BOOST_REQUIRE_EQUAL(restored.size(), continuous.size());
+    for (size_t i = 0; i < continuous.size(); i++)
+        BOOST_CHECK_SMALL(restored[i] - continuous[i],
+                          1.0e-6 * std::max(fabs(continuous[i]), 1.0));
+    remove_halves();
+}
+
+// Testing Hot Start File With A Corrupted Checksum
+BOOST_AUTO_TEST_CASE(hotstart_v5_checksum){
+    int error;
+    std::vector<double> restored;
+
+    write_halves("tmp.hsf", "tmp_bad.hsf");
+    error = swmm_run("tmp_hs1.inp", "tmp_hs.rpt", "tmp_hs.out");
+    BOOST_REQUIRE(error == ERR_NONE);
+
+    // Changing a byte of the last saved value leaves the file's structure
+    // intact, so only its section's checksum detects the change
+    std::string hsf = read_file("tmp.hsf");
+    BOOST_REQUIRE(hsf.size() > 0);
+    hsf[hsf.size() - 2] ^= 0x10;
+    std::ofstream("tmp_bad.hsf", std::ios::binary) << hsf;
+    error = get_state("tmp_hs2.inp", 0.0, restored);
+    BOOST_CHECK_EQUAL(error, 335);
+    remove("tmp.hsf");
+    remove("tmp_bad.hsf");
+    remove_halves();
+}
+
+// Writes a copy of the snow pack model whose temperature, evaporation and
+// wind speed come from a climate file, with the given [FILES] lines
+static void write_climate_inp(const char *to, const char *climateFile,
+    const std::string &files)
+{
+    std::string inp = read_file(DATA_PATH_INP_SNOW_GW);
+    const char *edits[3][2] = {
+        {"CONSTANT         0.2", "TEMPERATURE"},
+        {"TIMESERIES TEMP1", "FILE \""},
+        {"WINDSPEED MONTHLY 5 5 5 5 5 5 5 5 5 5 5 5", "WINDSPEED FILE"}};
+    for (int i = 0; i < 3; i++)
+    {
+        size_t pos = inp.find(edits[i][0]);
+        BOOST_REQUIRE(pos != std::string::npos);
+        std::string text = edits[i][1];
+        if (i == 1) text += std::string(climateFile) + "\"";
+        inp.replace(pos, strlen(edits[i][0]), text);
+    }
+    std::ofstream("tmp_clim0.inp") << inp;
+    copy_with_section("tmp_clim0.inp", to, "[FILES]\n" + files + "\n\n");
+    remove("tmp_clim0.inp");
+}
+
+// Testing Climate Table File Saved And Used
+BOOST_AUTO_TEST_CASE(climate_table_save_and_use){
+    int error;
+
+    write_climate_inp("tmp_clim1.inp", "test_climate.dat", "");
+    write_climate_inp("tmp_clim2.inp", "test_climate.dat",
+                      "SAVE CLIMATE \"tmp.ctb\"");
+    write_climate_inp("tmp_clim3.inp", "test_climate.dat",
+                      "USE CLIMATE \"tmp.ctb\"");
+
+    error = swmm_run("tmp_clim1.inp", "tmp_clim.rpt", "tmp_clim1.out");
+    BOOST_REQUIRE(error == ERR_NONE);
+    error = swmm_run("tmp_clim2.inp", "tmp_clim.rpt", "tmp_clim2.out");
+    BOOST_REQUIRE(error == ERR_NONE);
+    BOOST_CHECK(read_file("tmp.ctb").compare(0, 14, "SWMM5-CLIMATE2") == 0);
+    error = swmm_run("tmp_clim3.inp", "tmp_clim.rpt", "tmp_clim3.out");
+    BOOST_REQUIRE(error == ERR_NONE);
+
+    std::string results = read_file("tmp_clim1.out");
+    BOOST_CHECK(results.size() > 0);
+    BOOST_CHECK(read_file("tmp_clim2.out") == results);
+    BOOST_CHECK(read_file("tmp_clim3.out") == results);
+    remove("tmp.ctb");
+    for (int i = 1; i <= 3; i++)
+    {
+        std::string name = "tmp_clim" + std::to_string(i);
+        remove((name + ".inp").c_str());
+        remove((name + ".out").c_str());
+    }
+    remove("tmp_clim.rpt");
+}
+
+// Testing Climate Table File Not Matching The Project
+BOOST_AUTO_TEST_CASE(climate_table_mismatch){
+    int error;
+
+    write_climate_inp("tmp_clim1.inp", "test_climate.dat",
+                      "SAVE CLIMATE \"tmp.ctb\"");
+    write_climate_inp("tmp_clim2.inp", "test_climate.dat",
+                      "USE CLIMATE \"tmp.ctb\"");
+    error = swmm_run("tmp_clim1.inp", "tmp_clim.rpt", "tmp_clim.out");
+    BOOST_REQUIRE(error == ERR_NONE);
+    error = swmm_run("tmp_clim2.inp", "tmp_clim.rpt", "tmp_clim.out");
+    BOOST_REQUIRE(error == ERR_NONE);
+    std::string table = read_file("tmp.ctb");
+
+    // A longer period than the table holds
+    copy_with_option("tmp_clim2.inp", "tmp_clim3.inp", "END_DATE",
+                     "01/25/1998");
+    error = swmm_run("tmp_clim3.inp", "tmp_clim.rpt", "tmp_clim.out");
+    BOOST_CHECK_EQUAL(error, 338);
+
+    // A period starting on another date
+    copy_with_option("tmp_clim2.inp", "tmp_clim3.inp", "START_DATE",
+                     "01/02/1998");
+    copy_with_option("tmp_clim3.inp", "tmp_clim3.inp", "REPORT_START_DATE",
+                     "01/02/1998");
+    error = swmm_run("tmp_clim3.inp", "tmp_clim.rpt", "tmp_clim.out");
+    BOOST_CHECK_EQUAL(error, 338);
+
+    // Another unit system
+    copy_with_option("tmp_clim2.inp", "tmp_clim3.inp", "FLOW_UNITS", "CMS");
+    error = swmm_run("tmp_clim3.inp", "tmp_clim.rpt", "tmp_clim.out");
+    BOOST_CHECK_EQUAL(error, 338);
+
+    // A file with its header cut short
+    std::ofstream("tmp.ctb", std::ios::binary) << table.substr(0, 20);
+    error = swmm_run("tmp_clim2.inp", "tmp_clim.rpt", "tmp_clim.out");
+    BOOST_CHECK_EQUAL(error, 338);
+
+    // A file with another stamp
+    std::string stamped = table;
+    stamped[13] = '0';
+    std::ofstream("tmp.ctb", std::ios::binary) << stamped;
+    error = swmm_run("tmp_clim2.inp", "tmp_clim.rpt", "tmp_clim.out");
+    BOOST_CHECK_EQUAL(error, 338);
+
+    // A copy of the climate file under another name
+    std::string climate = read_file("test_climate.dat");
+    BOOST_REQUIRE(climate.size() > 0);
+    std::ofstream("tmp.ctb", std::ios::binary) << table;
+    std::ofstream("tmp_climate.dat", std::ios::binary) << climate;
+    write_climate_inp("tmp_clim3.inp", "tmp_climate.dat",
+                      "USE CLIMATE \"tmp.ctb\"");
+    error = swmm_run("tmp_clim3.inp", "tmp_clim.rpt", "tmp_clim.out");
+    BOOST_CHECK_EQUAL(error, 338);
+
+    // A climate file edited after the table was saved
+    write_climate_inp("tmp_clim1.inp", "tmp_climate.dat",
+                      "SAVE CLIMATE \"tmp.ctb\"");
+    error = swmm_run("tmp_clim1.inp", "tmp_clim.rpt", "tmp_clim.out");
+    BOOST_REQUIRE(error == ERR_NONE);
+    error = swmm_run("tmp_clim3.inp", "tmp_clim.rpt", "tmp_clim.out");
+    BOOST_REQUIRE(error == ERR_NONE);
+    std::ofstream("tmp_climate.dat", std::ios::binary | std::ios::app)
+        << "\n";
+    error = swmm_run("tmp_clim3.inp", "tmp_clim.rpt", "tmp_clim.out");
+    BOOST_CHECK_EQUAL(error, 338);
+
+    remove("tmp.ctb");
+    remove("tmp_climate.dat");
+    remove("tmp_clim1.inp");
+    remove("tmp_clim2.inp");
+    remove("tmp_clim3.inp");
+    remove("tmp_clim.rpt");
+    remove("tmp_clim.out");
+}
+
 // Testing Results Getters (Before End Simulation)
 // BOOST_FIXTURE_TEST_CASE(get_results_after_sim, FixtureBeforeEnd){
 //     int error;